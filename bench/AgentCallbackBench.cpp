@@ -0,0 +1,201 @@
+// 代理事件回调负载测试：通过模拟 JVM 加载代理（Agent_OnLoad），像 JVM 一样驱动
+// ClassFileLoadHook / NativeMethodBind / ClassPrepare 回调、被替换的解密方法与 DataGuard native 方法，不需要启动 JVM。
+// 用法：agent-callback-bench [代理参数]，默认只加载 classfile、native、probe 模块与关闭的 exception、cpu、monitor、gc 模块并关闭日志；
+// 使用默认参数时还会再次附加开启、关闭异常分析并开启 CPU 采样、GC 时间线与监视器分析，检查再次附加后启用的事件与能力与模块声明一致
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <classfile_constants.h>
+
+#include "Bench.h"
+#include "MockJvm.h"
+#include "../src/DataGuard.h"
+
+using namespace bench;
+
+namespace {
+    using DecryptFunc = jbyteArray (*)(JNIEnv *, jobject, jbyteArray);
+
+    // 普通 native 方法的原始实现
+    jint JNICALL hashNative(JNIEnv *, jobject, jbyteArray) {
+        return 0;
+    }
+
+    // 多个线程同时加载类（并行类加载器），返回每秒事件数
+    double parallelClassFileLoadHook(MockJvm &jvm, const MockClass *klass, const size_t threads,
+                                     const size_t events_per_thread) {
+        const auto elapsed = runConcurrently(threads, [&](const size_t t) -> MockJniEnv & {
+            return jvm.attach("loader-" + std::to_string(t));
+        }, [&](size_t, MockJniEnv &env) {
+            for (size_t i = 0; i < events_per_thread; ++i) {
+                jvm.classFileLoadHook(env, klass->name.c_str(), klass->class_file.data(),
+                                      static_cast<jint>(klass->class_file.size()));
+            }
+        });
+        return static_cast<double>(threads * events_per_thread) / std::chrono::duration<double>(elapsed).count();
+    }
+}
+
+int main(const int argc, char **argv) {
+    const bool default_options = argc <= 1;
+    std::string options = default_options
+                              ? "module=classfile,module=native,module=probe,module=exception,"
+                              "module=cpu,cpu_sample=false,module=monitor,monitor_profile=false,module=gc,log_level=off"
+                              : argv[1];
+
+    MockJvm jvm;
+    MockJniEnv &env = jvm.attach("main");
+    JNIEnv *jni = env.env();
+
+    // ---------- 脚本化的类与方法（名称命中代理的默认过滤规则） ----------
+    MockClass *excluded = jvm.defineClass("java/util/HashMap", classFile(2048, false));
+    MockClass *other = jvm.defineClass("org/example/service/OrderService", classFile(2048, false));
+    MockClass *included = jvm.defineClass("com/fr/stable/StringUtils", classFile(2048, false));
+    MockClass *encrypted = jvm.defineClass("com/fr/license/LicenseVerifier", classFile(2048, true));
+
+    MockMethod *other_native = jvm.defineMethod(other, "hash", "([B)I", JVM_ACC_PUBLIC | JVM_ACC_NATIVE);
+    MockMethod *included_native = jvm.defineMethod(included, "hash", "([B)I", JVM_ACC_PUBLIC | JVM_ACC_NATIVE);
+    MockClass *data_guard = jvm.defineClass("DataGuard");
+    MockMethod *decrypt = jvm.defineMethod(data_guard, "decrypt", "([B)[B", JVM_ACC_PUBLIC | JVM_ACC_NATIVE);
+
+    MockClass *constants = jvm.defineClass("com/fr/stable/ProductConstants");
+    jvm.defineStaticField(constants, "VERSION", "11.0");
+    MockClass *general = jvm.defineClass("com/fr/general/GeneralUtils");
+    jvm.defineMethod(general, "readBuildNO", "()Ljava/lang/String;", JVM_ACC_PUBLIC | JVM_ACC_STATIC)->string_result =
+            "Build#release-2024.01.01";
+    jvm.defineMethod(general, "getVersion", "()Ljava/lang/String;", JVM_ACC_PUBLIC | JVM_ACC_STATIC)->string_result =
+            "11.0.26";
+
+    // ---------- 加载代理 ----------
+    if (Agent_OnLoad(jvm.vm(), options.data(), nullptr) != JNI_OK) {
+        std::printf("FAIL: Agent_OnLoad\n");
+        return 1;
+    }
+    std::printf("agent options: %s\n", options.c_str());
+
+    const auto run = [](std::string name, const double bytes, auto &&fn) {
+        print(measure(std::move(name), bytes, fn));
+    };
+
+    // ---------- ClassFileLoadHook ----------
+    const std::pair<const char *, MockClass *> loads[] = {
+        {"excluded", excluded}, {"not_included", other}, {"included", included}, {"encrypted", encrypted},
+    };
+    for (const auto &[name, klass]: loads) {
+        run(std::string("class_file_load_hook/") + name, 0, [&] {
+            doNotOptimize(jvm.classFileLoadHook(env, klass->name.c_str(), klass->class_file.data(),
+                                                static_cast<jint>(klass->class_file.size())));
+        });
+    }
+
+    // ---------- NativeMethodBind ----------
+    run("native_method_bind/not_included", 0, [&] {
+        doNotOptimize(jvm.nativeMethodBind(env, other_native, reinterpret_cast<void *>(&hashNative)));
+    });
+    run("native_method_bind/included", 0, [&] {
+        doNotOptimize(jvm.nativeMethodBind(env, included_native, reinterpret_cast<void *>(&hashNative)));
+    });
+    void *trampoline = nullptr;
+    run("native_method_bind/decrypt_target", 0, [&] {
+        trampoline = jvm.nativeMethodBind(env, decrypt, reinterpret_cast<void *>(&Java_DataGuard_decrypt));
+    });
+
+    // ---------- ClassPrepare ----------
+    run("class_prepare/no_probe", 0, [&] { jvm.classPrepare(env, other); });
+    run("class_prepare/probe_field", 0, [&] { jvm.classPrepare(env, constants); });
+    run("class_prepare/probe_methods", 0, [&] { jvm.classPrepare(env, general); });
+
+    // ---------- 被替换的解密方法与 DataGuard native 方法 ----------
+    // 每次调用后释放局部引用，相当于 native 方法返回 Java
+    const jobject instance = jvm.newInstance(data_guard)->handle();
+    for (const size_t size: {size_t{1024}, size_t{64} * 1024}) {
+        const auto label = formatSize(size);
+        if (trampoline && trampoline != reinterpret_cast<void *>(&Java_DataGuard_decrypt)) {
+            const auto rebound = reinterpret_cast<DecryptFunc>(trampoline);
+            const auto original = reinterpret_cast<jbyteArray>(jvm.newByteArray(payload<jbyte>(size))->handle());
+            run("decrypt_trampoline/original/" + label, static_cast<double>(size), [&] {
+                doNotOptimize(rebound(jni, instance, original));
+                env.releaseLocals();
+            });
+            const auto license = reinterpret_cast<jbyteArray>(jvm.newByteArray(payload<jbyte>(size, "LICx"))->handle());
+            run("decrypt_trampoline/license/" + label, static_cast<double>(size), [&] {
+                doNotOptimize(rebound(jni, instance, license));
+                env.releaseLocals();
+            });
+        }
+        const auto input = reinterpret_cast<jbyteArray>(jvm.newByteArray(payload<jbyte>(size))->handle());
+        run("DataGuard.encrypt/" + label, static_cast<double>(size), [&] {
+            doNotOptimize(Java_DataGuard_encrypt(jni, data_guard->handle(), input));
+            env.releaseLocals();
+        });
+        MockObject *src = jvm.newDirectBuffer(size);
+        MockObject *dst = jvm.newDirectBuffer(size);
+        run("DataGuard.encryptDirect/" + label, static_cast<double>(size), [&] {
+            doNotOptimize(Java_DataGuard_encryptDirect(jni, data_guard->handle(), src->handle(), 0, dst->handle(), 0,
+                                                       static_cast<jint>(size)));
+        });
+    }
+
+    // ---------- 并行类加载 ----------
+    const size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const double rate = parallelClassFileLoadHook(jvm, included, threads, 200000);
+    std::printf("%-48s %14.0f events/s (%zu threads)\n", "class_file_load_hook/included/parallel", rate, threads);
+
+    // ---------- 再次附加：模块声明变化后补充能力并更新事件 ----------
+    // 返回失败原因；失败时同样先卸载代理，否则退出时代理的静态对象会访问已销毁的模拟 JVM
+    const auto verifyAttach = [&]() -> const char * {
+        const auto reattach = [&](std::string value) {
+            Agent_OnAttach(jvm.vm(), value.data(), nullptr);
+            return jvm.enabled(JVMTI_EVENT_EXCEPTION) && jvm.enabled(JVMTI_EVENT_CLASS_FILE_LOAD_HOOK);
+        };
+        if (jvm.enabled(JVMTI_EVENT_EXCEPTION) || !reattach("exception_profile=true,log_level=off")
+            || reattach("exception_profile=false,log_level=off") || !jvm.enabled(JVMTI_EVENT_CLASS_FILE_LOAD_HOOK)) {
+            return "exception events do not follow exception_profile on attach";
+        }
+        // 采样线程只遇到平台线程，开启 CPU 采样不请求虚拟线程支持；监视器事件可能发生在虚拟线程上，需要该能力
+        reattach("cpu_sample=true,log_level=off");
+        if (!jvm.capabilities().can_get_thread_cpu_time || jvm.capabilities().can_support_virtual_threads) {
+            return "cpu sampling requests can_support_virtual_threads";
+        }
+        // GC 时间线默认关闭
+        if (jvm.enabled(JVMTI_EVENT_GARBAGE_COLLECTION_START)) return "gc events are enabled by default";
+        reattach("gc_profile=true,log_level=off");
+        if (!jvm.enabled(JVMTI_EVENT_GARBAGE_COLLECTION_START) || !jvm.enabled(JVMTI_EVENT_GARBAGE_COLLECTION_FINISH)) {
+            return "gc_profile=true does not enable gc events";
+        }
+#ifdef JVMTI_HAS_VIRTUAL_THREADS
+        reattach("monitor_profile=true,log_level=off");
+        if (!jvm.capabilities().can_support_virtual_threads || !jvm.enabled(JVMTI_EVENT_VIRTUAL_THREAD_END)) {
+            return "monitor profiling does not track virtual thread ends";
+        }
+#endif
+        return nullptr;
+    };
+    const char *attach_failure = default_options ? verifyAttach() : nullptr;
+
+    Agent_OnUnload(jvm.vm());
+    if (attach_failure) {
+        std::printf("FAIL: %s\n", attach_failure);
+        return 1;
+    }
+    if (default_options) std::printf("verify: events and capabilities follow module declarations on attach\n");
+
+    // 回调中通过 Allocate 取得的内存（类签名、方法名等）应全部 Deallocate
+    const int64_t leaked = jvm.outstandingAllocations();
+    std::printf("jvmti allocations outstanding=%lld, unsupported jvmti calls=%llu, global refs=%lld\n",
+                static_cast<long long>(leaked), static_cast<unsigned long long>(jvm.unsupportedCalls()),
+                static_cast<long long>(jvm.globalRefs()));
+    if (leaked != 0) {
+        std::printf("FAIL: agent callbacks leak JVMTI allocations\n");
+        return 1;
+    }
+    if (env.hasException()) {
+        std::printf("FAIL: pending exception %s\n", env.describeException().c_str());
+        return 1;
+    }
+    return 0;
+}
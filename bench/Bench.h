@@ -0,0 +1,176 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 简易基准测试工具：自动放大迭代次数直到达到最短运行时间
+namespace bench {
+    // 阻止编译器优化掉基准测试中的计算结果
+    template<typename T>
+    inline void doNotOptimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void *sink;
+        sink = &value;
+#endif
+    }
+
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0;
+        double ns_per_op = 0;
+        double bytes_per_op = 0;
+
+        // 每秒处理的字节数（GB/s）
+        double gigabytesPerSecond() const {
+            return ns_per_op > 0 ? bytes_per_op / ns_per_op : 0;
+        }
+    };
+
+    template<typename F>
+    Result measure(std::string name, const double bytes_per_op, F &&fn,
+                   const std::chrono::nanoseconds min_time = std::chrono::milliseconds(200)) {
+        using clock = std::chrono::steady_clock;
+        fn(); // 预热
+
+        uint64_t iterations = 1;
+        while (true) {
+            const auto start = clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                fn();
+            }
+            const auto elapsed = clock::now() - start;
+            if (elapsed >= min_time || iterations >= (uint64_t{1} << 40)) {
+                const auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+                return {std::move(name), iterations, ns / static_cast<double>(iterations), bytes_per_op};
+            }
+            // 根据已用时间估算下一轮迭代次数
+            const auto ns = std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 1);
+            const auto scale = static_cast<uint64_t>(static_cast<double>(min_time.count()) * 1.2 / static_cast<double>(ns));
+            iterations = std::max(iterations * 2, iterations * std::min<uint64_t>(scale, 100));
+        }
+    }
+
+    inline void print(const Result &result) {
+        if (result.bytes_per_op > 0) {
+            std::printf("%-48s %14.1f ns/op %10.2f GB/s %12llu iters\n", result.name.c_str(), result.ns_per_op,
+                        result.gigabytesPerSecond(), static_cast<unsigned long long>(result.iterations));
+        } else {
+            std::printf("%-48s %14.1f ns/op %12llu iters\n", result.name.c_str(), result.ns_per_op,
+                        static_cast<unsigned long long>(result.iterations));
+        }
+    }
+
+    // JSON 字符串转义（名称只含 ASCII，其余控制字符按 Unicode 转义）
+    inline std::string jsonEscape(const std::string &text) {
+        std::string out;
+        out.reserve(text.size() + 2);
+        for (const char c: text) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(c));
+                        out += buffer;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        return out;
+    }
+
+    // 以 JSON 写出结果，context 为附加的键值（例如版本号、编译类型），便于比较不同版本的代理；失败返回 false
+    inline bool writeJson(const std::string &path, const std::vector<Result> &results,
+                          const std::vector<std::pair<std::string, std::string> > &context = {}) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (!file) return false;
+        char date[32] = {};
+        const std::time_t now = std::time(nullptr);
+        if (const std::tm *tm = std::gmtime(&now)) std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", tm);
+        std::fprintf(file, "{\n  \"context\": {\n    \"date\": \"%s\"", date);
+        for (const auto &[key, value]: context) {
+            std::fprintf(file, ",\n    \"%s\": \"%s\"", jsonEscape(key).c_str(), jsonEscape(value).c_str());
+        }
+        std::fprintf(file, "\n  },\n  \"benchmarks\": [");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto &result = results[i];
+            std::fprintf(file,
+                         "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, "
+                         "\"bytes_per_op\": %.0f, \"gb_per_s\": %.4f}",
+                         i == 0 ? "" : ",", jsonEscape(result.name).c_str(),
+                         static_cast<unsigned long long>(result.iterations), result.ns_per_op, result.bytes_per_op,
+                         result.gigabytesPerSecond());
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+        return std::fclose(file) == 0;
+    }
+
+    // threads 个线程全部就绪后同时执行 fn(线程序号, prepare 的结果)，返回从同时开始到全部结束的耗时；
+    // prepare(线程序号) 在就绪前于各线程中执行（例如附加到模拟 JVM），不计入耗时
+    template<typename Prepare, typename F>
+    std::chrono::nanoseconds runConcurrently(const size_t threads, Prepare &&prepare, F &&fn) {
+        std::atomic<size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                decltype(auto) context = prepare(t);
+                ready.fetch_add(1);
+                while (!go.load()) std::this_thread::yield();
+                fn(t, context);
+            });
+        }
+        while (ready.load() < threads) std::this_thread::yield();
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true);
+        for (auto &worker: workers) worker.join();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    // 以魔数开头的类文件，其余字节为固定的伪随机内容；encrypted 为 true 时头部不是 0xCAFEBABE
+    inline std::vector<unsigned char> classFile(const size_t size, const bool encrypted) {
+        static constexpr unsigned char magic[] = {0xCA, 0xFE, 0xBA, 0xBE};
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; ++i) data[i] = static_cast<unsigned char>(i * 31 + 7);
+        if (!encrypted && size >= std::size(magic)) std::copy(std::begin(magic), std::end(magic), data.begin());
+        return data;
+    }
+
+    // 小写字母循环填充的数据（DataGuard 大小写互换的典型输入），header 不为空时以其前 4 字节开头
+    template<typename Byte>
+    std::vector<Byte> payload(const size_t size, const char *header = nullptr) {
+        std::vector<Byte> data(size);
+        for (size_t i = 0; i < size; ++i) data[i] = static_cast<Byte>('a' + i % 26);
+        if (header && size >= 4) std::copy(header, header + 4, data.begin());
+        return data;
+    }
+
+    // 可读的字节大小，例如 64KiB
+    inline std::string formatSize(const size_t bytes) {
+        static const char *units[] = {"B", "KiB", "MiB", "GiB"};
+        size_t value = bytes;
+        size_t unit = 0;
+        while (value >= 1024 && value % 1024 == 0 && unit < 3) {
+            value /= 1024;
+            ++unit;
+        }
+        return std::to_string(value) + units[unit];
+    }
+}
+
+#endif //BENCH_H
@@ -0,0 +1,129 @@
+// DataGuard 大小写互换内核吞吐量测试：16B ~ 64MiB
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/CaseSwap.h"
+#include "../src/WorkerPool.h"
+
+using namespace jvmti_tools;
+
+namespace {
+    // 原实现：逐字节调用 isupper/tolower
+    void swapCaseLegacy(const unsigned char *in, unsigned char *out, const size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            const auto c = in[i];
+            if (isupper(c)) {
+                out[i] = static_cast<unsigned char>(tolower(c));
+            } else if (islower(c)) {
+                out[i] = static_cast<unsigned char>(toupper(c));
+            } else {
+                out[i] = c;
+            }
+        }
+    }
+
+    std::vector<unsigned char> randomBytes(const size_t length, const bool ascii_only) {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> dist(0, ascii_only ? 127 : 255);
+        std::vector<unsigned char> data(length);
+        for (auto &b: data) b = static_cast<unsigned char>(dist(rng));
+        return data;
+    }
+
+    // 校验所有内核在各种长度与非对齐偏移下与原实现（ASCII）及标量实现（全字节）一致
+    bool verify(const std::vector<CaseSwapImpl> &impls) {
+        bool ok = true;
+        for (const bool ascii_only: {true, false}) {
+            const auto input = randomBytes(4096 + 64, ascii_only);
+            for (size_t length = 0; length <= 300; ++length) {
+                for (size_t offset = 0; offset < 8; ++offset) {
+                    std::vector<unsigned char> expected(length);
+                    if (ascii_only) {
+                        swapCaseLegacy(input.data() + offset, expected.data(), length);
+                    } else {
+                        impls.front().kernel(input.data() + offset, expected.data(), length);
+                    }
+                    for (const auto &impl: impls) {
+                        std::vector<unsigned char> actual(length + 1, 0xEE);
+                        impl.kernel(input.data() + offset, actual.data(), length);
+                        if (std::memcmp(expected.data(), actual.data(), length) != 0 || actual[length] != 0xEE) {
+                            std::printf("MISMATCH kernel=%s length=%zu offset=%zu ascii=%d\n", impl.name, length,
+                                        offset, ascii_only);
+                            ok = false;
+                        }
+                    }
+                }
+            }
+        }
+        return ok;
+    }
+}
+
+int main() {
+    const auto impls = availableCaseSwaps();
+    std::printf("selected kernel: %s\n", selectedCaseSwap().name);
+    if (!verify(impls)) {
+        return 1;
+    }
+    std::printf("verify: all kernels match\n\n");
+
+    std::vector<CaseSwapImpl> candidates = {{"legacy", &swapCaseLegacy}};
+    candidates.insert(candidates.end(), impls.begin(), impls.end());
+
+    constexpr size_t max_size = size_t{64} << 20;
+    const auto input = randomBytes(max_size, true);
+    std::vector<unsigned char> output(max_size);
+    for (size_t size = 16; size <= max_size; size *= 4) {
+        for (const auto &impl: candidates) {
+            const auto result = bench::measure(std::string("case_swap/") + impl.name + "/" + bench::formatSize(size),
+                                               static_cast<double>(size), [&] {
+                                                   impl.kernel(input.data(), output.data(), size);
+                                                   bench::doNotOptimize(output.data());
+                                               });
+            bench::print(result);
+        }
+    }
+
+    // 单线程与分块并行的交叉点（与 DataGuard 使用相同的 256KiB 分块）
+    constexpr size_t chunk = 256 * 1024;
+    auto &pool = WorkerPool::shared();
+    std::printf("\nparallel: %zu threads (cpus=%zu), chunk=%s\n", pool.concurrency(), WorkerPool::availableCpus(),
+                bench::formatSize(chunk).c_str());
+    size_t crossover = 0;
+    for (size_t size = 64 * 1024; size <= max_size; size *= 2) {
+        const auto single = bench::measure("case_swap/single/" + bench::formatSize(size), static_cast<double>(size), [&] {
+            swapCase(input.data(), output.data(), size);
+            bench::doNotOptimize(output.data());
+        });
+        const auto parallel = bench::measure("case_swap/parallel/" + bench::formatSize(size), static_cast<double>(size),
+                                             [&] {
+                                                 pool.parallelFor(size, chunk, [&](const size_t begin, const size_t end) {
+                                                     swapCase(input.data() + begin, output.data() + begin, end - begin);
+                                                 });
+                                                 bench::doNotOptimize(output.data());
+                                             });
+        bench::print(single);
+        bench::print(parallel);
+        // 明显快于单线程（>5%）才视为越过交叉点，避免测量噪声
+        if (crossover == 0 && parallel.ns_per_op < single.ns_per_op * 0.95) {
+            crossover = size;
+        }
+    }
+
+    // 并行结果必须与单线程一致
+    std::vector<unsigned char> expected(max_size);
+    swapCase(input.data(), expected.data(), max_size);
+    pool.parallelFor(max_size, chunk, [&](const size_t begin, const size_t end) {
+        swapCase(input.data() + begin, output.data() + begin, end - begin);
+    });
+    if (std::memcmp(expected.data(), output.data(), max_size) != 0) {
+        std::printf("MISMATCH parallel output\n");
+        return 1;
+    }
+    std::printf("crossover: %s\n", crossover ? bench::formatSize(crossover).c_str() : "none");
+    return 0;
+}
@@ -0,0 +1,135 @@
+// JHook 热替换测试：通过模拟 JVM 以 JHook 加载代理模块（Agent_OnLoad），再以 reload 反复再次附加（Agent_OnAttach），
+// 统计每次替换的耗时，并检查被替换的模块副本已从 /proc/self/maps 中移除（没有被 glibc 标记为 NODELETE 而常驻内存）。
+// 解密方法绑定到 JHook 的跳板后同样可以替换：每个新模块都接管该方法，卸载后调用回到原始实现。
+// 用法：jhook-reload-bench [代理模块路径] [替换次数]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include <classfile_constants.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "MockJvm.h"
+
+using namespace bench;
+
+namespace {
+    // JHook 加载的模块副本名称为 jhook-<pid>-<序号>-<文件名>，返回当前映射的全部副本
+    std::set<std::string> mappedCopies() {
+        const std::string prefix = "jhook-" + std::to_string(getpid()) + "-";
+        std::set<std::string> copies;
+        std::ifstream maps("/proc/self/maps");
+        for (std::string line; std::getline(maps, line);) {
+            const auto begin = line.find(prefix);
+            if (begin == std::string::npos) continue;
+            copies.insert(line.substr(begin, line.find(' ', begin) - begin));
+        }
+        return copies;
+    }
+
+    void printCopies(const std::set<std::string> &copies) {
+        for (const auto &copy: copies) std::printf("  mapped: %s\n", copy.c_str());
+    }
+
+    using DecryptFunc = jbyteArray (JNICALL *)(JNIEnv *, jobject, jbyteArray);
+
+    // 解密方法的原始实现：原样返回参数
+    jbyteArray JNICALL originalDecrypt(JNIEnv *, jobject, jbyteArray data) {
+        return data;
+    }
+
+    // 以 LICx 开头的数据由模块去掉前 4 字节，其余数据交给原始实现；handled 表示调用应由模块处理
+    bool checkDecrypt(MockJvm &jvm, MockJniEnv &env, const DecryptFunc decrypt, const jobject instance,
+                      const bool handled) {
+        JNIEnv *jni = env.env();
+        const auto license = reinterpret_cast<jbyteArray>(
+            jvm.newByteArray({'L', 'I', 'C', 'x', 'd', 'a', 't', 'a'})->handle());
+        const auto plain = reinterpret_cast<jbyteArray>(jvm.newByteArray({'d', 'a', 't', 'a'})->handle());
+        const jbyteArray result = decrypt(jni, instance, license);
+        const bool ok = decrypt(jni, instance, plain) == plain
+                        && (handled ? result != license && jni->GetArrayLength(result) == 4 : result == license);
+        env.releaseLocals();
+        return ok;
+    }
+}
+
+int main(const int argc, char **argv) {
+    const std::string agent = argc > 1 ? argv[1] : JHOOK_RELOAD_AGENT;
+    const int reloads = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 20;
+    std::string options = "agent=" + agent + ",module=classfile,module=native,log_level=off";
+
+    MockJvm jvm;
+    MockJniEnv &env = jvm.attach("main");
+    std::vector<unsigned char> class_file(2048, 0x5A);
+    MockClass *klass = jvm.defineClass("com/fr/stable/StringUtils", class_file);
+    MockClass *data_guard = jvm.defineClass("DataGuard");
+    MockMethod *method = jvm.defineMethod(data_guard, "decrypt", "([B)[B", JVM_ACC_PUBLIC | JVM_ACC_NATIVE);
+    const jobject instance = jvm.newInstance(data_guard)->handle();
+
+    if (Agent_OnLoad(jvm.vm(), options.data(), nullptr) != JNI_OK || mappedCopies().size() != 1) {
+        std::printf("FAIL: JHook did not load %s\n", agent.c_str());
+        return 1;
+    }
+    std::printf("agent module: %s\n", agent.c_str());
+
+    // VM 只为首次绑定发送 NativeMethodBind，之后的模块经 JHook 的跳板接管该方法
+    const auto decrypt = reinterpret_cast<DecryptFunc>(
+        jvm.nativeMethodBind(env, method, reinterpret_cast<void *>(&originalDecrypt)));
+    if (decrypt == &originalDecrypt || !checkDecrypt(jvm, env, decrypt, instance, true)) {
+        std::printf("FAIL: decrypt is not rebound by the agent module\n");
+        return 1;
+    }
+
+    auto previous = mappedCopies();
+    std::vector<double> elapsed;
+    for (int i = 0; i < reloads; ++i) {
+        // 每轮都经过 JHook 的事件入口调用当前模块
+        jvm.classFileLoadHook(env, klass->name.c_str(), klass->class_file.data(),
+                              static_cast<jint>(klass->class_file.size()));
+
+        std::string reload = options + ",reload";
+        const auto start = std::chrono::steady_clock::now();
+        Agent_OnAttach(jvm.vm(), reload.data(), nullptr);
+        elapsed.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+        // 旧副本必须已卸载，只剩新加载的副本（模块拒绝卸载时保留的是旧副本）
+        const auto copies = mappedCopies();
+        if (copies.size() != 1 || copies == previous) {
+            std::printf("FAIL: %zu module copies mapped after reload %d\n", copies.size(), i + 1);
+            printCopies(copies);
+            return 1;
+        }
+        previous = copies;
+        if (!checkDecrypt(jvm, env, decrypt, instance, true)) {
+            std::printf("FAIL: decrypt is not handled by the module after reload %d\n", i + 1);
+            return 1;
+        }
+    }
+    jvm.classFileLoadHook(env, klass->name.c_str(), klass->class_file.data(),
+                          static_cast<jint>(klass->class_file.size()));
+
+    std::sort(elapsed.begin(), elapsed.end());
+    double total = 0;
+    for (const double value: elapsed) total += value;
+    std::printf("%-48s %14.1f us/op %10.1f us p50 %10.1f us max %6d reloads\n", "jhook/reload",
+                total / static_cast<double>(elapsed.size()), elapsed[elapsed.size() / 2], elapsed.back(), reloads);
+
+    Agent_OnUnload(jvm.vm());
+    if (const auto copies = mappedCopies(); !copies.empty()) {
+        std::printf("FAIL: module still mapped after Agent_OnUnload\n");
+        printCopies(copies);
+        return 1;
+    }
+    // 模块已卸载，跳板直接调用原始实现
+    if (!checkDecrypt(jvm, env, decrypt, instance, false)) {
+        std::printf("FAIL: decrypt does not fall back to the original after Agent_OnUnload\n");
+        return 1;
+    }
+    std::printf("verify: replaced module copies are unmapped, rebound natives follow the current module\n");
+    return 0;
+}
@@ -0,0 +1,380 @@
+// 代理热路径微基准：日志器获取（含多线程竞争）、类名过滤、加密类检测、类签名处理、阻塞队列、
+// 类文件转储（tmpfs）与 DataGuard 加密吞吐。运行前先校验 DataGuard 各入口的加解密往返，不一致时输出 MISMATCH 并返回 1。
+// 用法：jvmti-bench [--filter=子串] [--json=结果文件] [--label=代理版本] [--min-time-ms=200]
+// JSON 结果用于发布前比较不同版本代理的数据
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "MockJvm.h"
+#include "../src/DataGuard.h"
+#include "../src/jvmti/BlockingQueue.h"
+#include "../src/jvmti/ClassFile.h"
+#include "../src/jvmti/Config.h"
+#include "../src/jvmti/Logger.h"
+
+#ifndef JVMTI_TOOLS_VERSION
+#define JVMTI_TOOLS_VERSION "unknown"
+#endif
+
+using namespace bench;
+namespace fs = std::filesystem;
+
+namespace {
+    struct Options {
+        std::string filter;
+        std::string json;
+        std::string label;
+        std::chrono::milliseconds min_time{200};
+    };
+
+    class Suite {
+    private:
+        const Options &options_;
+        std::vector<Result> results_;
+
+    public:
+        explicit Suite(const Options &options): options_(options) {
+        }
+
+        bool selected(const std::string &name) const {
+            return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+        }
+
+        void add(Result result) {
+            print(result);
+            results_.push_back(std::move(result));
+        }
+
+        template<typename F>
+        void run(const std::string &name, const double bytes_per_op, F &&fn) {
+            if (!selected(name)) return;
+            add(measure(name, bytes_per_op, std::forward<F>(fn), options_.min_time));
+        }
+
+        // threads 个线程同时执行 ops_per_thread 次 fn(线程序号)，ns/op 为总耗时除以总次数（衡量竞争下的吞吐）
+        template<typename F>
+        void runParallel(const std::string &name, const size_t threads, const uint64_t ops_per_thread, F &&fn) {
+            if (!selected(name)) return;
+            const auto elapsed = runConcurrently(threads, [](size_t) { return 0; }, [&](const size_t t, int) {
+                for (uint64_t i = 0; i < ops_per_thread; ++i) fn(t);
+            });
+            const uint64_t total = threads * ops_per_thread;
+            add({name, total, static_cast<double>(elapsed.count()) / static_cast<double>(total), 0});
+        }
+
+        const std::vector<Result> &results() const { return results_; }
+    };
+
+    Options parseOptions(const int argc, char **argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            if (arg.starts_with("--filter=")) {
+                options.filter = arg.substr(9);
+            } else if (arg.starts_with("--json=")) {
+                options.json = arg.substr(7);
+            } else if (arg.starts_with("--label=")) {
+                options.label = arg.substr(8);
+            } else if (arg.starts_with("--min-time-ms=")) {
+                options.min_time = std::chrono::milliseconds(std::max(1, std::atoi(argv[i] + 14)));
+            } else {
+                std::fprintf(stderr, "unknown argument: %s\n", argv[i]);
+            }
+        }
+        return options;
+    }
+
+    // 优先写入 tmpfs（/dev/shm），排除磁盘带宽对结果的影响
+    fs::path dumpDirectory() {
+        std::error_code ec;
+        fs::path base = "/dev/shm";
+        if (!fs::is_directory(base, ec)) base = fs::temp_directory_path(ec);
+        return base / ("jvmti-bench-" + std::to_string(::getpid()));
+    }
+
+    void loggerCases(Suite &suite, const size_t threads) {
+        jvmti::Logger logger;
+        suite.run("logger/get/default", 0, [&] { doNotOptimize(logger.get()); });
+        suite.run("logger/get/event", 0, [&] { doNotOptimize(logger.get(JVMTI_EVENT_CLASS_FILE_LOAD_HOOK)); });
+        suite.runParallel("logger/get/contended/" + std::to_string(threads) + "t", threads, 200000,
+                          [&](size_t) { doNotOptimize(logger.get()); });
+    }
+
+    void filterCases(Suite &suite) {
+        const auto config = jvmti_tools::AgentConfig::defaults();
+        // 与 ClassFileLoadHook 一致：先排除后包含
+        const auto accepted = [&](const std::string_view name) {
+            return !config.class_exclude.matches(name) && config.class_include.matches(name);
+        };
+        const std::pair<const char *, const char *> names[] = {
+            {"excluded", "java/util/concurrent/ConcurrentHashMap"},
+            {"not_included", "org/example/service/OrderService"},
+            {"included", "com/fr/stable/StringUtils"},
+            {"signature", "Lcom/fr/license/LicenseVerifier;"},
+        };
+        for (const auto &[label, name]: names) {
+            const std::string_view view = name;
+            suite.run(std::string("class_filter/") + label, 0, [&] { doNotOptimize(accepted(view)); });
+        }
+    }
+
+    void classFileCases(Suite &suite) {
+        const auto plain = classFile(2048, false);
+        const auto encrypted = classFile(2048, true);
+        suite.run("is_class_encrypted/plain", 0, [&] {
+            doNotOptimize(jvmti_tools::isClassEncrypted(plain.data(), static_cast<jsize>(plain.size())));
+        });
+        suite.run("is_class_encrypted/encrypted", 0, [&] {
+            doNotOptimize(jvmti_tools::isClassEncrypted(encrypted.data(), static_cast<jsize>(encrypted.size())));
+        });
+
+        const std::pair<const char *, const char *> signatures[] = {
+            {"short", "LTestApp;"},
+            {"package", "Lcom/fr/stable/StringUtils;"},
+            {"nested", "Lcom/fr/third/springframework/context/support/AbstractApplicationContext$1;"},
+            {"array", "[Ljava/lang/String;"},
+        };
+        for (const auto &[label, signature]: signatures) {
+            suite.run(std::string("class_name/") + label, 0, [&] {
+                doNotOptimize(jvmti_tools::className(signature));
+            });
+        }
+    }
+
+    void queueCases(Suite &suite) {
+        jvmti_tools::BlockingQueue<uint64_t> queue;
+        uint64_t value = 0;
+        suite.run("blocking_queue/push_pop", 0, [&] {
+            queue.push(value);
+            queue.pop(value);
+        });
+
+        // 单生产者、单消费者，有界队列
+        const std::string name = "blocking_queue/spsc/bounded_1024";
+        if (suite.selected(name)) {
+            constexpr uint64_t items = 1000000;
+            jvmti_tools::BlockingQueue<uint64_t> bounded(1024);
+            const auto start = std::chrono::steady_clock::now();
+            std::thread consumer([&] {
+                uint64_t item = 0;
+                for (uint64_t i = 0; i < items;) {
+                    if (bounded.pop(item, std::chrono::milliseconds(100))) ++i;
+                }
+                doNotOptimize(item);
+            });
+            for (uint64_t i = 0; i < items; ++i) bounded.push(i);
+            consumer.join();
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            suite.add({name, items, elapsed.count() / static_cast<double>(items), 0});
+        }
+    }
+
+    void dumpCases(Suite &suite) {
+        const fs::path directory = dumpDirectory();
+        for (const size_t size: {size_t{2} * 1024, size_t{64} * 1024}) {
+            const auto data = classFile(size, false);
+            const auto label = formatSize(size);
+            suite.run("dump_class_file/" + label, static_cast<double>(size), [&] {
+                jvmti_tools::dumpClassFile(directory.string(), "com/fr/stable/StringUtils", data.data(),
+                                           static_cast<jint>(data.size()), false, nullptr);
+            });
+        }
+        std::error_code ec;
+        fs::remove_all(directory, ec);
+    }
+
+    void dataGuardCases(Suite &suite) {
+        MockJvm jvm;
+        MockJniEnv &env = jvm.attach("main");
+        JNIEnv *jni = env.env();
+        MockClass *data_guard = jvm.defineClass("DataGuard");
+        for (const size_t size: {size_t{1024}, size_t{64} * 1024, size_t{1024} * 1024}) {
+            const auto input = reinterpret_cast<jbyteArray>(jvm.newByteArray(payload<jbyte>(size))->handle());
+            // 每次调用后释放局部引用，相当于 native 方法返回 Java
+            suite.run("data_guard/encrypt/" + formatSize(size), static_cast<double>(size), [&] {
+                doNotOptimize(Java_DataGuard_encrypt(jni, data_guard->handle(), input));
+                env.releaseLocals();
+            });
+            // 原地处理，输出数组由调用方复用
+            const jlong stream = Java_DataGuard_streamInit(jni, nullptr);
+            suite.run("data_guard/stream_update/" + formatSize(size), static_cast<double>(size), [&] {
+                doNotOptimize(Java_DataGuard_streamUpdate(jni, nullptr, stream, input, 0, static_cast<jint>(size),
+                                                          input, 0));
+            });
+            Java_DataGuard_streamFinal(jni, nullptr, stream);
+        }
+    }
+
+    // DataGuard 往返校验：堆数组、直接缓冲区与流式入口加密后再解密必须还原原文，长度与偏移覆盖非 16 字节对齐的情况，
+    // 最大长度超过默认并行阈值（2MiB）；流式处理的任意分块方式必须得到与一次性处理相同的密文
+    bool verifyDataGuard() {
+        MockJvm jvm;
+        MockJniEnv &env = jvm.attach("main");
+        JNIEnv *jni = env.env();
+        const auto clazz = reinterpret_cast<jclass>(jvm.defineClass("DataGuard")->handle());
+        std::mt19937 rng(42);
+        const auto random = [&](const size_t length) {
+            std::vector<jbyte> data(length);
+            for (auto &b: data) b = static_cast<jbyte>(rng());
+            return data;
+        };
+        const auto array = [&](std::vector<jbyte> content) {
+            return reinterpret_cast<jbyteArray>(jvm.newByteArray(std::move(content))->handle());
+        };
+        const auto bytes = [](jobject object) -> std::vector<jbyte> & { return MockObject::of(object)->bytes; };
+        bool ok = true;
+        const auto check = [&](const bool condition, const char *path, const size_t length, const size_t offset) {
+            if (!condition) {
+                std::printf("MISMATCH data_guard/%s length=%zu offset=%zu%s%s\n", path, length, offset,
+                            env.hasException() ? " " : "", env.describeException().c_str());
+                ok = false;
+            }
+            env.releaseLocals();
+        };
+
+        constexpr size_t large = (size_t{2} << 20) + 5;
+        const size_t lengths[] = {0, 1, 15, 16, 17, 31, 33, 1000, large};
+        for (const size_t length: lengths) {
+            const auto plain = random(length);
+            const jbyteArray cipher = Java_DataGuard_encrypt(jni, clazz, array(plain));
+            const jbyteArray decrypted = cipher ? Java_DataGuard_decrypt(jni, clazz, cipher) : nullptr;
+            check(decrypted && bytes(decrypted) == plain, "encrypt", length, 0);
+        }
+
+        // 直接缓冲区：输入、输出使用不同的非对齐偏移，解密在输出缓冲区原地进行
+        for (const size_t length: lengths) {
+            for (size_t offset = 0; offset < 4; ++offset) {
+                const auto plain = random(length);
+                const size_t out_offset = (offset + 1) % 4;
+                MockObject *src = jvm.newDirectBuffer(length + offset);
+                MockObject *dst = jvm.newDirectBuffer(length + out_offset);
+                std::copy(plain.begin(), plain.end(), src->bytes.begin() + static_cast<ptrdiff_t>(offset));
+                const auto n = static_cast<jint>(length);
+                const bool done = Java_DataGuard_encryptDirect(jni, clazz, src->handle(), static_cast<jint>(offset),
+                                                               dst->handle(), static_cast<jint>(out_offset), n) == n
+                                  && Java_DataGuard_decryptDirect(jni, clazz, dst->handle(), static_cast<jint>(out_offset),
+                                                                  dst->handle(), static_cast<jint>(out_offset), n) == n;
+                check(done && std::equal(plain.begin(), plain.end(), dst->bytes.begin() + static_cast<ptrdiff_t>(out_offset)),
+                      "encrypt_direct", length, offset);
+            }
+        }
+
+        // 流式：以不规则分块经堆数组与直接缓冲区处理，结果必须与一次性 encrypt / encryptDirect 逐字节一致，
+        // 流式加密的数据也必须能由一次性 decrypt 还原
+        const size_t total = large + 3;
+        const auto plain = random(total);
+        const auto forEachChunk = [&](const std::vector<size_t> &sizes, auto &&update) {
+            const jlong stream = Java_DataGuard_streamInit(jni, clazz);
+            bool done = true;
+            for (size_t offset = 0, i = 0; offset < total && done; offset += sizes[i++ % sizes.size()]) {
+                const size_t length = std::min(sizes[i % sizes.size()], total - offset);
+                done = update(stream, offset, static_cast<jint>(length)) == static_cast<jint>(length);
+            }
+            return Java_DataGuard_streamFinal(jni, clazz, stream) == static_cast<jlong>(total) && done;
+        };
+        // encrypt 的结果是局部引用，check 会释放局部引用，先取出参考密文
+        const jbyteArray reference = Java_DataGuard_encrypt(jni, clazz, array(plain));
+        const std::vector<jbyte> expected = reference ? bytes(reference) : std::vector<jbyte>();
+        check(reference != nullptr, "encrypt", total, 0);
+        MockObject *direct_reference = jvm.newDirectBuffer(total);
+        {
+            MockObject *src = jvm.newDirectBuffer(total);
+            std::copy(plain.begin(), plain.end(), src->bytes.begin());
+            const auto n = static_cast<jint>(total);
+            check(Java_DataGuard_encryptDirect(jni, clazz, src->handle(), 0, direct_reference->handle(), 0, n) == n,
+                  "encrypt_direct", total, 0);
+        }
+        if (!ok) return ok;
+
+        // 输入偏移 3、输出偏移 1，均不对齐
+        std::vector<jbyte> padded(3);
+        padded.insert(padded.end(), plain.begin(), plain.end());
+        const jbyteArray input = array(std::move(padded));
+        const std::vector<std::vector<size_t> > chunkings = {
+            {total}, {1, 7, 15, 16, 17, 4096, 65537}, {33, 1000, (size_t{5} << 19) + 1}, {16},
+        };
+        for (const auto &sizes: chunkings) {
+            const jbyteArray output = array(std::vector<jbyte>(total + 1));
+            const bool done = forEachChunk(sizes, [&](const jlong stream, const size_t offset, const jint length) {
+                return Java_DataGuard_streamUpdate(jni, clazz, stream, input, static_cast<jint>(3 + offset), length,
+                                                   output, static_cast<jint>(1 + offset));
+            });
+            check(done && std::equal(expected.begin(), expected.end(), bytes(output).begin() + 1), "stream_heap",
+                  total, sizes.front());
+
+            // 流式密文经一次性 decrypt 还原原文
+            const jbyteArray cipher = array(std::vector<jbyte>(bytes(output).begin() + 1, bytes(output).end()));
+            const jbyteArray decrypted = Java_DataGuard_decrypt(jni, clazz, cipher);
+            check(decrypted && bytes(decrypted) == plain, "stream_heap_decrypt", total, sizes.front());
+        }
+        for (const auto &sizes: chunkings) {
+            // 直接缓冲区中原地处理，与 encryptDirect 的结果比较
+            MockObject *buffer = jvm.newDirectBuffer(total + 2);
+            std::copy(plain.begin(), plain.end(), buffer->bytes.begin() + 2);
+            const bool done = forEachChunk(sizes, [&](const jlong stream, const size_t offset, const jint length) {
+                return Java_DataGuard_streamUpdateDirect(jni, clazz, stream, buffer->handle(),
+                                                         static_cast<jint>(2 + offset), buffer->handle(),
+                                                         static_cast<jint>(2 + offset), length);
+            });
+            check(done && std::equal(direct_reference->bytes.begin(), direct_reference->bytes.end(),
+                                     buffer->bytes.begin() + 2), "stream_direct", total, sizes.front());
+        }
+
+        // 结束后的句柄无效
+        const jlong closed = Java_DataGuard_streamInit(jni, clazz);
+        Java_DataGuard_streamFinal(jni, clazz, closed);
+        check(Java_DataGuard_streamFinal(jni, clazz, closed) == -1 && env.hasException(), "stream_closed", 0, 0);
+        return ok;
+    }
+}
+
+int main(const int argc, char **argv) {
+    const Options options = parseOptions(argc, argv);
+    const size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+    if (!verifyDataGuard()) {
+        return 1;
+    }
+    std::printf("verify: DataGuard heap, direct and stream round trips match\n");
+
+    Suite suite(options);
+    loggerCases(suite, threads);
+    filterCases(suite);
+    classFileCases(suite);
+    queueCases(suite);
+    dumpCases(suite);
+    dataGuardCases(suite);
+
+    if (!options.json.empty()) {
+        const std::vector<std::pair<std::string, std::string> > context = {
+            {"version", JVMTI_TOOLS_VERSION},
+            {"label", options.label},
+            {"threads", std::to_string(threads)},
+#if defined(__VERSION__)
+            {"compiler", __VERSION__},
+#endif
+#ifdef NDEBUG
+            {"build", "release"},
+#else
+            {"build", "debug"},
+#endif
+        };
+        if (!writeJson(options.json, suite.results(), context)) {
+            std::fprintf(stderr, "FAIL: cannot write %s\n", options.json.c_str());
+            return 1;
+        }
+        std::printf("results written to %s\n", options.json.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,963 @@
+#include "MockJvm.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace bench {
+    namespace {
+        constexpr size_t JNI_SLOTS = sizeof(JNINativeInterface_) / sizeof(void *);
+        constexpr size_t JVMTI_SLOTS = sizeof(jvmtiInterface_1_) / sizeof(void *);
+
+        // 同一线程可能附加到多个模拟 JVM，按实例编号区分（实例析构后地址可能被复用）
+        std::atomic<uint64_t> next_instance{1};
+
+        struct Attachment {
+            uint64_t instance;
+            MockJniEnv *env;
+        };
+
+        thread_local std::vector<Attachment> attachments;
+
+        // 未模拟的 JNI 函数：继续执行只会得到错误的结果，直接终止并给出函数表位置
+        template<size_t Slot>
+        void JNICALL unsupportedJni(JNIEnv *) {
+            std::fprintf(stderr, "MockJvm: JNI function #%zu is not mocked\n", Slot);
+            std::abort();
+        }
+
+        template<size_t... Slots>
+        std::array<void *, sizeof...(Slots)> makeUnsupportedJni(std::index_sequence<Slots...>) {
+            return {reinterpret_cast<void *>(&unsupportedJni<Slots>)...};
+        }
+
+        // java.lang.String => java/lang/String
+        std::string dottedName(const std::string &name) {
+            std::string result = name;
+            std::replace(result.begin(), result.end(), '/', '.');
+            return result;
+        }
+
+        bool returnsString(const MockMethod *method) {
+            constexpr std::string_view string_type = ")Ljava/lang/String;";
+            const std::string_view signature = method->signature;
+            return signature.size() >= string_type.size() &&
+                   signature.substr(signature.size() - string_type.size()) == string_type;
+        }
+    }
+
+    // ---------- MockClass ----------
+
+    MockClass::MockClass(MockClass *class_class, std::string name, MockClass *super)
+        : MockObject(Kind::Class, class_class), name(std::move(name)), super(super) {
+        signature = "L" + this->name + ";";
+    }
+
+    MockMethod *MockClass::findMethod(const std::string_view method, const std::string_view method_signature,
+                                      const bool instance) const {
+        std::string key;
+        key.reserve(method.size() + method_signature.size());
+        key.append(method).append(method_signature);
+        for (const MockClass *klass = this; klass; klass = instance ? klass->super : nullptr) {
+            if (const auto it = klass->methods.find(key); it != klass->methods.end()) return it->second.get();
+        }
+        return nullptr;
+    }
+
+    bool MockClass::isSubclassOf(const MockClass *other) const {
+        for (const MockClass *klass = this; klass; klass = klass->super) {
+            if (klass == other) return true;
+        }
+        return false;
+    }
+
+    MockClass *MockClass::of(jobject klass) {
+        MockObject *object = MockObject::of(klass);
+        return object && object->kind == Kind::Class ? static_cast<MockClass *>(object) : nullptr;
+    }
+
+    // ---------- MockJniEnv ----------
+
+    MockJniEnv::MockJniEnv(MockJvm &jvm, const JNINativeInterface_ *functions, MockObject *thread)
+        : handle_{}, jvm_(jvm), thread_(thread) {
+        handle_.env.functions = functions;
+        handle_.self = this;
+    }
+
+    MockObject *MockJniEnv::newLocal(const MockObject::Kind kind, MockClass *klass, std::string text) {
+        auto object = std::make_unique<MockObject>(kind, klass);
+        object->text = std::move(text);
+        frame_.push_back(std::move(object));
+        ++local_refs_;
+        return frame_.back().get();
+    }
+
+    void MockJniEnv::raise(MockClass *klass, std::string message) {
+        auto object = std::make_unique<MockObject>(MockObject::Kind::Throwable, klass);
+        object->text = std::move(message);
+        frame_.push_back(std::move(object));
+        exception_ = frame_.back().get();
+    }
+
+    std::string MockJniEnv::describeException() const {
+        if (!exception_) return {};
+        std::string result = exception_->klass ? dottedName(exception_->klass->name) : "<unknown>";
+        if (!exception_->text.empty()) result.append(": ").append(exception_->text);
+        return result;
+    }
+
+    void MockJniEnv::popTo(const Mark &mark) {
+        if (frame_.size() > mark.objects) frame_.resize(mark.objects);
+        local_refs_ = mark.refs;
+        exception_ = nullptr;
+    }
+
+    // ---------- 函数表 ----------
+
+    struct MockFunctions {
+        static MockJniEnv &env(JNIEnv *jni) { return MockJniEnv::of(jni); }
+
+        static MockObject *object(jobject handle) { return MockObject::of(handle); }
+
+        template<typename T = jobject>
+        static T ref(MockJniEnv &env, MockObject *object) {
+            if (!object) return nullptr;
+            ++env.local_refs_;
+            return reinterpret_cast<T>(object);
+        }
+
+        static MockClass *predefined(MockJniEnv &env, const char *name) {
+            return env.jvm_.findClass(name);
+        }
+
+        // 未模拟的 JVMTI 函数：代理会按错误码降级处理，首次调用时提示函数表中的序号
+        template<size_t Slot>
+        static jvmtiError JNICALL unsupportedJvmti(jvmtiEnv *jvmti) {
+            static std::atomic<bool> reported{false};
+            if (!reported.exchange(true)) {
+                std::fprintf(stderr, "MockJvm: JVMTI function #%zu is not mocked\n", Slot + 1);
+            }
+            MockJvm::of(jvmti).unsupported_calls_.fetch_add(1, std::memory_order_relaxed);
+            return JVMTI_ERROR_NOT_AVAILABLE;
+        }
+
+        template<size_t... Slots>
+        static std::array<void *, sizeof...(Slots)> makeUnsupportedJvmti(std::index_sequence<Slots...>) {
+            return {reinterpret_cast<void *>(&unsupportedJvmti<Slots>)...};
+        }
+
+        // ---------- JNI ----------
+
+        static jint JNICALL getVersion(JNIEnv *) {
+            return JNI_VERSION_1_8;
+        }
+
+        static jclass JNICALL findClass(JNIEnv *jni, const char *name) {
+            auto &e = env(jni);
+            if (MockClass *klass = name ? e.jvm_.findClass(name) : nullptr) return ref<jclass>(e, klass);
+            e.raise(predefined(e, "java/lang/NoClassDefFoundError"), name ? name : "null");
+            return nullptr;
+        }
+
+        static jclass JNICALL getObjectClass(JNIEnv *jni, jobject handle) {
+            MockObject *o = object(handle);
+            return o ? ref<jclass>(env(jni), o->klass) : nullptr;
+        }
+
+        static jboolean JNICALL isInstanceOf(JNIEnv *, jobject handle, jclass klass) {
+            // null 是任何类型的实例
+            if (!handle) return JNI_TRUE;
+            const MockClass *type = MockClass::of(klass);
+            return type && object(handle)->klass && object(handle)->klass->isSubclassOf(type) ? JNI_TRUE : JNI_FALSE;
+        }
+
+        static jboolean JNICALL isSameObject(JNIEnv *, jobject a, jobject b) {
+            return a == b ? JNI_TRUE : JNI_FALSE;
+        }
+
+        static jobject JNICALL newLocalRef(JNIEnv *jni, jobject handle) {
+            return ref(env(jni), object(handle));
+        }
+
+        static void JNICALL deleteLocalRef(JNIEnv *jni, jobject handle) {
+            if (handle) --env(jni).local_refs_;
+        }
+
+        static jobject JNICALL newGlobalRef(JNIEnv *jni, jobject handle) {
+            if (handle) env(jni).jvm_.global_refs_.fetch_add(1, std::memory_order_relaxed);
+            return handle;
+        }
+
+        static void JNICALL deleteGlobalRef(JNIEnv *jni, jobject handle) {
+            if (handle) env(jni).jvm_.global_refs_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        static jboolean JNICALL exceptionCheck(JNIEnv *jni) {
+            return env(jni).exception_ ? JNI_TRUE : JNI_FALSE;
+        }
+
+        static jthrowable JNICALL exceptionOccurred(JNIEnv *jni) {
+            auto &e = env(jni);
+            return ref<jthrowable>(e, e.exception_);
+        }
+
+        static void JNICALL exceptionClear(JNIEnv *jni) {
+            env(jni).exception_ = nullptr;
+        }
+
+        static void JNICALL exceptionDescribe(JNIEnv *jni) {
+            auto &e = env(jni);
+            if (!e.exception_) return;
+            std::fprintf(stderr, "Exception in thread \"%s\" %s\n", e.thread_->text.c_str(),
+                         e.describeException().c_str());
+            e.exception_ = nullptr;
+        }
+
+        static jint JNICALL throwNew(JNIEnv *jni, jclass klass, const char *message) {
+            MockClass *type = MockClass::of(klass);
+            if (!type) return JNI_ERR;
+            env(jni).raise(type, message ? message : "");
+            return JNI_OK;
+        }
+
+        static jsize JNICALL getArrayLength(JNIEnv *, jarray array) {
+            return static_cast<jsize>(object(array)->bytes.size());
+        }
+
+        static jbyteArray JNICALL newByteArray(JNIEnv *jni, const jsize length) {
+            auto &e = env(jni);
+            if (length < 0) {
+                e.raise(predefined(e, "java/lang/NegativeArraySizeException"), std::to_string(length));
+                return nullptr;
+            }
+            MockObject *array = e.newLocal(MockObject::Kind::ByteArray, e.jvm_.byte_array_class);
+            array->bytes.resize(static_cast<size_t>(length));
+            return reinterpret_cast<jbyteArray>(array);
+        }
+
+        static bool checkRegion(MockJniEnv &e, const MockObject *array, const jsize start, const jsize length) {
+            if (start >= 0 && length >= 0 && static_cast<size_t>(start) + static_cast<size_t>(length) <= array->bytes.
+                size()) {
+                return true;
+            }
+            e.raise(predefined(e, "java/lang/ArrayIndexOutOfBoundsException"),
+                    "Array region " + std::to_string(start) + ".." + std::to_string(static_cast<int64_t>(start) + length)
+                    + " out of bounds for length " + std::to_string(array->bytes.size()));
+            return false;
+        }
+
+        static void JNICALL getByteArrayRegion(JNIEnv *jni, jbyteArray array, const jsize start, const jsize length,
+                                               jbyte *buffer) {
+            const MockObject *a = object(array);
+            if (!checkRegion(env(jni), a, start, length) || length == 0) return;
+            std::memcpy(buffer, a->bytes.data() + start, static_cast<size_t>(length));
+        }
+
+        static void JNICALL setByteArrayRegion(JNIEnv *jni, jbyteArray array, const jsize start, const jsize length,
+                                               const jbyte *buffer) {
+            MockObject *a = object(array);
+            if (!checkRegion(env(jni), a, start, length) || length == 0) return;
+            std::memcpy(a->bytes.data() + start, buffer, static_cast<size_t>(length));
+        }
+
+        // 模拟的数组不会移动，元素与临界区访问都直接返回数组存储；与 HotSpot 一致，空数组（以及容量为 0 的直接缓冲区）
+        // 同样返回非空地址
+        static jbyte *storage(MockObject *o) {
+            static jbyte empty;
+            return o->bytes.empty() ? &empty : o->bytes.data();
+        }
+
+        static jbyte *JNICALL getByteArrayElements(JNIEnv *, jbyteArray array, jboolean *is_copy) {
+            if (is_copy) *is_copy = JNI_FALSE;
+            return storage(object(array));
+        }
+
+        static void JNICALL releaseByteArrayElements(JNIEnv *, jbyteArray, jbyte *, jint) {
+        }
+
+        static void *JNICALL getPrimitiveArrayCritical(JNIEnv *, jarray array, jboolean *is_copy) {
+            if (is_copy) *is_copy = JNI_FALSE;
+            return storage(object(array));
+        }
+
+        static void JNICALL releasePrimitiveArrayCritical(JNIEnv *, jarray, void *, jint) {
+        }
+
+        static void *JNICALL getDirectBufferAddress(JNIEnv *, jobject buffer) {
+            MockObject *o = object(buffer);
+            return o && o->kind == MockObject::Kind::DirectBuffer ? storage(o) : nullptr;
+        }
+
+        static jlong JNICALL getDirectBufferCapacity(JNIEnv *, jobject buffer) {
+            const MockObject *o = object(buffer);
+            return o && o->kind == MockObject::Kind::DirectBuffer ? static_cast<jlong>(o->bytes.size()) : -1;
+        }
+
+        static const char *JNICALL getStringUTFChars(JNIEnv *, jstring string, jboolean *is_copy) {
+            if (is_copy) *is_copy = JNI_FALSE;
+            return object(string)->text.c_str();
+        }
+
+        static void JNICALL releaseStringUTFChars(JNIEnv *, jstring, const char *) {
+        }
+
+        static jsize JNICALL getStringUTFLength(JNIEnv *, jstring string) {
+            return static_cast<jsize>(object(string)->text.size());
+        }
+
+        static jstring JNICALL newStringUTF(JNIEnv *jni, const char *text) {
+            if (!text) return nullptr;
+            auto &e = env(jni);
+            return reinterpret_cast<jstring>(e.newLocal(MockObject::Kind::String, e.jvm_.string_class, text));
+        }
+
+        static jfieldID JNICALL getStaticFieldID(JNIEnv *jni, jclass klass, const char *name, const char *) {
+            const MockClass *type = MockClass::of(klass);
+            if (type) {
+                if (const auto it = type->fields.find(name); it != type->fields.end()) return it->second->id();
+            }
+            auto &e = env(jni);
+            e.raise(predefined(e, "java/lang/NoSuchFieldError"), name);
+            return nullptr;
+        }
+
+        template<typename T, T jvalue::*Member>
+        static T JNICALL getStaticField(JNIEnv *, jclass, jfieldID field) {
+            return MockField::of(field)->value.*Member;
+        }
+
+        static jobject JNICALL getStaticObjectField(JNIEnv *jni, jclass, jfieldID field) {
+            return ref(env(jni), MockField::of(field)->object);
+        }
+
+        static jmethodID lookupMethod(JNIEnv *jni, jclass klass, const char *name, const char *signature,
+                                      const bool instance) {
+            const MockClass *type = MockClass::of(klass);
+            if (type && name && signature) {
+                if (MockMethod *method = type->findMethod(name, signature, instance)) return method->id();
+            }
+            auto &e = env(jni);
+            e.raise(predefined(e, "java/lang/NoSuchMethodError"), name ? name : "null");
+            return nullptr;
+        }
+
+        static jmethodID JNICALL getMethodID(JNIEnv *jni, jclass klass, const char *name, const char *signature) {
+            return lookupMethod(jni, klass, name, signature, true);
+        }
+
+        static jmethodID JNICALL getStaticMethodID(JNIEnv *jni, jclass klass, const char *name,
+                                                   const char *signature) {
+            return lookupMethod(jni, klass, name, signature, false);
+        }
+
+        // 执行方法：抛出脚本指定的异常时返回 false
+        static bool invoke(MockJniEnv &e, const MockMethod *method) {
+            if (method->throws.empty()) return true;
+            MockClass *type = e.jvm_.findClass(method->throws);
+            e.raise(type ? type : predefined(e, "java/lang/RuntimeException"), method->name);
+            return false;
+        }
+
+        template<typename T, T jvalue::*Member>
+        static T JNICALL callStatic(JNIEnv *jni, jclass, jmethodID id, va_list) {
+            const MockMethod *method = MockMethod::of(id);
+            if (!invoke(env(jni), method)) return T{};
+            return method->result.*Member;
+        }
+
+        static jobject objectResult(MockJniEnv &e, const MockMethod *method) {
+            if (!invoke(e, method)) return nullptr;
+            if (returnsString(method)) {
+                return e.newLocal(MockObject::Kind::String, e.jvm_.string_class, method->string_result)->handle();
+            }
+            return ref(e, object(method->result.l));
+        }
+
+        static jobject JNICALL callStaticObject(JNIEnv *jni, jclass, jmethodID id, va_list) {
+            return objectResult(env(jni), MockMethod::of(id));
+        }
+
+        static jobject JNICALL callObject(JNIEnv *jni, jobject handle, jmethodID id, va_list) {
+            auto &e = env(jni);
+            const MockMethod *method = MockMethod::of(id);
+            MockObject *self = object(handle);
+            if (!self) {
+                e.raise(predefined(e, "java/lang/NullPointerException"), method->name);
+                return nullptr;
+            }
+            switch (method->builtin) {
+                case MockMethod::Builtin::ToString: {
+                    std::string text;
+                    if (self->kind == MockObject::Kind::String) {
+                        text = self->text;
+                    } else if (self->kind == MockObject::Kind::Class) {
+                        text = "class " + dottedName(static_cast<MockClass *>(self)->name);
+                    } else {
+                        char hash[32];
+                        std::snprintf(hash, sizeof(hash), "@%x",
+                                      static_cast<unsigned>(reinterpret_cast<uintptr_t>(self) >> 4));
+                        text = dottedName(self->klass->name) + hash;
+                    }
+                    return e.newLocal(MockObject::Kind::String, e.jvm_.string_class, std::move(text))->handle();
+                }
+                case MockMethod::Builtin::GetName:
+                    return e.newLocal(MockObject::Kind::String, e.jvm_.string_class,
+                                      dottedName(static_cast<MockClass *>(self)->name))->handle();
+                default:
+                    return objectResult(e, method);
+            }
+        }
+
+        static jobject JNICALL newObject(JNIEnv *jni, jclass klass, jmethodID id, va_list) {
+            auto &e = env(jni);
+            if (!invoke(e, MockMethod::of(id))) return nullptr;
+            return e.newLocal(MockObject::Kind::Object, MockClass::of(klass))->handle();
+        }
+
+        // ---------- JavaVM ----------
+
+        static jint JNICALL getEnv(JavaVM *vm, void **penv, const jint version) {
+            MockJvm &jvm = MockJvm::of(vm);
+            if ((version & 0x30000000) == 0x30000000) {
+                *penv = jvm.jvmti();
+                return JNI_OK;
+            }
+            MockJniEnv *current = jvm.current();
+            *penv = current ? current->env() : nullptr;
+            return current ? JNI_OK : JNI_EDETACHED;
+        }
+
+        static jint JNICALL attachCurrentThread(JavaVM *vm, void **penv, void *args) {
+            const auto *attach_args = static_cast<JavaVMAttachArgs *>(args);
+            const std::string name = attach_args && attach_args->name ? attach_args->name : "Thread";
+            *penv = MockJvm::of(vm).attach(name).env();
+            return JNI_OK;
+        }
+
+        static jint JNICALL detachCurrentThread(JavaVM *) {
+            return JNI_OK;
+        }
+
+        static jint JNICALL destroyJavaVM(JavaVM *) {
+            return JNI_ERR;
+        }
+
+        // ---------- JVMTI ----------
+
+        static jvmtiError JNICALL allocate(jvmtiEnv *jvmti, const jlong size, unsigned char **mem) {
+            if (!mem) return JVMTI_ERROR_NULL_POINTER;
+            if (size < 0) return JVMTI_ERROR_ILLEGAL_ARGUMENT;
+            if (size == 0) {
+                *mem = nullptr;
+                return JVMTI_ERROR_NONE;
+            }
+            *mem = static_cast<unsigned char *>(std::malloc(static_cast<size_t>(size)));
+            if (!*mem) return JVMTI_ERROR_OUT_OF_MEMORY;
+            MockJvm::of(jvmti).allocations_.fetch_add(1, std::memory_order_relaxed);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL deallocate(jvmtiEnv *jvmti, unsigned char *mem) {
+            if (!mem) return JVMTI_ERROR_NONE;
+            std::free(mem);
+            MockJvm::of(jvmti).allocations_.fetch_sub(1, std::memory_order_relaxed);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static char *copyString(jvmtiEnv *jvmti, const std::string &text) {
+            unsigned char *mem = nullptr;
+            if (allocate(jvmti, static_cast<jlong>(text.size() + 1), &mem) != JVMTI_ERROR_NONE) return nullptr;
+            std::memcpy(mem, text.c_str(), text.size() + 1);
+            return reinterpret_cast<char *>(mem);
+        }
+
+        static jvmtiError JNICALL getPotentialCapabilities(jvmtiEnv *, jvmtiCapabilities *capabilities) {
+            if (!capabilities) return JVMTI_ERROR_NULL_POINTER;
+            std::memset(capabilities, 0xFF, sizeof(*capabilities));
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL addCapabilities(jvmtiEnv *jvmti, const jvmtiCapabilities *capabilities) {
+            if (!capabilities) return JVMTI_ERROR_NULL_POINTER;
+            auto *target = reinterpret_cast<unsigned char *>(&MockJvm::of(jvmti).capabilities_);
+            const auto *source = reinterpret_cast<const unsigned char *>(capabilities);
+            for (size_t i = 0; i < sizeof(jvmtiCapabilities); ++i) target[i] |= source[i];
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getCapabilities(jvmtiEnv *jvmti, jvmtiCapabilities *capabilities) {
+            if (!capabilities) return JVMTI_ERROR_NULL_POINTER;
+            *capabilities = MockJvm::of(jvmti).capabilities_;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL setEventCallbacks(jvmtiEnv *jvmti, const jvmtiEventCallbacks *callbacks,
+                                                    const jint size) {
+            auto &target = MockJvm::of(jvmti).callbacks_;
+            target = {};
+            if (callbacks && size > 0) {
+                std::memcpy(&target, callbacks, std::min(sizeof(target), static_cast<size_t>(size)));
+            }
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL setEventNotificationMode(jvmtiEnv *jvmti, const jvmtiEventMode mode,
+                                                           const jvmtiEvent event, jthread, ...) {
+            if (event < JVMTI_MIN_EVENT_TYPE_VAL || event > JVMTI_MAX_EVENT_TYPE_VAL) {
+                return JVMTI_ERROR_INVALID_EVENT_TYPE;
+            }
+            MockJvm::of(jvmti).enabled_[event - JVMTI_MIN_EVENT_TYPE_VAL].store(
+                mode == JVMTI_ENABLE, std::memory_order_relaxed);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL generateEvents(jvmtiEnv *, jvmtiEvent) {
+            // 模拟环境中没有已编译的方法与桩代码
+            return JVMTI_ERROR_NONE;
+        }
+
+        static MockObject *threadOf(jvmtiEnv *jvmti, jthread thread) {
+            if (thread) {
+                MockObject *o = object(thread);
+                return o->kind == MockObject::Kind::Thread ? o : nullptr;
+            }
+            MockJniEnv *current = MockJvm::of(jvmti).current();
+            return current ? current->thread_ : nullptr;
+        }
+
+        static jvmtiError JNICALL getCurrentThread(jvmtiEnv *jvmti, jthread *thread) {
+            MockJniEnv *current = MockJvm::of(jvmti).current();
+            if (!current) return JVMTI_ERROR_UNATTACHED_THREAD;
+            *thread = current->thread();
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getThreadInfo(jvmtiEnv *jvmti, jthread thread, jvmtiThreadInfo *info) {
+            if (!info) return JVMTI_ERROR_NULL_POINTER;
+            const MockObject *t = threadOf(jvmti, thread);
+            if (!t) return JVMTI_ERROR_INVALID_THREAD;
+            *info = {};
+            info->name = copyString(jvmti, t->text);
+            info->priority = 5;
+            info->is_daemon = JNI_FALSE;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getThreadLocalStorage(jvmtiEnv *jvmti, jthread thread, void **data) {
+            if (!data) return JVMTI_ERROR_NULL_POINTER;
+            const MockObject *t = threadOf(jvmti, thread);
+            if (!t) return JVMTI_ERROR_INVALID_THREAD;
+            *data = t->local_storage.load(std::memory_order_acquire);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL setThreadLocalStorage(jvmtiEnv *jvmti, jthread thread, const void *data) {
+            MockObject *t = threadOf(jvmti, thread);
+            if (!t) return JVMTI_ERROR_INVALID_THREAD;
+            t->local_storage.store(const_cast<void *>(data), std::memory_order_release);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getStackTrace(jvmtiEnv *, jthread, jint, jint, jvmtiFrameInfo *, jint *count) {
+            if (!count) return JVMTI_ERROR_NULL_POINTER;
+            *count = 0;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getTag(jvmtiEnv *, jobject handle, jlong *tag) {
+            if (!handle || !tag) return JVMTI_ERROR_NULL_POINTER;
+            *tag = object(handle)->tag.load(std::memory_order_relaxed);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL setTag(jvmtiEnv *, jobject handle, const jlong tag) {
+            if (!handle) return JVMTI_ERROR_NULL_POINTER;
+            object(handle)->tag.store(tag, std::memory_order_relaxed);
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getLoadedClasses(jvmtiEnv *jvmti, jint *count, jclass **classes) {
+            if (!count || !classes) return JVMTI_ERROR_NULL_POINTER;
+            const auto &order = MockJvm::of(jvmti).class_order_;
+            unsigned char *mem = nullptr;
+            if (const jvmtiError err = allocate(jvmti, static_cast<jlong>(order.size() * sizeof(jclass)), &mem);
+                err != JVMTI_ERROR_NONE) {
+                return err;
+            }
+            *classes = reinterpret_cast<jclass *>(mem);
+            for (size_t i = 0; i < order.size(); ++i) (*classes)[i] = order[i]->handle();
+            *count = static_cast<jint>(order.size());
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getClassSignature(jvmtiEnv *jvmti, jclass klass, char **signature,
+                                                    char **generic) {
+            const MockClass *type = MockClass::of(klass);
+            if (!type) return JVMTI_ERROR_INVALID_CLASS;
+            if (signature) *signature = copyString(jvmti, type->signature);
+            if (generic) *generic = nullptr;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getClassLoader(jvmtiEnv *, jclass klass, jobject *loader) {
+            if (!MockClass::of(klass)) return JVMTI_ERROR_INVALID_CLASS;
+            if (!loader) return JVMTI_ERROR_NULL_POINTER;
+            *loader = nullptr; // 全部视为启动类加载器加载
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL isModifiableClass(jvmtiEnv *, jclass klass, jboolean *modifiable) {
+            if (!MockClass::of(klass)) return JVMTI_ERROR_INVALID_CLASS;
+            if (!modifiable) return JVMTI_ERROR_NULL_POINTER;
+            *modifiable = JNI_TRUE;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL retransformClasses(jvmtiEnv *jvmti, const jint count, const jclass *classes) {
+            MockJvm &jvm = MockJvm::of(jvmti);
+            MockJniEnv *current = jvm.current();
+            if (!current) return JVMTI_ERROR_UNATTACHED_THREAD;
+            for (jint i = 0; i < count; ++i) {
+                MockClass *type = MockClass::of(classes[i]);
+                if (!type) return JVMTI_ERROR_INVALID_CLASS;
+                jvm.classFileLoadHook(*current, type->name.c_str(), type->class_file.data(),
+                                      static_cast<jint>(type->class_file.size()), type->handle());
+            }
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getMethodName(jvmtiEnv *jvmti, jmethodID id, char **name, char **signature,
+                                                char **generic) {
+            if (!id) return JVMTI_ERROR_INVALID_METHODID;
+            const MockMethod *method = MockMethod::of(id);
+            if (name) *name = copyString(jvmti, method->name);
+            if (signature) *signature = copyString(jvmti, method->signature);
+            if (generic) *generic = nullptr;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getMethodDeclaringClass(jvmtiEnv *, jmethodID id, jclass *klass) {
+            if (!id) return JVMTI_ERROR_INVALID_METHODID;
+            if (!klass) return JVMTI_ERROR_NULL_POINTER;
+            *klass = MockMethod::of(id)->klass->handle();
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getMethodModifiers(jvmtiEnv *, jmethodID id, jint *modifiers) {
+            if (!id) return JVMTI_ERROR_INVALID_METHODID;
+            if (!modifiers) return JVMTI_ERROR_NULL_POINTER;
+            *modifiers = MockMethod::of(id)->modifiers;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getLineNumberTable(jvmtiEnv *, jmethodID, jint *, jvmtiLineNumberEntry **) {
+            return JVMTI_ERROR_ABSENT_INFORMATION;
+        }
+
+        static jvmtiError JNICALL getPhase(jvmtiEnv *, jvmtiPhase *phase) {
+            if (!phase) return JVMTI_ERROR_NULL_POINTER;
+            *phase = JVMTI_PHASE_LIVE;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL disposeEnvironment(jvmtiEnv *) {
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getVersionNumber(jvmtiEnv *, jint *version) {
+            if (!version) return JVMTI_ERROR_NULL_POINTER;
+            *version = JVMTI_VERSION;
+            return JVMTI_ERROR_NONE;
+        }
+
+        static jvmtiError JNICALL getErrorName(jvmtiEnv *jvmti, const jvmtiError error, char **name) {
+            if (!name) return JVMTI_ERROR_NULL_POINTER;
+            *name = copyString(jvmti, "JVMTI_ERROR_" + std::to_string(static_cast<int>(error)));
+            return JVMTI_ERROR_NONE;
+        }
+
+        static void install(JNINativeInterface_ &t) {
+            static const auto unsupported = makeUnsupportedJni(std::make_index_sequence<JNI_SLOTS>{});
+            std::memcpy(&t, unsupported.data(), sizeof(t));
+            t.GetVersion = &getVersion;
+            t.FindClass = &findClass;
+            t.GetObjectClass = &getObjectClass;
+            t.IsInstanceOf = &isInstanceOf;
+            t.IsSameObject = &isSameObject;
+            t.NewLocalRef = &newLocalRef;
+            t.DeleteLocalRef = &deleteLocalRef;
+            t.NewGlobalRef = &newGlobalRef;
+            t.DeleteGlobalRef = &deleteGlobalRef;
+            t.ExceptionCheck = &exceptionCheck;
+            t.ExceptionOccurred = &exceptionOccurred;
+            t.ExceptionClear = &exceptionClear;
+            t.ExceptionDescribe = &exceptionDescribe;
+            t.ThrowNew = &throwNew;
+            t.GetArrayLength = &getArrayLength;
+            t.NewByteArray = &newByteArray;
+            t.GetByteArrayRegion = &getByteArrayRegion;
+            t.SetByteArrayRegion = &setByteArrayRegion;
+            t.GetByteArrayElements = &getByteArrayElements;
+            t.ReleaseByteArrayElements = &releaseByteArrayElements;
+            t.GetPrimitiveArrayCritical = &getPrimitiveArrayCritical;
+            t.ReleasePrimitiveArrayCritical = &releasePrimitiveArrayCritical;
+            t.GetDirectBufferAddress = &getDirectBufferAddress;
+            t.GetDirectBufferCapacity = &getDirectBufferCapacity;
+            t.GetStringUTFChars = &getStringUTFChars;
+            t.ReleaseStringUTFChars = &releaseStringUTFChars;
+            t.GetStringUTFLength = &getStringUTFLength;
+            t.NewStringUTF = &newStringUTF;
+            t.GetStaticFieldID = &getStaticFieldID;
+            t.GetStaticObjectField = &getStaticObjectField;
+            t.GetStaticBooleanField = &getStaticField<jboolean, &jvalue::z>;
+            t.GetStaticByteField = &getStaticField<jbyte, &jvalue::b>;
+            t.GetStaticCharField = &getStaticField<jchar, &jvalue::c>;
+            t.GetStaticShortField = &getStaticField<jshort, &jvalue::s>;
+            t.GetStaticIntField = &getStaticField<jint, &jvalue::i>;
+            t.GetStaticLongField = &getStaticField<jlong, &jvalue::j>;
+            t.GetStaticFloatField = &getStaticField<jfloat, &jvalue::f>;
+            t.GetStaticDoubleField = &getStaticField<jdouble, &jvalue::d>;
+            t.GetMethodID = &getMethodID;
+            t.GetStaticMethodID = &getStaticMethodID;
+            t.CallStaticObjectMethodV = &callStaticObject;
+            t.CallStaticBooleanMethodV = &callStatic<jboolean, &jvalue::z>;
+            t.CallStaticByteMethodV = &callStatic<jbyte, &jvalue::b>;
+            t.CallStaticCharMethodV = &callStatic<jchar, &jvalue::c>;
+            t.CallStaticShortMethodV = &callStatic<jshort, &jvalue::s>;
+            t.CallStaticIntMethodV = &callStatic<jint, &jvalue::i>;
+            t.CallStaticLongMethodV = &callStatic<jlong, &jvalue::j>;
+            t.CallStaticFloatMethodV = &callStatic<jfloat, &jvalue::f>;
+            t.CallStaticDoubleMethodV = &callStatic<jdouble, &jvalue::d>;
+            t.CallObjectMethodV = &callObject;
+            t.NewObjectV = &newObject;
+        }
+
+        static void install(JNIInvokeInterface_ &t) {
+            t = {};
+            t.GetEnv = &getEnv;
+            t.AttachCurrentThread = &attachCurrentThread;
+            t.AttachCurrentThreadAsDaemon = &attachCurrentThread;
+            t.DetachCurrentThread = &detachCurrentThread;
+            t.DestroyJavaVM = &destroyJavaVM;
+        }
+
+        static void install(jvmtiInterface_1_ &t) {
+            static const auto unsupported = makeUnsupportedJvmti(std::make_index_sequence<JVMTI_SLOTS>{});
+            std::memcpy(&t, unsupported.data(), sizeof(t));
+            t.Allocate = &allocate;
+            t.Deallocate = &deallocate;
+            t.GetPotentialCapabilities = &getPotentialCapabilities;
+            t.AddCapabilities = &addCapabilities;
+            t.GetCapabilities = &getCapabilities;
+            t.SetEventCallbacks = &setEventCallbacks;
+            t.SetEventNotificationMode = &setEventNotificationMode;
+            t.GenerateEvents = &generateEvents;
+            t.GetCurrentThread = &getCurrentThread;
+            t.GetThreadInfo = &getThreadInfo;
+            t.GetThreadLocalStorage = &getThreadLocalStorage;
+            t.SetThreadLocalStorage = &setThreadLocalStorage;
+            t.GetStackTrace = &getStackTrace;
+            t.GetTag = &getTag;
+            t.SetTag = &setTag;
+            t.GetLoadedClasses = &getLoadedClasses;
+            t.GetClassSignature = &getClassSignature;
+            t.GetClassLoader = &getClassLoader;
+            t.IsModifiableClass = &isModifiableClass;
+            t.RetransformClasses = &retransformClasses;
+            t.GetMethodName = &getMethodName;
+            t.GetMethodDeclaringClass = &getMethodDeclaringClass;
+            t.GetMethodModifiers = &getMethodModifiers;
+            t.GetLineNumberTable = &getLineNumberTable;
+            t.GetPhase = &getPhase;
+            t.DisposeEnvironment = &disposeEnvironment;
+            t.GetVersionNumber = &getVersionNumber;
+            t.GetErrorName = &getErrorName;
+        }
+    };
+
+    // ---------- MockJvm ----------
+
+    MockJvm::MockJvm() : instance_(next_instance.fetch_add(1, std::memory_order_relaxed)) {
+        MockFunctions::install(invoke_);
+        MockFunctions::install(native_);
+        MockFunctions::install(jvmti_functions_);
+        vm_.vm.functions = &invoke_;
+        vm_.self = this;
+        jvmti_.env.functions = &jvmti_functions_;
+        jvmti_.self = this;
+
+        object_class = defineClass("java/lang/Object");
+        class_class = defineClass("java/lang/Class");
+        // 先定义的类没有 Class 对象的类型
+        object_class->klass = class_class;
+        class_class->klass = class_class;
+        string_class = defineClass("java/lang/String");
+        thread_class = defineClass("java/lang/Thread");
+        byte_array_class = defineClass("[B");
+        byte_buffer_class = defineClass("java/nio/DirectByteBuffer");
+
+        defineMethod(object_class, "toString", "()Ljava/lang/String;", 0x0001)->builtin = MockMethod::Builtin::ToString;
+        defineMethod(class_class, "getName", "()Ljava/lang/String;", 0x0001)->builtin = MockMethod::Builtin::GetName;
+
+        // 代理与 DataGuard 可能抛出或查找的异常类型
+        MockClass *throwable = defineClass("java/lang/Throwable");
+        MockClass *runtime = defineClass("java/lang/RuntimeException", {}, throwable);
+        MockClass *error = defineClass("java/lang/Error", {}, throwable);
+        for (const char *name: {
+                 "java/lang/NullPointerException", "java/lang/IllegalArgumentException",
+                 "java/lang/IllegalStateException", "java/lang/NegativeArraySizeException",
+             }) {
+            defineClass(name, {}, runtime);
+        }
+        MockClass *index = defineClass("java/lang/IndexOutOfBoundsException", {}, runtime);
+        defineClass("java/lang/ArrayIndexOutOfBoundsException", {}, index);
+        for (const char *name: {
+                 "java/lang/NoClassDefFoundError", "java/lang/NoSuchMethodError", "java/lang/NoSuchFieldError",
+                 "java/lang/OutOfMemoryError",
+             }) {
+            defineClass(name, {}, error);
+        }
+    }
+
+    MockJvm::~MockJvm() = default;
+
+    MockJniEnv &MockJvm::attach(const std::string &thread_name) {
+        if (MockJniEnv *env = current()) return *env;
+        MockObject *thread = newThread(thread_name);
+        std::lock_guard<std::mutex> lock(envs_mutex_);
+        envs_.push_back(std::make_unique<MockJniEnv>(*this, &native_, thread));
+        attachments.push_back({instance_, envs_.back().get()});
+        return *envs_.back();
+    }
+
+    MockJniEnv *MockJvm::current() {
+        for (const auto &attachment: attachments) {
+            if (attachment.instance == instance_) return attachment.env;
+        }
+        return nullptr;
+    }
+
+    MockObject *MockJvm::addObject(std::unique_ptr<MockObject> object) {
+        std::lock_guard<std::mutex> lock(envs_mutex_);
+        objects_.push_back(std::move(object));
+        return objects_.back().get();
+    }
+
+    MockClass *MockJvm::defineClass(const std::string &name, std::vector<unsigned char> class_file,
+                                    MockClass *super) {
+        if (MockClass *existing = findClass(name)) return existing;
+        auto klass = std::make_unique<MockClass>(class_class, name, super ? super : object_class);
+        klass->class_file = std::move(class_file);
+        MockClass *result = klass.get();
+        classes_.emplace(name, std::move(klass));
+        class_order_.push_back(result);
+        return result;
+    }
+
+    MockClass *MockJvm::findClass(const std::string_view name) const {
+        const auto it = classes_.find(std::string(name));
+        return it == classes_.end() ? nullptr : it->second.get();
+    }
+
+    MockMethod *MockJvm::defineMethod(MockClass *klass, const std::string &name, const std::string &signature,
+                                      const jint modifiers) {
+        auto &slot = klass->methods[name + signature];
+        if (!slot) slot = std::make_unique<MockMethod>();
+        slot->klass = klass;
+        slot->name = name;
+        slot->signature = signature;
+        slot->modifiers = modifiers;
+        return slot.get();
+    }
+
+    MockField *MockJvm::defineStaticField(MockClass *klass, const std::string &name, const std::string &descriptor,
+                                          const jvalue value) {
+        auto &slot = klass->fields[name];
+        if (!slot) slot = std::make_unique<MockField>();
+        slot->klass = klass;
+        slot->name = name;
+        slot->descriptor = descriptor;
+        slot->value = value;
+        return slot.get();
+    }
+
+    MockField *MockJvm::defineStaticField(MockClass *klass, const std::string &name, const std::string &value) {
+        MockField *field = defineStaticField(klass, name, "Ljava/lang/String;", jvalue{});
+        field->object = newString(value);
+        field->value.l = field->object->handle();
+        return field;
+    }
+
+    MockObject *MockJvm::newInstance(MockClass *klass) {
+        return addObject(std::make_unique<MockObject>(MockObject::Kind::Object, klass));
+    }
+
+    MockObject *MockJvm::newString(const std::string &text) {
+        auto object = std::make_unique<MockObject>(MockObject::Kind::String, string_class);
+        object->text = text;
+        return addObject(std::move(object));
+    }
+
+    MockObject *MockJvm::newThread(const std::string &name) {
+        auto object = std::make_unique<MockObject>(MockObject::Kind::Thread, thread_class);
+        object->text = name;
+        return addObject(std::move(object));
+    }
+
+    MockObject *MockJvm::newByteArray(std::vector<jbyte> content) {
+        auto object = std::make_unique<MockObject>(MockObject::Kind::ByteArray, byte_array_class);
+        object->bytes = std::move(content);
+        return addObject(std::move(object));
+    }
+
+    MockObject *MockJvm::newDirectBuffer(const size_t capacity) {
+        auto object = std::make_unique<MockObject>(MockObject::Kind::DirectBuffer, byte_buffer_class);
+        object->bytes.resize(capacity);
+        return addObject(std::move(object));
+    }
+
+    bool MockJvm::enabled(const jvmtiEvent event) const {
+        if (event < JVMTI_MIN_EVENT_TYPE_VAL || event > JVMTI_MAX_EVENT_TYPE_VAL) return false;
+        return enabled_[event - JVMTI_MIN_EVENT_TYPE_VAL].load(std::memory_order_relaxed);
+    }
+
+    jint MockJvm::classFileLoadHook(MockJniEnv &env, const char *name, const unsigned char *data, const jint length,
+                                    jclass class_being_redefined) {
+        if (!enabled(JVMTI_EVENT_CLASS_FILE_LOAD_HOOK) || !callbacks_.ClassFileLoadHook) return -1;
+        const auto mark = env.mark();
+        jint new_length = -1;
+        unsigned char *new_data = nullptr;
+        callbacks_.ClassFileLoadHook(jvmti(), env.env(), class_being_redefined, nullptr, name, nullptr, length, data,
+                                     &new_length, &new_data);
+        env.popTo(mark);
+        if (!new_data) return -1;
+        // 替换的类文件由 JVM 解析后释放
+        MockFunctions::deallocate(jvmti(), new_data);
+        return new_length;
+    }
+
+    void *MockJvm::nativeMethodBind(MockJniEnv &env, MockMethod *method, void *address) {
+        if (!enabled(JVMTI_EVENT_NATIVE_METHOD_BIND) || !callbacks_.NativeMethodBind) return address;
+        const auto mark = env.mark();
+        void *new_address = address;
+        callbacks_.NativeMethodBind(jvmti(), env.env(), env.thread(), method->id(), address, &new_address);
+        env.popTo(mark);
+        return new_address;
+    }
+
+    void MockJvm::classLoad(MockJniEnv &env, MockClass *klass) {
+        if (!enabled(JVMTI_EVENT_CLASS_LOAD) || !callbacks_.ClassLoad) return;
+        const auto mark = env.mark();
+        callbacks_.ClassLoad(jvmti(), env.env(), env.thread(), klass->handle());
+        env.popTo(mark);
+    }
+
+    void MockJvm::classPrepare(MockJniEnv &env, MockClass *klass) {
+        if (!enabled(JVMTI_EVENT_CLASS_PREPARE) || !callbacks_.ClassPrepare) return;
+        const auto mark = env.mark();
+        callbacks_.ClassPrepare(jvmti(), env.env(), env.thread(), klass->handle());
+        env.popTo(mark);
+    }
+}
@@ -0,0 +1,296 @@
+#ifndef MOCKJVM_H
+#define MOCKJVM_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <jni.h>
+#include <jvmti.h>
+
+// 模拟 JVM：提供 JavaVM / jvmtiEnv / JNIEnv 函数表，元数据（类签名、方法名、线程信息、数组内容）由测试脚本定义，
+// 无需启动 JVM 即可在普通可执行程序中以每秒数百万次的频率驱动代理的事件回调与 native 方法。
+// 只模拟代理用到的函数，其余 JVMTI 函数返回 JVMTI_ERROR_NOT_AVAILABLE，其余 JNI 函数打印函数表偏移后终止进程。
+// 元数据须在驱动事件之前定义，之后只读，可在多个线程上并发驱动（每个线程使用自己的 JNIEnv）
+namespace bench {
+    struct MockClass;
+
+    // Java 对象：jobject / jclass / jstring / jbyteArray / jthread 句柄直接指向该结构
+    struct MockObject {
+        enum class Kind : uint8_t { Object, Class, String, ByteArray, DirectBuffer, Thread, Throwable };
+
+        const Kind kind;
+        MockClass *klass;
+        std::string text; // String 内容、Thread 名称、Throwable 消息
+        std::vector<jbyte> bytes; // byte[] 内容、直接缓冲区的存储
+        std::atomic<jlong> tag{0};
+        std::atomic<void *> local_storage{nullptr}; // JVMTI 线程本地存储（Thread）
+
+        MockObject(const Kind kind, MockClass *klass) : kind(kind), klass(klass) {
+        }
+
+        virtual ~MockObject() = default;
+
+        MockObject(const MockObject &) = delete;
+
+        MockObject &operator=(const MockObject &) = delete;
+
+        jobject handle() { return reinterpret_cast<jobject>(this); }
+
+        static MockObject *of(jobject object) { return reinterpret_cast<MockObject *>(object); }
+    };
+
+    // 方法：jmethodID 直接指向该结构。静态方法调用返回 result / string_result，throws 非空时改为抛出该异常
+    struct MockMethod {
+        enum class Builtin : uint8_t { None, ToString, GetName };
+
+        MockClass *klass = nullptr;
+        std::string name;
+        std::string signature;
+        jint modifiers = 0;
+        jvalue result{};
+        std::string string_result; // 返回类型为 String 时每次调用创建新字符串（局部引用）
+        std::string throws; // 异常类内部名称，例如 java/lang/IllegalStateException
+        Builtin builtin = Builtin::None;
+
+        jmethodID id() { return reinterpret_cast<jmethodID>(this); }
+
+        static MockMethod *of(jmethodID method) { return reinterpret_cast<MockMethod *>(method); }
+    };
+
+    // 静态字段：jfieldID 直接指向该结构，引用类型读取 object
+    struct MockField {
+        MockClass *klass = nullptr;
+        std::string name;
+        std::string descriptor;
+        jvalue value{};
+        MockObject *object = nullptr;
+
+        jfieldID id() { return reinterpret_cast<jfieldID>(this); }
+
+        static MockField *of(jfieldID field) { return reinterpret_cast<MockField *>(field); }
+    };
+
+    struct MockClass final : MockObject {
+        std::string name; // 内部名称，例如 com/example/Foo
+        std::string signature; // Lcom/example/Foo;
+        MockClass *super = nullptr;
+        std::vector<unsigned char> class_file; // RetransformClasses 时交给 ClassFileLoadHook 的类文件
+        std::unordered_map<std::string, std::unique_ptr<MockMethod> > methods; // 名称 + 签名 => 方法
+        std::unordered_map<std::string, std::unique_ptr<MockField> > fields; // 名称 => 字段
+
+        MockClass(MockClass *class_class, std::string name, MockClass *super);
+
+        jclass handle() { return reinterpret_cast<jclass>(this); }
+
+        // 按名称与签名查找方法，instance 为 true 时沿父类查找
+        MockMethod *findMethod(std::string_view method, std::string_view method_signature, bool instance) const;
+
+        bool isSubclassOf(const MockClass *other) const;
+
+        static MockClass *of(jobject klass);
+    };
+
+    class MockJvm;
+
+    // 线程的 JNIEnv：返回给代理的新对象（字符串、数组、异常）保存在当前帧中，
+    // releaseLocals() 模拟 native 方法或事件回调返回时释放局部引用
+    class MockJniEnv {
+    private:
+        struct Handle {
+            JNIEnv env;
+            MockJniEnv *self;
+        };
+
+        Handle handle_;
+        MockJvm &jvm_;
+        MockObject *thread_;
+        MockObject *exception_ = nullptr;
+        std::vector<std::unique_ptr<MockObject> > frame_;
+        int64_t local_refs_ = 0;
+
+        friend struct MockFunctions;
+
+    public:
+        MockJniEnv(MockJvm &jvm, const JNINativeInterface_ *functions, MockObject *thread);
+
+        MockJniEnv(const MockJniEnv &) = delete;
+
+        MockJniEnv &operator=(const MockJniEnv &) = delete;
+
+        JNIEnv *env() { return &handle_.env; }
+
+        MockJvm &jvm() const { return jvm_; }
+
+        // 所属线程对象（jthread）
+        jthread thread() const { return reinterpret_cast<jthread>(thread_); }
+
+        // 在当前帧创建对象并返回局部引用
+        MockObject *newLocal(MockObject::Kind kind, MockClass *klass, std::string text = {});
+
+        // 挂起一个异常（ThrowNew）
+        void raise(MockClass *klass, std::string message);
+
+        bool hasException() const { return exception_ != nullptr; }
+
+        // 挂起异常的类名与消息，没有异常时返回空字符串
+        std::string describeException() const;
+
+        // 尚未 DeleteLocalRef 的局部引用数量（代理在循环中泄漏局部引用时持续增长）
+        int64_t localRefs() const { return local_refs_; }
+
+        // 当前帧持有的对象数量
+        size_t frameSize() const { return frame_.size(); }
+
+        // 局部引用帧位置，事件回调返回时回到进入前的位置（PushLocalFrame / PopLocalFrame）
+        struct Mark {
+            size_t objects;
+            int64_t refs;
+        };
+
+        Mark mark() const { return {frame_.size(), local_refs_}; }
+
+        void popTo(const Mark &mark);
+
+        // 模拟 native 方法返回：释放当前帧的全部对象与局部引用，并清除挂起的异常
+        void releaseLocals() { popTo({0, 0}); }
+
+        static MockJniEnv &of(JNIEnv *env) { return *reinterpret_cast<Handle *>(env)->self; }
+    };
+
+    class MockJvm {
+    private:
+        struct VmHandle {
+            JavaVM vm;
+            MockJvm *self;
+        };
+
+        struct JvmtiHandle {
+            jvmtiEnv env;
+            MockJvm *self;
+        };
+
+        const uint64_t instance_;
+        JNIInvokeInterface_ invoke_{};
+        JNINativeInterface_ native_{};
+        jvmtiInterface_1_ jvmti_functions_{};
+        VmHandle vm_{};
+        JvmtiHandle jvmti_{};
+
+        std::unordered_map<std::string, std::unique_ptr<MockClass> > classes_;
+        std::vector<MockClass *> class_order_; // 按定义顺序（GetLoadedClasses）
+        std::vector<std::unique_ptr<MockObject> > objects_; // 脚本定义的字符串、线程、数组
+        std::mutex envs_mutex_;
+        std::vector<std::unique_ptr<MockJniEnv> > envs_;
+
+        jvmtiEventCallbacks callbacks_{};
+        std::array<std::atomic<bool>, JVMTI_MAX_EVENT_TYPE_VAL - JVMTI_MIN_EVENT_TYPE_VAL + 1> enabled_{};
+        jvmtiCapabilities capabilities_{};
+        std::atomic<int64_t> allocations_{0};
+        std::atomic<int64_t> global_refs_{0};
+        std::atomic<uint64_t> unsupported_calls_{0};
+
+        friend struct MockFunctions;
+
+        MockObject *addObject(std::unique_ptr<MockObject> object);
+
+    public:
+        // 预定义的类
+        MockClass *object_class = nullptr;
+        MockClass *class_class = nullptr;
+        MockClass *string_class = nullptr;
+        MockClass *thread_class = nullptr;
+        MockClass *byte_array_class = nullptr;
+        MockClass *byte_buffer_class = nullptr;
+
+        MockJvm();
+
+        ~MockJvm();
+
+        MockJvm(const MockJvm &) = delete;
+
+        MockJvm &operator=(const MockJvm &) = delete;
+
+        JavaVM *vm() { return &vm_.vm; }
+
+        jvmtiEnv *jvmti() { return &jvmti_.env; }
+
+        // 当前线程的 JNIEnv，首次调用时附加当前线程（线程名 thread_name）
+        MockJniEnv &attach(const std::string &thread_name = "main");
+
+        // 当前线程已附加时返回其 JNIEnv，否则返回 nullptr
+        MockJniEnv *current();
+
+        JNIEnv *jni() { return attach().env(); }
+
+        // ---------- 元数据脚本 ----------
+
+        // 定义类（内部名称），super 为空时继承 java/lang/Object；重复定义返回已有的类
+        MockClass *defineClass(const std::string &name, std::vector<unsigned char> class_file = {},
+                               MockClass *super = nullptr);
+
+        MockClass *findClass(std::string_view name) const;
+
+        MockMethod *defineMethod(MockClass *klass, const std::string &name, const std::string &signature,
+                                 jint modifiers);
+
+        // 基本类型静态字段
+        MockField *defineStaticField(MockClass *klass, const std::string &name, const std::string &descriptor,
+                                     jvalue value);
+
+        // String 静态字段
+        MockField *defineStaticField(MockClass *klass, const std::string &name, const std::string &value);
+
+        // 以下对象由 MockJvm 持有，不随 releaseLocals 释放
+        MockObject *newInstance(MockClass *klass);
+
+        MockObject *newString(const std::string &text);
+
+        MockObject *newThread(const std::string &name);
+
+        MockObject *newByteArray(std::vector<jbyte> content);
+
+        MockObject *newDirectBuffer(size_t capacity);
+
+        // ---------- 事件 ----------
+
+        const jvmtiEventCallbacks &callbacks() const { return callbacks_; }
+
+        bool enabled(jvmtiEvent event) const;
+
+        // 以下事件在事件已启用时触发，回调中创建的局部引用在返回后释放，挂起的异常被清除
+
+        // 返回代理替换后的类文件长度（未替换时为 -1），替换的类文件随即释放
+        jint classFileLoadHook(MockJniEnv &env, const char *name, const unsigned char *data, jint length,
+                               jclass class_being_redefined = nullptr);
+
+        // 返回代理替换后的地址（未替换时为 address）
+        void *nativeMethodBind(MockJniEnv &env, MockMethod *method, void *address);
+
+        void classLoad(MockJniEnv &env, MockClass *klass);
+
+        void classPrepare(MockJniEnv &env, MockClass *klass);
+
+        // ---------- 检查 ----------
+
+        const jvmtiCapabilities &capabilities() const { return capabilities_; }
+
+        // Allocate 尚未 Deallocate 的内存块数量
+        int64_t outstandingAllocations() const { return allocations_.load(std::memory_order_relaxed); }
+
+        int64_t globalRefs() const { return global_refs_.load(std::memory_order_relaxed); }
+
+        // 调用未模拟的 JVMTI 函数的次数
+        uint64_t unsupportedCalls() const { return unsupported_calls_.load(std::memory_order_relaxed); }
+
+        static MockJvm &of(jvmtiEnv *env) { return *reinterpret_cast<JvmtiHandle *>(env)->self; }
+
+        static MockJvm &of(JavaVM *vm) { return *reinterpret_cast<VmHandle *>(vm)->self; }
+    };
+}
+
+#endif //MOCKJVM_H
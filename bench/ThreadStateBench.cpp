@@ -0,0 +1,137 @@
+// 线程状态池负载测试：模拟每分钟上百万个短生命周期虚拟线程（JDK 21+）
+// 每个虚拟线程：VirtualThreadStart → 若干次事件回调读取线程状态 → VirtualThreadEnd 归还。
+// 状态池已分配的数量应只与同时存活的线程数相关，与累计创建的线程数无关
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "Bench.h"
+#include "MockJvm.h"
+#include "../src/jvmti/ThreadState.h"
+
+using namespace jvmti_tools;
+
+namespace {
+    // 进程的峰值常驻内存（KiB），不支持时返回 0
+    long maxResidentKb() {
+#if defined(__unix__) || defined(__APPLE__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    struct Options {
+        size_t carriers; // 载体线程数
+        size_t live_per_carrier; // 每个载体线程上同时存活的虚拟线程数
+        size_t virtual_threads; // 累计创建的虚拟线程数
+        size_t events; // 每个虚拟线程触发的事件数
+        bool release; // 是否处理 VirtualThreadEnd
+    };
+
+    struct Result {
+        double seconds;
+        size_t size;
+        size_t capacity;
+        long rss_kb;
+    };
+
+    // 线程本地存储由模拟 JVM 的线程对象持有；虚拟线程的线程对象由载体线程创建，结束后即释放，相当于被 GC 回收
+    Result run(bench::MockJvm &jvm, ThreadStates &states, const Options &options) {
+        jvmtiEnv *jvmti = jvm.jvmti();
+        const long rss_before = maxResidentKb();
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> carriers;
+        for (size_t c = 0; c < options.carriers; ++c) {
+            carriers.emplace_back([&, c] {
+                const size_t total = options.virtual_threads / options.carriers +
+                                     (c < options.virtual_threads % options.carriers ? 1 : 0);
+                // 环形槽位模拟载体线程上交替调度的虚拟线程
+                std::vector<std::unique_ptr<bench::MockObject> > live(options.live_per_carrier);
+                std::vector<size_t> remaining(options.live_per_carrier, 0);
+                size_t started = 0;
+                size_t finished = 0;
+                size_t slot = 0;
+                while (finished < total) {
+                    if (!live[slot] && started < total) {
+                        // VirtualThreadStart
+                        live[slot] = std::make_unique<bench::MockObject>(bench::MockObject::Kind::Thread,
+                                                                         jvm.thread_class);
+                        remaining[slot] = options.events;
+                        ++started;
+                    }
+                    if (live[slot]) {
+                        const auto thread = static_cast<jthread>(live[slot]->handle());
+                        ThreadState *state = states.get(jvmti, thread);
+                        if (remaining[slot] > 0) {
+                            // 事件回调：读写线程状态
+                            state->contended_since = static_cast<int64_t>(remaining[slot]);
+                            state->call_stack.push_back({});
+                            state->call_stack.pop_back();
+                            bench::doNotOptimize(state);
+                            --remaining[slot];
+                        } else {
+                            // VirtualThreadEnd：release 在本地存储中留下结束标记，线程对象回收后随之消失
+                            if (options.release) states.release(jvmti, thread);
+                            live[slot].reset();
+                            ++finished;
+                        }
+                    }
+                    slot = (slot + 1) % live.size();
+                }
+            });
+        }
+        for (auto &carrier: carriers) carrier.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return {elapsed.count(), states.size(), states.capacity(), maxResidentKb() - rss_before};
+    }
+
+    void print(const char *name, const Options &options, const Result &result) {
+        std::printf("%-28s threads=%-8zu live=%-6zu %8.0f threads/s  in-use=%-6zu pooled=%-8zu maxrss +%ldKiB\n",
+                    name, options.virtual_threads, options.carriers * options.live_per_carrier,
+                    static_cast<double>(options.virtual_threads) / result.seconds, result.size, result.capacity,
+                    result.rss_kb);
+    }
+}
+
+int main() {
+    bench::MockJvm jvm;
+
+    const size_t carriers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    // 1. 1M 个虚拟线程，处理 VirtualThreadEnd：池大小只取决于同时存活的线程数
+    ThreadStates pooled;
+    const Options churn{carriers, 256, 1000000, 8, true};
+    const auto result = run(jvm, pooled, churn);
+    print("virtual_threads/pooled", churn, result);
+
+    // 2. 再跑一轮：池已预热，不应再分配
+    const auto again = run(jvm, pooled, churn);
+    print("virtual_threads/pooled#2", churn, again);
+
+    // 3. 对照：只处理平台线程的 ThreadEnd（旧版本行为），虚拟线程的状态无法归还
+    ThreadStates leaked;
+    const Options legacy{carriers, 256, 100000, 8, false};
+    print("virtual_threads/no_end_event", legacy, run(jvm, leaked, legacy));
+
+    const size_t live = churn.carriers * churn.live_per_carrier;
+    if (result.size != 0 || again.size != 0 || result.capacity > live * 2 || again.capacity != result.capacity) {
+        std::printf("FAIL: thread state pool grows with virtual thread churn\n");
+        return 1;
+    }
+    std::printf("ok: pooled states bounded by live threads (%zu <= %zu)\n", again.capacity, live * 2);
+    return 0;
+}
@@ -0,0 +1,197 @@
+import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardCopyOption;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.function.Supplier;
+import java.util.jar.Attributes;
+import java.util.jar.JarEntry;
+import java.util.jar.JarOutputStream;
+import java.util.jar.Manifest;
+
+/**
+ * 生成启动基准使用的合成类语料 jar，不需要 javac：类文件直接按 class 文件格式写出。
+ * <p>
+ * 每 100 个类中前 included_percent 个放在代理默认包含的包（com/fr/stable/synthetic）下，其余放在 org/synthetic 下；
+ * 包含的类中前 encrypted_percent 个以非 0xCAFEBABE 头部写出（模拟加密类），加载时 ClassFileLoadHook 仍会收到这些字节，
+ * 随后 JVM 拒绝定义（ClassFormatError）。类名清单写入 META-INF/startup-corpus.idx，每行 "内部类名\tP|E"。
+ * <p>
+ * 用法：java StartupCorpus.java &lt;输出 jar&gt; &lt;类数量&gt; [encrypted_percent=5] [included_percent=50]
+ */
+public class StartupCorpus {
+    static final String INDEX = "META-INF/startup-corpus.idx";
+    static final byte[] ENCRYPTED_MAGIC = {'F', 'R', 'C', 'E'};
+    static final int CLASSES_PER_PACKAGE = 500;
+    static final int MEMBERS = 4;
+
+    public static void main(String[] args) throws IOException {
+        if (args.length < 2) {
+            System.err.println("usage: java StartupCorpus.java <out.jar> <classes> [encrypted_percent] [included_percent]");
+            System.exit(2);
+        }
+        Path out = Paths.get(args[0]);
+        int classes = Integer.parseInt(args[1]);
+        int includedPercent = args.length > 3 ? clamp(Integer.parseInt(args[3])) : 50;
+        int encryptedPercent = Math.min(args.length > 2 ? clamp(Integer.parseInt(args[2])) : 5, includedPercent);
+
+        if (out.getParent() != null) Files.createDirectories(out.getParent());
+        Manifest manifest = new Manifest();
+        manifest.getMainAttributes().put(Attributes.Name.MANIFEST_VERSION, "1.0");
+        Path tmp = Paths.get(out + ".tmp");
+        StringBuilder index = new StringBuilder();
+        int encrypted = 0;
+        try (OutputStream file = Files.newOutputStream(tmp); JarOutputStream jar = new JarOutputStream(file, manifest)) {
+            for (int i = 0; i < classes; i++) {
+                int slot = i % 100;
+                boolean included = slot < includedPercent;
+                boolean isEncrypted = slot < encryptedPercent;
+                String pkg = (included ? "com/fr/stable/synthetic/p" : "org/synthetic/p") + (i / CLASSES_PER_PACKAGE);
+                String name = pkg + "/C" + i;
+                byte[] data = classFile(name, i);
+                if (isEncrypted) {
+                    encrypt(data);
+                    encrypted++;
+                }
+                jar.putNextEntry(new JarEntry(name + ".class"));
+                jar.write(data);
+                jar.closeEntry();
+                index.append(name).append('\t').append(isEncrypted ? 'E' : 'P').append('\n');
+            }
+            jar.putNextEntry(new JarEntry(INDEX));
+            jar.write(index.toString().getBytes(StandardCharsets.UTF_8));
+            jar.closeEntry();
+        }
+        Files.move(tmp, out, StandardCopyOption.REPLACE_EXISTING);
+        System.out.printf("%s: %d classes, %d encrypted%n", out, classes, encrypted);
+    }
+
+    static int clamp(int percent) {
+        return Math.max(0, Math.min(100, percent));
+    }
+
+    // 替换魔数并异或其余字节
+    static void encrypt(byte[] data) {
+        System.arraycopy(ENCRYPTED_MAGIC, 0, data, 0, ENCRYPTED_MAGIC.length);
+        for (int i = ENCRYPTED_MAGIC.length; i < data.length; i++) data[i] ^= 0x5A;
+    }
+
+    /**
+     * public class &lt;name&gt;：MEMBERS 个 public static int 字段、MEMBERS 个返回常量的 public static int m&lt;k&gt;()，
+     * 以及返回字符串常量的 public static String text()。版本 52（Java 8），不需要 StackMapTable
+     */
+    static byte[] classFile(String name, int seed) throws IOException {
+        ConstantPool pool = new ConstantPool();
+        int thisClass = pool.classRef(name);
+        int superClass = pool.classRef("java/lang/Object");
+        int code = pool.utf8("Code");
+        int intType = pool.utf8("I");
+        int intMethod = pool.utf8("()I");
+        int stringMethod = pool.utf8("()Ljava/lang/String;");
+        int text = pool.string("synthetic class " + name.replace('/', '.') + " #" + seed);
+        int[] fields = new int[MEMBERS];
+        int[] methods = new int[MEMBERS];
+        for (int k = 0; k < MEMBERS; k++) {
+            fields[k] = pool.utf8("f" + k);
+            methods[k] = pool.utf8("m" + k);
+        }
+        int textName = pool.utf8("text");
+
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream(512);
+        DataOutputStream out = new DataOutputStream(bytes);
+        out.writeInt(0xCAFEBABE);
+        out.writeShort(0);
+        out.writeShort(52);
+        pool.write(out);
+        out.writeShort(0x0021); // ACC_PUBLIC | ACC_SUPER
+        out.writeShort(thisClass);
+        out.writeShort(superClass);
+        out.writeShort(0); // interfaces
+
+        out.writeShort(MEMBERS);
+        for (int k = 0; k < MEMBERS; k++) {
+            out.writeShort(0x0009); // ACC_PUBLIC | ACC_STATIC
+            out.writeShort(fields[k]);
+            out.writeShort(intType);
+            out.writeShort(0);
+        }
+
+        out.writeShort(MEMBERS + 1);
+        for (int k = 0; k < MEMBERS; k++) {
+            int value = (seed * 31 + k) & 0x7FFF;
+            // sipush value; ireturn
+            method(out, methods[k], intMethod, code,
+                    new byte[]{0x11, (byte) (value >> 8), (byte) value, (byte) 0xAC});
+        }
+        // ldc_w text; areturn
+        method(out, textName, stringMethod, code,
+                new byte[]{0x13, (byte) (text >> 8), (byte) text, (byte) 0xB0});
+
+        out.writeShort(0); // attributes
+        out.flush();
+        return bytes.toByteArray();
+    }
+
+    static void method(DataOutputStream out, int name, int descriptor, int code, byte[] bytecode) throws IOException {
+        out.writeShort(0x0009);
+        out.writeShort(name);
+        out.writeShort(descriptor);
+        out.writeShort(1);
+        out.writeShort(code);
+        out.writeInt(12 + bytecode.length);
+        out.writeShort(1); // max_stack
+        out.writeShort(0); // max_locals
+        out.writeInt(bytecode.length);
+        out.write(bytecode);
+        out.writeShort(0); // exception_table
+        out.writeShort(0); // attributes
+    }
+
+    // 常量池：按内容去重，索引从 1 开始
+    static final class ConstantPool {
+        private final List<byte[]> entries = new ArrayList<>();
+        private final Map<String, Integer> indexes = new HashMap<>();
+
+        int utf8(String value) {
+            return add("U" + value, () -> {
+                byte[] text = value.getBytes(StandardCharsets.UTF_8);
+                byte[] entry = new byte[3 + text.length];
+                entry[0] = 1;
+                entry[1] = (byte) (text.length >> 8);
+                entry[2] = (byte) text.length;
+                System.arraycopy(text, 0, entry, 3, text.length);
+                return entry;
+            });
+        }
+
+        int classRef(String name) {
+            int utf8 = utf8(name);
+            return add("C" + name, () -> new byte[]{7, (byte) (utf8 >> 8), (byte) utf8});
+        }
+
+        int string(String value) {
+            int utf8 = utf8(value);
+            return add("S" + value, () -> new byte[]{8, (byte) (utf8 >> 8), (byte) utf8});
+        }
+
+        private int add(String key, Supplier<byte[]> entry) {
+            Integer index = indexes.get(key);
+            if (index != null) return index;
+            entries.add(entry.get());
+            indexes.put(key, entries.size());
+            return entries.size();
+        }
+
+        void write(DataOutputStream out) throws IOException {
+            out.writeShort(entries.size() + 1);
+            for (byte[] entry : entries) out.write(entry);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+import java.io.BufferedReader;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.InputStreamReader;
+import java.lang.management.ManagementFactory;
+import java.lang.management.ThreadInfo;
+import java.lang.management.ThreadMXBean;
+import java.lang.reflect.Method;
+import java.nio.charset.StandardCharsets;
+import java.time.Instant;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * 启动基准的主类：按 META-INF/startup-corpus.idx 的顺序加载（并初始化）语料中的全部类，输出一行结果：
+ * <pre>
+ * STARTUP time_to_main_ms=.. class_load_ms=.. jvm_class_load_ms=.. loaded=.. rejected=.. jvm_classes=..
+ *         main_cpu_ms=.. agent_thread_cpu_ms=..
+ * </pre>
+ * time_to_main_ms 为启动脚本传入的 -Dstartup.launch_ns（Unix 纪元纳秒）到进入 main 的时间；
+ * jvm_class_load_ms 为 HotSpot 统计的全部类加载耗时（需要 --add-exports java.management/sun.management=ALL-UNNAMED，
+ * 不可用时为 -1）；agent_thread_cpu_ms 为代理线程（jvmti-*）的 CPU 时间，回调本身的开销计入触发事件的线程
+ */
+public class StartupMain {
+    static final String INDEX = "META-INF/startup-corpus.idx";
+
+    public static void main(String[] args) throws IOException {
+        Instant entered = Instant.now();
+        long launch = Long.getLong("startup.launch_ns", 0L);
+        double timeToMain = launch > 0
+                ? ((entered.getEpochSecond() * 1_000_000_000L + entered.getNano()) - launch) / 1e6 : -1;
+
+        ClassLoader loader = StartupMain.class.getClassLoader();
+        List<String> names = readIndex(loader);
+
+        long start = System.nanoTime();
+        int loaded = 0;
+        int rejected = 0;
+        for (String name : names) {
+            try {
+                Class.forName(name, true, loader);
+                loaded++;
+            } catch (LinkageError | ClassNotFoundException e) {
+                // 加密的类不是合法的类文件
+                rejected++;
+            }
+        }
+        double classLoad = (System.nanoTime() - start) / 1e6;
+
+        double mainCpu = ProcessHandle.current().info().totalCpuDuration().map(d -> d.toNanos() / 1e6).orElse(-1.0);
+        System.out.printf(Locale.ROOT,
+                "STARTUP time_to_main_ms=%.2f class_load_ms=%.2f jvm_class_load_ms=%d loaded=%d rejected=%d "
+                        + "jvm_classes=%d main_cpu_ms=%.2f agent_thread_cpu_ms=%.2f%n",
+                timeToMain, classLoad, jvmClassLoadingTime(), loaded, rejected,
+                ManagementFactory.getClassLoadingMXBean().getTotalLoadedClassCount(), mainCpu, agentThreadCpu());
+    }
+
+    static List<String> readIndex(ClassLoader loader) throws IOException {
+        List<String> names = new ArrayList<>();
+        try (InputStream in = loader.getResourceAsStream(INDEX)) {
+            if (in == null) throw new IOException(INDEX + " not found on class path");
+            BufferedReader reader = new BufferedReader(new InputStreamReader(in, StandardCharsets.UTF_8));
+            for (String line; (line = reader.readLine()) != null; ) {
+                int tab = line.indexOf('\t');
+                if (tab > 0) names.add(line.substring(0, tab).replace('/', '.'));
+            }
+        }
+        return names;
+    }
+
+    // sun.management.HotspotClassLoadingMBean#getClassLoadingTime（毫秒）
+    static long jvmClassLoadingTime() {
+        try {
+            Class<?> helper = Class.forName("sun.management.ManagementFactoryHelper");
+            Object bean = helper.getMethod("getHotspotClassLoadingMBean").invoke(null);
+            Method time = Class.forName("sun.management.HotspotClassLoadingMBean").getMethod("getClassLoadingTime");
+            return (Long) time.invoke(bean);
+        } catch (ReflectiveOperationException | RuntimeException e) {
+            return -1;
+        }
+    }
+
+    static double agentThreadCpu() {
+        ThreadMXBean threads = ManagementFactory.getThreadMXBean();
+        if (!threads.isThreadCpuTimeSupported()) return -1;
+        long total = 0;
+        for (ThreadInfo info : threads.getThreadInfo(threads.getAllThreadIds())) {
+            if (info == null || !info.getThreadName().startsWith("jvmti-")) continue;
+            long cpu = threads.getThreadCpuTime(info.getThreadId());
+            if (cpu > 0) total += cpu;
+        }
+        return total / 1e6;
+    }
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/env bash
+# JVM 启动开销基准：生成合成类语料（默认 1k/10k/50k 个类，部分为非 0xCAFEBABE 头部的“加密”类），
+# 分别在无代理、代理各模式（filter / dump / trace / all）与各功能单独启用时启动 JVM 加载全部语料，
+# 输出各配置的中位数：进入 main 的时间、类加载耗时与代理 CPU 时间（进程 CPU 减去无代理时的进程 CPU）。
+# 用于决定生产环境可以启用哪些代理功能。需要 JDK 11+（单文件源码启动、ProcessHandle）。
+#
+# 环境变量：
+#   AGENT_LIB          代理库路径（必需，例如 install/lib/libagent.so）
+#   JAVA_LIBRARY_PATH  java.library.path（data-guard 等库所在目录，默认为代理库所在目录）
+#   JAVA_HOME          使用其中的 java / javac，未设置时使用 PATH 中的命令
+#   SIZES              语料的类数量（默认 "1000 10000 50000"）
+#   RUNS               每个配置的启动次数，取中位数（默认 5）
+#   ENCRYPTED_PERCENT  加密类比例（默认 5），INCLUDED_PERCENT 代理默认包含的包中的类比例（默认 50）
+#   CONFIGS            只运行名称匹配该正则的配置（例如 "filter|dump"），baseline 总是运行
+#   WORK_DIR           语料、日志与结果目录（默认 build/startup-bench），已有的语料会复用
+#   JAVA_OPTS          附加的 JVM 参数
+set -euo pipefail
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+SIZES=${SIZES:-"1000 10000 50000"}
+RUNS=${RUNS:-5}
+ENCRYPTED_PERCENT=${ENCRYPTED_PERCENT:-5}
+INCLUDED_PERCENT=${INCLUDED_PERCENT:-50}
+CONFIGS=${CONFIGS:-}
+WORK_DIR=${WORK_DIR:-build/startup-bench}
+JAVA_OPTS=${JAVA_OPTS:-}
+
+if [[ -n "${JAVA_HOME:-}" ]]; then
+  JAVA="$JAVA_HOME/bin/java"
+  JAVAC="$JAVA_HOME/bin/javac"
+else
+  JAVA=java
+  JAVAC=javac
+fi
+
+if [[ -z "${AGENT_LIB:-}" || ! -f "$AGENT_LIB" ]]; then
+  echo "AGENT_LIB 未设置或不存在: ${AGENT_LIB:-}" >&2
+  exit 2
+fi
+AGENT_LIB=$(cd "$(dirname "$AGENT_LIB")" && pwd)/$(basename "$AGENT_LIB")
+JAVA_LIBRARY_PATH=${JAVA_LIBRARY_PATH:-$(dirname "$AGENT_LIB")}
+
+mkdir -p "$WORK_DIR"
+WORK_DIR=$(cd "$WORK_DIR" && pwd)
+RAW="$WORK_DIR/runs.tsv"
+SUMMARY="$WORK_DIR/summary.tsv"
+
+# 配置名称与代理参数；baseline 不加载代理。trace 模式开启逐事件的 trace 日志，其余配置关闭日志。
+# all 启用全部可在启动时开启的功能（heap_histo 只在 attach 时生效，不包含在内）
+ALL_FEATURES="exception_profile=true,monitor_profile=true,cpu_sample=true,wall_sample=true,alloc_profile=true"
+ALL_FEATURES+=",gc_profile=true,jit_stats=true,perf_map=true,metrics=true"
+CONFIG_NAMES=(baseline filter dump trace all)
+CONFIG_OPTIONS=(
+  ""
+  "module=classfile,log_level=off"
+  "module=classfile,dump=@DUMP@,log_level=off"
+  "module=classfile,module=native,module=probe,log_level=trace"
+  "$ALL_FEATURES,log_level=off"
+)
+# 各功能单独启用（名称为 feature/<模块>）；堆直方图在启动时只输出警告，需通过 attach 测量，不在此列
+FEATURES=(
+  "native:module=native"
+  "probe:module=probe"
+  "exception:module=exception,exception_profile=true"
+  "monitor:module=monitor,monitor_profile=true"
+  "cpu:module=cpu,cpu_sample=true"
+  "wall:module=wall,wall_sample=true"
+  "alloc:module=alloc,alloc_profile=true"
+  "gc:module=gc,gc_profile=true"
+  "jit:module=jit,jit_stats=true"
+  "perf:module=perf,perf_map=true"
+  "metrics:module=metrics,metrics=true"
+)
+for feature in "${FEATURES[@]}"; do
+  CONFIG_NAMES+=("feature/${feature%%:*}")
+  CONFIG_OPTIONS+=("${feature#*:},log_level=off")
+done
+
+# 当前时间（Unix 纪元纳秒），macOS 的 date 不支持 %N
+now_ns() {
+  local ns
+  ns=$(date +%s%N)
+  if [[ "$ns" == *N ]]; then
+    perl -MTime::HiRes=time -e 'printf "%.0f\n", time() * 1e9'
+  else
+    echo "$ns"
+  fi
+}
+
+# 标准输入中数值的中位数
+median() {
+  sort -g | awk '{ v[NR] = $1 } END { if (NR == 0) print "-"; else if (NR % 2) print v[(NR + 1) / 2]; else printf "%.2f\n", (v[NR / 2] + v[NR / 2 + 1]) / 2 }'
+}
+
+# 从 STARTUP 行中取出 key 的值
+field() {
+  sed -n "s/.*[[:space:]]$1=\\([^[:space:]]*\\).*/\\1/p" <<<"$2"
+}
+
+# ---------- 编译主类、生成语料 ----------
+mkdir -p "$WORK_DIR/classes"
+"$JAVAC" -d "$WORK_DIR/classes" "$SCRIPT_DIR/StartupMain.java"
+for size in $SIZES; do
+  jar="$WORK_DIR/corpus-$size-e$ENCRYPTED_PERCENT-i$INCLUDED_PERCENT.jar"
+  [[ -f "$jar" ]] || "$JAVA" "$SCRIPT_DIR/StartupCorpus.java" "$jar" "$size" "$ENCRYPTED_PERCENT" "$INCLUDED_PERCENT"
+done
+
+# ---------- 启动 ----------
+printf "size\tconfig\trun\twall_ms\tcpu_ms\ttime_to_main_ms\tclass_load_ms\tjvm_class_load_ms\tagent_thread_cpu_ms\tloaded\trejected\n" >"$RAW"
+TIMEFORMAT='%R %U %S'
+for size in $SIZES; do
+  jar="$WORK_DIR/corpus-$size-e$ENCRYPTED_PERCENT-i$INCLUDED_PERCENT.jar"
+  for i in "${!CONFIG_NAMES[@]}"; do
+    name=${CONFIG_NAMES[$i]}
+    [[ -z "$CONFIGS" || "$name" == baseline || "$name" =~ $CONFIGS ]] || continue
+    run_dir="$WORK_DIR/run/${name//\//-}"
+    for ((run = 1; run <= RUNS; run++)); do
+      rm -rf "$run_dir"
+      mkdir -p "$run_dir"
+      agent=()
+      if [[ -n "${CONFIG_OPTIONS[$i]}" ]]; then
+        agent=("-agentpath:$AGENT_LIB=${CONFIG_OPTIONS[$i]//@DUMP@/$run_dir/dump}")
+      fi
+      # 在独立目录中运行，代理日志（logs/）与转储文件互不影响
+      # shellcheck disable=SC2086
+      if ! { time (cd "$run_dir" && "$JAVA" $JAVA_OPTS \
+        --add-exports java.management/sun.management=ALL-UNNAMED \
+        -Djava.library.path="$JAVA_LIBRARY_PATH" ${agent[@]+"${agent[@]}"} \
+        -Dstartup.launch_ns="$(now_ns)" -cp "$WORK_DIR/classes:$jar" StartupMain \
+        >"$run_dir/stdout.log" 2>"$run_dir/stderr.log"); } 2>"$run_dir/time.log"; then
+        echo "FAIL: size=$size config=$name run=$run" >&2
+        tail -n 20 "$run_dir/stderr.log" >&2
+        exit 1
+      fi
+      line=$(grep '^STARTUP ' "$run_dir/stdout.log" || true)
+      if [[ -z "$line" ]]; then
+        echo "FAIL: size=$size config=$name 没有输出 STARTUP 行" >&2
+        tail -n 20 "$run_dir/stderr.log" >&2
+        exit 1
+      fi
+      read -r real user sys <"$run_dir/time.log"
+      printf "%s\t%s\t%d\t%.1f\t%.1f\t%s\t%s\t%s\t%s\t%s\t%s\n" "$size" "$name" "$run" \
+        "$(awk -v r="$real" 'BEGIN { print r * 1000 }')" \
+        "$(awk -v u="$user" -v s="$sys" 'BEGIN { print (u + s) * 1000 }')" \
+        "$(field time_to_main_ms " $line")" "$(field class_load_ms " $line")" \
+        "$(field jvm_class_load_ms " $line")" "$(field agent_thread_cpu_ms " $line")" \
+        "$(field loaded " $line")" "$(field rejected " $line")" >>"$RAW"
+    done
+    printf "." >&2
+  done
+  echo >&2
+done
+
+# ---------- 汇总（中位数），agent_cpu_ms 为进程 CPU 减去同一语料无代理时的进程 CPU ----------
+column_median() {
+  awk -F'\t' -v s="$1" -v c="$2" -v col="$3" 'NR > 1 && $1 == s && $2 == c { print $col }' "$RAW" | median
+}
+
+printf "size\tconfig\twall_ms\ttime_to_main_ms\tclass_load_ms\tjvm_class_load_ms\tcpu_ms\tagent_cpu_ms\tagent_thread_cpu_ms\n" >"$SUMMARY"
+for size in $SIZES; do
+  baseline_cpu=$(column_median "$size" baseline 5)
+  for name in "${CONFIG_NAMES[@]}"; do
+    [[ -z "$CONFIGS" || "$name" == baseline || "$name" =~ $CONFIGS ]] || continue
+    cpu=$(column_median "$size" "$name" 5)
+    agent_cpu="-"
+    if [[ "$baseline_cpu" != "-" && "$cpu" != "-" ]]; then
+      agent_cpu=$(awk -v a="$cpu" -v b="$baseline_cpu" 'BEGIN { printf "%.1f", a - b }')
+    fi
+    printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$size" "$name" \
+      "$(column_median "$size" "$name" 4)" "$(column_median "$size" "$name" 6)" \
+      "$(column_median "$size" "$name" 7)" "$(column_median "$size" "$name" 8)" \
+      "$cpu" "$agent_cpu" "$(column_median "$size" "$name" 9)" >>"$SUMMARY"
+  done
+done
+
+awk -F'\t' '{ printf "%-8s %-18s %10s %16s %14s %18s %10s %13s %20s\n", $1, $2, $3, $4, $5, $6, $7, $8, $9 }' "$SUMMARY"
+echo "每次启动的数据: $RAW"
+echo "中位数汇总: $SUMMARY"
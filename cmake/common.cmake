@@ -4,6 +4,7 @@
 option(JVMTI_TOOLS_ENABLE_SYSTEM_INFO "Show system information during configuration" ON)
 option(JVMTI_TOOLS_ENABLE_LOG "JVMTI 工具启用日志" ON)
 option(JVMTI_TOOLS_LINK_JVM_LIBRARY "JVMTI 是否链接到 JVM" OFF)
+option(JVMTI_TOOLS_BUILD_BENCH "JVMTI 工具构建基准测试" OFF)
 
 # ----------------------
 # 系统信息收集函数
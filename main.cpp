@@ -1,55 +1,99 @@
-#include <spdlog/spdlog.h>
-#include <spdlog/async.h>
-#include <thread>
 #include <chrono>
-#include <unordered_set>
+#include <cstring>
+#include <format>
+#include <iostream>
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#endif
 
-#include "spdlog/sinks/rotating_file_sink.h"
-#include "src/jvmti/Logger.h"
+#include "src/jvmti/Histogram.h"
+#include "src/jvmti/Metrics.h"
 
-void test(jvmti::Logger logger) {
-    const std::unordered_set<std::string> target_packages = {
-        "com/fr/jvm/",
-        "com/fr/license/"
-    };
-    bool is_target = false;
-    const std::string sig = "Lcom/fr/jvm/assist/FineAssist;";
-    const auto log = logger.get(JVMTI_EVENT_METHOD_ENTRY);
-    for (const auto &pkg: target_packages) {
-        if (sig.find(pkg) != std::string::npos) {
-            log->warn("method_entry_callback => {}", sig);
-            log->warn("find: {0} != {1} {3} contains {2}", sig.find(pkg), std::string::npos, pkg, sig);
-            is_target = true;
-            break;
-        }
-    }
-    log->info("is target: {0}!", is_target);
+// 直方图快照的分位数，与代理内的 Histogram::percentile 使用同一算法
+uint64_t percentile(const jvmti_tools::MetricsSnapshot::HistogramValue &histogram, const double q) {
+    return jvmti_tools::Histogram::percentile(histogram.buckets, histogram.count, histogram.max, q);
 }
 
-int main() {
-    std::stack<int> s;
-    jvmti::Logger logger;
-    const auto primary = logger.get();
-
-    // 测试日志记录
-    for (int i = 0; i < 10; ++i) {
-        // 模拟异步日志处理时间
-        s.push(i + 1);
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        primary->debug("异步日志测试 - 消息 {}", i);
+void printText(const jvmti_tools::MetricsSnapshot &snapshot) {
+    const auto now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    const double age = now > snapshot.updated_ns ? static_cast<double>(now - snapshot.updated_ns) / 1e9 : 0.0;
+    std::cout << std::format("pid {}  sequence {}  interval {}ms  updated {:.1f}s ago\n",
+                             snapshot.pid, snapshot.sequence, snapshot.interval_ms, age);
+    for (const auto &counter: snapshot.counters) {
+        std::cout << std::format("  {:<40} {:>16}{}\n", counter.name, counter.value, counter.gauge ? " (gauge)" : "");
     }
+    for (const auto &histogram: snapshot.histograms) {
+        const double mean = histogram.count == 0
+                                ? 0.0
+                                : static_cast<double>(histogram.sum) / static_cast<double>(histogram.count);
+        std::cout << std::format("  {:<40} count={} mean={:.0f} p50={} p99={} max={}\n", histogram.name,
+                                 histogram.count, mean, percentile(histogram, 0.5), percentile(histogram, 0.99),
+                                 histogram.max);
+    }
+}
 
-    test(logger);
-
-    // 遍历栈（需先复制，因 pop 会修改原栈）
-    std::stack<int> temp = s;
-    while (!temp.empty()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        primary->info("stack => {}", temp.top());
-        temp.pop();
+// Prometheus 文本格式（0.0.4）：计数器加 _total 后缀，直方图桶为累计值，仅输出到最后一个非空桶
+void printPrometheus(const jvmti_tools::MetricsSnapshot &snapshot) {
+    const std::string labels = std::format("pid=\"{}\"", snapshot.pid);
+    for (const auto &counter: snapshot.counters) {
+        const std::string name = "jvmti_" + counter.name + (counter.gauge ? "" : "_total");
+        std::cout << std::format("# TYPE {} {}\n{}{{{}}} {}\n", name, counter.gauge ? "gauge" : "counter", name,
+                                 labels, counter.value);
+    }
+    for (const auto &histogram: snapshot.histograms) {
+        const std::string name = "jvmti_" + histogram.name;
+        std::cout << std::format("# TYPE {} histogram\n", name);
+        size_t last = 0;
+        for (size_t i = 0; i < histogram.buckets.size(); ++i) {
+            if (histogram.buckets[i] != 0) last = i;
+        }
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i <= last && i + 1 < histogram.buckets.size(); ++i) {
+            cumulative += histogram.buckets[i];
+            std::cout << std::format("{}_bucket{{{},le=\"{}\"}} {}\n", name, labels,
+                                     jvmti_tools::Histogram::upperBound(i), cumulative);
+        }
+        std::cout << std::format("{}_bucket{{{},le=\"+Inf\"}} {}\n", name, labels, histogram.count);
+        std::cout << std::format("{}_sum{{{}}} {}\n{}_count{{{}}} {}\n", name, labels, histogram.sum, name, labels,
+                                 histogram.count);
     }
+}
 
-    logger.shutdown();
+// jvmti metrics <pid> [--prometheus]：读取代理发布的共享内存指标，不与目标 JVM 交互
+int metrics(const int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " metrics <pid> [--prometheus]" << std::endl;
+        return 2;
+    }
+    const uint64_t pid = std::strtoull(argv[2], nullptr, 10);
+    const bool prometheus = argc > 3 && std::strcmp(argv[3], "--prometheus") == 0;
 
+    std::string error;
+    const auto snapshot = jvmti_tools::readMetrics(pid, error);
+    if (!snapshot) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+#ifndef _WIN32
+    // 进程异常退出时共享内存段不会被删除，数据停留在最后一次发布
+    if (kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) {
+        std::cerr << "warning: process " << pid << " is not running, metrics are stale" << std::endl;
+    }
+#endif
+    if (prometheus) {
+        printPrometheus(*snapshot);
+    } else {
+        printText(*snapshot);
+    }
     return 0;
 }
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::strcmp(argv[1], "metrics") == 0) {
+        return metrics(argc, argv);
+    }
+    std::cerr << "usage: " << argv[0] << " metrics <pid> [--prometheus]" << std::endl;
+    return 2;
+}
@@ -0,0 +1,156 @@
+#include "CaseSwap.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CASE_SWAP_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CASE_SWAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang 需要为单个函数开启指令集，MSVC 可直接使用对应 intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#define CASE_SWAP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CASE_SWAP_TARGET(isa)
+#endif
+
+namespace jvmti_tools {
+    namespace {
+        inline unsigned char swapByte(const unsigned char c) {
+            // 转为小写后判断是否为字母，是则翻转 0x20 位
+            const auto lower = static_cast<unsigned char>(c | 0x20);
+            return static_cast<unsigned char>(c ^ (static_cast<unsigned char>(lower - 'a') < 26 ? 0x20 : 0));
+        }
+
+        void swapCaseScalar(const unsigned char *in, unsigned char *out, const size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                out[i] = swapByte(in[i]);
+            }
+        }
+
+#ifdef CASE_SWAP_X86
+        // 无符号比较 (c|0x20) - 'a' < 26 借助加 0x80 偏移转换为有符号比较
+        CASE_SWAP_TARGET("sse2")
+        void swapCaseSse2(const unsigned char *in, unsigned char *out, const size_t length) {
+            const __m128i case_bit = _mm_set1_epi8(0x20);
+            const __m128i offset = _mm_set1_epi8(static_cast<char>(0x80 - 'a'));
+            const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+                const __m128i shifted = _mm_add_epi8(_mm_or_si128(c, case_bit), offset);
+                const __m128i alpha = _mm_cmplt_epi8(shifted, limit);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                                 _mm_xor_si128(c, _mm_and_si128(alpha, case_bit)));
+            }
+            swapCaseScalar(in + i, out + i, length - i);
+        }
+
+        CASE_SWAP_TARGET("avx2")
+        void swapCaseAvx2(const unsigned char *in, unsigned char *out, const size_t length) {
+            const __m256i case_bit = _mm256_set1_epi8(0x20);
+            const __m256i offset = _mm256_set1_epi8(static_cast<char>(0x80 - 'a'));
+            const __m256i limit = _mm256_set1_epi8(static_cast<char>(-128 + 26));
+            size_t i = 0;
+            for (; i + 32 <= length; i += 32) {
+                const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+                const __m256i shifted = _mm256_add_epi8(_mm256_or_si256(c, case_bit), offset);
+                const __m256i alpha = _mm256_cmpgt_epi8(limit, shifted);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                                    _mm256_xor_si256(c, _mm256_and_si256(alpha, case_bit)));
+            }
+            swapCaseSse2(in + i, out + i, length - i);
+        }
+
+        CASE_SWAP_TARGET("avx512f,avx512bw")
+        void swapCaseAvx512(const unsigned char *in, unsigned char *out, const size_t length) {
+            const __m512i case_bit = _mm512_set1_epi8(0x20);
+            const __m512i a = _mm512_set1_epi8('a');
+            const __m512i letters = _mm512_set1_epi8(26);
+            size_t i = 0;
+            for (; i < length; i += 64) {
+                // 尾部使用掩码加载/存储，无需标量收尾
+                const __mmask64 lanes = length - i >= 64 ? ~__mmask64{0} : (__mmask64{1} << (length - i)) - 1;
+                const __m512i c = _mm512_maskz_loadu_epi8(lanes, in + i);
+                const __m512i relative = _mm512_sub_epi8(_mm512_or_si512(c, case_bit), a);
+                const __mmask64 alpha = _mm512_cmplt_epu8_mask(relative, letters);
+                const __m512i flip = _mm512_maskz_mov_epi8(alpha, case_bit);
+                _mm512_mask_storeu_epi8(out + i, lanes, _mm512_xor_si512(c, flip));
+            }
+        }
+
+        bool cpuSupports(const char *feature) {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_cpu_init();
+            if (std::strcmp(feature, "avx2") == 0) return __builtin_cpu_supports("avx2");
+            if (std::strcmp(feature, "avx512bw") == 0) {
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+            }
+            return std::strcmp(feature, "sse2") == 0 && __builtin_cpu_supports("sse2");
+#else
+            // MSVC 仅启用 x64 基线的 SSE2
+            return std::strcmp(feature, "sse2") == 0;
+#endif
+        }
+#endif
+
+#ifdef CASE_SWAP_NEON
+        void swapCaseNeon(const unsigned char *in, unsigned char *out, const size_t length) {
+            const uint8x16_t case_bit = vdupq_n_u8(0x20);
+            const uint8x16_t a = vdupq_n_u8('a');
+            const uint8x16_t letters = vdupq_n_u8(26);
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                const uint8x16_t c = vld1q_u8(in + i);
+                const uint8x16_t alpha = vcltq_u8(vsubq_u8(vorrq_u8(c, case_bit), a), letters);
+                vst1q_u8(out + i, veorq_u8(c, vandq_u8(alpha, case_bit)));
+            }
+            swapCaseScalar(in + i, out + i, length - i);
+        }
+#endif
+
+        CaseSwapImpl select() {
+            const auto available = availableCaseSwaps();
+            if (const char *name = std::getenv("DATA_GUARD_KERNEL")) {
+                for (const auto &impl: available) {
+                    if (std::strcmp(impl.name, name) == 0) return impl;
+                }
+            }
+            return available.back();
+        }
+
+        // 在库加载时完成选择，调用路径只有一次间接调用
+        const CaseSwapImpl selected = select();
+    }
+
+    std::vector<CaseSwapImpl> availableCaseSwaps() {
+        std::vector<CaseSwapImpl> impls = {{"scalar", &swapCaseScalar}};
+#ifdef CASE_SWAP_X86
+        if (cpuSupports("sse2")) impls.push_back({"sse2", &swapCaseSse2});
+#if defined(__GNUC__) || defined(__clang__)
+        if (cpuSupports("avx2")) impls.push_back({"avx2", &swapCaseAvx2});
+        if (cpuSupports("avx512bw")) impls.push_back({"avx512bw", &swapCaseAvx512});
+#endif
+#endif
+#ifdef CASE_SWAP_NEON
+        impls.push_back({"neon", &swapCaseNeon});
+#endif
+        return impls;
+    }
+
+    const CaseSwapImpl &selectedCaseSwap() {
+        return selected;
+    }
+
+    void swapCase(const void *in, void *out, const size_t length) {
+        selected.kernel(static_cast<const unsigned char *>(in), static_cast<unsigned char *>(out), length);
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef CASESWAP_H
+#define CASESWAP_H
+#include <cstddef>
+#include <vector>
+
+namespace jvmti_tools {
+    // ASCII 大小写互换内核：A-Z <-> a-z，其他字节原样输出；in 与 out 可以是同一块内存
+    using CaseSwapKernel = void (*)(const unsigned char *in, unsigned char *out, size_t length);
+
+    struct CaseSwapImpl {
+        const char *name;
+        CaseSwapKernel kernel;
+    };
+
+    // 使用加载时根据 CPU 特性选定的最优内核（可用环境变量 DATA_GUARD_KERNEL 指定内核名称）
+    void swapCase(const void *in, void *out, size_t length);
+
+    // 当前选定的内核
+    const CaseSwapImpl &selectedCaseSwap();
+
+    // 当前 CPU 上可用的全部内核（第一个为标量实现）
+    std::vector<CaseSwapImpl> availableCaseSwaps();
+}
+
+#endif //CASESWAP_H
@@ -1,7 +1,218 @@
-
 #include "DataGuard.h"
 
-#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <vector>
+
+#include "CaseSwap.h"
+#include "WorkerPool.h"
+#include "jvmti/ByteArray.h"
+
+namespace {
+    // 流式处理上下文：大小写互换逐字节进行，与分块方式无关，跨分块只需记录已处理的字节数
+    struct StreamContext {
+        uint64_t processed = 0;
+    };
+
+    // 流式处理上下文表：句柄高 32 位为代数、低 32 位为槽位序号，槽位释放时代数加一，
+    // 过期或重复释放的句柄只会查找失败，不会访问已释放的上下文。
+    // 查找与更新在锁内完成，加解密在锁外进行；调用方不得在持有 JNI 临界区时访问本表
+    class StreamTable {
+    private:
+        struct Slot {
+            uint32_t generation = 1; // 从 1 开始，句柄 0 永远无效
+            bool used = false;
+            StreamContext context;
+        };
+
+        std::mutex mutex_;
+        std::vector<Slot> slots_;
+        std::vector<uint32_t> free_;
+
+        // 调用方持有 mutex_
+        Slot *find(const jlong handle) {
+            const auto value = static_cast<uint64_t>(handle);
+            const auto index = static_cast<uint32_t>(value);
+            const auto generation = static_cast<uint32_t>(value >> 32);
+            if (index >= slots_.size()) return nullptr;
+            Slot &slot = slots_[index];
+            return slot.used && slot.generation == generation ? &slot : nullptr;
+        }
+
+    public:
+        jlong open() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint32_t index;
+            if (!free_.empty()) {
+                index = free_.back();
+                free_.pop_back();
+            } else {
+                index = static_cast<uint32_t>(slots_.size());
+                slots_.emplace_back();
+            }
+            Slot &slot = slots_[index];
+            slot.used = true;
+            slot.context = StreamContext{};
+            return static_cast<jlong>(static_cast<uint64_t>(slot.generation) << 32 | index);
+        }
+
+        bool contains(const jlong handle) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return find(handle) != nullptr;
+        }
+
+        // 累加已处理的字节数，句柄无效（例如处理期间被另一线程结束）时返回 false
+        bool add(const jlong handle, const jint length) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Slot *slot = find(handle);
+            if (slot == nullptr) return false;
+            slot->context.processed += static_cast<uint64_t>(length);
+            return true;
+        }
+
+        // 释放句柄并返回已处理的字节数，句柄无效时返回空
+        std::optional<jlong> close(const jlong handle) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Slot *slot = find(handle);
+            if (slot == nullptr) return std::nullopt;
+            const auto processed = static_cast<jlong>(slot->context.processed);
+            slot->used = false;
+            if (++slot->generation == 0) slot->generation = 1;
+            free_.push_back(static_cast<uint32_t>(slot - slots_.data()));
+            return processed;
+        }
+    };
+
+    StreamTable &streams() {
+        static StreamTable table;
+        return table;
+    }
+
+    // 并行处理的分块大小（约为 L2 缓存大小）
+    constexpr size_t PARALLEL_CHUNK_SIZE = 256 * 1024;
+    // 默认并行阈值，低于该大小时单线程处理
+    constexpr size_t DEFAULT_PARALLEL_THRESHOLD = 2 * 1024 * 1024;
+
+    // 可用环境变量 DATA_GUARD_PARALLEL_THRESHOLD 调整阈值（字节），0 表示禁用并行
+    size_t parallelThreshold() {
+        if (const char *value = std::getenv("DATA_GUARD_PARALLEL_THRESHOLD")) {
+            char *end = nullptr;
+            const unsigned long long threshold = std::strtoull(value, &end, 10);
+            if (end != value && *end == '\0') {
+                return threshold == 0 ? SIZE_MAX : static_cast<size_t>(threshold);
+            }
+        }
+        return DEFAULT_PARALLEL_THRESHOLD;
+    }
+
+    const size_t parallel_threshold = parallelThreshold();
+
+    // 加解密变换（大小写互换，加密与解密是同一变换，因此不区分方向）
+    // 大块输入按块分给工作线程处理，每块只写入自己的区间，输出与单线程结果完全一致
+    void transform(const void *in, void *out, const size_t length) {
+        if (length < parallel_threshold) {
+            jvmti_tools::swapCase(in, out, length);
+            return;
+        }
+        const auto *src = static_cast<const unsigned char *>(in);
+        auto *dst = static_cast<unsigned char *>(out);
+        jvmti_tools::WorkerPool::shared().parallelFor(length, PARALLEL_CHUNK_SIZE,
+                                                      [&](const size_t begin, const size_t end) {
+                                                          jvmti_tools::swapCase(src + begin, dst + begin, end - begin);
+                                                      });
+    }
+
+    void throwException(JNIEnv *env, const char *class_name, const char *message) {
+        if (const jclass clazz = env->FindClass(class_name)) {
+            env->ThrowNew(clazz, message);
+            env->DeleteLocalRef(clazz);
+        }
+    }
+
+    bool checkRange(JNIEnv *env, const jlong capacity, const jint offset, const jint length) {
+        if (offset < 0 || length < 0 || static_cast<jlong>(offset) + length > capacity) {
+            throwException(env, "java/lang/IndexOutOfBoundsException", "offset/length out of range");
+            return false;
+        }
+        return true;
+    }
+
+    // 输入与输出区间完全重合（原地处理）或互不重叠时才能处理；部分重叠时分块（可能并行）处理会读到已改写的数据
+    bool checkOverlap(JNIEnv *env, const unsigned char *in, const unsigned char *out, const jint length) {
+        if (in != out && in < out + length && out < in + length) {
+            throwException(env, "java/lang/IllegalArgumentException", "input and output ranges partially overlap");
+            return false;
+        }
+        return true;
+    }
+
+    // 校验直接缓冲区区间并取得输入、输出地址：src 与 dst 可为同一缓冲区的同一区间（原地处理），出错时抛出异常并返回 false
+    bool directRange(JNIEnv *env, jobject src, const jint src_offset, jobject dst, const jint dst_offset,
+                     const jint length, unsigned char **in, unsigned char **out) {
+        if (src == nullptr || dst == nullptr) {
+            throwException(env, "java/lang/NullPointerException", "buffer is null");
+            return false;
+        }
+        auto *src_address = static_cast<unsigned char *>(env->GetDirectBufferAddress(src));
+        auto *dst_address = static_cast<unsigned char *>(env->GetDirectBufferAddress(dst));
+        if (src_address == nullptr || dst_address == nullptr) {
+            throwException(env, "java/lang/IllegalArgumentException", "buffer is not direct");
+            return false;
+        }
+        if (!checkRange(env, env->GetDirectBufferCapacity(src), src_offset, length) ||
+            !checkRange(env, env->GetDirectBufferCapacity(dst), dst_offset, length)) {
+            return false;
+        }
+        *in = src_address + src_offset;
+        *out = dst_address + dst_offset;
+        return checkOverlap(env, *in, *out, length);
+    }
+
+    // 直接缓冲区处理，返回处理的字节数，出错时抛出异常并返回 -1
+    jint transformDirect(JNIEnv *env, jobject src, const jint src_offset,
+                         jobject dst, const jint dst_offset, const jint length) {
+        unsigned char *in = nullptr;
+        unsigned char *out = nullptr;
+        if (!directRange(env, src, src_offset, dst, dst_offset, length, &in, &out)) return -1;
+        transform(in, out, length);
+        return length;
+    }
+
+    // 堆数组处理，出错时抛出异常（或保留 JNI 挂起的异常）并返回 false。
+    // 低于并行阈值时在临界区内单线程处理；大块输入等待工作线程会阻塞调用线程，不能在临界区内进行（会推迟 GC），
+    // 因此拷贝到本地缓冲区并行处理后再写回。超大数据应使用直接缓冲区接口，既能并行又无需拷贝
+    bool transformArray(JNIEnv *env, jbyteArray input, const jsize input_length, const jint input_offset,
+                        jbyteArray output, const jsize output_length, const jint output_offset, const jint length) {
+        if (static_cast<size_t>(length) >= parallel_threshold) {
+            const std::unique_ptr<jbyte[]> buffer(new(std::nothrow) jbyte[length]);
+            if (!buffer) {
+                throwException(env, "java/lang/OutOfMemoryError", "cannot allocate transform buffer");
+                return false;
+            }
+            env->GetByteArrayRegion(input, input_offset, length, buffer.get());
+            if (env->ExceptionCheck()) return false;
+            transform(buffer.get(), buffer.get(), length);
+            env->SetByteArrayRegion(output, output_offset, length, buffer.get());
+            return !env->ExceptionCheck();
+        }
+        // 输入输出为同一数组时只进入一次临界区，并在释放时写回
+        const bool same = env->IsSameObject(input, output);
+        const jvmti_tools::CriticalArray in(env, input, input_length, same ? 0 : JNI_ABORT);
+        const jvmti_tools::CriticalArray out(env, same ? nullptr : output, output_length, 0);
+        if (!in || !(same || out)) return false;
+        // 大小写转换（SIMD 内核，临界区内不调用任何 JNI 函数）
+        jvmti_tools::swapCase(in.bytes() + input_offset, (same ? in.bytes() : out.bytes()) + output_offset, length);
+        return true;
+    }
+
+    void invalidStream(JNIEnv *env) {
+        throwException(env, "java/lang/IllegalStateException", "invalid stream handle");
+    }
+}
 
 
 jbyteArray Java_DataGuard_encrypt(JNIEnv *env, jclass clazz, jbyteArray input) {
@@ -17,39 +228,90 @@ jbyteArray Java_DataGuard_encrypt(JNIEnv *env, jclass clazz, jbyteArray input) {
         return nullptr; // 内存分配失败
     }
 
-    // 获取输入数组的元素
-    jbyte *inputBytes = env->GetByteArrayElements(input, nullptr);
-    if (inputBytes == nullptr) {
+    // 结果直接写入输出数组
+    if (!transformArray(env, input, length, 0, output, length, 0, length)) {
         env->DeleteLocalRef(output);
         return nullptr;
     }
 
-    // 处理每个字节，进行大小写转换
-    jbyte *outputBytes = env->GetByteArrayElements(output, nullptr);
-    if (outputBytes == nullptr) {
-        env->ReleaseByteArrayElements(input, inputBytes, JNI_ABORT);
-        env->DeleteLocalRef(output);
-        return nullptr;
-    }
+    return output;
+}
 
-    for (jsize i = 0; i < length; i++) {
-        const auto c = static_cast<unsigned char>(inputBytes[i]);
-        if (isupper(c)) {
-            outputBytes[i] = static_cast<jbyte>(tolower(c));
-        } else if (islower(c)) {
-            outputBytes[i] = static_cast<jbyte>(toupper(c));
-        } else {
-            outputBytes[i] = inputBytes[i]; // 保持其他字符不变
-        }
+jbyteArray Java_DataGuard_decrypt(JNIEnv *env, jclass clazz, jbyteArray input) {
+    return Java_DataGuard_encrypt(env, clazz, input);
+}
+
+jint Java_DataGuard_encryptDirect(JNIEnv *env, jclass, jobject src, jint src_offset, jobject dst,
+                                  jint dst_offset, jint length) {
+    return transformDirect(env, src, src_offset, dst, dst_offset, length);
+}
+
+jint Java_DataGuard_decryptDirect(JNIEnv *env, jclass, jobject src, jint src_offset, jobject dst,
+                                  jint dst_offset, jint length) {
+    return transformDirect(env, src, src_offset, dst, dst_offset, length);
+}
+
+jlong Java_DataGuard_streamInit(JNIEnv *, jclass) {
+    return streams().open();
+}
+
+jint Java_DataGuard_streamUpdate(JNIEnv *env, jclass, jlong handle, jbyteArray input, jint input_offset,
+                                 jint length, jbyteArray output, jint output_offset) {
+    if (input == nullptr || output == nullptr) {
+        throwException(env, "java/lang/NullPointerException", "array is null");
+        return -1;
+    }
+    const jsize input_length = env->GetArrayLength(input);
+    const jsize output_length = env->GetArrayLength(output);
+    if (!checkRange(env, input_length, input_offset, length) ||
+        !checkRange(env, output_length, output_offset, length)) {
+        return -1;
     }
 
-    // 释放数组元素并提交更改
-    env->ReleaseByteArrayElements(input, inputBytes, JNI_ABORT);
-    env->ReleaseByteArrayElements(output, outputBytes, 0);
+    // 由调用方复用输出数组，分块处理超大输入时不产生额外分配；同一数组只允许原地处理或互不重叠的区间
+    const bool same = env->IsSameObject(input, output);
+    if (same && input_offset != output_offset &&
+        (input_offset < output_offset ? output_offset - input_offset : input_offset - output_offset) < length) {
+        throwException(env, "java/lang/IllegalArgumentException", "input and output ranges partially overlap");
+        return -1;
+    }
+    // 先校验句柄再处理，处理成功后才计入已处理的字节数
+    if (!streams().contains(handle)) {
+        invalidStream(env);
+        return -1;
+    }
+    if (!transformArray(env, input, input_length, input_offset, output, output_length, output_offset, length)) {
+        return -1;
+    }
+    if (!streams().add(handle, length)) {
+        invalidStream(env);
+        return -1;
+    }
+    return length;
+}
 
-    return output;
+jint Java_DataGuard_streamUpdateDirect(JNIEnv *env, jclass, jlong handle, jobject src, jint src_offset,
+                                       jobject dst, jint dst_offset, jint length) {
+    unsigned char *in = nullptr;
+    unsigned char *out = nullptr;
+    if (!directRange(env, src, src_offset, dst, dst_offset, length, &in, &out)) return -1;
+    if (!streams().contains(handle)) {
+        invalidStream(env);
+        return -1;
+    }
+    transform(in, out, length);
+    if (!streams().add(handle, length)) {
+        invalidStream(env);
+        return -1;
+    }
+    return length;
 }
 
-jbyteArray Java_DataGuard_decrypt(JNIEnv *env, jclass clazz, jbyteArray input) {
-    return Java_DataGuard_encrypt(env, clazz, input);
+jlong Java_DataGuard_streamFinal(JNIEnv *env, jclass, jlong handle) {
+    const auto processed = streams().close(handle);
+    if (!processed) {
+        invalidStream(env);
+        return -1;
+    }
+    return *processed;
 }
@@ -1,6 +1,5 @@
-/* DO NOT EDIT THIS FILE - it is machine generated */
+/* DataGuard 类的 native 方法声明，手工维护，须与 DataGuard.java 中的 native 声明保持一致 */
 #include <jni.h>
-/* Header for class DataGuard */
 
 #ifndef _Included_DataGuard
 #define _Included_DataGuard
@@ -32,6 +31,54 @@ JNIEXPORT jbyteArray JNICALL Java_DataGuard_encrypt
 JNIEXPORT jbyteArray JNICALL Java_DataGuard_decrypt
   (JNIEnv *, jclass, jbyteArray);
 
+/*
+ * Class:     DataGuard
+ * Method:    encryptDirect
+ * Signature: (Ljava/nio/ByteBuffer;ILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_DataGuard_encryptDirect
+  (JNIEnv *, jclass, jobject, jint, jobject, jint, jint);
+
+/*
+ * Class:     DataGuard
+ * Method:    decryptDirect
+ * Signature: (Ljava/nio/ByteBuffer;ILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_DataGuard_decryptDirect
+  (JNIEnv *, jclass, jobject, jint, jobject, jint, jint);
+
+/*
+ * Class:     DataGuard
+ * Method:    streamInit
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_DataGuard_streamInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     DataGuard
+ * Method:    streamUpdate
+ * Signature: (J[BII[BI)I
+ */
+JNIEXPORT jint JNICALL Java_DataGuard_streamUpdate
+  (JNIEnv *, jclass, jlong, jbyteArray, jint, jint, jbyteArray, jint);
+
+/*
+ * Class:     DataGuard
+ * Method:    streamUpdateDirect
+ * Signature: (JLjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_DataGuard_streamUpdateDirect
+  (JNIEnv *, jclass, jlong, jobject, jint, jobject, jint, jint);
+
+/*
+ * Class:     DataGuard
+ * Method:    streamFinal
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_DataGuard_streamFinal
+  (JNIEnv *, jclass, jlong);
+
 #ifdef __cplusplus
 }
 #endif
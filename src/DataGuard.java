@@ -0,0 +1,57 @@
+import java.nio.ByteBuffer;
+
+/**
+ * data-guard 库的 Java 入口，native 方法由 DataGuard.cpp 实现（声明见 DataGuard.h）。
+ * <p>
+ * encrypt/decrypt 与 encryptDirect/decryptDirect 为一次性变换，加密与解密互为逆变换；
+ * stream* 方法按块处理任意长度的数据，每个句柄记录已处理的字节数，任意分块方式得到的结果与 encrypt/decrypt 一次性处理一致，
+ * 因此流式加密的数据可以一次性解密，反之亦然：
+ * <pre>
+ * long stream = DataGuard.streamInit();
+ * while ((n = in.read(buffer)) > 0) {
+ *     DataGuard.streamUpdate(stream, buffer, 0, n, buffer, 0);
+ *     out.write(buffer, 0, n);
+ * }
+ * DataGuard.streamFinal(stream);
+ * </pre>
+ * 大块数据（默认 2MiB 以上）并行处理：byte[] 入口需先拷贝到本地缓冲区再写回，直接缓冲区入口无需拷贝，优先使用。
+ * 参数越界、缓冲区不是直接缓冲区或输入输出区间部分重叠时抛出 IndexOutOfBoundsException / IllegalArgumentException，
+ * 句柄无效（未创建或已结束）时抛出 IllegalStateException
+ */
+public final class DataGuard {
+    static {
+        System.loadLibrary("data-guard");
+    }
+
+    /** 保留的实例方法声明，data-guard 库未实现，调用时抛出 UnsatisfiedLinkError */
+    public native byte[] bytes(byte[] data);
+
+    /** 加密整个数组，返回新数组 */
+    public static native byte[] encrypt(byte[] data);
+
+    /** 解密 encrypt 的结果，返回新数组 */
+    public static native byte[] decrypt(byte[] data);
+
+    /** 加密直接缓冲区的区间，src 与 dst 可为同一区间（原地处理），返回处理的字节数 */
+    public static native int encryptDirect(ByteBuffer src, int srcOffset, ByteBuffer dst, int dstOffset, int length);
+
+    /** 解密直接缓冲区的区间，参数同 encryptDirect */
+    public static native int decryptDirect(ByteBuffer src, int srcOffset, ByteBuffer dst, int dstOffset, int length);
+
+    /** 创建流式处理句柄 */
+    public static native long streamInit();
+
+    /**
+     * 处理下一块数据并写入 output，input 与 output 可为同一数组的同一区间，返回处理的字节数。
+     * 流式变换与 encrypt/decrypt 相同，加密与解密是同一变换，分块大小不必与加密时一致
+     */
+    public static native int streamUpdate(long stream, byte[] input, int inputOffset, int length,
+                                          byte[] output, int outputOffset);
+
+    /** 以直接缓冲区处理下一块数据，参数同 streamUpdate */
+    public static native int streamUpdateDirect(long stream, ByteBuffer src, int srcOffset,
+                                                ByteBuffer dst, int dstOffset, int length);
+
+    /** 结束流式处理并释放句柄，返回处理的总字节数 */
+    public static native long streamFinal(long stream);
+}
@@ -0,0 +1,140 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace jvmti_tools {
+    namespace {
+        // 单个池的工作线程上限
+        constexpr size_t MAX_WORKERS = 16;
+
+        // 读取 cgroup CPU 配额，未限制时返回 0
+        size_t cgroupCpuQuota() {
+#ifdef __linux__
+            // cgroup v2: "<quota|max> <period>"
+            if (std::ifstream cpu_max("/sys/fs/cgroup/cpu.max"); cpu_max) {
+                std::string quota;
+                long long period = 0;
+                if (cpu_max >> quota >> period && quota != "max" && period > 0) {
+                    return static_cast<size_t>(std::ceil(std::stod(quota) / static_cast<double>(period)));
+                }
+                return 0;
+            }
+            // cgroup v1
+            long long quota = -1;
+            long long period = 0;
+            std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+            std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+            if (quota_file >> quota && period_file >> period && quota > 0 && period > 0) {
+                return static_cast<size_t>(std::ceil(static_cast<double>(quota) / static_cast<double>(period)));
+            }
+#endif
+            return 0;
+        }
+    }
+
+    WorkerPool::WorkerPool(const size_t workers) {
+        workers_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            workers_.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    WorkerPool::~WorkerPool() { {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto &worker: workers_) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    WorkerPool &WorkerPool::shared() {
+        static WorkerPool pool(std::min(availableCpus(), MAX_WORKERS + 1) - 1);
+        return pool;
+    }
+
+    size_t WorkerPool::availableCpus() {
+        size_t cpus = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+#ifdef __linux__
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            cpus = std::min<size_t>(cpus, std::max(CPU_COUNT(&set), 1));
+        }
+#endif
+        if (const size_t quota = cgroupCpuQuota(); quota > 0) {
+            cpus = std::min(cpus, quota);
+        }
+        return cpus;
+    }
+
+    void WorkerPool::run(const size_t total, const size_t chunk, const Task task, void *context) {
+        if (total == 0) return;
+        const size_t chunks = chunk == 0 ? 1 : (total + chunk - 1) / chunk;
+
+        // 只有一块、无工作线程或池正被其他调用方占用时，直接在调用线程处理
+        std::unique_lock<std::mutex> submit(submit_mutex_, std::try_to_lock);
+        if (chunks <= 1 || workers_.empty() || !submit.owns_lock()) {
+            task(context, 0, total);
+            return;
+        }
+
+        const Job job{task, context, total, chunk, chunks};
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = job;
+            next_chunk_.store(0, std::memory_order_relaxed);
+            done_chunks_.store(0, std::memory_order_relaxed);
+            ++generation_;
+        }
+        work_ready_.notify_all();
+
+        work(job);
+
+        // 等待所有块完成，且没有工作线程仍持有本任务（避免其误领下一任务的块）
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_done_.wait(lock, [&] {
+            return done_chunks_.load(std::memory_order_acquire) == chunks && active_ == 0;
+        });
+        job_ = {};
+    }
+
+    void WorkerPool::work(const Job &job) {
+        size_t index;
+        while ((index = next_chunk_.fetch_add(1, std::memory_order_relaxed)) < job.chunks) {
+            const size_t begin = index * job.chunk;
+            job.task(job.context, begin, std::min(job.total, begin + job.chunk));
+            done_chunks_.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void WorkerPool::workerLoop() {
+        uint64_t seen = 0;
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_ready_.wait(lock, [&] { return stop_ || (generation_ != seen && job_.task != nullptr); });
+                if (stop_) return;
+                seen = generation_;
+                job = job_;
+                ++active_;
+            }
+
+            work(job);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --active_;
+            }
+            work_done_.notify_all();
+        }
+    }
+}
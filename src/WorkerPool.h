@@ -0,0 +1,73 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jvmti_tools {
+    // 小型本地线程池：按块并行处理一段连续数据，调用线程同时参与计算。
+    // 同一时刻只执行一个任务，池忙时调用方直接单线程处理，不排队等待。
+    class WorkerPool {
+    private:
+        using Task = void (*)(void *context, size_t begin, size_t end);
+
+        struct Job {
+            Task task = nullptr;
+            void *context = nullptr;
+            size_t total = 0;
+            size_t chunk = 0;
+            size_t chunks = 0;
+        };
+
+        std::vector<std::thread> workers_;
+        std::mutex submit_mutex_; // 保证同一时刻只有一个任务
+        std::mutex mutex_;
+        std::condition_variable work_ready_;
+        std::condition_variable work_done_;
+        Job job_;
+        uint64_t generation_ = 0;
+        size_t active_ = 0; // 正在处理当前任务的工作线程数
+        bool stop_ = false;
+        std::atomic<size_t> next_chunk_{0};
+        std::atomic<size_t> done_chunks_{0};
+
+    public:
+        explicit WorkerPool(size_t workers);
+
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &) = delete;
+
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        // 按 cgroup CPU 配额确定线程数的共享线程池，首次使用时创建
+        static WorkerPool &shared();
+
+        // 可用 CPU 数：取 CPU 亲和性、cgroup v1/v2 配额与硬件线程数中的最小值
+        static size_t availableCpus();
+
+        // 参与计算的线程数（含调用线程）
+        size_t concurrency() const { return workers_.size() + 1; }
+
+        // 将 [0, total) 按 chunk 切分后并行执行 fn(begin, end)，各块互不重叠，返回时全部完成
+        template<typename F>
+        void parallelFor(const size_t total, const size_t chunk, F &&fn) {
+            run(total, chunk, [](void *context, const size_t begin, const size_t end) {
+                (*static_cast<std::remove_reference_t<F> *>(context))(begin, end);
+            }, &fn);
+        }
+
+    private:
+        void run(size_t total, size_t chunk, Task task, void *context);
+
+        void work(const Job &job);
+
+        void workerLoop();
+    };
+}
+
+#endif //WORKERPOOL_H
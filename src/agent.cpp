@@ -3,21 +3,47 @@
 #ifdef _WIN32
 #include <Windows.h>
 #endif
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <fstream>
 #include <iostream>
-#include <filesystem>
 #include <mutex>
+#include <optional>
 #include <atomic>
-#include <regex>
-#include <shared_mutex>
+#include <unordered_map>
 #include <unordered_set>
-
+#include <utility>
+
+#include "jhook/JHookModule.h"
+#include "jvmti/AgentHost.h"
+#include "jvmti/AgentThread.h"
+#include "jvmti/AllocationProfiler.h"
+#include "jvmti/ByteArray.h"
+#include "jvmti/ClassFile.h"
+#include "jvmti/Config.h"
+#include "jvmti/CpuSampler.h"
+#include "jvmti/ExceptionProfiler.h"
+#include "jvmti/GcTimeline.h"
+#include "jvmti/HeapHistogram.h"
+#include "jvmti/JitStats.h"
+#include "jvmti/Metrics.h"
+#include "jvmti/MonitorProfiler.h"
+#include "jvmti/NativeInterceptor.h"
+#include "jvmti/Options.h"
+#include "jvmti/PerfMap.h"
+#include "jvmti/Probe.h"
+#include "jvmti/Retransformer.h"
+#include "jvmti/ThreadState.h"
+#include "jvmti/WallSampler.h"
 #include "spdlog/async.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 using namespace std;
+using jvmti_tools::className;
+using jvmti_tools::isClassEncrypted;
 
 class JvmtiLogger {
     static std::shared_ptr<spdlog::details::thread_pool> tp;
@@ -90,6 +116,13 @@ public:
         spdlog::shutdown();
         tp.reset(); // 释放线程池
     }
+
+    // 异步日志队列深度与因队列满被丢弃的消息数（供指标采样）
+    static std::pair<size_t, size_t> queueStats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!tp) return {0, 0};
+        return {tp->queue_size(), tp->overrun_counter()};
+    }
 };
 
 // 静态成员初始化
@@ -98,12 +131,51 @@ std::shared_ptr<spdlog::logger> JvmtiLogger::logger = nullptr;
 std::mutex JvmtiLogger::mutex_;
 std::atomic<bool> JvmtiLogger::shutdown_(false);
 
-static const std::regex exclude_class_pattern("^(L)?(apple|java|jdk|sun|com/sun|com/apple)/");
-static const std::regex include_class_pattern(
-    "^L?com/fr/(general|license|plugin|protect|record|regist|security|stable|startup|web|workspace|jvm)|TestApp|DataGuard");
-static std::shared_ptr<unordered_set<std::string> > encryptedClasses = nullptr;
+// 由事件回调读取的模块对象：事件可能先于对象创建启用（再次附加时新启用的模块），
+// 创建后以 release 发布、回调以 acquire 读取，回调读到空指针时直接返回。对象保留到模块卸载
+template<typename T>
+class Published {
+private:
+    std::unique_ptr<T> owner_;
+    std::atomic<T *> value_{nullptr};
+
+public:
+    T *get() const { return value_.load(std::memory_order_acquire); }
+
+    T *operator->() const { return get(); }
+
+    explicit operator bool() const { return get() != nullptr; }
+
+    void publish(std::unique_ptr<T> value) {
+        owner_ = std::move(value);
+        value_.store(owner_.get(), std::memory_order_release);
+    }
+};
+
+// 已发现的加密类（内部类名）：ClassFileLoadHook 可能在多个类加载线程中并发写入，
+// 再次附加时取快照交给 Retransformer，转换期间触发的回调不会与遍历冲突
+class EncryptedClasses {
+private:
+    mutable std::mutex mutex_;
+    std::unordered_set<std::string> names_;
 
-static jvmtiEnv *jvmti = nullptr; // 全局JVMTI环境指针
+public:
+    // 返回加入后的数量
+    size_t insert(const char *name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        names_.emplace(name);
+        return names_.size();
+    }
+
+    std::unordered_set<std::string> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return names_;
+    }
+};
+
+static EncryptedClasses encryptedClasses;
+
+static Published<jvmti_tools::NativeInterceptor> native_interceptor; // 通用 native 方法拦截器
 // static JNIEnv *jni = nullptr; // 全局JNI环境指针
 // static bool agent_onloaded = false; // 全局标记
 // static bool agent_unloaded = false; // 全局标记
@@ -133,79 +205,6 @@ namespace jvmti_tools {
     }
 }
 
-std::string className(const char *class_signature) {
-    // 移除类签名中的 'L' 和 ';'
-    std::string class_name(class_signature);
-    if (class_name[0] == 'L' && class_name[class_name.length() - 1] == ';') {
-        class_name = class_name.substr(1, class_name.length() - 2);
-    }
-    return class_name;
-}
-
-namespace fs = std::filesystem;
-static std::mutex dump_mutex;
-
-std::string removeTrailingSlash(const std::string &base_path) {
-    namespace fs = std::filesystem;
-    fs::path p = base_path;
-    if (!p.empty() && p.filename() == "") {
-        // 尾部是斜杠
-        p = p.parent_path();
-    }
-    return p.string();
-}
-
-// 转储类文件到磁盘
-void dump_class_file(const std::string &base, const std::string &class_name,
-                     const unsigned char *class_data,
-                     const jint class_data_len, const atomic_bool &encrypted_class = false) {
-    if (!class_data || class_data_len <= 0) {
-        return;
-    }
-
-    const auto logger = JvmtiLogger::get();
-
-    // 创建输出目录
-    std::string file_path = std::format("{0}/{2}/{1}.class", removeTrailingSlash(base), class_name,
-                                        encrypted_class ? "classes_encrypted" : "classes");
-
-    // logger->warn("file path {}", file_path);
-
-    const fs::path dir = fs::path(file_path).parent_path();
-    try {
-        if (!fs::exists(dir)) {
-            fs::create_directories(dir);
-        }
-    } catch (const fs::filesystem_error &ex) {
-        if (logger) logger->error("Failed to create directory: {}", ex.what());
-        return;
-    }
-
-    // 写入类文件
-    std::lock_guard<std::mutex> lock(dump_mutex);
-    try {
-        if (std::ofstream file(file_path, std::ios::binary); file.is_open()) {
-            file.write(reinterpret_cast<const char *>(class_data), class_data_len);
-            file.close();
-        } else {
-            if (logger) logger->error("Failed to open file: {}", file_path);
-        }
-    } catch (const std::exception &ex) {
-        if (logger) logger->error("Error dumping class: {}", ex.what());
-    }
-}
-
-// 检测类是否被加密（示例逻辑，需根据实际加密方式调整）
-bool isClassEncrypted(const unsigned char *class_data, const jsize class_data_len) {
-    // 示例：检查类文件魔数（正常Java类魔数为0xCAFEBABE）
-    if (class_data_len >= 4 &&
-        (class_data[0] != 0xCA || class_data[1] != 0xFE ||
-         class_data[2] != 0xBA || class_data[3] != 0xBE)) {
-        return true; // 魔数不匹配，可能被加密
-    }
-    return false;
-}
-
 jmethodID get_name_method;
 jclass class_loader_class;
 // ClassFileLoadHook 回调函数
@@ -221,29 +220,36 @@ void JNICALL class_file_load_hook_callback(
     jint *new_class_data_len,
     unsigned char **new_class_data
 ) {
-    if (!name || std::regex_search(name, exclude_class_pattern)) return;
-    if (std::regex_search(name, include_class_pattern)) {
+    if (!name) return;
+    const jvmti_tools::ScopedTimer timer(jvmti_tools::Timer::ClassFileLoadHook);
+    jvmti_tools::Metrics::global().add(jvmti_tools::Counter::ClassesSeen);
+    // 读取当前配置快照（无锁、无拷贝），回调返回前快照不会被回收
+    const auto config = jvmti_tools::ConfigStore::global().acquire();
+    if (config->class_exclude.matches(name)) return;
+    if (config->class_include.matches(name)) {
         const bool is_encrypted = isClassEncrypted(class_data, class_data_len);
         // 验证魔数
         if (is_encrypted) {
-            encryptedClasses->insert(name);
+            const size_t count = encryptedClasses.insert(name);
+            jvmti_tools::Metrics::global().add(jvmti_tools::Counter::EncryptedClasses);
             const auto log = JvmtiLogger::get();
-            log->trace("JVMTI ClassFileLoad: encrypted_class [{}] {}",
-                       std::format("{:04}", encryptedClasses->size()), name);
+            log->trace("JVMTI ClassFileLoad: encrypted_class [{}] {}", std::format("{:04}", count), name);
         }
         // todo 获取类加载器名称, 查看到底是哪个类加载器解密的，或者是 attach agent 解密的
         // log->trace("JVMTI ClassFileLoad: {}", name);
 
-        // 转储原始类文件
-        dump_class_file("/Users/wuyujie/Project/opensource/jvmti-demo/",
-                        name, class_data, class_data_len, is_encrypted);
+        // 转储原始类文件（dump=目录）
+        if (!config->dump_path.empty()) {
+            jvmti_tools::dumpClassFile(config->dump_path, name, class_data, class_data_len, is_encrypted,
+                                       JvmtiLogger::get().get());
+        }
     }
 }
 
 
 // 方法进入事件回调
 void method_entry_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jmethodID method) {
-    // if (!agent_state->getConfig().enabled) return;
+    // if (!agent_state->getConfig()->trace_enabled) return;
     //
     // // 获取方法所属类
     // jclass declaring_class;
@@ -257,22 +263,15 @@ void method_entry_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread,
     //
     // bool is_target = false;
     // if (class_signature) {
-    //     const std::string sig(class_signature);
-    //     for (const auto &pkg: agent_state->getConfig().target_packages) {
-    //         if (sig.find(pkg) != std::string::npos) {
-    //             is_target = true;
-    //             logger->trace("method_entry_callback => {} contains {}", sig.find(pkg), sig, pkg);
-    //             break;
-    //         }
-    //     }
+    //     is_target = agent_state->getConfig()->trace_packages.matches(class_signature);
     //     jvmti_env->Deallocate(reinterpret_cast<unsigned char *>(class_signature));
     // }
     //
     // if (!is_target) return;
     //
     // // 记录方法开始时间
-    // auto &data = jvmti_tools::AgentState::getThreadData(jvmti, thread);
-    // data.call_stack.push({method, std::chrono::high_resolution_clock::now()});
+    // auto *data = jvmti_tools::AgentState::getThreadData(jvmti_env, thread);
+    // if (data) data->call_stack.push_back({method, std::chrono::high_resolution_clock::now()});
 
     // 获取方法所属类
     jclass declaring_class;
@@ -337,11 +336,11 @@ void method_exit_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread,
     return;
     // if (!agent_state->getConfig().enabled) return;
     //
-    // auto &data = jvmti_tools::AgentState::getThreadData(jvmti, thread);
-    // if (data.call_stack.empty()) return;
+    // auto *data = jvmti_tools::AgentState::getThreadData(jvmti_env, thread);
+    // if (!data || data->call_stack.empty()) return;
     //
     // // 获取栈顶调用记录
-    // const auto &call = data.call_stack.top();
+    // const auto &call = data->call_stack.back();
     //
     // // 计算耗时（毫秒）
     // auto end_time = std::chrono::high_resolution_clock::now();
@@ -360,7 +359,7 @@ void method_exit_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread,
     //
     // // 构建耗时记录
     // jvmti_tools::MethodTiming timing;
-    // timing.thread_name = data.thread_name;
+    // timing.thread_name = data->name;
     // timing.class_name = class_sig ? class_sig : "unknown";
     // timing.method_name = method_name ? method_name : "unknown";
     // timing.elapsed_ms = elapsed.count();
@@ -374,7 +373,7 @@ void method_exit_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread,
     // if (class_sig) jvmti->Deallocate(reinterpret_cast<unsigned char *>(class_sig));
     //
     // // 弹出栈顶
-    // data.call_stack.pop();
+    // data->call_stack.pop_back();
 
     // return;
     // const auto logger = JvmtiLogger::get();
@@ -430,152 +429,47 @@ private:
     unsigned char *ptr;
 };
 
-// 执行类转换函数
-jvmtiError retransform_target_classes(jvmtiEnv *jvmti, const std::unordered_set<std::string> &target_classes) {
-    // 1. 检查目标类集合是否为空
-    if (target_classes.empty()) return JVMTI_ERROR_NONE;
-
-    // 2. 获取所有已加载的类
-    jclass *classes = nullptr;
-    jint class_count = 0;
-    jvmtiError err = jvmti->GetLoadedClasses(&class_count, &classes);
-    if (err != JNI_OK) {
-        return err;
-    }
-
-    // 3. 筛选出需要重新转换的类
-    std::vector<jclass> classes_to_retransform;
-    const auto logger = JvmtiLogger::get();
-
-    char *class_signature = nullptr;
-    for (jint i = 0; i < class_count; i++) {
-        jvmti->GetClassSignature(classes[i], &class_signature, nullptr);
-        std::string class_name = className(class_signature);
-        // 检查是否是目标类
-        for (const auto &target: target_classes) {
-            if (class_name == target) {
-                logger->trace("Found target class: {}", class_name);
-                classes_to_retransform.push_back(classes[i]);
-                break;
-            }
-        }
-    }
-    jvmti->Deallocate(reinterpret_cast<unsigned char *>(class_signature));
-    // 释放类列表
-    jvmti->Deallocate(reinterpret_cast<unsigned char *>(classes));
-
-    // 执行类转换
-    if (!classes_to_retransform.empty()) {
-        logger->trace("Retransforming classes {} ...", classes_to_retransform.size());
-        err = jvmti->RetransformClasses(classes_to_retransform.size(), classes_to_retransform.data());
-        if (err != JNI_OK) {
-            logger->error("Failed to retransform classes");
-        }
-    }
-
-    return err;
-}
-
 // 跳板结构 - 用于保存原始方法信息
 struct NativeMethodTrampoline {
-    void *original_address; // 原始方法地址
-    // void *replacement; // 替换方法地址
-    bool active; // 是否激活
+    std::atomic<void *> original_address{nullptr}; // 原始方法地址（绑定时写入，调用时只读）
 };
 
-// 全局跳板注册表
-static std::unordered_map<jmethodID, NativeMethodTrampoline> trampoline_registry;
-static std::shared_mutex registry_mutex; // 读写锁
+// 跳板槽位数量：每个被拦截的 native 方法独占一个槽位
+constexpr size_t MAX_NATIVE_TRAMPOLINES = 16;
+static NativeMethodTrampoline trampoline_slots[MAX_NATIVE_TRAMPOLINES];
 
-std::string jbyte_array_to_string(JNIEnv *env, jbyteArray byteArray) {
-    // 1. 检查输入是否为NULL
-    if (byteArray == nullptr) {
-        return "";
-    }
-
-    // 2. 获取数组长度
-    const jsize length = env->GetArrayLength(byteArray);
-    if (length <= 0) {
-        return "";
-    }
+// 方法与槽位的映射，仅在绑定事件中使用（重复绑定时复用槽位）
+static std::unordered_map<jmethodID, size_t> trampoline_registry;
+static std::mutex registry_mutex;
 
-    // 3. 获取数组元素
-    jbyte *bytes = env->GetByteArrayElements(byteArray, nullptr);
-    if (bytes == nullptr) {
-        return "";
-    }
+// 直接绑定到本模块代码（未经 JHook 跳板）的 native 方法数量；不为 0 时模块不能被 JHook 卸载
+static std::atomic<size_t> rebound_natives{0};
 
-    // 4. 转换为字符串（假设使用UTF-8编码）
-    std::string result(reinterpret_cast<char *>(bytes), length);
+// 由 JHook 加载时的服务，native 方法经其中的稳定跳板绑定
+static const JHookShim *jhook_shim = nullptr;
 
-    // 5. 释放数组元素
-    env->ReleaseByteArrayElements(byteArray, bytes, JNI_ABORT); // 使用JNI_ABORT避免复制回JVM
-
-    return result;
-}
-
-// 检查字节数组前几位是否满足条件
+// 检查字节数组前几位是否满足条件（短前缀读入栈缓冲区，不在堆上分配）
 bool check_header_bytes(JNIEnv *env, jbyteArray data, const char *expected, size_t expected_len) {
     if (!data || !expected || expected_len == 0) return false;
-
-    jsize len = env->GetArrayLength(data);
-    if (len < static_cast<jsize>(expected_len)) return false;
-
-    jbyte *buffer = new jbyte[expected_len];
-    env->GetByteArrayRegion(data, 0, expected_len, buffer);
-
-    bool match = memcmp(buffer, expected, expected_len) == 0;
-    delete[] buffer;
-
-    return match;
+    return jvmti_tools::ByteArrays::startsWith(env, data, std::string_view(expected, expected_len));
 }
 
-// 自定义解密函数
+// 自定义解密函数：去掉前4字节，由原数组直接拷贝到新数组
 jbyteArray custom_decrypt(JNIEnv *env, jbyteArray data) {
     // 获取原始数据长度
-    jsize original_len = env->GetArrayLength(data);
+    const jsize original_len = env->GetArrayLength(data);
     if (original_len <= 4) {
         // 数据长度不足4字节，直接返回空
         return nullptr;
     }
-
-    // 计算解密后的数据长度（去掉前4字节）
-    jsize decrypted_len = original_len - 4;
-
-    // 创建新的字节数组用于存储解密后的数据
-    jbyteArray decrypted_data = env->NewByteArray(decrypted_len);
-    if (!decrypted_data) {
-        return nullptr; // 内存分配失败
-    }
-
-    // 提取原始数据中除前4字节外的内容
-    jbyte *buffer = new jbyte[decrypted_len];
-    env->GetByteArrayRegion(data, 4, decrypted_len, buffer);
-
-    // 设置解密后的数据
-    env->SetByteArrayRegion(decrypted_data, 0, decrypted_len, buffer);
-
-    // 释放临时缓冲区
-    delete[] buffer;
-
-    return decrypted_data;
+    return jvmti_tools::ByteArrays::copyOfRange(env, data, 4, original_len - 4);
 }
 
 // 替换后的解密函数 - 会调用原始实现
-JNIEXPORT jbyteArray JNICALL new_decrypt(JNIEnv *env, jobject object, jbyteArray data) {
-    // 记录方法信息
-    const auto log = JvmtiLogger::get();
-    // 获取当前方法ID
-    const auto clazz = env->GetObjectClass(object);
-    jmethodID method_id = env->GetMethodID(clazz, "decrypt", "([B)[B");
-    if (!method_id) {
-        return nullptr;
-    }
-
-    // 获取原始方法地址
-    std::shared_lock<std::shared_mutex> lock(registry_mutex);
-    const auto it = trampoline_registry.find(method_id);
-    if (it == trampoline_registry.end()) {
+jbyteArray new_decrypt(JNIEnv *env, jobject object, jbyteArray data, const NativeMethodTrampoline &trampoline) {
+    // 原始地址由绑定回调在发布新地址之前写入
+    const auto original_address = trampoline.original_address.load(std::memory_order_acquire);
+    if (!original_address) {
         return nullptr;
     }
 
@@ -584,56 +478,91 @@ JNIEXPORT jbyteArray JNICALL new_decrypt(JNIEnv *env, jobject object, jbyteArray
 
     jbyteArray result;
     const bool header_matched = check_header_bytes(env, data, expected_header, 4);
-    log->warn("header_matched: {}", header_matched);
     if (header_matched) {
         // 满足条件时使用自定义解密方法
         result = custom_decrypt(env, data);
     } else {
         // 不满足条件时使用原始解密方法
         typedef jbyteArray (*DecryptFunc)(JNIEnv *, jobject, jbyteArray);
-        const auto original_decrypt = reinterpret_cast<DecryptFunc>(it->second.original_address);
+        const auto original_decrypt = reinterpret_cast<DecryptFunc>(original_address);
+        // 调用路径上不写日志：格式化解密结果需要分配内存，异步日志器入队需要加锁
         result = original_decrypt(env, object, data);
-        auto str = jbyte_array_to_string(env, result);
-        log->info("{}方法解密结果: {}", header_matched ? "自定义" : "原始", str);
     }
 
     return result;
 }
 
-// 本地方法绑定回调函数
-void native_method_bind_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jmethodID method,
-                                 void *address, void **new_address_ptr) {
-    // 定义静态正则表达式（避免重复编译）
-    static const std::regex exclude_pattern("^L?(java|sun|jdk)/");
-    static const std::regex include_pattern("^L?(com/fr/|TestApp|DataGuard)");
-    static const std::regex target_class_pattern("^L?com/fr/license/selector/EncryptedLicenseSelector|DataGuard");
+// 每个槽位对应一个独立的跳板函数，原始地址在编译期绑定到槽位，调用路径无需 JNI 查找和加锁
+template<size_t Slot>
+JNIEXPORT jbyteArray JNICALL decrypt_trampoline(JNIEnv *env, jobject object, jbyteArray data) {
+    return new_decrypt(env, object, data, trampoline_slots[Slot]);
+}
+
+template<size_t... Slots>
+std::array<void *, sizeof...(Slots)> make_decrypt_trampolines(std::index_sequence<Slots...>) {
+    return {reinterpret_cast<void *>(&decrypt_trampoline<Slots>)...};
+}
+
+static const auto decrypt_trampolines = make_decrypt_trampolines(std::make_index_sequence<MAX_NATIVE_TRAMPOLINES>{});
+
+// 为目标方法分配跳板槽位，返回跳板地址；槽位耗尽时返回 nullptr
+void *bind_decrypt_trampoline(const jmethodID method, void *address) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    size_t slot;
+    if (const auto it = trampoline_registry.find(method); it != trampoline_registry.end()) {
+        slot = it->second;
+    } else if (trampoline_registry.size() < MAX_NATIVE_TRAMPOLINES) {
+        slot = trampoline_registry.size();
+        trampoline_registry[method] = slot;
+    } else {
+        return nullptr;
+    }
+
+    trampoline_slots[slot].original_address.store(address, std::memory_order_release);
+    return decrypt_trampolines[slot];
+}
+
+// native 方法的新绑定：target 为本模块中的实现（解密跳板或拦截跳板），为空表示保持原绑定
+struct NativeBinding {
+    void *target = nullptr;
+    std::string signature;
+};
+
+// 按当前配置确定 native 方法的新绑定，address 为方法的原始实现
+NativeBinding resolve_native_binding(jvmtiEnv *jvmti_env, const jmethodID method, void *address) {
+    NativeBinding binding;
+    const auto config = jvmti_tools::ConfigStore::global().acquire();
 
     // 获取方法所在的类
     jclass method_class;
     if (jvmti_env->GetMethodDeclaringClass(method, &method_class) != JVMTI_ERROR_NONE) {
-        return;
+        return binding;
     }
 
     // 获取类签名
     char *class_signature = nullptr;
     if (jvmti_env->GetClassSignature(method_class, &class_signature, nullptr) != JVMTI_ERROR_NONE) {
-        return;
+        return binding;
     }
     JvmtiResource classResource(jvmti_env, reinterpret_cast<unsigned char *>(class_signature));
 
-    // 过滤不需要的类
-    if (!class_signature || std::regex_search(class_signature, exclude_pattern)) {
-        return;
+    // 过滤不需要的类；命中拦截规则的类不受包含/排除规则限制
+    if (!class_signature) {
+        return binding;
     }
-    if (!std::regex_search(class_signature, include_pattern)) {
-        return;
+    const auto class_name = className(class_signature);
+    const bool profiled = native_interceptor && native_interceptor->matchesClass(class_name);
+    const bool included = !config->native_exclude.matches(class_name)
+                          && config->native_include.matches(class_name);
+    if (!included && !profiled) {
+        return binding;
     }
 
     // 获取方法名称和签名
     char *method_name = nullptr;
     char *method_signature = nullptr;
     if (jvmti_env->GetMethodName(method, &method_name, &method_signature, nullptr) != JVMTI_ERROR_NONE) {
-        return;
+        return binding;
     }
     JvmtiResource methodNameResource(jvmti_env, reinterpret_cast<unsigned char *>(method_name));
     JvmtiResource methodSigResource(jvmti_env, reinterpret_cast<unsigned char *>(method_signature));
@@ -641,16 +570,19 @@ void native_method_bind_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread t
     // 获取方法修饰符
     jint method_modifiers;
     if (jvmti_env->GetMethodModifiers(method, &method_modifiers) != JVMTI_ERROR_NONE) {
-        return;
+        return binding;
     }
 
     // 记录方法信息
     const auto log = JvmtiLogger::get();
-    log->info("JVMTI NativeMethod: {}.{}{}", className(class_signature), method_name, method_signature);
+    if (included) {
+        log->info("JVMTI NativeMethod: {}.{}{}", class_name, method_name, method_signature);
+    }
 
     // 检查是否为目标方法
     const bool isTargetMethod =
-            std::regex_search(class_signature, target_class_pattern) &&
+            included &&
+            config->decrypt_classes.matches(class_name) &&
             (method_modifiers & JVM_ACC_PUBLIC) == JVM_ACC_PUBLIC &&
             // (method_modifiers & JVM_ACC_STATIC) == JVM_ACC_STATIC &&
             (method_modifiers & JVM_ACC_NATIVE) == JVM_ACC_NATIVE &&
@@ -659,30 +591,71 @@ void native_method_bind_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread t
 
     if (isTargetMethod) {
         log->warn("发现目标方法: {} {}", method_name, method_signature);
-        // 保存原始方法信息
-        {
-            std::unique_lock<std::shared_mutex> lock(registry_mutex);
-            trampoline_registry[method] = {
-                .original_address = address,
-                // .replacement = *new_address_ptr,
-                .active = true
-            };
-        }
 
         if ((method_modifiers & JVM_ACC_STATIC) == JVM_ACC_STATIC) {
-            *new_address_ptr = reinterpret_cast<void *>(jvmti_tools::encrypt);
+            binding.target = reinterpret_cast<void *>(jvmti_tools::encrypt);
+            log->warn("原始地址: {} => 新地址: {}", address, binding.target);
+        } else if (void *trampoline = bind_decrypt_trampoline(method, address)) {
+            binding.target = trampoline;
+            log->warn("原始地址: {} => 新地址: {}", address, binding.target);
         } else {
-            *new_address_ptr = reinterpret_cast<void *>(&new_decrypt);
+            log->error("跳板槽位已耗尽({})，保持原始绑定: {}.{}", MAX_NATIVE_TRAMPOLINES, class_name, method_name);
         }
+    }
 
-        log->warn("原始地址: {} => 新地址: {}", address, *new_address_ptr);
+    // 通用拦截：包装当前绑定地址（可能已被替换为上面的解密跳板）
+    if (profiled && native_interceptor->matches(class_name, method_name, method_signature)) {
+        void *target = binding.target ? binding.target : address;
+        if (void *thunk = native_interceptor->bind(method, class_name, method_name, method_signature, target)) {
+            binding.target = thunk;
+            log->info("JVMTI NativeIntercept: {}.{}{} {} => {}", class_name, method_name, method_signature,
+                      target, thunk);
+        } else {
+            log->warn("JVMTI NativeIntercept: 签名不支持或跳板槽位已耗尽，跳过 {}.{}{}", class_name, method_name,
+                      method_signature);
+        }
+    }
+
+    if (binding.target) binding.signature = method_signature;
+    return binding;
+}
+
+// 返回 VM 应绑定的地址：由 JHook 加载时绑定 JHook 中的稳定跳板，模块卸载后方法仍指向有效代码；
+// 跳板不可用时直接绑定模块代码，此后模块不能再被卸载
+void *publish_native_binding(const jmethodID method, void *address, const NativeBinding &binding) {
+    jvmti_tools::Metrics::global().add(jvmti_tools::Counter::ReboundNatives);
+    if (jhook_shim) {
+        if (const auto shape = jvmti_tools::wordSignature(binding.signature)) {
+            if (void *stub = jhook_shim->bindNative(method, address, binding.target, static_cast<jint>(shape->words),
+                                                    shape->returns_void ? JNI_TRUE : JNI_FALSE)) {
+                return stub;
+            }
+        }
+        JvmtiLogger::get()->warn("JHook native 跳板不可用，直接绑定到模块代码，模块将不能被卸载: {}",
+                                 binding.signature);
+    }
+    rebound_natives.fetch_add(1, std::memory_order_relaxed);
+    return binding.target;
+}
+
+// 重新加载后由 JHook 为已绑定的跳板确定新目标
+void *JNICALL resolve_jhook_native(void *context, const jmethodID method, void *original) {
+    return resolve_native_binding(static_cast<jvmtiEnv *>(context), method, original).target;
+}
+
+// 本地方法绑定回调函数
+void native_method_bind_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jmethodID method,
+                                 void *address, void **new_address_ptr) {
+    const jvmti_tools::ScopedTimer timer(jvmti_tools::Timer::NativeMethodBind);
+    jvmti_tools::Metrics::global().add(jvmti_tools::Counter::NativeBinds);
+
+    if (const auto binding = resolve_native_binding(jvmti_env, method, address); binding.target) {
+        *new_address_ptr = publish_native_binding(method, address, binding);
     }
 }
 
 char *class_signature;
 jobject class_loader;
-// 缓存已处理的线程信息，避免重复查询
-std::unordered_map<jthread, jvmtiThreadInfo> threadInfoCache;
 
 void class_load_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jclass klass) {
     const auto logger = JvmtiLogger::get();
@@ -690,87 +663,36 @@ void class_load_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, j
     if (const auto class_name = className(class_signature); startsWith(
         class_name, "com/fr/license/selector/LicenseConstants")) {
         logger->warn("class_load_callback: {}", class_name);
-        if (const auto it = threadInfoCache.find(thread); it != threadInfoCache.end()) {
-            logger->warn("class_load_callback: thread: {}，class: {}", it->second.name, class_name);
+        // 线程名由 thread_start_callback 缓存在线程状态中
+        if (const auto *state = jvmti_tools::ThreadStates::find(jvmti_env, thread); state && !state->name.empty()) {
+            logger->warn("class_load_callback: thread: {}，class: {}", state->name, class_name);
         }
     }
 }
 
 void class_prepare_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jclass klass) {
-    // 静态常量正则表达式，避免重复编译
-    static const std::regex product_constants_pattern("Lcom/fr/stable/ProductConstants;$");
-    static const std::regex general_utils_pattern("^Lcom/fr/general/GeneralUtils;$");
-
-    const auto logger = JvmtiLogger::get();
-    char *class_signature = nullptr;
+    const jvmti_tools::ScopedTimer timer(jvmti_tools::Timer::ClassPrepare);
+    const auto config = jvmti_tools::ConfigStore::global().acquire();
+    if (config->probes.empty()) return;
 
     // 获取类签名
+    char *class_signature = nullptr;
     if (jvmti_env->GetClassSignature(klass, &class_signature, nullptr) != JVMTI_ERROR_NONE) {
         return;
     }
+    JvmtiResource classResource(jvmti_env, reinterpret_cast<unsigned char *>(class_signature));
 
-    // 辅助函数：安全获取字符串字段值并记录日志
-    auto getAndLogStringField = [&](const char *fieldName, const char *signature) {
-        const jfieldID fieldId = jni_env->GetStaticFieldID(klass, fieldName, signature);
-        if (!fieldId) {
-            logger->warn("Field {} not found!", fieldName);
-            return;
-        }
-
-        const auto strObj = static_cast<jstring>(jni_env->GetStaticObjectField(klass, fieldId));
-        if (!strObj) {
-            logger->warn("Field {} value is null!", fieldName);
-            return;
-        }
-
-        if (const char *cStr = jni_env->GetStringUTFChars(strObj, nullptr)) {
-            logger->info("{}: {}", fieldName, cStr);
-            jni_env->ReleaseStringUTFChars(strObj, cStr);
-        }
-        jni_env->DeleteLocalRef(strObj);
-    };
-
-    // 辅助函数：安全调用静态方法并记录返回的字符串
-    auto callAndLogStaticStringMethod = [&](const char *methodName, const char *signature) {
-        const jmethodID methodId = jni_env->GetStaticMethodID(klass, methodName, signature);
-        if (!methodId) {
-            logger->warn("Method {} not found!", methodName);
-            return;
-        }
-
-        const auto strObj = static_cast<jstring>(jni_env->CallStaticObjectMethod(klass, methodId));
-        if (jni_env->ExceptionCheck()) {
-            jni_env->ExceptionDescribe();
-            jni_env->ExceptionClear();
-            return;
-        }
-
-        if (!strObj) {
-            logger->warn("Method {} returned null!", methodName);
-            return;
-        }
+    // 未配置探针的类只需一次哈希查找
+    const auto *targets = config->probes.find(class_signature);
+    if (!targets) return;
 
-        if (const char *cStr = jni_env->GetStringUTFChars(strObj, nullptr)) {
-            logger->info("{}: {}", methodName, cStr);
-            // todo 存储方法返回值
-            jni_env->ReleaseStringUTFChars(strObj, cStr);
+    const auto logger = JvmtiLogger::get();
+    for (const auto &value: jvmti_tools::ProbeTable::global().capture(jni_env, klass, class_signature, *targets)) {
+        if (value.ok) {
+            logger->info("JVMTI Probe: {}#{} = {}", value.class_name, value.member, value.value);
+        } else {
+            logger->warn("JVMTI Probe: {}#{} failed: {}", value.class_name, value.member, value.value);
         }
-        jni_env->DeleteLocalRef(strObj);
-    };
-
-    // 处理 ProductConstants 类
-    if (std::regex_match(class_signature, product_constants_pattern)) {
-        getAndLogStringField("VERSION", "Ljava/lang/String;");
-    }
-    // 处理 GeneralUtils 类
-    else if (std::regex_match(class_signature, general_utils_pattern)) {
-        callAndLogStaticStringMethod("readBuildNO", "()Ljava/lang/String;");
-        callAndLogStaticStringMethod("getVersion", "()Ljava/lang/String;");
-    }
-
-    // 释放类签名资源
-    if (class_signature) {
-        jvmti_env->Deallocate(reinterpret_cast<unsigned char *>(class_signature));
     }
 }
 
@@ -778,13 +700,21 @@ void class_prepare_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread
 void thread_start_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, const jthread thread) {
     const auto logger = JvmtiLogger::get();
     try {
-        jvmtiThreadInfo threadInfo;
-        jvmti_env->GetThreadInfo(thread, &threadInfo);
-        threadInfoCache[thread] = threadInfo;
-        logger->info("Thread started: [{}]", threadInfo.name);
-        if (startsWith(threadInfo.name, "main")
-            || startsWith(threadInfo.name, "Attach Listener")
-            || startsWith(threadInfo.name, "Thread-4")
+        // 线程名缓存在 JVMTI 线程本地存储的线程状态中：jthread 是局部引用，不能作为跨事件的键
+        auto *state = jvmti_tools::ThreadStates::global().get(jvmti_env, thread);
+        if (!state) return;
+        jvmtiThreadInfo threadInfo{};
+        if (jvmti_env->GetThreadInfo(thread, &threadInfo) != JVMTI_ERROR_NONE) return;
+        if (threadInfo.name) {
+            state->name = threadInfo.name;
+            jvmti_env->Deallocate(reinterpret_cast<unsigned char *>(threadInfo.name));
+        }
+        if (threadInfo.thread_group) jni_env->DeleteLocalRef(threadInfo.thread_group);
+        if (threadInfo.context_class_loader) jni_env->DeleteLocalRef(threadInfo.context_class_loader);
+        logger->info("Thread started: [{}]", state->name);
+        if (startsWith(state->name, "main")
+            || startsWith(state->name, "Attach Listener")
+            || startsWith(state->name, "Thread-4")
         ) {
             jvmti_env->SetEventNotificationMode(JVMTI_ENABLE, JVMTI_EVENT_METHOD_ENTRY, thread);
             jvmti_env->SetEventNotificationMode(JVMTI_ENABLE, JVMTI_EVENT_METHOD_EXIT, thread);
@@ -797,12 +727,11 @@ void thread_start_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, const jthread t
 void thread_end_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, const jthread thread) {
     const auto logger = JvmtiLogger::get();
     try {
-        if (const auto it = threadInfoCache.find(thread); it != threadInfoCache.end()) {
-            logger->info("Thread ended: {}", it->second.name);
-            threadInfoCache.erase(it);
-            if (startsWith(it->second.name, "main")
-                || startsWith(it->second.name, "Attach Listener")
-                || startsWith(it->second.name, "Thread-4")
+        if (const auto *state = jvmti_tools::ThreadStates::find(jvmti_env, thread); state) {
+            logger->info("Thread ended: {}", state->name);
+            if (startsWith(state->name, "main")
+                || startsWith(state->name, "Attach Listener")
+                || startsWith(state->name, "Thread-4")
             ) {
                 jvmti_env->SetEventNotificationMode(JVMTI_DISABLE, JVMTI_EVENT_METHOD_ENTRY, thread);
                 jvmti_env->SetEventNotificationMode(JVMTI_DISABLE, JVMTI_EVENT_METHOD_EXIT, thread);
@@ -811,105 +740,996 @@ void thread_end_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, const jthread thr
     } catch (std::exception &e) {
         logger->error("The registration event callback failed: {}", e.what());
     }
+    jvmti_tools::ThreadStates::global().release(jvmti_env, thread);
 }
 
 void vm_start_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env) {
 }
 
+static Published<jvmti_tools::ExceptionProfiler> exception_profiler; // 异常分析
+static Published<jvmti_tools::AgentThread> exception_thread; // 定期报告线程
+
+// 异常抛出事件：catch_method 为空表示异常未被捕获
 void exception_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jmethodID method, jlocation location,
                         jobject exception,
                         jmethodID catch_method, jlocation catch_location) {
-    // // 获取异常类名
-    // const jclass exceptionClass = jni_env->GetObjectClass(exception);
-    // char* classSignature;
-    // jvmti_env->GetClassSignature(exceptionClass, &classSignature, nullptr);
-    //
-    // const auto log = JvmtiLogger::get();
-    // // 记录异常信息
-    // log->error("Exception thrown: {} at method {} at location {}", classSignature, "method", location);
-    //
-    // // 释放资源
-    // if (classSignature != nullptr) {
-    //     jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(classSignature));
-    // }
+    const jvmti_tools::ScopedTimer timer(jvmti_tools::Timer::Exception);
+    jvmti_tools::Metrics::global().add(jvmti_tools::Counter::Exceptions);
+    if (auto *profiler = exception_profiler.get()) {
+        profiler->record(jni_env, thread, method, location, exception, catch_method);
+    }
+}
+
+void exception_vm_init_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread) {
+    if (exception_thread && !exception_thread->start(jvmti_env, jni_env)) {
+        JvmtiLogger::get()->warn("Failed to start exception report thread");
+    }
+}
+
+void exception_vm_death_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env) {
+    if (exception_thread) exception_thread->stop();
+}
+
+static Published<jvmti_tools::AllocationProfiler> allocation_profiler; // 分配点采样分析
+
+// 分配采样事件（JDK 11+），按 SetHeapSamplingInterval 设置的平均间隔触发
+void sampled_object_alloc_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jobject object,
+                                   jclass object_klass, jlong size) {
+    const jvmti_tools::ScopedTimer timer(jvmti_tools::Timer::SampledObjectAlloc);
+    jvmti_tools::Metrics::global().add(jvmti_tools::Counter::AllocationSamples);
+    if (auto *profiler = allocation_profiler.get()) {
+        profiler->record(jni_env, thread, object, object_klass, size);
+    }
+}
+
+// 带标签的对象被回收：在 GC 期间调用，只允许原子操作，不能调用 JNI 与大部分 JVMTI 函数
+void object_free_callback(jvmtiEnv *jvmti_env, jlong tag) {
+    if (auto *profiler = allocation_profiler.get(); profiler && profiler->free(tag)) {
+        jvmti_tools::Metrics::global().add(jvmti_tools::Counter::FreedSamples);
+    }
+}
+
+static Published<jvmti_tools::GcTimeline> gc_timeline; // GC 停顿时间线
+
+// GC 开始/结束事件：在 GC 期间调用，不能调用 JNI 与大部分 JVMTI 函数，只记录时间戳
+void gc_start_callback(jvmtiEnv *jvmti_env) {
+    if (auto *timeline = gc_timeline.get()) timeline->gcStart();
+}
+
+void gc_finish_callback(jvmtiEnv *jvmti_env) {
+    if (auto *timeline = gc_timeline.get()) timeline->gcFinish();
+}
+
+static Published<jvmti_tools::JitStats> jit_stats; // JIT 编译活动统计
+
+void jit_compiled_method_load_callback(jvmtiEnv *jvmti_env, jmethodID method, jint code_size, const void *code_addr,
+                                       jint map_length, const jvmtiAddrLocationMap *map, const void *compile_info) {
+    const jvmti_tools::ScopedTimer timer(jvmti_tools::Timer::CompiledMethodLoad);
+    if (auto *stats = jit_stats.get()) stats->compiledMethodLoad(method, code_size, code_addr);
+}
+
+void jit_compiled_method_unload_callback(jvmtiEnv *jvmti_env, jmethodID method, const void *code_addr) {
+    if (auto *stats = jit_stats.get()) stats->compiledMethodUnload(method, code_addr);
+}
+
+void jit_dynamic_code_generated_callback(jvmtiEnv *jvmti_env, const char *name, const void *address, jint length) {
+    if (auto *stats = jit_stats.get()) stats->dynamicCodeGenerated(address, length);
+}
+
+static Published<jvmti_tools::PerfMapWriter> perf_map_writer; // perf 符号导出
+
+void perf_compiled_method_load_callback(jvmtiEnv *jvmti_env, jmethodID method, jint code_size, const void *code_addr,
+                                        jint map_length, const jvmtiAddrLocationMap *map, const void *compile_info) {
+    if (auto *writer = perf_map_writer.get()) writer->compiledMethodLoad(method, code_size, code_addr);
+}
+
+void perf_compiled_method_unload_callback(jvmtiEnv *jvmti_env, jmethodID method, const void *code_addr) {
+    if (auto *writer = perf_map_writer.get()) writer->compiledMethodUnload(method, code_addr);
+}
+
+void perf_dynamic_code_generated_callback(jvmtiEnv *jvmti_env, const char *name, const void *address, jint length) {
+    if (auto *writer = perf_map_writer.get()) writer->dynamicCodeGenerated(name, address, length);
+}
+
+static Published<jvmti_tools::MonitorProfiler> monitor_profiler; // 监视器竞争分析
+static Published<jvmti_tools::AgentThread> monitor_thread; // 定期报告线程
+
+void monitor_vm_init_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread) {
+    if (monitor_thread && !monitor_thread->start(jvmti_env, jni_env)) {
+        JvmtiLogger::get()->warn("Failed to start monitor report thread");
+    }
+}
+
+void monitor_vm_death_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env) {
+    if (monitor_thread) monitor_thread->stop();
+}
+
+void monitor_contended_enter_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jobject object) {
+    jvmti_tools::Metrics::global().add(jvmti_tools::Counter::MonitorContentions);
+    if (auto *profiler = monitor_profiler.get()) {
+        profiler->enter(jni_env, thread, object, jvmti_tools::MonitorProfiler::Kind::Contended);
+    }
+}
+
+void monitor_contended_entered_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jobject object) {
+    if (auto *profiler = monitor_profiler.get()) {
+        profiler->exit(thread, jvmti_tools::MonitorProfiler::Kind::Contended);
+    }
+}
+
+void monitor_wait_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jobject object, jlong timeout) {
+    if (auto *profiler = monitor_profiler.get()) {
+        profiler->enter(jni_env, thread, object, jvmti_tools::MonitorProfiler::Kind::Wait);
+    }
+}
+
+void monitor_waited_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jobject object,
+                             jboolean timed_out) {
+    if (auto *profiler = monitor_profiler.get()) {
+        profiler->exit(thread, jvmti_tools::MonitorProfiler::Kind::Wait);
+    }
 }
 
-void exception_catch_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread, jmethodID method,
-                              jlocation location,
-                              jobject exception) {
+// 线程结束时释放保存在线程本地存储中的代理状态
+void thread_state_end_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread) {
+    jvmti_tools::ThreadStates::global().release(jvmti_env, thread);
 }
 
-// 初始化 Agent 通用逻辑
-jint initialize_agent(JavaVM *vm, char *options) {
+// 注册归还线程状态的事件。采样线程通过 GetAllThreads 只会遇到平台线程，ThreadEnd 即可归还全部状态
+void register_thread_state_events(jvmtiEventCallbacks *callbacks) {
+    callbacks->ThreadEnd = &thread_state_end_callback;
+}
+
+// 在事件线程上创建线程状态的模块（监视器事件可能发生在虚拟线程上）请求的能力：JDK 21+ 需要
+// can_support_virtual_threads 才会发送 VirtualThreadEnd，否则虚拟线程结束时状态无法归还，
+// 每分钟上百万个虚拟线程会使状态数量持续增长
+void add_virtual_thread_state_capability(jvmtiCapabilities *capabilities) {
+#ifdef JVMTI_HAS_VIRTUAL_THREADS
+    capabilities->can_support_virtual_threads = 1;
+#endif
+}
+
+// 同时归还平台线程与虚拟线程的状态；运行在不支持虚拟线程的 VM 上时不注册 VirtualThreadEnd，避免启用事件失败
+void register_virtual_thread_state_events(jvmtiEnv *jvmti, jvmtiEventCallbacks *callbacks) {
+    register_thread_state_events(callbacks);
+#ifdef JVMTI_HAS_VIRTUAL_THREADS
+    jvmtiCapabilities potential = {};
+    if (jvmti && jvmti->GetPotentialCapabilities(&potential) == JVMTI_ERROR_NONE
+        && potential.can_support_virtual_threads) {
+        callbacks->VirtualThreadEnd = &thread_state_end_callback;
+    }
+#endif
+}
+
+static Published<jvmti_tools::CpuSampler> cpu_sampler; // 线程 CPU 采样
+static Published<jvmti_tools::AgentThread> cpu_thread; // 采样线程
+
+// 启动时加载需要等到 VMInit 才能创建采样线程
+void cpu_vm_init_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread) {
+    if (cpu_thread && !cpu_thread->start(jvmti_env, jni_env)) {
+        JvmtiLogger::get()->warn("Failed to start thread CPU sampler");
+    }
+}
+
+// 采样线程调用 JVMTI，VM 退出前必须结束
+void cpu_vm_death_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env) {
+    if (cpu_thread) cpu_thread->stop();
+}
+
+static Published<jvmti_tools::WallSampler> wall_sampler; // 墙钟采样
+static Published<jvmti_tools::AgentThread> wall_thread;
+
+void wall_vm_init_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jthread thread) {
+    if (wall_thread && !wall_thread->start(jvmti_env, jni_env)) {
+        JvmtiLogger::get()->warn("Failed to start wall-clock sampler");
+    }
+}
+
+void wall_vm_death_callback(jvmtiEnv *jvmti_env, JNIEnv *jni_env) {
+    if (wall_thread) wall_thread->stop();
+}
+
+namespace jvmti_tools {
+    // 加密类检测与转储；动态附加时分批重新转换已加载的加密类
+    class ClassFileModule final : public jvmti::Agent {
+    private:
+        RetransformOptions retransform_options_;
+
+    public:
+        const char *name() const override { return "classfile"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            // retransform_batch=批次大小，retransform_loader=加载器类名（可重复，bootstrap 表示启动类加载器）
+            retransform_options_.batch_size = static_cast<size_t>(
+                std::max(1LL, options.getInt("retransform_batch",
+                                             static_cast<long long>(retransform_options_.batch_size))));
+            retransform_options_.loaders = options.getAll("retransform_loader");
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            capabilities->can_generate_all_class_hook_events = 1;
+            capabilities->can_redefine_classes = 1;
+            capabilities->can_retransform_classes = 1;
+            capabilities->can_retransform_any_class = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            callbacks->ClassFileLoadHook = &class_file_load_hook_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!attach) return;
+            // 立即执行类转换（分批进行，避免大量类时长时间停顿）
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            const Retransformer retransformer(g_jvmti, jni, retransform_options_);
+            const auto log = JvmtiLogger::get();
+            RetransformResult result;
+            if (const auto targets = encryptedClasses.snapshot(); !targets.empty()) {
+                result = retransformer.run(targets, *log);
+            } else {
+                // 首次附加：附加前加载的类没有经过 ClassFileLoadHook，按包含/排除规则重新转换，由回调识别加密类
+                const auto config = ConfigStore::global().acquire();
+                result = retransformer.run([&config](const std::string_view signature) {
+                    if (signature.size() < 2 || signature.front() != 'L') return false;
+                    const auto name = signature.substr(1, signature.size() - 2);
+                    return !config->class_exclude.matches(name) && config->class_include.matches(name);
+                }, *log);
+            }
+            auto &metrics = Metrics::global();
+            metrics.add(Counter::RetransformedClasses, result.retransformed);
+            metrics.add(Counter::RetransformFailures, result.failed);
+        }
+    };
+
+    // native 方法绑定：替换目标解密方法，并按 intercept= 规则统计 native 调用
+    class NativeBindModule final : public jvmti::Agent {
+    public:
+        const char *name() const override { return "native"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            // 通用 native 方法拦截规则：intercept=class#method(signature)，可重复指定
+            if (native_interceptor) return;
+            const auto log = JvmtiLogger::get();
+            std::vector<InterceptRule> rules;
+            for (const auto &value: options.getAll("intercept")) {
+                if (auto rule = InterceptRule::parse(value)) {
+                    rules.push_back(std::move(*rule));
+                } else {
+                    log->warn("Ignore invalid intercept rule: {}", value);
+                }
+            }
+            if (!rules.empty()) {
+                log->info("Native intercept rules: {}", rules.size());
+                native_interceptor.publish(std::make_unique<NativeInterceptor>(std::move(rules)));
+            }
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            capabilities->can_generate_native_method_bind_events = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            callbacks->NativeMethodBind = &native_method_bind_callback;
+        }
+
+        // 热替换后 VM 不会为已绑定的方法再次发送 NativeMethodBind，由 JHook 的跳板重新指向本模块
+        void OnStart(const bool attach) override {
+            if (jhook_shim) jhook_shim->rebindNatives(&resolve_jhook_native, g_jvmti);
+        }
+
+        void OnStop() override {
+            // 输出 native 方法拦截统计
+            if (native_interceptor) {
+                native_interceptor->report(*JvmtiLogger::get());
+            }
+        }
+
+        // 经 JHook 跳板绑定的方法在卸载后回到原始实现；直接绑定到模块代码的方法在卸载后将跳转到无效地址
+        bool CanUnload() const override { return rebound_natives.load(std::memory_order_relaxed) == 0; }
+    };
+
+    // 静态字段/方法探针：类准备完成后按 probe= 规则读取静态字段或调用无参静态方法，
+    // 结果保存在 ProbeTable 中供查询，停止时输出；默认读取产品版本信息
+    class ProbeModule final : public jvmti::Agent {
+    public:
+        const char *name() const override { return "probe"; }
+
+    protected:
+        // probe= 规则在发布配置快照时编译，无法解析的规则由 initialize_agent 提示
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            callbacks->ClassPrepare = &class_prepare_callback;
+        }
+
+        void OnStop() override {
+            const auto log = JvmtiLogger::get();
+            for (const auto &value: ProbeTable::global().values()) {
+                log->info("JVMTI Probe [{}] {}#{} = {}", value.ok ? "ok" : "failed", value.class_name, value.member,
+                          value.value);
+            }
+        }
+    };
+
+    // 异常分析（默认关闭）：exception_profile=true 按抛出点聚合异常事件并由报告线程定期输出热点，
+    // exception_sample=N 每 N 次记录一次，exception_stack=D 按 D 层调用栈区分抛出点，
+    // exception_top=N 报告条数，exception_report=秒 定期报告间隔（0 仅停止时报告）
+    class ExceptionModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        ExceptionProfilerOptions options_;
+
+    public:
+        const char *name() const override { return "exception"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("exception_profile", enabled_);
+            options_.sample = static_cast<uint32_t>(std::clamp(
+                options.getInt("exception_sample", options_.sample), 1LL, static_cast<long long>(UINT32_MAX)));
+            options_.stack_depth = static_cast<uint32_t>(std::clamp(
+                options.getInt("exception_stack", options_.stack_depth), 0LL,
+                static_cast<long long>(ExceptionProfiler::MAX_STACK_DEPTH)));
+            options_.top = static_cast<size_t>(std::max(1LL, options.getInt("exception_top",
+                                                                         static_cast<long long>(options_.top))));
+            options_.report_interval = std::chrono::seconds(std::max(
+                0LL, options.getInt("exception_report", options_.report_interval.count())));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_generate_exception_events = 1;
+            capabilities->can_tag_objects = 1;
+            capabilities->can_get_line_numbers = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->Exception = &exception_callback;
+            if (options_.report_interval.count() == 0) return;
+            callbacks->VMInit = &exception_vm_init_callback;
+            callbacks->VMDeath = &exception_vm_death_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_) return;
+            if (!exception_profiler) {
+                exception_profiler.publish(std::make_unique<ExceptionProfiler>(g_jvmti, options_, JvmtiLogger::get()));
+                if (options_.report_interval.count() > 0) {
+                    exception_thread.publish(std::make_unique<AgentThread>(
+                        "jvmti-exception-report",
+                        std::chrono::duration_cast<std::chrono::milliseconds>(options_.report_interval),
+                        [](JNIEnv *jni) { exception_profiler->periodicReport(jni); }));
+                }
+            }
+            if (!attach) return;
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            exception_vm_init_callback(g_jvmti, jni, nullptr);
+        }
+
+        void OnStop() override {
+            if (exception_thread) exception_thread->stop();
+            if (!exception_profiler) return;
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            exception_profiler->report(jni, exception_profiler->options().top);
+        }
+    };
+
+    // 监视器竞争分析：monitor_profile=true 启用，monitor_wait=true 同时统计 Object.wait，
+    // monitor_stack=D 区分等待点的调用栈深度，monitor_top=N 报告条数，monitor_report=秒 定期报告间隔
+    class MonitorModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        bool wait_ = false;
+        MonitorProfilerOptions options_;
+
+    public:
+        const char *name() const override { return "monitor"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("monitor_profile", enabled_);
+            wait_ = options.getBool("monitor_wait", wait_);
+            options_.stack_depth = static_cast<uint32_t>(std::clamp(
+                options.getInt("monitor_stack", options_.stack_depth), 1LL,
+                static_cast<long long>(MonitorProfiler::MAX_STACK_DEPTH)));
+            options_.top = static_cast<size_t>(std::max(1LL, options.getInt("monitor_top",
+                                                                         static_cast<long long>(options_.top))));
+            options_.report_interval = std::chrono::seconds(std::max(
+                0LL, options.getInt("monitor_report", options_.report_interval.count())));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_generate_monitor_events = 1;
+            capabilities->can_tag_objects = 1;
+            capabilities->can_get_line_numbers = 1;
+            add_virtual_thread_state_capability(capabilities);
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->MonitorContendedEnter = &monitor_contended_enter_callback;
+            callbacks->MonitorContendedEntered = &monitor_contended_entered_callback;
+            register_virtual_thread_state_events(g_jvmti, callbacks);
+            if (options_.report_interval.count() > 0) {
+                callbacks->VMInit = &monitor_vm_init_callback;
+                callbacks->VMDeath = &monitor_vm_death_callback;
+            }
+            if (!wait_) return;
+            callbacks->MonitorWait = &monitor_wait_callback;
+            callbacks->MonitorWaited = &monitor_waited_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_) return;
+            if (!monitor_profiler) {
+                monitor_profiler.publish(std::make_unique<MonitorProfiler>(g_jvmti, options_, JvmtiLogger::get()));
+                if (options_.report_interval.count() > 0) {
+                    monitor_thread.publish(std::make_unique<AgentThread>(
+                        "jvmti-monitor-report",
+                        std::chrono::duration_cast<std::chrono::milliseconds>(options_.report_interval),
+                        [](JNIEnv *jni) { monitor_profiler->periodicReport(jni); }));
+                }
+            }
+            if (!attach) return;
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            monitor_vm_init_callback(g_jvmti, jni, nullptr);
+        }
+
+        void OnStop() override {
+            if (monitor_thread) monitor_thread->stop();
+            if (!monitor_profiler) return;
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            monitor_profiler->report(jni, monitor_profiler->options().top);
+        }
+    };
+
+    // 线程 CPU 采样：cpu_sample=true 启用，cpu_interval=毫秒 采样间隔，cpu_report=秒 报告间隔，
+    // cpu_top=N 报告线程数，cpu_stack=D 为报告中的线程附带 D 层调用栈
+    class CpuModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        CpuSamplerOptions options_;
+
+    public:
+        const char *name() const override { return "cpu"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("cpu_sample", enabled_);
+            options_.interval = std::chrono::milliseconds(std::max(
+                10LL, options.getInt("cpu_interval", static_cast<long long>(options_.interval.count()))));
+            options_.report_interval = std::chrono::seconds(std::max(
+                1LL, options.getInt("cpu_report", options_.report_interval.count())));
+            options_.top = static_cast<size_t>(std::max(1LL, options.getInt("cpu_top",
+                                                                         static_cast<long long>(options_.top))));
+            options_.stack_depth = static_cast<uint32_t>(std::clamp(
+                options.getInt("cpu_stack", options_.stack_depth), 0LL,
+                static_cast<long long>(CpuSampler::MAX_STACK_DEPTH)));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_get_thread_cpu_time = 1;
+            capabilities->can_get_line_numbers = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->VMInit = &cpu_vm_init_callback;
+            callbacks->VMDeath = &cpu_vm_death_callback;
+            register_thread_state_events(callbacks);
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_ || cpu_sampler) return;
+            jvmtiCapabilities capabilities = {};
+            g_jvmti->GetCapabilities(&capabilities);
+            if (!capabilities.can_get_thread_cpu_time) {
+                JvmtiLogger::get()->warn("Thread CPU time is not supported by this VM");
+                return;
+            }
+            cpu_sampler.publish(std::make_unique<CpuSampler>(g_jvmti, options_, JvmtiLogger::get()));
+            cpu_thread.publish(std::make_unique<AgentThread>("jvmti-cpu-sampler", options_.interval,
+                                                             [](JNIEnv *jni) { cpu_sampler->sample(jni); }));
+            if (!attach) return;
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            cpu_vm_init_callback(g_jvmti, jni, nullptr);
+        }
+
+        void OnStop() override {
+            if (cpu_thread) cpu_thread->stop();
+        }
+    };
+
+    // 墙钟采样：wall_sample=true 启用，wall_interval=毫秒 目标间隔，wall_max_interval=毫秒 降频上限，
+    // wall_budget=千分比 采样耗时预算（默认 20‰），wall_stack=D 栈深度，wall_top=N 报告条数，
+    // wall_thread=线程名前缀（可重复，未指定时采样全部线程），wall_flame=文件 输出火焰图（再次附加与停止时写入）
+    class WallModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        std::string flame_;
+        WallSamplerOptions options_;
+
+        void writeFlame(JNIEnv *jni) const {
+            if (flame_.empty() || !wall_sampler) return;
+            const auto log = JvmtiLogger::get();
+            if (std::ofstream out(flame_); out.is_open()) {
+                wall_sampler->writeFlame(jni, out);
+                log->info("Wall-clock flame graph written to {}", flame_);
+            } else {
+                log->error("Wall-clock flame graph: failed to open {}", flame_);
+            }
+        }
+
+    public:
+        const char *name() const override { return "wall"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("wall_sample", enabled_);
+            options_.interval = std::chrono::milliseconds(std::max(
+                1LL, options.getInt("wall_interval", static_cast<long long>(options_.interval.count()))));
+            options_.max_interval = std::chrono::milliseconds(std::max(
+                1LL, options.getInt("wall_max_interval", static_cast<long long>(options_.max_interval.count()))));
+            options_.budget = static_cast<double>(std::clamp(
+                options.getInt("wall_budget", std::llround(options_.budget * 1000)), 1LL, 1000LL)) / 1000.0;
+            options_.stack_depth = static_cast<uint32_t>(std::clamp(
+                options.getInt("wall_stack", options_.stack_depth), 1LL,
+                static_cast<long long>(WallSampler::MAX_STACK_DEPTH)));
+            options_.top = static_cast<size_t>(std::max(1LL, options.getInt("wall_top",
+                                                                         static_cast<long long>(options_.top))));
+            options_.threads = options.getAll("wall_thread");
+            flame_ = options.get("wall_flame");
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_get_line_numbers = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->VMInit = &wall_vm_init_callback;
+            callbacks->VMDeath = &wall_vm_death_callback;
+            if (!options_.threads.empty()) register_thread_state_events(callbacks);
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_) return;
+            JNIEnv *jni = nullptr;
+            if (attach) g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            if (wall_sampler) {
+                // 再次附加：输出当前火焰图
+                writeFlame(jni);
+                return;
+            }
+            wall_sampler.publish(std::make_unique<WallSampler>(g_jvmti, options_, JvmtiLogger::get()));
+            wall_thread.publish(std::make_unique<AgentThread>("jvmti-wall-sampler", options_.interval,
+                                                              [](JNIEnv *env) {
+                                                                  wall_thread->setInterval(wall_sampler->sample(env));
+                                                              }));
+            if (attach) wall_vm_init_callback(g_jvmti, jni, nullptr);
+        }
+
+        void OnStop() override {
+            if (!wall_sampler) return;
+            if (wall_thread) wall_thread->stop();
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            wall_sampler->report(jni, options_.top);
+            writeFlame(jni);
+        }
+    };
+
+    // 分配点采样（JDK 11+）：alloc_profile=true 启用，alloc_interval=字节 平均采样间隔，
+    // alloc_stack=D 调用栈深度，alloc_top=N 报告条数，alloc_live=false 不跟踪对象回收，
+    // alloc_flame=文件 输出折叠栈火焰图（再次附加与停止时写入）
+    class AllocationModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        jint interval_ = 512 * 1024;
+        std::string flame_;
+        AllocationProfilerOptions options_;
+
+        void writeFlame(JNIEnv *jni) const {
+            if (flame_.empty() || !allocation_profiler) return;
+            const auto log = JvmtiLogger::get();
+            if (std::ofstream out(flame_); out.is_open()) {
+                allocation_profiler->writeFlame(jni, out, options_.track_live);
+                log->info("Allocation flame graph written to {}", flame_);
+            } else {
+                log->error("Allocation flame graph: failed to open {}", flame_);
+            }
+        }
+
+    public:
+        const char *name() const override { return "alloc"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("alloc_profile", enabled_);
+            interval_ = static_cast<jint>(std::clamp(options.getInt("alloc_interval", interval_), 0LL,
+                                                     static_cast<long long>(INT32_MAX)));
+            options_.stack_depth = static_cast<uint32_t>(std::clamp(
+                options.getInt("alloc_stack", options_.stack_depth), 0LL,
+                static_cast<long long>(AllocationProfiler::MAX_STACK_DEPTH)));
+            options_.top = static_cast<size_t>(std::max(1LL, options.getInt("alloc_top",
+                                                                         static_cast<long long>(options_.top))));
+            options_.track_live = options.getBool("alloc_live", options_.track_live);
+            flame_ = options.get("alloc_flame");
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_generate_sampled_object_alloc_events = 1;
+            capabilities->can_generate_object_free_events = 1;
+            capabilities->can_tag_objects = 1;
+            capabilities->can_get_line_numbers = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->SampledObjectAlloc = &sampled_object_alloc_callback;
+            callbacks->ObjectFree = &object_free_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_) return;
+            const auto log = JvmtiLogger::get();
+            jvmtiCapabilities capabilities = {};
+            g_jvmti->GetCapabilities(&capabilities);
+            if (!capabilities.can_generate_sampled_object_alloc_events) {
+                log->warn("Allocation sampling is not supported by this VM (requires JDK 11+)");
+                return;
+            }
+            // 再次附加时可调整采样间隔，并输出当前火焰图
+            if (const jvmtiError err = g_jvmti->SetHeapSamplingInterval(interval_); err != JVMTI_ERROR_NONE) {
+                log->error("Failed to set heap sampling interval {}: {}", interval_, static_cast<int>(err));
+            }
+            if (allocation_profiler) {
+                JNIEnv *jni = nullptr;
+                g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+                writeFlame(jni);
+                return;
+            }
+            // 对象回收需要 can_generate_object_free_events，不可用时仅统计分配
+            options_.track_live = options_.track_live && capabilities.can_generate_object_free_events;
+            allocation_profiler.publish(std::make_unique<AllocationProfiler>(g_jvmti, options_, log));
+            log->info("Allocation sampling started: interval={} bytes, stack={}", interval_, options_.stack_depth);
+        }
+
+        void OnStop() override {
+            if (!allocation_profiler) return;
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            allocation_profiler->report(jni, options_.top);
+            writeFlame(jni);
+        }
+    };
+
+    // GC 停顿时间线（默认关闭）：gc_profile=true 开启，gc_timeline=文件 开启并追加 CSV 时间线（gc_timeline=true/false
+    // 仍可作为开关，与 gc_profile 等价），gc_interval=毫秒 汇总间隔，gc_report=秒 定期输出停顿统计（0 仅停止时输出），
+    // gc_capacity=N 环形缓冲区容量
+    class GcModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        GcTimelineOptions options_;
+
+    public:
+        const char *name() const override { return "gc"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("gc_profile", enabled_);
+            // gc_timeline 仅作为开关时不写文件
+            if (options.has("gc_timeline")) {
+                const auto timeline = options.getFlagOrPath("gc_timeline");
+                enabled_ = timeline.has_value();
+                options_.timeline_file = timeline.value_or("");
+            }
+            options_.drain_interval = std::chrono::milliseconds(std::max(
+                10LL, options.getInt("gc_interval", static_cast<long long>(options_.drain_interval.count()))));
+            options_.report_interval = std::chrono::seconds(std::max(
+                0LL, options.getInt("gc_report", options_.report_interval.count())));
+            options_.capacity = static_cast<size_t>(std::max(
+                16LL, options.getInt("gc_capacity", static_cast<long long>(options_.capacity))));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_generate_garbage_collection_events = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->GarbageCollectionStart = &gc_start_callback;
+            callbacks->GarbageCollectionFinish = &gc_finish_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_ || gc_timeline) return;
+            gc_timeline.publish(std::make_unique<GcTimeline>(options_, JvmtiLogger::get()));
+            gc_timeline->start();
+        }
+
+        void OnStop() override {
+            if (gc_timeline) gc_timeline->stop();
+        }
+    };
+
+    // JIT 编译活动与代码缓存统计：jit_stats=true 开启，jit_report=秒 定期输出（0 仅停止时输出），
+    // jit_top=N 输出条数，jit_churn=N 编译次数达到 N 的方法视为反复编译。附加时补发已编译方法作为代码缓存基线
+    class JitModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        JitStatsOptions options_;
+
+    public:
+        const char *name() const override { return "jit"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("jit_stats", enabled_);
+            options_.report_interval = std::chrono::seconds(std::max(
+                0LL, options.getInt("jit_report", options_.report_interval.count())));
+            options_.top = static_cast<size_t>(std::max(1LL, options.getInt("jit_top",
+                                                                         static_cast<long long>(options_.top))));
+            options_.churn_threshold = static_cast<uint32_t>(std::clamp(
+                options.getInt("jit_churn", options_.churn_threshold), 2LL, 1000LL));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_generate_compiled_method_load_events = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->CompiledMethodLoad = &jit_compiled_method_load_callback;
+            callbacks->CompiledMethodUnload = &jit_compiled_method_unload_callback;
+            callbacks->DynamicCodeGenerated = &jit_dynamic_code_generated_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_ || jit_stats) return;
+            jit_stats.publish(std::make_unique<JitStats>(g_jvmti, options_, JvmtiLogger::get()));
+            if (attach) jit_stats->replay();
+            jit_stats->start();
+        }
+
+        void OnStop() override {
+            if (jit_stats) jit_stats->stop();
+        }
+    };
+
+    // perf 符号导出：perf_map=true 写入 /tmp/perf-<pid>.map，perf_jitdump[=目录] 写入 jit-<pid>.dump（默认 /tmp），
+    // perf_flush=毫秒 最长刷新间隔。附加时通过 GenerateEvents 补发已编译方法与已生成的桩代码
+    class PerfMapModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = false;
+        PerfMapOptions options_;
+
+    public:
+        const char *name() const override { return "perf"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            options_.perf_map = options.getBool("perf_map", options_.perf_map);
+            // perf_jitdump 仅作为开关时使用 /tmp
+            if (options.has("perf_jitdump")) {
+                options_.jitdump_dir = options.getFlagOrPath("perf_jitdump", "/tmp").value_or("");
+            }
+            options_.flush_interval = std::chrono::milliseconds(std::max(
+                10LL, options.getInt("perf_flush", static_cast<long long>(options_.flush_interval.count()))));
+            enabled_ = options_.perf_map || !options_.jitdump_dir.empty();
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+            if (!enabled_) return;
+            capabilities->can_generate_compiled_method_load_events = 1;
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+            if (!enabled_) return;
+            callbacks->CompiledMethodLoad = &perf_compiled_method_load_callback;
+            callbacks->CompiledMethodUnload = &perf_compiled_method_unload_callback;
+            callbacks->DynamicCodeGenerated = &perf_dynamic_code_generated_callback;
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_ || perf_map_writer) return;
+            perf_map_writer.publish(std::make_unique<PerfMapWriter>(g_jvmti, options_, JvmtiLogger::get()));
+            if (!perf_map_writer->start()) return;
+            if (!attach) return;
+            // 附加前已编译的方法与已生成的桩代码不会再收到事件
+            for (const jvmtiEvent event: {JVMTI_EVENT_COMPILED_METHOD_LOAD, JVMTI_EVENT_DYNAMIC_CODE_GENERATED}) {
+                if (const jvmtiError err = g_jvmti->GenerateEvents(event); err != JVMTI_ERROR_NONE) {
+                    JvmtiLogger::get()->warn("perf map: GenerateEvents({}) failed: {}", static_cast<int>(event),
+                                             static_cast<int>(err));
+                }
+            }
+        }
+
+        void OnStop() override {
+            if (perf_map_writer) perf_map_writer->stop();
+        }
+    };
+
+    // 按需堆直方图：附加时指定 heap_histo[=文件] 生成一次快照（CSV 写入文件），并与上一次快照
+    // 或 heap_baseline=文件 指定的快照比较；heap_top=N 输出条数。使用独立环境，不占用共享环境的能力与标签
+    class HeapModule final : public jvmti::Agent {
+    private:
+        bool pending_ = false;
+        std::string output_;
+        std::string baseline_;
+        size_t top_ = 30;
+        std::optional<HeapSnapshot> previous_;
+
+    public:
+        const char *name() const override { return "heap"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            // heap_histo 仅作为开关时不写文件
+            const auto histo = options.getFlagOrPath("heap_histo");
+            pending_ = histo.has_value();
+            output_ = histo.value_or("");
+            baseline_ = options.get("heap_baseline");
+            top_ = static_cast<size_t>(std::max(1LL, options.getInt("heap_top", static_cast<long long>(top_))));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+        }
+
+        void OnStart(const bool attach) override {
+            if (!pending_) return;
+            pending_ = false;
+            const auto log = JvmtiLogger::get();
+            if (!attach) {
+                log->warn("Heap histogram is only available after the VM has started, attach with heap_histo");
+                return;
+            }
+            JNIEnv *jni = nullptr;
+            g_vm->GetEnv(reinterpret_cast<void **>(&jni), JNI_VERSION_1_8);
+            auto snapshot = HeapHistogram::take(g_vm, jni, *log);
+            if (!snapshot) return;
+            HeapHistogram::report(*snapshot, top_, *log);
+
+            // 对比基线：优先使用指定文件，否则使用上一次快照
+            std::optional<HeapSnapshot> baseline;
+            if (!baseline_.empty()) {
+                if (std::ifstream in(baseline_); in.is_open()) baseline = HeapSnapshot::read(in);
+                if (!baseline) log->warn("Heap histogram: invalid baseline file {}", baseline_);
+            } else {
+                baseline = std::move(previous_);
+            }
+            if (baseline) HeapHistogram::report(diff(*baseline, *snapshot), top_, *log);
+
+            if (!output_.empty()) {
+                if (std::ofstream out(output_); out.is_open()) {
+                    snapshot->write(out);
+                    log->info("Heap histogram written to {}", output_);
+                } else {
+                    log->error("Heap histogram: failed to open {}", output_);
+                }
+            }
+            previous_ = std::move(snapshot);
+        }
+    };
+
+    // 指标导出：按 metrics_interval（毫秒）把计数器发布到共享内存，外部通过 `jvmti metrics <pid>` 读取；
+    // 不订阅任何事件，metrics=false 时仅在进程内计数
+    class MetricsModule final : public jvmti::Agent {
+    private:
+        bool enabled_ = true;
+        std::chrono::milliseconds interval_{1000};
+
+    public:
+        const char *name() const override { return "metrics"; }
+
+    protected:
+        void ParseOptions(const Options &options) override {
+            enabled_ = options.getBool("metrics", enabled_);
+            interval_ = std::chrono::milliseconds(
+                std::max(10LL, options.getInt("metrics_interval", static_cast<long long>(interval_.count()))));
+        }
+
+        void AddCapability(jvmtiCapabilities *capabilities) const override {
+        }
+
+        void RegisterEvent(jvmtiEventCallbacks *callbacks) const override {
+        }
+
+        void OnStart(const bool attach) override {
+            if (!enabled_) return;
+            const bool published = Metrics::global().start(interval_, [](Metrics &metrics) {
+                const auto [depth, drops] = JvmtiLogger::queueStats();
+                metrics.set(Counter::LogQueueDepth, depth);
+                metrics.set(Counter::LogDrops, drops);
+            });
+            if (published) {
+                JvmtiLogger::get()->info("Metrics published to shared memory: {}", Metrics::global().segment());
+            } else {
+                JvmtiLogger::get()->warn("Metrics shared memory is unavailable, counters stay in process");
+            }
+        }
+
+        void OnStop() override {
+            Metrics::global().stop();
+        }
+    };
+}
+
+static std::unique_ptr<jvmti::AgentHost> agent_host = nullptr; // 模块宿主
+
+// 初始化 Agent 通用逻辑；shim 不为空表示由 JHook 加载，需要支持热替换
+jint initialize_agent(JavaVM *vm, char *options, const bool attach, const JHookShim *shim = nullptr) {
     const auto log = JvmtiLogger::get();
     try {
-        // 1. 获取 JVMTI 环境
-        vm->GetEnv(reinterpret_cast<void **>(&jvmti), JVMTI_VERSION_1_2);
-
-        // 2. 解析命令行参数（指定目标类）
-        // if (options != nullptr) {
-        //     std::string opt_str(options);
-        //     size_t pos = 0;
-        //     while ((pos = opt_str.find(',')) != std::string::npos) {
-        //         target_classes.push_back(opt_str.substr(0, pos));
-        //         opt_str.erase(0, pos + 1);
-        //     }
-        //     target_classes.push_back(opt_str);
-        // }
-
-        // 初始化全局状态
-        if (!encryptedClasses) {
-            encryptedClasses = std::make_shared<std::unordered_set<std::string> >();
-        }
-
-        // 3. 设置 JVMTI 功能
-        jvmtiCapabilities capabilities;
-        capabilities.can_generate_all_class_hook_events = 1;
-        capabilities.can_redefine_classes = 1;
-        capabilities.can_retransform_classes = 1;
-        capabilities.can_retransform_any_class = 1;
-
-        capabilities.can_generate_method_entry_events = 1;
-        capabilities.can_generate_method_exit_events = 1;
-
-        capabilities.can_generate_exception_events = 1;
-        capabilities.can_generate_native_method_bind_events = 1;
-        jvmti->AddCapabilities(&capabilities);
-
-        // 4. 注册事件回调
-        jvmtiEventCallbacks callbacks = {};
-        // callbacks.ThreadStart = &thread_start_callback;
-        // callbacks.ThreadEnd = &thread_end_callback;
-        callbacks.ClassFileLoadHook = &class_file_load_hook_callback;
-        // callbacks.ClassLoad = &class_load_callback;
-        callbacks.ClassPrepare = &class_prepare_callback;
-        // callbacks.VMStart = &vm_start_callback;
-        callbacks.Exception = &exception_callback;
-        callbacks.ExceptionCatch = &exception_catch_callback;
-        callbacks.NativeMethodBind = &native_method_bind_callback;
-        // callbacks.MethodEntry = &method_entry_callback;
-        // callbacks.MethodExit = &method_exit_callback;
-        jvmti->SetEventCallbacks(&callbacks, sizeof(callbacks));
-
-        std::vector<jvmtiEvent> events = {
-            // JVMTI_EVENT_THREAD_START,
-            // JVMTI_EVENT_THREAD_END,
-            JVMTI_EVENT_CLASS_FILE_LOAD_HOOK, // 启用类文件加载事件
-            // JVMTI_EVENT_CLASS_LOAD, // 启用类加载事件
-            JVMTI_EVENT_CLASS_PREPARE, // 启用类准备事件
-            // JVMTI_EVENT_VM_START, // 启用虚拟机启动事件
-            JVMTI_EVENT_EXCEPTION, // 启用异常事件
-            JVMTI_EVENT_EXCEPTION_CATCH, // 启用异常捕获事件
-            JVMTI_EVENT_NATIVE_METHOD_BIND, // 启用本地方法绑定事件
-        };
-        for (jvmtiEvent event: events) {
-            jvmti->SetEventNotificationMode(JVMTI_ENABLE, event, nullptr);
-        }
-
-        // 全局禁用 方法进入/退出事件
-        jvmti->SetEventNotificationMode(JVMTI_DISABLE, JVMTI_EVENT_METHOD_ENTRY, nullptr);
-        jvmti->SetEventNotificationMode(JVMTI_DISABLE, JVMTI_EVENT_METHOD_EXIT, nullptr);
-        // 启用主进程 方法进入/退出事件
+        // 1. 解析命令行参数，以当前配置为基础发布新的配置快照（再次附加时即重新配置）
+        const jvmti_tools::Options opts(options);
+        std::vector<jvmti_tools::InvalidProbeRule> invalid_probes;
+        const auto version = jvmti_tools::ConfigStore::global().reconfigure(opts, &invalid_probes);
+        log->debug("Agent config published: version={}", version);
+        for (const auto &[rule, reason]: invalid_probes) {
+            log->warn("Ignore invalid probe rule: {} ({})", rule, reason);
+        }
+        // 日志级别：log_level=trace|debug|info|warn|error|critical|off（压测时关闭日志，排除日志开销）
+        if (opts.has("log_level")) {
+            const auto value = opts.get("log_level");
+            // 无法识别的名称被解析为 off
+            if (const auto level = spdlog::level::from_str(value); level != spdlog::level::off || value == "off") {
+                log->set_level(level);
+            } else {
+                log->warn("Ignore invalid log_level: {}", value);
+            }
+        }
+
+        // 2. 加载模块：module=classfile|native|probe|exception|monitor|cpu|wall|alloc|gc|jit|perf|heap|metrics，可重复指定；未指定时加载全部模块
+        if (!agent_host) {
+            // 由 JHook 加载时代理线程经 JHook 启动，卸载前可确认线程已离开模块代码
+            if (shim) jvmti_tools::AgentThread::setLauncher(shim->runAgentThread);
+            jhook_shim = shim;
+            agent_host = std::make_unique<jvmti::AgentHost>(log, shim);
+            const auto selected = opts.getAll("module");
+            std::unique_ptr<jvmti::Agent> modules[] = {
+                std::make_unique<jvmti_tools::ClassFileModule>(),
+                std::make_unique<jvmti_tools::NativeBindModule>(),
+                std::make_unique<jvmti_tools::ProbeModule>(),
+                std::make_unique<jvmti_tools::ExceptionModule>(),
+                std::make_unique<jvmti_tools::MonitorModule>(),
+                std::make_unique<jvmti_tools::CpuModule>(),
+                std::make_unique<jvmti_tools::WallModule>(),
+                std::make_unique<jvmti_tools::AllocationModule>(),
+                std::make_unique<jvmti_tools::GcModule>(),
+                std::make_unique<jvmti_tools::JitModule>(),
+                std::make_unique<jvmti_tools::PerfMapModule>(),
+                std::make_unique<jvmti_tools::HeapModule>(),
+                std::make_unique<jvmti_tools::MetricsModule>(),
+            };
+            for (auto &module: modules) {
+                if (selected.empty() || std::find(selected.begin(), selected.end(), module->name()) != selected.end()) {
+                    agent_host->add(std::move(module));
+                }
+            }
+        }
+
+        // 3. 合并能力、注册回调，仅启用模块订阅的事件
+        return agent_host->start(vm, opts, attach);
     } catch (std::exception &e) {
         log->error("The registration event callback failed: {}", e.what());
     }
@@ -924,7 +1744,7 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved) {
     const auto addr = reinterpret_cast<uintptr_t>(vm);
     log->debug("JVMTI Agent OnLoad: 0x{:016X}", addr);
 
-    initialize_agent(vm, options);
+    initialize_agent(vm, options, false);
     return JNI_OK;
 }
 
@@ -933,10 +1753,7 @@ JNIEXPORT jint JNICALL Agent_OnAttach(JavaVM *vm, char *options, void *reserved)
     const auto addr = reinterpret_cast<uintptr_t>(vm);
     log->debug("JVMTI Agent OnAttach: 0x{:016X}", addr);
 
-    initialize_agent(vm, options);
-
-    // 立即执行类转换
-    retransform_target_classes(jvmti, *encryptedClasses);
+    initialize_agent(vm, options, true);
     return JNI_OK;
 }
 
@@ -945,6 +1762,34 @@ JNIEXPORT void JNICALL Agent_OnUnload(JavaVM *vm) {
     // 执行其他清理操作（如释放 JVM TI 资源）
     const auto addr = reinterpret_cast<uintptr_t>(vm);
     logger->debug("JVMTI Agent Unloaded: 0x{:016X}", addr);
+    // 停止事件分发，各模块输出统计信息
+    if (agent_host) {
+        agent_host->stop();
+    }
     // 最后关闭日志器
     JvmtiLogger::shutdown();
 }
+
+// JHook 模块接口：由 JHook 通过 dlopen 加载，事件经过 JHook 的稳定入口分发以支持热替换
+extern "C" JNIEXPORT jint JNICALL JHook_ModuleVersion() {
+    return JHOOK_MODULE_ABI_VERSION;
+}
+
+extern "C" JNIEXPORT jint JNICALL JHook_ModuleLoad(JavaVM *vm, char *options, const jboolean attach,
+                                                   const JHookShim *shim) {
+    const auto log = JvmtiLogger::get();
+    log->debug("JVMTI Agent module load: attach={}", attach == JNI_TRUE);
+    return initialize_agent(vm, options, attach == JNI_TRUE, shim);
+}
+
+extern "C" JNIEXPORT jint JNICALL JHook_ModuleUnload(JavaVM *vm) {
+    if (agent_host) {
+        if (!agent_host->canUnload()) return JHOOK_MODULE_REFUSED;
+        // 仍有回调未结束时保留日志器等资源，模块代码也不会被卸载
+        if (!agent_host->unload()) return JHOOK_MODULE_BUSY;
+        agent_host.reset();
+    }
+    // 日志线程属于模块代码，必须在卸载前结束
+    JvmtiLogger::shutdown();
+    return JHOOK_MODULE_UNLOADED;
+}
@@ -1,45 +1,479 @@
 //
 // Created by WuYujie on 2025-06-09.
 //
+// JHook：稳定的代理外壳，本身不包含业务逻辑，通过 dlopen 加载真正的代理模块（libagent），
+// 再次附加时可以在不重启 JVM 的情况下卸载旧模块、加载新模块：
+//   -agentpath:libjhook.so=agent=/path/to/libagent.so,...
+//   jattach <pid> load /path/to/libjhook.so true agent=/path/to/libagent.so,reload
+// 除 agent/reload 外的参数原样传给模块
+//
 #include <jvmti.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+#include "JHookModule.h"
+#include "../jvmti/Options.h"
+
+#ifndef JHOOK_DEFAULT_MODULE
+#ifdef _WIN32
+#define JHOOK_DEFAULT_MODULE "agent.dll"
+#elif defined(__APPLE__)
+#define JHOOK_DEFAULT_MODULE "libagent.dylib"
+#else
+#define JHOOK_DEFAULT_MODULE "libagent.so"
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+// 事件路由：VM 只持有 JHook 中的入口函数（事件入口与 native 方法跳板），入口在调用模块代码前后维护在途计数。
+// 计数的增减都发生在 JHook 代码中，排空后不会再有线程停留在模块代码里，模块可以安全卸载
+namespace {
+    // jvmtiEventCallbacks 按事件编号顺序排列（含保留槽位），可视为函数指针数组
+    constexpr size_t EVENT_SLOTS = sizeof(jvmtiEventCallbacks) / sizeof(void *);
+
+    // 当前模块的回调，drain 时清空
+    std::array<std::atomic<void *>, EVENT_SLOTS> targets{};
+    // 正在执行模块回调的线程数量，按线程分散到多个独占缓存行的计数上：入口只增减本线程所属的计数，
+    // 不同线程之间没有缓存行争用，只有 drain 需要汇总全部计数。同一线程的增减总在同一计数上，
+    // 因此每个计数都不为负，汇总为 0 即没有线程停留在模块代码中
+    class InFlight {
+    private:
+        static constexpr size_t STRIPES = 64;
+
+        struct alignas(64) Stripe {
+            std::atomic<int64_t> count{0};
+        };
+
+        std::array<Stripe, STRIPES> stripes_{};
+        std::atomic<size_t> next_{0};
+
+    public:
+        // 线程首次进入时按轮转分配计数
+        std::atomic<int64_t> &local() {
+            thread_local const size_t stripe = next_.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+            return stripes_[stripe].count;
+        }
+
+        int64_t sum() const {
+            int64_t total = 0;
+            for (const auto &stripe: stripes_) total += stripe.count.load();
+            return total;
+        }
+    };
+
+    InFlight in_flight;
+    // 正在执行模块线程函数的代理线程数量
+    std::atomic<int64_t> agent_threads{0};
+
+    // 入口先登记再读取回调地址，drain 先清空回调再读取各计数（均为顺序一致），
+    // 因此 drain 汇总为 0 之后不会再有入口调用到旧的回调
+    template<size_t Slot, typename Callback>
+    struct Entry;
+
+    template<size_t Slot, typename... Args>
+    struct Entry<Slot, void (JNICALL *)(Args...)> {
+        static void JNICALL dispatch(Args... args) {
+            auto &counter = in_flight.local();
+            counter.fetch_add(1);
+            if (void *target = targets[Slot].load()) {
+                reinterpret_cast<void (JNICALL *)(Args...)>(target)(args...);
+            }
+            counter.fetch_sub(1);
+        }
+    };
+
+    template<size_t Slot, typename Callback>
+    void *entryOf() {
+        static_assert(Slot < EVENT_SLOTS);
+        return reinterpret_cast<void *>(&Entry<Slot, Callback>::dispatch);
+    }
+
+#define JHOOK_ENTRY(Member) \
+    entries[offsetof(jvmtiEventCallbacks, Member) / sizeof(void *)] = \
+        entryOf<offsetof(jvmtiEventCallbacks, Member) / sizeof(void *), decltype(jvmtiEventCallbacks::Member)>()
+
+    // 各事件的入口函数；未列出的事件（如较新 JDK 新增的事件）没有入口，模块不能启用
+    std::array<void *, EVENT_SLOTS> makeEntries() {
+        std::array<void *, EVENT_SLOTS> entries{};
+        JHOOK_ENTRY(VMInit);
+        JHOOK_ENTRY(VMDeath);
+        JHOOK_ENTRY(ThreadStart);
+        JHOOK_ENTRY(ThreadEnd);
+        JHOOK_ENTRY(ClassFileLoadHook);
+        JHOOK_ENTRY(ClassLoad);
+        JHOOK_ENTRY(ClassPrepare);
+        JHOOK_ENTRY(VMStart);
+        JHOOK_ENTRY(Exception);
+        JHOOK_ENTRY(ExceptionCatch);
+        JHOOK_ENTRY(SingleStep);
+        JHOOK_ENTRY(FramePop);
+        JHOOK_ENTRY(Breakpoint);
+        JHOOK_ENTRY(FieldAccess);
+        JHOOK_ENTRY(FieldModification);
+        JHOOK_ENTRY(MethodEntry);
+        JHOOK_ENTRY(MethodExit);
+        JHOOK_ENTRY(NativeMethodBind);
+        JHOOK_ENTRY(CompiledMethodLoad);
+        JHOOK_ENTRY(CompiledMethodUnload);
+        JHOOK_ENTRY(DynamicCodeGenerated);
+        JHOOK_ENTRY(DataDumpRequest);
+        JHOOK_ENTRY(MonitorWait);
+        JHOOK_ENTRY(MonitorWaited);
+        JHOOK_ENTRY(MonitorContendedEnter);
+        JHOOK_ENTRY(MonitorContendedEntered);
+        JHOOK_ENTRY(ResourceExhausted);
+        JHOOK_ENTRY(GarbageCollectionStart);
+        JHOOK_ENTRY(GarbageCollectionFinish);
+        JHOOK_ENTRY(ObjectFree);
+        JHOOK_ENTRY(VMObjectAlloc);
+        JHOOK_ENTRY(SampledObjectAlloc);
+#ifdef JVMTI_HAS_VIRTUAL_THREADS
+        JHOOK_ENTRY(VirtualThreadStart);
+        JHOOK_ENTRY(VirtualThreadEnd);
+#endif
+        return entries;
+    }
+
+#undef JHOOK_ENTRY
+
+    const auto entries = makeEntries();
+
+    void JNICALL route(const jvmtiEventCallbacks *callbacks, jvmtiEventCallbacks *stable) {
+        std::array<void *, EVENT_SLOTS> slots{};
+        std::memcpy(slots.data(), callbacks, sizeof(jvmtiEventCallbacks));
+        std::array<void *, EVENT_SLOTS> routed{};
+        for (size_t slot = 0; slot < EVENT_SLOTS; ++slot) {
+            if (slots[slot] == nullptr || entries[slot] == nullptr) {
+                targets[slot].store(nullptr);
+                continue;
+            }
+            targets[slot].store(slots[slot]);
+            routed[slot] = entries[slot];
+        }
+        std::memcpy(stable, routed.data(), sizeof(jvmtiEventCallbacks));
+    }
+
+    // native 方法跳板：VM 绑定的是 JHook 中的跳板，模块卸载后方法仍保持绑定。
+    // 跳板与事件入口一样先登记在途计数再读取目标，目标被 drain 清空后直接调用原始实现
+    using Word = uintptr_t;
+    template<size_t>
+    using WordAt = Word;
+
+    struct NativeSlot {
+        jmethodID method = nullptr;
+        void *stub = nullptr;
+        std::atomic<void *> original{nullptr};
+        std::atomic<void *> target{nullptr};
+    };
+
+    std::array<NativeSlot, JHOOK_NATIVE_SLOTS> natives;
+    size_t native_count = 0; // 已分配的跳板数量，由 native_mutex 保护
+    std::mutex native_mutex;
+
+    template<size_t Slot, bool Void, typename... Words>
+    std::conditional_t<Void, void, Word> JNICALL nativeStub(JNIEnv *env, jobject self, Words... words) {
+        using Target = std::conditional_t<Void, void, Word> (JNICALL *)(JNIEnv *, jobject, Words...);
+        auto &native = natives[Slot];
+        auto &counter = in_flight.local();
+        counter.fetch_add(1);
+        if (void *target = native.target.load()) {
+            if constexpr (Void) {
+                reinterpret_cast<Target>(target)(env, self, words...);
+                counter.fetch_sub(1);
+                return;
+            } else {
+                const Word result = reinterpret_cast<Target>(target)(env, self, words...);
+                counter.fetch_sub(1);
+                return result;
+            }
+        }
+        counter.fetch_sub(1);
+        return reinterpret_cast<Target>(native.original.load())(env, self, words...);
+    }
+
+    // 跳板表：[槽位][参数字数][是否 void 返回]
+    using StubRow = std::array<std::array<void *, 2>, JHOOK_NATIVE_MAX_WORDS + 1>;
+
+    template<size_t Slot, bool Void, size_t... I>
+    void *stubOf(std::index_sequence<I...>) {
+        return reinterpret_cast<void *>(&nativeStub<Slot, Void, WordAt<I>...>);
+    }
+
+    template<size_t Slot, size_t... N>
+    StubRow stubRow(std::index_sequence<N...>) {
+        return {{{stubOf<Slot, false>(std::make_index_sequence<N>{}), stubOf<Slot, true>(std::make_index_sequence<N>{})}...}};
+    }
+
+    template<size_t... Slot>
+    std::array<StubRow, sizeof...(Slot)> stubTable(std::index_sequence<Slot...>) {
+        return {stubRow<Slot>(std::make_index_sequence<JHOOK_NATIVE_MAX_WORDS + 1>{})...};
+    }
+
+    const auto stubs = stubTable(std::make_index_sequence<JHOOK_NATIVE_SLOTS>{});
+
+    void *JNICALL bindNative(const jmethodID method, void *original, void *target, const jint words,
+                             const jboolean returns_void) {
+        if (original == nullptr || words < 0 || words > JHOOK_NATIVE_MAX_WORDS) return nullptr;
+        std::lock_guard<std::mutex> lock(native_mutex);
+        size_t slot = 0;
+        while (slot < native_count && natives[slot].method != method) ++slot;
+        if (slot == native_count) {
+            if (native_count == natives.size()) return nullptr;
+            natives[slot].method = method;
+            natives[slot].stub = stubs[slot][words][returns_void == JNI_TRUE ? 1 : 0];
+            ++native_count;
+        }
+        auto &native = natives[slot];
+        // 重复绑定（如再次 RegisterNatives）时 VM 传入的可能就是本跳板
+        if (original != native.stub) native.original.store(original);
+        native.target.store(target);
+        return native.stub;
+    }
+
+    void JNICALL rebindNatives(const JHookNativeResolver resolve, void *context) {
+        std::lock_guard<std::mutex> lock(native_mutex);
+        for (size_t slot = 0; slot < native_count; ++slot) {
+            auto &native = natives[slot];
+            native.target.store(resolve(context, native.method, native.original.load()));
+        }
+    }
+
+    template<typename Count>
+    jboolean waitIdle(const Count &count, const jlong timeout_ms) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (count() != 0) {
+            if (std::chrono::steady_clock::now() >= deadline) return JNI_FALSE;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return JNI_TRUE;
+    }
+
+    jboolean JNICALL drain(const jlong timeout_ms) {
+        for (auto &target: targets) target.store(nullptr);
+        for (auto &native: natives) native.target.store(nullptr);
+        return waitIdle([] { return in_flight.sum(); }, timeout_ms);
+    }
+
+    struct ThreadStart {
+        jvmtiStartFunction proc;
+        void *arg;
+    };
+
+    // 代理线程入口：模块线程函数返回后线程只在 JHook 中执行
+    void JNICALL threadEntry(jvmtiEnv *jvmti, JNIEnv *jni, void *arg) {
+        const auto start = *static_cast<ThreadStart *>(arg);
+        delete static_cast<ThreadStart *>(arg);
+        start.proc(jvmti, jni, start.arg);
+        agent_threads.fetch_sub(1);
+    }
+
+    jvmtiError JNICALL runAgentThread(jvmtiEnv *jvmti, const jthread thread, const jvmtiStartFunction proc,
+                                      const void *arg, const jint priority) {
+        auto *start = new ThreadStart{proc, const_cast<void *>(arg)};
+        agent_threads.fetch_add(1);
+        const jvmtiError err = jvmti->RunAgentThread(thread, &threadEntry, start, priority);
+        if (err != JVMTI_ERROR_NONE) {
+            agent_threads.fetch_sub(1);
+            delete start;
+        }
+        return err;
+    }
+
+    jboolean JNICALL join(const jlong timeout_ms) {
+        return waitIdle([] { return agent_threads.load(); }, timeout_ms);
+    }
+
+    const JHookShim shim{route, drain, runAgentThread, join, bindNative, rebindNatives};
+}
+
+// 已加载的代理模块
+struct LoadedModule {
+    void *handle = nullptr;
+    fs::path copy; // 实际加载的临时副本
+    JHookModuleLoad load = nullptr;
+    JHookModuleUnload unload = nullptr;
+};
 
 class AgentProxy {
-    static bool initialized;
-    JavaVM *vm;
+    static std::mutex mutex;
+    static LoadedModule current;
+    static std::atomic<unsigned> sequence;
 
 public:
-    AgentProxy();
-
     static bool isInitialized() {
-        return initialized;
+        std::lock_guard<std::mutex> lock(mutex);
+        return current.handle != nullptr;
     }
 
     static void Initialization(JavaVM *vm, char *options, const bool attach = false) {
-        // 检查是否已初始化
-        if (initialized) {
-            printf("Agent already initialized, skipping re-initialization\n");
-            return;
-        } else {
-            // 执行初始化逻辑
-            printf("Initializing agent for the first time\n");
+        std::lock_guard<std::mutex> lock(mutex);
+        const jvmti_tools::Options opts(options);
 
-            // 这里放置你的初始化代码
-            // ...
+        // 首次加载
+        if (current.handle == nullptr) {
+            if (Open(modulePath(opts), current)) {
+                current.load(vm, options, attach ? JNI_TRUE : JNI_FALSE, &shim);
+            }
+            return;
+        }
 
-            // 设置标志为已初始化
-            initialized = true;
+        // 已加载且未要求替换：转发给当前模块
+        if (!opts.getBool("reload", false)) {
+            current.load(vm, options, attach ? JNI_TRUE : JNI_FALSE, &shim);
+            return;
         }
 
-        if (attach) {
-            // 执行附加逻辑
+        // 热替换：先完整加载新模块，确认可用后再卸载旧模块
+        LoadedModule next;
+        if (!Open(modulePath(opts), next)) {
+            fprintf(stderr, "[JHook] Reload aborted, keep current module\n");
+            return;
         }
+        switch (current.unload(vm)) {
+            case JHOOK_MODULE_UNLOADED:
+                Close(current);
+                break;
+            case JHOOK_MODULE_BUSY:
+                // 仍有回调未结束，旧模块代码保留在内存中（不会再收到事件）
+                fprintf(stderr, "[JHook] Previous module is still busy, keep it mapped\n");
+                break;
+            default:
+                fprintf(stderr, "[JHook] Previous module refused to unload, reload skipped\n");
+                Close(next);
+                return;
+        }
+        current = next;
+        current.load(vm, options, JNI_TRUE, &shim);
+        fprintf(stderr, "[JHook] Module reloaded: %s\n", current.copy.string().c_str());
     }
 
     static void Shutdown(JavaVM *vm) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current.handle == nullptr) return;
+        if (current.unload(vm) == JHOOK_MODULE_UNLOADED) {
+            Close(current);
+        }
+        current = {};
+    }
+
+private:
+    // 模块路径：agent=<path>，未指定时使用与 JHook 同目录的默认模块
+    static fs::path modulePath(const jvmti_tools::Options &options) {
+        if (const auto path = options.get("agent"); !path.empty()) return path;
+#ifdef _WIN32
+        HMODULE self = nullptr;
+        char buffer[MAX_PATH] = {};
+        GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCSTR>(&AgentProxy::modulePath), &self);
+        GetModuleFileNameA(self, buffer, MAX_PATH);
+        const fs::path location(buffer);
+#else
+        Dl_info info = {};
+        dladdr(reinterpret_cast<void *>(&AgentProxy::modulePath), &info);
+        const fs::path location(info.dli_fname ? info.dli_fname : "");
+#endif
+        return location.parent_path() / JHOOK_DEFAULT_MODULE;
+    }
+
+    // 复制为唯一的临时文件再加载：同一路径重复 dlopen 会返回已加载的旧模块，
+    // 并且覆盖正在映射的库文件会导致进程崩溃
+    static bool Open(const fs::path &source, LoadedModule &module) {
+        std::error_code ec;
+        const auto copy = fs::temp_directory_path(ec) / ("jhook-" + std::to_string(processId()) + "-" +
+                                                         std::to_string(sequence.fetch_add(1)) + "-" +
+                                                         source.filename().string());
+        if (ec || !fs::copy_file(source, copy, fs::copy_options::overwrite_existing, ec)) {
+            fprintf(stderr, "[JHook] Failed to copy module %s: %s\n", source.string().c_str(), ec.message().c_str());
+            return false;
+        }
+
+#ifdef _WIN32
+        void *handle = LoadLibraryA(copy.string().c_str());
+#else
+        void *handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+        // 已映射的库不依赖文件，立即删除副本
+        fs::remove(copy, ec);
+#endif
+        if (handle == nullptr) {
+            fprintf(stderr, "[JHook] Failed to load module %s: %s\n", source.string().c_str(), lastError().c_str());
+            fs::remove(copy, ec);
+            return false;
+        }
+
+        const auto version = reinterpret_cast<JHookModuleVersion>(symbol(handle, JHOOK_MODULE_VERSION_SYMBOL));
+        LoadedModule loaded{handle, copy};
+        loaded.load = reinterpret_cast<JHookModuleLoad>(symbol(handle, JHOOK_MODULE_LOAD_SYMBOL));
+        loaded.unload = reinterpret_cast<JHookModuleUnload>(symbol(handle, JHOOK_MODULE_UNLOAD_SYMBOL));
+        if (version == nullptr || loaded.load == nullptr || loaded.unload == nullptr
+            || version() != JHOOK_MODULE_ABI_VERSION) {
+            fprintf(stderr, "[JHook] Incompatible module: %s\n", source.string().c_str());
+            Close(loaded);
+            return false;
+        }
+        module = loaded;
+        return true;
+    }
+
+    static void Close(LoadedModule &module) {
+        if (module.handle == nullptr) return;
+#ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(module.handle));
+        std::error_code ec;
+        fs::remove(module.copy, ec);
+#else
+        dlclose(module.handle);
+#endif
+        module = {};
+    }
+
+    static void *symbol(void *handle, const char *name) {
+#ifdef _WIN32
+        return reinterpret_cast<void *>(GetProcAddress(static_cast<HMODULE>(handle), name));
+#else
+        return dlsym(handle, name);
+#endif
+    }
+
+    static std::string lastError() {
+#ifdef _WIN32
+        return std::to_string(GetLastError());
+#else
+        const char *error = dlerror();
+        return error ? error : "";
+#endif
+    }
+
+    static unsigned long processId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
     }
 };
 
-bool AgentProxy::initialized = false;
+std::mutex AgentProxy::mutex;
+LoadedModule AgentProxy::current;
+std::atomic<unsigned> AgentProxy::sequence{0};
 
 // 代理随 JVM 初始化启动逻辑
 JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved) {
@@ -47,7 +481,7 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved) {
     return JNI_OK;
 }
 
-// 代理动态附加处理逻辑
+// 代理动态附加处理逻辑（再次附加并指定 reload 时热替换模块）
 JNIEXPORT jint JNICALL Agent_OnAttach(JavaVM *vm, char *options, void *reserved) {
     AgentProxy::Initialization(vm, options, true);
     return JNI_OK;
@@ -0,0 +1,71 @@
+//
+// JHook 与代理模块之间的接口约定，JHook 通过 dlopen 加载模块后按名称查找以下导出函数
+//
+
+#ifndef JHOOK_MODULE_H
+#define JHOOK_MODULE_H
+#include <jni.h>
+#include <jvmti.h>
+
+// 接口版本：JHook 与模块不一致时拒绝加载
+#define JHOOK_MODULE_ABI_VERSION 3
+
+#define JHOOK_MODULE_VERSION_SYMBOL "JHook_ModuleVersion"
+#define JHOOK_MODULE_LOAD_SYMBOL "JHook_ModuleLoad"
+#define JHOOK_MODULE_UNLOAD_SYMBOL "JHook_ModuleUnload"
+
+// 模块卸载结果
+#define JHOOK_MODULE_UNLOADED 0 // 事件已停止、回调与代理线程均已离开模块代码，可以安全卸载
+#define JHOOK_MODULE_BUSY 1 // 事件已停止但仍有回调或代理线程未结束，模块代码必须保留在内存中
+#define JHOOK_MODULE_REFUSED 2 // 模块仍被 VM 引用（如 native 方法直接绑定到模块代码），未做任何变更
+
+// native 方法跳板数量，以及跳板按机器字转发的最多参数字数（不含 JNIEnv 与 this/class）
+#define JHOOK_NATIVE_SLOTS 64
+#define JHOOK_NATIVE_MAX_WORDS 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 由模块根据方法与原始实现地址重新确定跳板目标，返回 NULL 表示直接调用原始实现
+typedef void *(JNICALL *JHookNativeResolver)(void *context, jmethodID method, void *original);
+
+// JHook 提供给模块的服务，函数均位于 JHook 中，模块卸载后仍然有效
+typedef struct JHookShim {
+    // 为模块回调生成 JHook 中的稳定入口：入口先登记在途计数，再调用 targets 中的模块回调，
+    // 模块回调返回后才撤销计数。模块应向 VM 注册 entries 而不是自己的回调；
+    // JHook 不支持的事件在 entries 中为空，模块不能启用该事件
+    void (JNICALL *route)(const jvmtiEventCallbacks *targets, jvmtiEventCallbacks *entries);
+
+    // 停止路由并等待在途回调返回 JHook，超时返回 JNI_FALSE
+    jboolean (JNICALL *drain)(jlong timeout_ms);
+
+    // 代替 jvmtiEnv::RunAgentThread：线程入口位于 JHook 中，proc 返回后才撤销线程计数
+    jvmtiError (JNICALL *runAgentThread)(jvmtiEnv *jvmti, jthread thread, jvmtiStartFunction proc, const void *arg,
+                                         jint priority);
+
+    // 等待经 runAgentThread 启动的线程全部从模块代码返回，超时返回 JNI_FALSE
+    jboolean (JNICALL *join)(jlong timeout_ms);
+
+    // 为 native 方法分配 JHook 中的稳定跳板，模块应让 VM 绑定跳板而不是自己的实现：
+    // 跳板与事件入口共用在途计数（按线程分散，drain 时汇总），经 target 调用模块代码，drain 之后直接调用 original。
+    // 跳板按机器字转发 words 个参数，不支持含 float/double 的签名；同一方法重复绑定时复用跳板，
+    // 槽位耗尽或参数过多时返回 NULL
+    void *(JNICALL *bindNative)(jmethodID method, void *original, void *target, jint words, jboolean returns_void);
+
+    // 模块加载后为已分配的跳板重新确定目标：VM 不会为已绑定的方法再次发送 NativeMethodBind
+    void (JNICALL *rebindNatives)(JHookNativeResolver resolve, void *context);
+} JHookShim;
+
+typedef jint (JNICALL *JHookModuleVersion)();
+
+// attach 为 JNI_TRUE 表示动态附加（包括热替换后的重新加载）
+typedef jint (JNICALL *JHookModuleLoad)(JavaVM *vm, char *options, jboolean attach, const JHookShim *shim);
+
+typedef jint (JNICALL *JHookModuleUnload)(JavaVM *vm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //JHOOK_MODULE_H
@@ -7,28 +7,55 @@
 #include <jvmti.h>
 
 #include "Logger.h"
+#include "Options.h"
 
 namespace jvmti {
+    class AgentHost;
+
+    // 代理模块：声明所需能力与事件回调，由 AgentHost 合并后注册到同一个 jvmtiEnv
     class Agent {
+        friend class AgentHost;
+
     protected:
         static Logger logger;
-        JavaVM *g_vm = nullptr;
-        jvmtiEnv *g_jvmti = nullptr;
+        JavaVM *g_vm = nullptr; // 由 AgentHost 在启动时设置
+        jvmtiEnv *g_jvmti = nullptr; // 所有模块共享同一个环境，不得释放
         jvmtiCapabilities capabilities = {};
         jvmtiEventCallbacks callbacks = {};
+
     public:
-        Agent(JavaVM *vm, char *args);
+        Agent() = default;
+
+        virtual ~Agent() = default;
 
-        virtual ~Agent();
+        Agent(const Agent &) = delete;
 
-        virtual void processAgent(bool attach = false);
+        Agent &operator=(const Agent &) = delete;
+
+        // 模块名称，用于 module= 参数选择模块及日志输出
+        virtual const char *name() const = 0;
 
     protected:
-        virtual void ParseOptions(const char *args) const = 0;
+        // 启动时及每次再次附加时调用；再次附加后会重新声明能力与事件，宿主按变化补充能力并更新事件
+        virtual void ParseOptions(const jvmti_tools::Options &options) {
+        }
 
         virtual void AddCapability(jvmtiCapabilities *capabilities) const = 0;
 
+        // 仅设置需要的回调；未设置回调的事件不会被启用
         virtual void RegisterEvent(jvmtiEventCallbacks *callbacks) const = 0;
+
+        // 能力与事件均已生效后调用，attach 表示动态附加
+        virtual void OnStart(bool attach) {
+        }
+
+        // 事件已停止分发后调用，用于输出统计、释放资源。模块启动的线程执行模块代码，必须在此结束；
+        // 回调使用的对象不在此释放而保留到模块卸载，非受保护模式下停止时可能仍有回调在执行
+        virtual void OnStop() {
+        }
+
+        // 模块代码卸载后是否仍会被 VM 调用（例如 native 方法未经 JHook 跳板直接绑定到模块代码）
+        virtual bool CanUnload() const { return true; }
     };
 } // jvmti
 
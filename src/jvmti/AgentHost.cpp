@@ -0,0 +1,409 @@
+#include "AgentHost.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace jvmti {
+    namespace {
+        // jvmtiEventCallbacks 按事件编号顺序排列（含保留槽位），可视为以 event - 50 为下标的函数指针数组
+        constexpr size_t EVENT_SLOTS = sizeof(jvmtiEventCallbacks) / sizeof(void *);
+        // 同一事件最多订阅的模块数量
+        constexpr size_t MAX_SUBSCRIBERS = 8;
+
+        // 再次附加时分发表可能被重建：先写回调再发布数量，扇出函数在重建期间可能看到新旧回调的混合，
+        // 二者都是已加载模块中的有效代码
+        struct DispatchTable {
+            std::atomic<size_t> count{0};
+            std::array<std::atomic<void *>, MAX_SUBSCRIBERS> callbacks{};
+        };
+
+        std::array<DispatchTable, EVENT_SLOTS> dispatch_tables;
+        std::atomic<bool> host_active{false};
+
+        constexpr jvmtiEvent eventOf(const size_t slot) {
+            return static_cast<jvmtiEvent>(JVMTI_MIN_EVENT_TYPE_VAL + slot);
+        }
+
+        std::array<void *, EVENT_SLOTS> slotsOf(const jvmtiEventCallbacks &callbacks) {
+            std::array<void *, EVENT_SLOTS> slots{};
+            std::memcpy(slots.data(), &callbacks, sizeof(callbacks));
+            return slots;
+        }
+
+        // 扇出函数：按注册顺序调用订阅了该事件的模块回调
+        template<size_t Slot, typename Callback>
+        struct Fanout;
+
+        template<size_t Slot, typename... Args>
+        struct Fanout<Slot, void (JNICALL *)(Args...)> {
+            static void JNICALL dispatch(Args... args) {
+                const auto &table = dispatch_tables[Slot];
+                const size_t count = table.count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i) {
+                    reinterpret_cast<void (JNICALL *)(Args...)>(table.callbacks[i].load(std::memory_order_relaxed))(
+                        args...);
+                }
+            }
+        };
+
+        constexpr size_t CLASS_FILE_LOAD_HOOK_SLOT = offsetof(jvmtiEventCallbacks, ClassFileLoadHook) / sizeof(void *);
+        static_assert(eventOf(CLASS_FILE_LOAD_HOOK_SLOT) == JVMTI_EVENT_CLASS_FILE_LOAD_HOOK);
+
+        // ClassFileLoadHook 需要串联：后一个模块看到的是前一个模块替换后的字节码
+        template<>
+        struct Fanout<CLASS_FILE_LOAD_HOOK_SLOT, jvmtiEventClassFileLoadHook> {
+            static void JNICALL dispatch(jvmtiEnv *jvmti_env, JNIEnv *jni_env, jclass class_being_redefined,
+                                         jobject loader, const char *name, jobject protection_domain,
+                                         const jint class_data_len, const unsigned char *class_data,
+                                         jint *new_class_data_len, unsigned char **new_class_data) {
+                const auto &table = dispatch_tables[CLASS_FILE_LOAD_HOOK_SLOT];
+                const size_t count = table.count.load(std::memory_order_acquire);
+                jint current_len = class_data_len;
+                const unsigned char *current = class_data;
+                unsigned char *replaced = nullptr;
+                for (size_t i = 0; i < count; ++i) {
+                    jint out_len = 0;
+                    unsigned char *out = nullptr;
+                    reinterpret_cast<jvmtiEventClassFileLoadHook>(table.callbacks[i].load(std::memory_order_relaxed))(
+                        jvmti_env, jni_env, class_being_redefined, loader, name, protection_domain,
+                        current_len, current, &out_len, &out);
+                    if (out == nullptr) continue;
+                    if (replaced) jvmti_env->Deallocate(replaced);
+                    replaced = out;
+                    current = out;
+                    current_len = out_len;
+                }
+                if (replaced) {
+                    *new_class_data = replaced;
+                    *new_class_data_len = current_len;
+                }
+            }
+        };
+
+        template<size_t Slot, typename Callback>
+        void *fanoutOf() {
+            static_assert(Slot < EVENT_SLOTS);
+            return reinterpret_cast<void *>(&Fanout<Slot, Callback>::dispatch);
+        }
+
+#define AGENT_HOST_FANOUT(Member) \
+        fanouts[offsetof(jvmtiEventCallbacks, Member) / sizeof(void *)] = \
+            fanoutOf<offsetof(jvmtiEventCallbacks, Member) / sizeof(void *), decltype(jvmtiEventCallbacks::Member)>()
+
+        // 各事件的扇出函数；未列出的事件（如较新 JDK 新增的事件）只允许单个模块订阅
+        std::array<void *, EVENT_SLOTS> makeFanouts() {
+            std::array<void *, EVENT_SLOTS> fanouts{};
+            AGENT_HOST_FANOUT(VMInit);
+            AGENT_HOST_FANOUT(VMDeath);
+            AGENT_HOST_FANOUT(ThreadStart);
+            AGENT_HOST_FANOUT(ThreadEnd);
+            AGENT_HOST_FANOUT(ClassFileLoadHook);
+            AGENT_HOST_FANOUT(ClassLoad);
+            AGENT_HOST_FANOUT(ClassPrepare);
+            AGENT_HOST_FANOUT(VMStart);
+            AGENT_HOST_FANOUT(Exception);
+            AGENT_HOST_FANOUT(ExceptionCatch);
+            AGENT_HOST_FANOUT(SingleStep);
+            AGENT_HOST_FANOUT(FramePop);
+            AGENT_HOST_FANOUT(Breakpoint);
+            AGENT_HOST_FANOUT(FieldAccess);
+            AGENT_HOST_FANOUT(FieldModification);
+            AGENT_HOST_FANOUT(MethodEntry);
+            AGENT_HOST_FANOUT(MethodExit);
+            AGENT_HOST_FANOUT(NativeMethodBind);
+            AGENT_HOST_FANOUT(CompiledMethodLoad);
+            AGENT_HOST_FANOUT(CompiledMethodUnload);
+            AGENT_HOST_FANOUT(DynamicCodeGenerated);
+            AGENT_HOST_FANOUT(DataDumpRequest);
+            AGENT_HOST_FANOUT(MonitorWait);
+            AGENT_HOST_FANOUT(MonitorWaited);
+            AGENT_HOST_FANOUT(MonitorContendedEnter);
+            AGENT_HOST_FANOUT(MonitorContendedEntered);
+            AGENT_HOST_FANOUT(ResourceExhausted);
+            AGENT_HOST_FANOUT(GarbageCollectionStart);
+            AGENT_HOST_FANOUT(GarbageCollectionFinish);
+            AGENT_HOST_FANOUT(ObjectFree);
+            AGENT_HOST_FANOUT(VMObjectAlloc);
+            AGENT_HOST_FANOUT(SampledObjectAlloc);
+#ifdef JVMTI_HAS_VIRTUAL_THREADS
+            AGENT_HOST_FANOUT(VirtualThreadStart);
+            AGENT_HOST_FANOUT(VirtualThreadEnd);
+#endif
+            return fanouts;
+        }
+
+#undef AGENT_HOST_FANOUT
+
+        const auto fanouts = makeFanouts();
+
+        // jvmtiCapabilities 由位域组成，按字节合并
+        using CapabilityBytes = std::array<unsigned char, sizeof(jvmtiCapabilities)>;
+
+        CapabilityBytes bytesOf(const jvmtiCapabilities &capabilities) {
+            CapabilityBytes bytes;
+            std::memcpy(bytes.data(), &capabilities, sizeof(capabilities));
+            return bytes;
+        }
+
+        jvmtiCapabilities capabilitiesOf(const CapabilityBytes &bytes) {
+            jvmtiCapabilities capabilities;
+            std::memcpy(&capabilities, bytes.data(), sizeof(capabilities));
+            return capabilities;
+        }
+
+        // 添加 VM 可以提供的能力，不可用的能力被忽略（由模块在运行时按实际能力降级）
+        jvmtiError addAvailable(jvmtiEnv *jvmti, CapabilityBytes bytes, const CapabilityBytes &available) {
+            bool empty = true;
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                bytes[i] &= available[i];
+                empty &= bytes[i] == 0;
+            }
+            if (empty) return JVMTI_ERROR_NONE;
+            const auto capabilities = capabilitiesOf(bytes);
+            return jvmti->AddCapabilities(&capabilities);
+        }
+
+        bool sameCallbacks(const jvmtiEventCallbacks &a, const jvmtiEventCallbacks &b) {
+            return std::memcmp(&a, &b, sizeof(jvmtiEventCallbacks)) == 0;
+        }
+    }
+
+    AgentHost::AgentHost(std::shared_ptr<spdlog::logger> log, const JHookShim *shim)
+        : log_(std::move(log)), shim_(shim) {
+    }
+
+    AgentHost::~AgentHost() {
+        if (started_) stop();
+    }
+
+    void AgentHost::add(std::unique_ptr<Agent> module) {
+        if (started_) {
+            log_->error("Agent host already started, ignore module: {}", module->name());
+            return;
+        }
+        modules_.push_back(std::move(module));
+    }
+
+    jint AgentHost::start(JavaVM *vm, const jvmti_tools::Options &options, const bool attach) {
+        if (started_) return reattach(options, attach);
+        if (host_active.exchange(true)) {
+            log_->error("Another agent host is already running");
+            return JNI_ERR;
+        }
+
+        vm_ = vm;
+        if (vm->GetEnv(reinterpret_cast<void **>(&jvmti_), JVMTI_VERSION_1_2) != JNI_OK || jvmti_ == nullptr) {
+            log_->error("Failed to get JVMTI environment");
+            host_active = false;
+            return JNI_ERR;
+        }
+
+        // 1. 收集模块声明并合并能力
+        CapabilityBytes required{};
+        for (const auto &module: modules_) {
+            module->g_vm = vm;
+            module->g_jvmti = jvmti_;
+            module->ParseOptions(options);
+            module->AddCapability(&module->capabilities);
+            module->RegisterEvent(&module->callbacks);
+            const auto bytes = bytesOf(module->capabilities);
+            for (size_t i = 0; i < required.size(); ++i) required[i] |= bytes[i];
+        }
+
+        jvmtiCapabilities potential = {};
+        jvmti_->GetPotentialCapabilities(&potential);
+        const auto available = bytesOf(potential);
+        bool missing = false;
+        for (size_t i = 0; i < required.size(); ++i) missing |= (required[i] & ~available[i]) != 0;
+        if (missing) log_->warn("Some capabilities required by agent modules are not available");
+        if (const jvmtiError err = addAvailable(jvmti_, required, available); err != JVMTI_ERROR_NONE) {
+            // 合并添加失败时逐个模块添加，添加失败的模块不启用任何事件
+            log_->error("Failed to add capabilities: {}", static_cast<int>(err));
+            for (const auto &module: modules_) {
+                if (const jvmtiError module_err = addAvailable(jvmti_, bytesOf(module->capabilities), available);
+                    module_err != JVMTI_ERROR_NONE) {
+                    log_->error("Failed to add capabilities for module {}: {}, its events are disabled",
+                                module->name(), static_cast<int>(module_err));
+                    module->callbacks = {};
+                }
+            }
+        }
+
+        // 2. 构建分发表、注册回调并仅启用有订阅者的事件
+        install();
+
+        std::string names;
+        for (const auto &module: modules_) {
+            if (!names.empty()) names += ',';
+            names += module->name();
+        }
+        log_->info("Agent host started: modules=[{}], events={}", names, enabled_.size());
+
+        started_ = true;
+        for (const auto &module: modules_) module->OnStart(attach);
+        return JNI_OK;
+    }
+
+    jint AgentHost::reattach(const jvmti_tools::Options &options, const bool attach) {
+        jvmtiCapabilities potential = {};
+        jvmti_->GetPotentialCapabilities(&potential);
+        const auto available = bytesOf(potential);
+
+        // 模块重新解析参数后声明可能变化：新增的能力能够添加时采用新声明，否则保留原声明并跳过该模块
+        bool changed = false;
+        std::vector<const Agent *> refused;
+        for (const auto &module: modules_) {
+            module->ParseOptions(options);
+            jvmtiCapabilities capabilities = {};
+            jvmtiEventCallbacks callbacks = {};
+            module->AddCapability(&capabilities);
+            module->RegisterEvent(&callbacks);
+            auto added = bytesOf(capabilities);
+            const auto current = bytesOf(module->capabilities);
+            bool grown = false;
+            for (size_t i = 0; i < added.size(); ++i) {
+                added[i] &= ~current[i];
+                grown |= added[i] != 0;
+            }
+            if (!grown && sameCallbacks(callbacks, module->callbacks)) continue;
+
+            if (const jvmtiError err = addAvailable(jvmti_, added, available); err != JVMTI_ERROR_NONE) {
+                log_->error("Failed to add capabilities for module {} on attach: {}, keep previous events",
+                            module->name(), static_cast<int>(err));
+                refused.push_back(module.get());
+                continue;
+            }
+            module->capabilities = capabilities;
+            module->callbacks = callbacks;
+            changed = true;
+        }
+
+        if (changed) {
+            install();
+            log_->info("Agent host events updated on attach: events={}", enabled_.size());
+        }
+        for (const auto &module: modules_) {
+            if (std::find(refused.begin(), refused.end(), module.get()) == refused.end()) module->OnStart(attach);
+        }
+        return JNI_OK;
+    }
+
+    void AgentHost::install() {
+        // 单个订阅者直接注册，多个订阅者注册扇出函数
+        std::array<void *, EVENT_SLOTS> installed{};
+        for (size_t slot = 0; slot < EVENT_SLOTS; ++slot) {
+            std::array<void *, MAX_SUBSCRIBERS> subscribers{};
+            size_t count = 0;
+            for (const auto &module: modules_) {
+                void *callback = slotsOf(module->callbacks)[slot];
+                if (callback == nullptr) continue;
+                if (count == MAX_SUBSCRIBERS) {
+                    log_->error("Too many subscribers for event {}, ignore module: {}", JVMTI_MIN_EVENT_TYPE_VAL + slot,
+                                module->name());
+                    continue;
+                }
+                subscribers[count++] = callback;
+            }
+            auto &table = dispatch_tables[slot];
+            for (size_t i = 0; i < count; ++i) table.callbacks[i].store(subscribers[i], std::memory_order_relaxed);
+            table.count.store(count, std::memory_order_release);
+
+            if (count == 1) {
+                installed[slot] = subscribers[0];
+            } else if (count > 0) {
+                installed[slot] = fanouts[slot];
+                if (installed[slot] == nullptr) {
+                    log_->error("Event {} does not support fan-out, only the first subscriber is used",
+                                JVMTI_MIN_EVENT_TYPE_VAL + slot);
+                    installed[slot] = subscribers[0];
+                }
+            }
+        }
+
+        jvmtiEventCallbacks callbacks = {};
+        std::memcpy(&callbacks, installed.data(), sizeof(callbacks));
+        if (shim_) {
+            // 由 JHook 加载：VM 只能持有 JHook 中的入口，JHook 没有入口的事件不能启用
+            jvmtiEventCallbacks entries = {};
+            shim_->route(&callbacks, &entries);
+            const auto routed = slotsOf(entries);
+            for (size_t slot = 0; slot < EVENT_SLOTS; ++slot) {
+                if (installed[slot] == nullptr || routed[slot] != nullptr) continue;
+                log_->error("Event {} is not supported by JHook, disabled", JVMTI_MIN_EVENT_TYPE_VAL + slot);
+                installed[slot] = nullptr;
+            }
+            callbacks = entries;
+        }
+        jvmti_->SetEventCallbacks(&callbacks, sizeof(callbacks));
+
+        // 仅启用有订阅者的事件，不再有订阅者的事件被关闭
+        std::vector<jvmtiEvent> enabled;
+        for (size_t slot = 0; slot < EVENT_SLOTS; ++slot) {
+            const jvmtiEvent event = eventOf(slot);
+            const bool active = std::find(enabled_.begin(), enabled_.end(), event) != enabled_.end();
+            if (installed[slot] == nullptr) {
+                if (active) jvmti_->SetEventNotificationMode(JVMTI_DISABLE, event, nullptr);
+                continue;
+            }
+            if (!active) {
+                if (const jvmtiError err = jvmti_->SetEventNotificationMode(JVMTI_ENABLE, event, nullptr);
+                    err != JVMTI_ERROR_NONE) {
+                    log_->error("Failed to enable event {}: {}", static_cast<int>(event), static_cast<int>(err));
+                    continue;
+                }
+            }
+            enabled.push_back(event);
+        }
+        enabled_ = std::move(enabled);
+    }
+
+    void AgentHost::stop() {
+        if (!started_) return;
+        for (const jvmtiEvent event: enabled_) {
+            jvmti_->SetEventNotificationMode(JVMTI_DISABLE, event, nullptr);
+        }
+        enabled_.clear();
+        const jvmtiEventCallbacks callbacks = {};
+        jvmti_->SetEventCallbacks(&callbacks, sizeof(callbacks));
+
+        // 模块释放资源前等待正在执行的回调返回 JHook
+        if (shim_) {
+            drained_ = shim_->drain(DRAIN_TIMEOUT.count()) == JNI_TRUE;
+            if (!drained_) log_->warn("Agent host stopped with callbacks still running");
+        }
+        for (const auto &module: modules_) module->OnStop();
+        started_ = false;
+        host_active = false;
+    }
+
+    bool AgentHost::canUnload() const {
+        for (const auto &module: modules_) {
+            if (!module->CanUnload()) {
+                log_->warn("Agent module {} can not be unloaded", module->name());
+                return false;
+            }
+        }
+        return shim_ != nullptr || !started_;
+    }
+
+    bool AgentHost::unload() {
+        if (!canUnload()) return false;
+        stop();
+        if (!drained_) return false;
+        // 模块的代理线程已在 OnStop 中结束，等待其线程函数返回 JHook
+        if (shim_ && shim_->join(DRAIN_TIMEOUT.count()) != JNI_TRUE) {
+            log_->warn("Agent threads are still running module code");
+            return false;
+        }
+        // 释放环境：回收能力，此后 VM 不再持有任何指向模块代码的回调
+        if (jvmti_) {
+            jvmti_->DisposeEnvironment();
+            jvmti_ = nullptr;
+        }
+        return true;
+    }
+} // jvmti
@@ -0,0 +1,75 @@
+#ifndef AGENTHOST_H
+#define AGENTHOST_H
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <jvmti.h>
+
+#include "Agent.h"
+#include "Options.h"
+#include "../jhook/JHookModule.h"
+#include "spdlog/logger.h"
+
+namespace jvmti {
+    // 多模块代理宿主：
+    // 1. 合并所有模块声明的能力，一次性添加到共享的 jvmtiEnv
+    // 2. 为每个事件建立分发表：仅一个模块订阅时直接注册该模块的回调，
+    //    多个模块订阅时注册扇出函数按注册顺序依次调用（无虚函数调用）
+    // 3. 只启用至少有一个模块订阅的事件，未使用的事件没有任何开销
+    // 4. 由 JHook 加载时，VM 只持有 JHook 中的稳定入口（见 JHookShim::route），在途回调由 JHook 统计，
+    //    卸载前先停止事件再由 JHook 等待在途回调返回，之后才能安全卸载模块代码
+    // 进程内同一时刻只允许一个宿主处于启动状态（事件回调为全局函数）
+    class AgentHost {
+    private:
+        static constexpr std::chrono::milliseconds DRAIN_TIMEOUT{5000};
+
+        std::shared_ptr<spdlog::logger> log_;
+        std::vector<std::unique_ptr<Agent> > modules_;
+        JavaVM *vm_ = nullptr;
+        jvmtiEnv *jvmti_ = nullptr;
+        std::vector<jvmtiEvent> enabled_;
+        const JHookShim *shim_ = nullptr;
+        bool started_ = false;
+        bool drained_ = true;
+
+        // 再次附加：对比模块的新声明，补充能力并重建分发表
+        jint reattach(const jvmti_tools::Options &options, bool attach);
+
+        // 按模块当前声明构建分发表、注册回调，并使启用的事件与订阅一致
+        void install();
+
+    public:
+        // shim 不为空表示由 JHook 加载，事件经过 JHook 的稳定入口分发
+        explicit AgentHost(std::shared_ptr<spdlog::logger> log, const JHookShim *shim = nullptr);
+
+        ~AgentHost();
+
+        AgentHost(const AgentHost &) = delete;
+
+        AgentHost &operator=(const AgentHost &) = delete;
+
+        // 启动前添加模块，添加顺序即同一事件的回调顺序
+        void add(std::unique_ptr<Agent> module);
+
+        // 获取环境、合并能力、注册回调并启用事件；已启动时模块重新解析参数，声明变化的模块补充能力与事件后
+        // 收到再次附加通知，新增能力无法添加的模块保留原有事件且不会收到通知
+        jint start(JavaVM *vm, const jvmti_tools::Options &options, bool attach);
+
+        // 停止事件分发，等待在途回调结束后通知模块
+        void stop();
+
+        // 所有模块均允许卸载且事件经过 JHook 分发时才能卸载
+        bool canUnload() const;
+
+        // 停止、排空回调并释放 jvmtiEnv；返回 true 表示模块代码可以安全卸载
+        bool unload();
+
+        bool started() const { return started_; }
+
+        jvmtiEnv *env() const { return jvmti_; }
+
+        const std::vector<jvmtiEvent> &enabledEvents() const { return enabled_; }
+    };
+} // jvmti
+
+#endif //AGENTHOST_H
@@ -0,0 +1,84 @@
+#include "AgentThread.h"
+
+#include <utility>
+
+namespace jvmti_tools {
+    AgentThread::Launcher AgentThread::launcher_ = nullptr;
+
+    AgentThread::AgentThread(std::string name, const std::chrono::milliseconds interval, Task task)
+        : name_(std::move(name)), interval_(interval), task_(std::move(task)) {
+    }
+
+    AgentThread::~AgentThread() {
+        stop();
+    }
+
+    void AgentThread::setLauncher(const Launcher launcher) {
+        launcher_ = launcher;
+    }
+
+    bool AgentThread::start(jvmtiEnv *jvmti, JNIEnv *jni) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return true;
+        if (!jni) return false;
+
+        // RunAgentThread 需要一个尚未启动的 java.lang.Thread 对象
+        const jclass thread_class = jni->FindClass("java/lang/Thread");
+        if (!thread_class) {
+            jni->ExceptionClear();
+            return false;
+        }
+        const jmethodID constructor = jni->GetMethodID(thread_class, "<init>", "(Ljava/lang/String;)V");
+        const jstring name = jni->NewStringUTF(name_.c_str());
+        const jobject thread = constructor && name ? jni->NewObject(thread_class, constructor, name) : nullptr;
+        if (jni->ExceptionCheck()) jni->ExceptionClear();
+        jni->DeleteLocalRef(thread_class);
+        if (name) jni->DeleteLocalRef(name);
+        if (!thread) return false;
+
+        stopping_ = false;
+        const jvmtiError err = launcher_
+                                   ? launcher_(jvmti, thread, &AgentThread::run, this, JVMTI_THREAD_NORM_PRIORITY)
+                                   : jvmti->RunAgentThread(thread, &AgentThread::run, this, JVMTI_THREAD_NORM_PRIORITY);
+        running_ = err == JVMTI_ERROR_NONE;
+        jni->DeleteLocalRef(thread);
+        return running_;
+    }
+
+    void JNICALL AgentThread::run(jvmtiEnv *, JNIEnv *jni, void *arg) {
+        auto *self = static_cast<AgentThread *>(arg);
+        std::unique_lock<std::mutex> guard(self->mutex_);
+        while (!self->stopping_) {
+            guard.unlock();
+            self->task_(jni);
+            guard.lock();
+            self->wakeup_.wait_for(guard, self->interval_, [self] { return self->stopping_; });
+        }
+        // 通知 stop 之后线程不再访问本对象，但仍在执行本函数的收尾指令（见 setLauncher）
+        self->running_ = false;
+        self->wakeup_.notify_all();
+    }
+
+    void AgentThread::stop() {
+        std::unique_lock<std::mutex> guard(mutex_);
+        if (!running_) return;
+        stopping_ = true;
+        wakeup_.notify_all();
+        wakeup_.wait(guard, [this] { return !running_; });
+    }
+
+    void AgentThread::setInterval(const std::chrono::milliseconds interval) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interval_ = interval;
+    }
+
+    std::chrono::milliseconds AgentThread::interval() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return interval_;
+    }
+
+    bool AgentThread::running() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+} // jvmti_tools
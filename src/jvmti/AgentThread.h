@@ -0,0 +1,61 @@
+#ifndef AGENTTHREAD_H
+#define AGENTTHREAD_H
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <jvmti.h>
+
+namespace jvmti_tools {
+    // 周期任务线程：通过 RunAgentThread 以守护 Java 线程运行，由 VM 负责附加与 JNIEnv，
+    // 可在任务中调用 JNI/JVMTI；VM 退出时不会被等待。需要在活动阶段（VMInit 之后）启动，
+    // 停止时等待线程函数返回，模块在 VMDeath 与 OnStop 中都应调用 stop。
+    // stop 返回时线程仍在执行线程函数的收尾指令，由 JHook 加载时须通过 setLauncher 使用 JHook 启动线程，
+    // 卸载模块前由 JHook 确认线程已离开模块代码
+    class AgentThread {
+    public:
+        using Task = std::function<void(JNIEnv *)>;
+        using Launcher = jvmtiError (JNICALL *)(jvmtiEnv *jvmti, jthread thread, jvmtiStartFunction proc,
+                                                const void *arg, jint priority);
+
+    private:
+        static Launcher launcher_;
+
+        std::string name_;
+        std::chrono::milliseconds interval_;
+        Task task_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable wakeup_;
+        bool running_ = false;
+        bool stopping_ = false;
+
+        static void JNICALL run(jvmtiEnv *jvmti, JNIEnv *jni, void *arg);
+
+    public:
+        AgentThread(std::string name, std::chrono::milliseconds interval, Task task);
+
+        ~AgentThread();
+
+        AgentThread(const AgentThread &) = delete;
+
+        AgentThread &operator=(const AgentThread &) = delete;
+
+        // 替换线程的启动方式，为空时使用 jvmtiEnv::RunAgentThread；须在启动任何线程之前设置
+        static void setLauncher(Launcher launcher);
+
+        bool start(jvmtiEnv *jvmti, JNIEnv *jni);
+
+        void stop();
+
+        // 调整执行间隔，下一次等待生效
+        void setInterval(std::chrono::milliseconds interval);
+
+        std::chrono::milliseconds interval() const;
+
+        bool running() const;
+    };
+} // jvmti_tools
+
+#endif //AGENTTHREAD_H
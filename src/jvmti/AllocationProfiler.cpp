@@ -0,0 +1,158 @@
+#include "AllocationProfiler.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "ClassRegistry.h"
+
+namespace jvmti_tools {
+    namespace {
+        // 对象标签布局：第 62 位标记对象标签，40~61 位为分配点编号，低 40 位为对象大小
+        constexpr int SITE_SHIFT = 40;
+        constexpr uint64_t SIZE_MASK = (uint64_t{1} << SITE_SHIFT) - 1;
+        constexpr uint64_t SITE_MASK = AllocationProfiler::MAX_CAPACITY - 1;
+
+        jlong encodeTag(const uint32_t site, const jlong size) {
+            const uint64_t bytes = std::min(static_cast<uint64_t>(std::max<jlong>(size, 0)), SIZE_MASK);
+            return ClassRegistry::OBJECT_TAG_BIT | static_cast<jlong>(static_cast<uint64_t>(site) << SITE_SHIFT | bytes);
+        }
+
+        // 折叠栈格式以 ';' 分隔帧，数组类型签名中的 ';' 需要去掉
+        std::string flameFrame(std::string name) {
+            name.erase(std::remove(name.begin(), name.end(), ';'), name.end());
+            return name;
+        }
+    }
+
+    AllocationProfiler::AllocationProfiler(jvmtiEnv *jvmti, const AllocationProfilerOptions &options,
+                                           std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)),
+          index_(std::min(options.capacity, MAX_CAPACITY / 2)),
+          sites_(std::make_unique<Site[]>(index_.capacity())), stacks_(options.capacity), methods_(jvmti) {
+        options_.stack_depth = std::min(options_.stack_depth, MAX_STACK_DEPTH);
+    }
+
+    void AllocationProfiler::record(JNIEnv *jni, const jthread thread, const jobject object, const jclass klass,
+                                    const jlong size) {
+        const jlong type = ClassRegistry::global().idOf(jvmti_, klass);
+        uint64_t key = mixHash(static_cast<uint64_t>(type));
+        uint64_t stack = 0;
+        if (options_.stack_depth > 0) {
+            jvmtiFrameInfo frames[MAX_STACK_DEPTH];
+            jint depth = 0;
+            if (jvmti_->GetStackTrace(thread, 0, static_cast<jint>(options_.stack_depth), frames, &depth) ==
+                JVMTI_ERROR_NONE) {
+                stack = stacks_.intern(frames, depth);
+                key = combineHash(key, stack);
+            }
+        }
+
+        // 分配点编号在发布前写入，其他线程取得编号时类型与调用栈已就绪
+        const uint32_t *index = index_.acquire(key, 1, [&](uint32_t &slot) {
+            slot = next_site_.fetch_add(1, std::memory_order_relaxed);
+            sites_[slot].type = type;
+            sites_[slot].stack = stack;
+        });
+        if (!index) return;
+        Site &site = sites_[*index];
+        site.samples.fetch_add(1, std::memory_order_relaxed);
+        site.bytes.fetch_add(static_cast<uint64_t>(std::max<jlong>(size, 0)), std::memory_order_relaxed);
+
+        if (options_.track_live && jvmti_->SetTag(object, encodeTag(*index, size)) != JVMTI_ERROR_NONE) {
+            tag_failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool AllocationProfiler::free(const jlong tag) {
+        // 类编号等其他标签同样会触发 ObjectFree
+        if ((tag & ClassRegistry::OBJECT_TAG_BIT) == 0) return false;
+        const auto value = static_cast<uint64_t>(tag);
+        const auto index = static_cast<uint32_t>(value >> SITE_SHIFT & SITE_MASK);
+        if (index >= next_site_.load(std::memory_order_relaxed) || index >= index_.capacity()) return false;
+        Site &site = sites_[index];
+        site.freed.fetch_add(1, std::memory_order_relaxed);
+        site.freed_bytes.fetch_add(value & SIZE_MASK, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::vector<AllocationProfiler::Row> AllocationProfiler::rows() const {
+        // 同名类型可能被重复登记，按类型名称与调用栈合并
+        const ClassRegistry &classes = ClassRegistry::global();
+        std::map<std::pair<std::string, uint64_t>, Row> merged;
+        index_.forEach([&](uint64_t, uint64_t, const uint32_t index) {
+            const Site &site = sites_[index];
+            Row &row = merged[{classes.name(site.type), site.stack}];
+            if (row.type == 0) {
+                row.type = site.type;
+                row.stack = site.stack;
+            }
+            row.totals.samples += site.samples.load(std::memory_order_relaxed);
+            row.totals.bytes += site.bytes.load(std::memory_order_relaxed);
+            row.totals.freed += site.freed.load(std::memory_order_relaxed);
+            row.totals.freed_bytes += site.freed_bytes.load(std::memory_order_relaxed);
+        });
+        std::vector<Row> rows;
+        rows.reserve(merged.size());
+        for (auto &[key, row]: merged) rows.push_back(row);
+        return rows;
+    }
+
+    AllocationProfiler::Totals AllocationProfiler::totals() const {
+        Totals totals;
+        const uint32_t count = std::min<uint32_t>(next_site_.load(std::memory_order_relaxed),
+                                                  static_cast<uint32_t>(index_.capacity()));
+        for (uint32_t i = 0; i < count; ++i) {
+            totals.samples += sites_[i].samples.load(std::memory_order_relaxed);
+            totals.bytes += sites_[i].bytes.load(std::memory_order_relaxed);
+            totals.freed += sites_[i].freed.load(std::memory_order_relaxed);
+            totals.freed_bytes += sites_[i].freed_bytes.load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+
+    void AllocationProfiler::report(JNIEnv *jni, const size_t top) const {
+        if (!log_) return;
+        auto rows = this->rows();
+        const size_t shown = std::min(top, rows.size());
+        std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(shown), rows.end(),
+                          [](const Row &a, const Row &b) { return a.totals.bytes > b.totals.bytes; });
+
+        const Totals totals = this->totals();
+        log_->info("Allocation profile: samples={} bytes={} freed={} sites={} stacks={} dropped={}",
+                   totals.samples, totals.bytes, totals.freed, index_.size(), stacks_.size(),
+                   index_.dropped() + stacks_.dropped());
+        const ClassRegistry &classes = ClassRegistry::global();
+        for (size_t i = 0; i < shown; ++i) {
+            const auto &[type, stack, site] = rows[i];
+            if (options_.track_live) {
+                log_->info("  #{:<2} bytes={} samples={} live={} {}", i + 1, site.bytes, site.samples,
+                           site.bytes - std::min(site.bytes, site.freed_bytes), classes.name(type));
+            } else {
+                log_->info("  #{:<2} bytes={} samples={} {}", i + 1, site.bytes, site.samples, classes.name(type));
+            }
+            for (const auto &frame: stacks_.frames(stack)) {
+                log_->info("        at {}", methods_.frame(jni, frame.method, frame.location));
+            }
+        }
+        if (const uint64_t failures = tag_failures_.load(std::memory_order_relaxed); failures > 0) {
+            log_->warn("Allocation profile: {} sampled objects could not be tagged, live bytes overestimated",
+                       failures);
+        }
+    }
+
+    void AllocationProfiler::writeFlame(JNIEnv *jni, std::ostream &out, const bool live) const {
+        const ClassRegistry &classes = ClassRegistry::global();
+        for (const auto &[type, stack, site]: rows()) {
+            const uint64_t value = live ? site.bytes - std::min(site.bytes, site.freed_bytes) : site.bytes;
+            if (value == 0) continue;
+            // GetStackTrace 返回的帧栈顶在前，折叠栈需要根帧在前
+            const auto frames = stacks_.frames(stack);
+            for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+                out << flameFrame(methods_.name(jni, it->method, false)) << ';';
+            }
+            out << flameFrame(classes.name(type)) << ' ' << value << '\n';
+        }
+    }
+} // jvmti_tools
@@ -0,0 +1,90 @@
+#ifndef ALLOCATIONPROFILER_H
+#define ALLOCATIONPROFILER_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <jvmti.h>
+
+#include "CounterTable.h"
+#include "MethodResolver.h"
+#include "StackTable.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct AllocationProfilerOptions {
+        size_t capacity = 8192; // 分配点数量上限
+        uint32_t stack_depth = 32; // 采集的调用栈深度，0 表示只按类型统计
+        size_t top = 20; // 报告输出的分配点数量
+        bool track_live = true; // 给采样对象打标签，通过 ObjectFree 统计已回收对象
+    };
+
+    // 分配点采样分析（JDK 11+ SampledObjectAlloc）：按（对象类型、调用栈）聚合采样到的分配。
+    // 分配点编号通过无锁计数表取得，统计值保存在预分配的原子数组中；track_live 时对象标签
+    // 编码分配点与对象大小，ObjectFree 回调只需解码标签并做原子减法，不调用任何 JVMTI/JNI 函数
+    class AllocationProfiler {
+    public:
+        static constexpr uint32_t MAX_STACK_DEPTH = 64;
+        static constexpr size_t MAX_CAPACITY = size_t{1} << 22; // 标签中分配点编号占 22 位
+
+        struct Totals {
+            uint64_t samples = 0;
+            uint64_t bytes = 0;
+            uint64_t freed = 0;
+            uint64_t freed_bytes = 0;
+        };
+
+    private:
+        struct Site {
+            std::atomic<uint64_t> samples{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<uint64_t> freed{0};
+            std::atomic<uint64_t> freed_bytes{0};
+            jlong type = 0; // 对象类型编号（ClassRegistry）
+            uint64_t stack = 0; // 调用栈编号，0 表示未采集
+        };
+
+        jvmtiEnv *jvmti_;
+        AllocationProfilerOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        CounterTable<uint32_t> index_; // (类型, 调用栈) => 分配点编号
+        std::unique_ptr<Site[]> sites_;
+        std::atomic<uint32_t> next_site_{0};
+        StackTable stacks_;
+        MethodResolver methods_;
+        std::atomic<uint64_t> tag_failures_{0};
+
+        // 合并同名类型后的分配点
+        struct Row {
+            jlong type = 0;
+            uint64_t stack = 0;
+            Totals totals;
+        };
+
+        std::vector<Row> rows() const;
+
+    public:
+        AllocationProfiler(jvmtiEnv *jvmti, const AllocationProfilerOptions &options,
+                           std::shared_ptr<spdlog::logger> log);
+
+        // SampledObjectAlloc 事件回调中调用
+        void record(JNIEnv *jni, jthread thread, jobject object, jclass klass, jlong size);
+
+        // ObjectFree 事件回调中调用；不是由本分析器打上的标签返回 false
+        bool free(jlong tag);
+
+        Totals totals() const;
+
+        // 输出采样字节数最高的分配点；jni 可为空
+        void report(JNIEnv *jni, size_t top) const;
+
+        // 以折叠栈格式（flamegraph.pl / speedscope 可读）输出，根帧在前、对象类型为叶子；
+        // live=true 时数值为尚未回收的采样字节数
+        void writeFlame(JNIEnv *jni, std::ostream &out, bool live) const;
+
+        const AllocationProfilerOptions &options() const { return options_; }
+    };
+} // jvmti_tools
+
+#endif //ALLOCATIONPROFILER_H
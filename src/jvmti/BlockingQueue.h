@@ -0,0 +1,64 @@
+#ifndef BLOCKINGQUEUE_H
+#define BLOCKINGQUEUE_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+namespace jvmti_tools {
+    // 阻塞队列（支持生产者-消费者模型），max_size 为 0 时无界
+    template<typename T>
+    class BlockingQueue {
+    private:
+        std::queue<T> queue_;
+        mutable std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::atomic<size_t> max_size_;
+
+    public:
+        explicit BlockingQueue(const size_t max_size = 0): max_size_(max_size) {
+        }
+
+        ~BlockingQueue() = default;
+
+        void push(const T &value) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // 队列满时等待
+            not_full_.wait(lock, [this] {
+                return max_size_ == 0 || queue_.size() < max_size_;
+            });
+            queue_.push(value);
+            not_empty_.notify_one();
+        }
+
+        void push(T &&value) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [this] {
+                return max_size_ == 0 || queue_.size() < max_size_;
+            });
+            queue_.push(std::move(value));
+            not_empty_.notify_one();
+        }
+
+        // 队列为空时最多等待 timeout，超时返回 false
+        bool pop(T &value, const std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!not_empty_.wait_for(lock, timeout, [this] { return !queue_.empty(); })) {
+                return false;
+            }
+            value = std::move(queue_.front());
+            queue_.pop();
+            not_full_.notify_one();
+            return true;
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return queue_.size();
+        }
+    };
+} // jvmti_tools
+
+#endif //BLOCKINGQUEUE_H
@@ -0,0 +1,103 @@
+#ifndef BYTEARRAY_H
+#define BYTEARRAY_H
+#include <array>
+#include <cstring>
+#include <string_view>
+#include <jni.h>
+
+namespace jvmti_tools {
+    // byte[] 临界区访问（GetPrimitiveArrayCritical），持有期间不得调用其他 JNI 函数，也不应阻塞
+    // 只读访问使用 JNI_ABORT 释放，避免拷贝回 Java 堆；写入时调用 commit() 提交
+    class CriticalArray {
+    private:
+        JNIEnv *env_;
+        jarray array_;
+        jsize length_ = 0;
+        void *data_ = nullptr;
+        jint mode_;
+
+    public:
+        CriticalArray(JNIEnv *env, jarray array, const jint release_mode = JNI_ABORT)
+            : env_(env), array_(array), mode_(release_mode) {
+            if (array_ == nullptr) return;
+            // 长度需在进入临界区之前获取
+            length_ = env_->GetArrayLength(array_);
+            data_ = env_->GetPrimitiveArrayCritical(array_, nullptr);
+        }
+
+        // 长度已知时直接进入临界区（例如嵌套获取多个临界区时）
+        CriticalArray(JNIEnv *env, jarray array, const jsize length, const jint release_mode)
+            : env_(env), array_(array), length_(length), mode_(release_mode) {
+            if (array_ == nullptr) return;
+            data_ = env_->GetPrimitiveArrayCritical(array_, nullptr);
+        }
+
+        ~CriticalArray() {
+            if (data_) env_->ReleasePrimitiveArrayCritical(array_, data_, mode_);
+        }
+
+        CriticalArray(const CriticalArray &) = delete;
+
+        CriticalArray &operator=(const CriticalArray &) = delete;
+
+        // 释放时将修改写回数组
+        void commit() { mode_ = 0; }
+
+        explicit operator bool() const { return data_ != nullptr; }
+
+        jsize length() const { return length_; }
+
+        jbyte *bytes() const { return static_cast<jbyte *>(data_); }
+
+        unsigned char *data() const { return static_cast<unsigned char *>(data_); }
+
+        std::string_view view() const {
+            return data_ ? std::string_view(static_cast<const char *>(data_), length_) : std::string_view();
+        }
+    };
+
+    namespace ByteArrays {
+        // 栈上缓冲区能容纳的最大读取长度
+        constexpr size_t STACK_BUFFER_SIZE = 64;
+
+        // 判断数组是否以指定字节开头：短前缀读入栈缓冲区，长前缀在临界区内直接比较
+        inline bool startsWith(JNIEnv *env, jbyteArray array, const std::string_view prefix) {
+            if (array == nullptr || prefix.empty()) return false;
+            const jsize length = env->GetArrayLength(array);
+            if (length < static_cast<jsize>(prefix.size())) return false;
+
+            if (prefix.size() <= STACK_BUFFER_SIZE) {
+                std::array<jbyte, STACK_BUFFER_SIZE> buffer;
+                env->GetByteArrayRegion(array, 0, static_cast<jsize>(prefix.size()), buffer.data());
+                return std::memcmp(buffer.data(), prefix.data(), prefix.size()) == 0;
+            }
+            const CriticalArray bytes(env, array);
+            return bytes && std::memcmp(bytes.bytes(), prefix.data(), prefix.size()) == 0;
+        }
+
+        // 复制数组的一段为新数组：两个临界区之间直接拷贝，无中间缓冲区
+        inline jbyteArray copyOfRange(JNIEnv *env, jbyteArray source, const jsize offset, const jsize length) {
+            if (source == nullptr || offset < 0 || length < 0) return nullptr;
+            const jsize source_length = env->GetArrayLength(source);
+            if (source_length - offset < length) return nullptr;
+            const jbyteArray target = env->NewByteArray(length);
+            if (target == nullptr || length == 0) return target;
+
+            bool copied;
+            {
+                const CriticalArray from(env, source, source_length, JNI_ABORT);
+                const CriticalArray to(env, target, length, 0);
+                copied = from && to;
+                if (copied) std::memcpy(to.bytes(), from.bytes() + offset, length);
+            }
+            // 临界区释放后才能调用其他 JNI 函数
+            if (!copied) {
+                env->DeleteLocalRef(target);
+                return nullptr;
+            }
+            return target;
+        }
+    }
+}
+
+#endif //BYTEARRAY_H
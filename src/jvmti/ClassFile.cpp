@@ -0,0 +1,62 @@
+#include "ClassFile.h"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+
+#include "Metrics.h"
+
+namespace fs = std::filesystem;
+
+namespace jvmti_tools {
+    namespace {
+        std::mutex dump_mutex;
+
+        std::string removeTrailingSlash(const std::string &base_path) {
+            fs::path p = base_path;
+            if (!p.empty() && p.filename() == "") {
+                // 尾部是斜杠
+                p = p.parent_path();
+            }
+            return p.string();
+        }
+    }
+
+    void dumpClassFile(const std::string &base, const std::string &class_name, const unsigned char *class_data,
+                       const jint class_data_len, const bool encrypted, spdlog::logger *log) {
+        if (!class_data || class_data_len <= 0) {
+            return;
+        }
+
+        // 创建输出目录
+        const std::string file_path = std::format("{0}/{2}/{1}.class", removeTrailingSlash(base), class_name,
+                                                  encrypted ? "classes_encrypted" : "classes");
+
+        const fs::path dir = fs::path(file_path).parent_path();
+        try {
+            if (!fs::exists(dir)) {
+                fs::create_directories(dir);
+            }
+        } catch (const fs::filesystem_error &ex) {
+            if (log) log->error("Failed to create directory: {}", ex.what());
+            return;
+        }
+
+        // 写入类文件
+        std::lock_guard<std::mutex> lock(dump_mutex);
+        try {
+            if (std::ofstream file(file_path, std::ios::binary); file.is_open()) {
+                file.write(reinterpret_cast<const char *>(class_data), class_data_len);
+                file.close();
+                auto &metrics = Metrics::global();
+                metrics.add(Counter::DumpedClasses);
+                metrics.add(Counter::DumpedBytes, static_cast<uint64_t>(class_data_len));
+            } else {
+                if (log) log->error("Failed to open file: {}", file_path);
+            }
+        } catch (const std::exception &ex) {
+            if (log) log->error("Error dumping class: {}", ex.what());
+        }
+    }
+} // jvmti_tools
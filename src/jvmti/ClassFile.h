@@ -0,0 +1,35 @@
+#ifndef CLASSFILE_H
+#define CLASSFILE_H
+#include <string>
+#include <jni.h>
+
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    // 类签名转内部类名：Lcom/example/Foo; => com/example/Foo，其他形式原样返回
+    inline std::string className(const char *class_signature) {
+        // 移除类签名中的 'L' 和 ';'
+        std::string class_name(class_signature);
+        if (!class_name.empty() && class_name[0] == 'L' && class_name[class_name.length() - 1] == ';') {
+            class_name = class_name.substr(1, class_name.length() - 2);
+        }
+        return class_name;
+    }
+
+    // 检测类是否被加密（示例逻辑，需根据实际加密方式调整）
+    inline bool isClassEncrypted(const unsigned char *class_data, const jsize class_data_len) {
+        // 示例：检查类文件魔数（正常Java类魔数为0xCAFEBABE）
+        if (class_data_len >= 4 &&
+            (class_data[0] != 0xCA || class_data[1] != 0xFE ||
+             class_data[2] != 0xBA || class_data[3] != 0xBE)) {
+            return true; // 魔数不匹配，可能被加密
+        }
+        return false;
+    }
+
+    // 转储类文件到 <base>/classes/<类名>.class，加密的类转储到 classes_encrypted 目录；log 为空时不输出错误
+    void dumpClassFile(const std::string &base, const std::string &class_name, const unsigned char *class_data,
+                       jint class_data_len, bool encrypted, spdlog::logger *log);
+} // jvmti_tools
+
+#endif //CLASSFILE_H
@@ -0,0 +1,38 @@
+#include "ClassRegistry.h"
+
+#include <string_view>
+
+namespace jvmti_tools {
+    jlong ClassRegistry::idOf(jvmtiEnv *jvmti, const jclass klass) {
+        if (!klass) return 0;
+        jlong tag = 0;
+        if (jvmti->GetTag(klass, &tag) != JVMTI_ERROR_NONE) return 0;
+        if (isClassTag(tag)) return tag;
+
+        char *signature = nullptr;
+        if (jvmti->GetClassSignature(klass, &signature, nullptr) != JVMTI_ERROR_NONE) return 0;
+        std::string_view name = signature ? signature : "?";
+        if (name.size() >= 2 && name.front() == 'L' && name.back() == ';') {
+            name = name.substr(1, name.size() - 2);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            names_.emplace_back(name);
+            tag = static_cast<jlong>(names_.size());
+        }
+        if (signature) jvmti->Deallocate(reinterpret_cast<unsigned char *>(signature));
+        jvmti->SetTag(klass, tag);
+        return tag;
+    }
+
+    std::string ClassRegistry::name(const jlong id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (id <= 0 || static_cast<size_t>(id) > names_.size()) return "?";
+        return names_[static_cast<size_t>(id) - 1];
+    }
+
+    ClassRegistry &ClassRegistry::global() {
+        static ClassRegistry registry;
+        return registry;
+    }
+} // jvmti_tools
@@ -0,0 +1,32 @@
+#ifndef CLASSREGISTRY_H
+#define CLASSREGISTRY_H
+#include <mutex>
+#include <string>
+#include <vector>
+#include <jvmti.h>
+
+namespace jvmti_tools {
+    // 类编号登记：通过共享环境中 Class 对象的标签缓存编号，首次出现时才读取类签名，
+    // 之后每次查询只需一次 GetTag。需要 can_tag_objects。
+    // 类编号占用标签的低位区间；其他模块给普通对象打标签时必须设置 OBJECT_TAG_BIT 以示区分
+    class ClassRegistry {
+    public:
+        static constexpr jlong OBJECT_TAG_BIT = jlong{1} << 62;
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<std::string> names_; // 编号 - 1 => 类内部名称
+
+    public:
+        // 返回类编号，失败时返回 0。并发首次登记同一类时可能得到不同编号，名称相同
+        jlong idOf(jvmtiEnv *jvmti, jclass klass);
+
+        std::string name(jlong id) const;
+
+        static bool isClassTag(const jlong tag) { return tag > 0 && (tag & OBJECT_TAG_BIT) == 0; }
+
+        static ClassRegistry &global();
+    };
+} // jvmti_tools
+
+#endif //CLASSREGISTRY_H
@@ -4,23 +4,26 @@
 
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 
 #include "Agent.h"
 
 namespace fs = std::filesystem;
 
 namespace jvmti {
-    class CodeDump final : Agent {
+    class CodeDump final : public Agent {
     private:
         static std::mutex dump_mutex;
+        static std::string base_path; // 转储目录：dump=<path>
 
     public:
-        CodeDump(JavaVM *vm, char *args) : Agent(vm, args) {
-        }
+        const char *name() const override { return "dump"; }
 
     protected:
-        void ParseOptions(const char *args) const override {
+        void ParseOptions(const jvmti_tools::Options &options) override {
             // 解析命令行参数
+            base_path = options.get("dump");
+            if (!base_path.empty() && base_path.back() != '/') base_path += '/';
         }
 
         void AddCapability(jvmtiCapabilities *capabilities) const override {
@@ -78,9 +81,10 @@ namespace jvmti {
             if (name == nullptr || class_data_len < 0) {
                 return;
             }
-            save("", name, class_data, class_data_len);
+            save(base_path, name, class_data, class_data_len);
         }
     };
 
     std::mutex CodeDump::dump_mutex;
+    std::string CodeDump::base_path;
 } // jvmti
@@ -0,0 +1,170 @@
+#include "Config.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+
+namespace jvmti_tools {
+    namespace {
+        // 槽位已被借用但尚未写入快照指针时的占位值，不会出现在发布或待回收的快照中
+        const AgentConfig reserved_marker;
+        const AgentConfig *const RESERVED = &reserved_marker;
+
+        std::string_view trim(std::string_view value) {
+            while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+            while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+            return value;
+        }
+    }
+
+    PrefixMatcher::PrefixMatcher(const std::string_view rules): source_(rules) {
+        size_t start = 0;
+        while (start <= rules.size()) {
+            const size_t end = std::min(rules.find('|', start), rules.size());
+            const auto rule = trim(rules.substr(start, end - start));
+            if (!rule.empty()) {
+                std::string prefix(rule);
+                std::replace(prefix.begin(), prefix.end(), '.', '/');
+                lengths_.push_back(prefix.size());
+                prefixes_.insert(std::move(prefix));
+            }
+            start = end + 1;
+        }
+        std::sort(lengths_.begin(), lengths_.end());
+        lengths_.erase(std::unique(lengths_.begin(), lengths_.end()), lengths_.end());
+    }
+
+    bool PrefixMatcher::matches(std::string_view name) const {
+        if (name.size() >= 2 && name.front() == 'L' && name.back() == ';') {
+            name = name.substr(1, name.size() - 2);
+        }
+        for (const size_t length: lengths_) {
+            if (length > name.size()) break;
+            if (prefixes_.find(name.substr(0, length)) != prefixes_.end()) return true;
+        }
+        return false;
+    }
+
+    AgentConfig AgentConfig::defaults() {
+        AgentConfig config;
+        config.class_exclude = PrefixMatcher("apple/|java/|jdk/|sun/|com/sun/|com/apple/");
+        config.class_include = PrefixMatcher(
+            "com/fr/general|com/fr/license|com/fr/plugin|com/fr/protect|com/fr/record|com/fr/regist|"
+            "com/fr/security|com/fr/stable|com/fr/startup|com/fr/web|com/fr/workspace|com/fr/jvm|TestApp|DataGuard");
+        config.native_exclude = PrefixMatcher("java/|sun/|jdk/");
+        config.native_include = PrefixMatcher("com/fr/|TestApp|DataGuard");
+        config.decrypt_classes = PrefixMatcher("com/fr/license/selector/EncryptedLicenseSelector|DataGuard");
+        config.trace_packages = PrefixMatcher("com/fr/jvm/|com/fr/license/|TestApp|DataGuard");
+        config.probes = ProbeRules({
+            "com/fr/stable/ProductConstants#VERSION",
+            "com/fr/general/GeneralUtils#readBuildNO()|getVersion()",
+        });
+        return config;
+    }
+
+    AgentConfig AgentConfig::compile(const Options &options, const AgentConfig &base,
+                                     std::vector<InvalidProbeRule> *invalid_probes) {
+        AgentConfig config = base;
+        const auto matcher = [&](const std::string_view key, PrefixMatcher &target) {
+            if (options.has(key)) target = PrefixMatcher(options.get(key));
+        };
+        matcher("class_exclude", config.class_exclude);
+        matcher("class_include", config.class_include);
+        matcher("native_exclude", config.native_exclude);
+        matcher("native_include", config.native_include);
+        matcher("decrypt_class", config.decrypt_classes);
+        matcher("trace_packages", config.trace_packages);
+        // 指定 probe= 时替换默认探针规则，可重复指定
+        if (options.has("probe")) config.probes = ProbeRules(options.getAll("probe"), invalid_probes);
+        if (options.has("dump")) config.dump_path = options.get("dump");
+        config.trace_enabled = options.getBool("trace", config.trace_enabled);
+        config.trace_async_logging = options.getBool("trace_async", config.trace_async_logging);
+        config.trace_queue_size = static_cast<size_t>(std::max(
+            0LL, options.getInt("trace_queue_size", static_cast<long long>(config.trace_queue_size))));
+        return config;
+    }
+
+    ConfigStore::ConfigStore(): current_(new AgentConfig(AgentConfig::defaults())) {
+    }
+
+    ConfigStore::~ConfigStore() {
+        delete current_.load();
+        for (const auto *config: retired_) delete config;
+    }
+
+    std::atomic<const AgentConfig *> *ConfigStore::claimSlot() {
+        // 从线程相关的位置开始查找空闲槽位，减少线程间在同一槽位上竞争
+        size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % HAZARD_SLOTS;
+        for (size_t i = 0; i < HAZARD_SLOTS; ++i, index = (index + 1) % HAZARD_SLOTS) {
+            const AgentConfig *expected = nullptr;
+            if (hazards_[index].load(std::memory_order_relaxed) == nullptr
+                && hazards_[index].compare_exchange_strong(expected, RESERVED, std::memory_order_acquire)) {
+                return &hazards_[index];
+            }
+        }
+        return nullptr;
+    }
+
+    ConfigSnapshot ConfigStore::acquire() {
+        auto *hazard = claimSlot();
+        if (!hazard) {
+            // 同时读取的线程数超过槽位数量：先登记溢出计数再读取当前快照（均为顺序一致），
+            // 发布线程替换快照后读取该计数，只要读取端仍可能持有旧快照就不会回收
+            overflow_readers_.fetch_add(1, std::memory_order_seq_cst);
+            return {current_.load(std::memory_order_seq_cst), nullptr, &overflow_readers_};
+        }
+        const AgentConfig *config = current_.load(std::memory_order_acquire);
+        while (true) {
+            hazard->store(config, std::memory_order_seq_cst);
+            // 写入保护后再次确认仍是当前快照，否则发布线程可能已在写入前完成扫描
+            const AgentConfig *again = current_.load(std::memory_order_seq_cst);
+            if (again == config) break;
+            config = again;
+        }
+        return {config, hazard, nullptr};
+    }
+
+    uint64_t ConfigStore::publish(AgentConfig config) {
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        return publishLocked(std::move(config));
+    }
+
+    uint64_t ConfigStore::reconfigure(const Options &options, std::vector<InvalidProbeRule> *invalid_probes) {
+        // 读取、编译与发布在同一把锁内完成，并发的 reconfigure 不会基于同一旧快照而丢失彼此的修改；
+        // 持有锁时当前快照不会被回收，无需借用保护槽位
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        const AgentConfig *current = current_.load(std::memory_order_acquire);
+        return publishLocked(AgentConfig::compile(options, *current, invalid_probes));
+    }
+
+    uint64_t ConfigStore::publishLocked(AgentConfig config) {
+        config.version = next_version_++;
+        const uint64_t version = config.version;
+        const AgentConfig *previous = current_.exchange(new AgentConfig(std::move(config)), std::memory_order_seq_cst);
+        if (previous) retired_.push_back(previous);
+        reclaim();
+        return version;
+    }
+
+    void ConfigStore::reclaim() {
+        // 溢出读取端没有登记所持有的快照，期间全部旧快照保留到下一次发布时再回收
+        if (overflow_readers_.load(std::memory_order_seq_cst) != 0) return;
+        std::vector<const AgentConfig *> protected_configs;
+        for (const auto &hazard: hazards_) {
+            if (const auto *config = hazard.load(std::memory_order_seq_cst); config && config != RESERVED) {
+                protected_configs.push_back(config);
+            }
+        }
+        const auto end = std::partition(retired_.begin(), retired_.end(), [&](const AgentConfig *config) {
+            return std::find(protected_configs.begin(), protected_configs.end(), config) != protected_configs.end();
+        });
+        for (auto it = end; it != retired_.end(); ++it) delete *it;
+        retired_.erase(end, retired_.end());
+    }
+
+    ConfigStore &ConfigStore::global() {
+        static ConfigStore store;
+        return store;
+    }
+} // jvmti_tools
@@ -0,0 +1,154 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Options.h"
+#include "Probe.h"
+#include "Retransformer.h"
+
+namespace jvmti_tools {
+    // 类名前缀匹配器：规则以 '|' 分隔（代理参数本身以 ',' 分隔），'.' 与 '/' 等价；
+    // 按前缀长度分组存入哈希表，匹配代价为“不同前缀长度数”次哈希查找，与规则数量无关
+    class PrefixMatcher {
+    private:
+        std::string source_;
+        SignatureSet prefixes_;
+        std::vector<size_t> lengths_; // 升序、去重
+
+    public:
+        PrefixMatcher() = default;
+
+        explicit PrefixMatcher(std::string_view rules);
+
+        // 接受内部类名（com/fr/Foo）或类签名（Lcom/fr/Foo;）
+        bool matches(std::string_view name) const;
+
+        bool empty() const { return prefixes_.empty(); }
+
+        const std::string &source() const { return source_; }
+    };
+
+    // 不可变的运行时配置快照，发布后只读；重新配置时整体替换
+    struct AgentConfig {
+        uint64_t version = 0;
+
+        // 类文件加载：排除/包含规则与转储目录（为空表示不转储）
+        PrefixMatcher class_exclude;
+        PrefixMatcher class_include;
+        std::string dump_path;
+
+        // native 方法绑定：排除/包含规则与解密方法所在类
+        PrefixMatcher native_exclude;
+        PrefixMatcher native_include;
+        PrefixMatcher decrypt_classes;
+
+        // 方法耗时跟踪
+        bool trace_enabled = true;
+        bool trace_async_logging = true;
+        size_t trace_queue_size = 10240;
+        PrefixMatcher trace_packages;
+
+        // 类准备完成后读取的静态字段/无参静态方法
+        ProbeRules probes;
+
+        // 默认配置
+        static AgentConfig defaults();
+
+        // 以 base 为基础，用参数中出现的 key 覆盖对应配置项；无法解析的 probe= 规则写入 invalid_probes（可为空）
+        static AgentConfig compile(const Options &options, const AgentConfig &base,
+                                   std::vector<InvalidProbeRule> *invalid_probes = nullptr);
+    };
+
+    class ConfigStore;
+
+    // 读取端持有的快照：持有期间快照不会被回收，析构时释放占用的保护槽位（或溢出读取计数）
+    class ConfigSnapshot {
+        friend class ConfigStore;
+
+    private:
+        const AgentConfig *config_;
+        std::atomic<const AgentConfig *> *hazard_;
+        std::atomic<size_t> *overflow_;
+
+        ConfigSnapshot(const AgentConfig *config, std::atomic<const AgentConfig *> *hazard,
+                       std::atomic<size_t> *overflow)
+            : config_(config), hazard_(hazard), overflow_(overflow) {
+        }
+
+    public:
+        ~ConfigSnapshot() {
+            if (hazard_) hazard_->store(nullptr, std::memory_order_release);
+            if (overflow_) overflow_->fetch_sub(1, std::memory_order_release);
+        }
+
+        ConfigSnapshot(ConfigSnapshot &&other) noexcept
+            : config_(other.config_), hazard_(other.hazard_), overflow_(other.overflow_) {
+            other.hazard_ = nullptr;
+            other.overflow_ = nullptr;
+        }
+
+        ConfigSnapshot(const ConfigSnapshot &) = delete;
+
+        ConfigSnapshot &operator=(const ConfigSnapshot &) = delete;
+
+        ConfigSnapshot &operator=(ConfigSnapshot &&) = delete;
+
+        const AgentConfig *operator->() const { return config_; }
+
+        const AgentConfig &operator*() const { return *config_; }
+    };
+
+    // 配置发布：快照通过原子指针发布，读取端以危险指针（hazard pointer）保护，
+    // 读取无锁、无拷贝；旧快照在没有任何读取端引用后由发布线程回收。
+    // 保护槽位按次借用而非按线程分配，不使用 thread_local，模块卸载时无需清理线程状态。
+    // 槽位全部被占用时读取端改为登记溢出读取计数，计数不为 0 期间发布线程暂不回收旧快照，读取端不会等待
+    class ConfigStore {
+    private:
+        static constexpr size_t HAZARD_SLOTS = 256;
+
+        std::atomic<const AgentConfig *> current_;
+        std::array<std::atomic<const AgentConfig *>, HAZARD_SLOTS> hazards_{};
+        std::atomic<size_t> overflow_readers_{0}; // 未取得保护槽位的读取端数量
+        std::mutex publish_mutex_;
+        std::vector<const AgentConfig *> retired_;
+        uint64_t next_version_ = 1;
+
+        // 借用空闲的保护槽位，全部被占用时返回 nullptr
+        std::atomic<const AgentConfig *> *claimSlot();
+
+        // 发布新配置并返回其版本号（持有 publish_mutex_）
+        uint64_t publishLocked(AgentConfig config);
+
+        // 回收不再被任何槽位引用的旧快照（持有 publish_mutex_）
+        void reclaim();
+
+    public:
+        ConfigStore();
+
+        ~ConfigStore();
+
+        ConfigStore(const ConfigStore &) = delete;
+
+        ConfigStore &operator=(const ConfigStore &) = delete;
+
+        ConfigSnapshot acquire();
+
+        // 发布新配置并返回其版本号
+        uint64_t publish(AgentConfig config);
+
+        // 以当前配置为基础应用参数后发布，invalid_probes 同 AgentConfig::compile
+        uint64_t reconfigure(const Options &options, std::vector<InvalidProbeRule> *invalid_probes = nullptr);
+
+        // 进程内共享的配置
+        static ConfigStore &global();
+    };
+} // jvmti_tools
+
+#endif //CONFIG_H
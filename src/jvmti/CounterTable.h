@@ -0,0 +1,131 @@
+#ifndef COUNTERTABLE_H
+#define COUNTERTABLE_H
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace jvmti_tools {
+    // 混合 64 位哈希值（splitmix64 终结函数）
+    inline uint64_t mixHash(uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        value ^= value >> 31;
+        return value;
+    }
+
+    inline uint64_t combineHash(const uint64_t seed, const uint64_t value) {
+        return mixHash(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+    }
+
+    // 无锁计数表：开放寻址、线性探测，容量固定，只插入不删除。
+    // 事件回调中对已有 key 计数只需一次 fetch_add；新 key 通过 CAS 抢占槽位后写入附加数据，
+    // 写完再发布 ready，遍历时跳过尚未就绪的槽位。超过负载上限后的新 key 计入 dropped。
+    // Payload 必须可平凡复制，仅由抢占槽位的线程写入一次
+    template<typename Payload>
+    class CounterTable {
+    private:
+        struct Entry {
+            std::atomic<uint64_t> key{0}; // 0 表示空槽位
+            std::atomic<uint64_t> count{0};
+            std::atomic<bool> ready{false};
+            Payload payload{};
+        };
+
+        std::unique_ptr<Entry[]> entries_;
+        size_t mask_;
+        size_t limit_; // 最多插入的 key 数量，保证探测长度有界
+        std::atomic<size_t> size_{0};
+        std::atomic<uint64_t> dropped_{0};
+
+        // 找到或插入 key 并增加 n；首次出现时调用 init(Payload &) 填充附加数据。表满时返回 nullptr
+        template<typename Init>
+        Entry *insert(uint64_t key, const uint64_t n, Init &&init) {
+            if (key == 0) key = 1;
+            for (size_t index = key & mask_, probes = 0; probes <= mask_; index = (index + 1) & mask_, ++probes) {
+                Entry &entry = entries_[index];
+                uint64_t current = entry.key.load(std::memory_order_acquire);
+                if (current == key) {
+                    entry.count.fetch_add(n, std::memory_order_relaxed);
+                    return &entry;
+                }
+                if (current != 0) continue;
+
+                // 空槽位：先占用名额，超过负载上限时放弃插入
+                if (size_.fetch_add(1, std::memory_order_relaxed) >= limit_) {
+                    size_.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+                if (entry.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                    init(entry.payload);
+                    entry.count.fetch_add(n, std::memory_order_relaxed);
+                    entry.ready.store(true, std::memory_order_release);
+                    return &entry;
+                }
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                // 被其他线程抢占：可能正是同一个 key
+                if (current == key) {
+                    entry.count.fetch_add(n, std::memory_order_relaxed);
+                    return &entry;
+                }
+            }
+            dropped_.fetch_add(n, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+    public:
+        explicit CounterTable(const size_t capacity)
+            : entries_(std::make_unique<Entry[]>(std::bit_ceil(capacity < 16 ? size_t{16} : capacity))),
+              mask_(std::bit_ceil(capacity < 16 ? size_t{16} : capacity) - 1),
+              limit_((mask_ + 1) / 4 * 3) {
+        }
+
+        CounterTable(const CounterTable &) = delete;
+
+        CounterTable &operator=(const CounterTable &) = delete;
+
+        // 为 key 增加 n；首次出现时调用 init(Payload &) 填充附加数据。表满时返回 false
+        template<typename Init>
+        bool add(const uint64_t key, const uint64_t n, Init &&init) {
+            return insert(key, n, std::forward<Init>(init)) != nullptr;
+        }
+
+        // 与 add 相同，但返回附加数据；其他线程正在初始化同一 key 时等待其完成。表满时返回 nullptr
+        template<typename Init>
+        const Payload *acquire(const uint64_t key, const uint64_t n, Init &&init) {
+            Entry *entry = insert(key, n, std::forward<Init>(init));
+            if (entry == nullptr) return nullptr;
+            while (!entry->ready.load(std::memory_order_acquire)) std::this_thread::yield();
+            return &entry->payload;
+        }
+
+        bool add(const uint64_t key, const uint64_t n = 1) {
+            return add(key, n, [](Payload &) {
+            });
+        }
+
+        // 遍历已就绪的条目：fn(key, count, const Payload &)
+        template<typename Fn>
+        void forEach(Fn &&fn) const {
+            for (size_t i = 0; i <= mask_; ++i) {
+                const Entry &entry = entries_[i];
+                if (!entry.ready.load(std::memory_order_acquire)) continue;
+                fn(entry.key.load(std::memory_order_relaxed), entry.count.load(std::memory_order_relaxed),
+                   entry.payload);
+            }
+        }
+
+        size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+        size_t capacity() const { return mask_ + 1; }
+
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    };
+} // jvmti_tools
+
+#endif //COUNTERTABLE_H
@@ -0,0 +1,82 @@
+#include "CpuSampler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace jvmti_tools {
+    CpuSampler::CpuSampler(jvmtiEnv *jvmti, const CpuSamplerOptions &options, std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)), methods_(jvmti),
+          window_start_(std::chrono::steady_clock::now()) {
+        options_.stack_depth = std::min(options_.stack_depth, MAX_STACK_DEPTH);
+    }
+
+    void CpuSampler::sample(JNIEnv *jni) {
+        jint count = 0;
+        jthread *threads = nullptr;
+        if (jvmti_->GetAllThreads(&count, &threads) != JVMTI_ERROR_NONE) return;
+
+        entries_.clear();
+        for (jint i = 0; i < count; ++i) {
+            jlong cpu = 0;
+            if (jvmti_->GetThreadCpuTime(threads[i], &cpu) != JVMTI_ERROR_NONE) continue;
+            ThreadState *state = ThreadStates::global().get(jvmti_, threads[i]);
+            if (!state) continue;
+            // 首次采样的线程只记录基准值
+            const int64_t previous = state->cpu_time.exchange(cpu, std::memory_order_relaxed);
+            const uint64_t delta = previous < 0 || cpu < previous ? 0 : static_cast<uint64_t>(cpu - previous);
+            const uint64_t window = state->cpu_window.fetch_add(delta, std::memory_order_relaxed) + delta;
+            entries_.push_back({threads[i], state, window});
+        }
+        ++samples_;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - window_start_ >= options_.report_interval) {
+            report(jni, now - window_start_);
+            for (const auto &entry: entries_) entry.state->cpu_window.store(0, std::memory_order_relaxed);
+            window_start_ = now;
+            samples_ = 0;
+        }
+
+        for (jint i = 0; i < count; ++i) jni->DeleteLocalRef(threads[i]);
+        jvmti_->Deallocate(reinterpret_cast<unsigned char *>(threads));
+    }
+
+    void CpuSampler::report(JNIEnv *jni, const std::chrono::nanoseconds elapsed) {
+        if (!log_ || elapsed.count() <= 0) return;
+        const size_t shown = std::min(options_.top, entries_.size());
+        std::partial_sort(entries_.begin(), entries_.begin() + static_cast<std::ptrdiff_t>(shown), entries_.end(),
+                          [](const Entry &a, const Entry &b) { return a.window > b.window; });
+        uint64_t total = 0;
+        for (const auto &entry: entries_) total += entry.window;
+        const auto percent = [&](const uint64_t nanos) {
+            return static_cast<double>(nanos) * 100.0 / static_cast<double>(elapsed.count());
+        };
+
+        log_->info("Thread CPU: threads={} window={:.1f}s samples={} total={:.1f}%", entries_.size(),
+                   static_cast<double>(elapsed.count()) / 1e9, samples_, percent(total));
+        for (size_t i = 0; i < shown; ++i) {
+            const Entry &entry = entries_[i];
+            if (entry.window == 0) break;
+            jvmtiThreadInfo info{};
+            std::string name = "?";
+            if (jvmti_->GetThreadInfo(entry.thread, &info) == JVMTI_ERROR_NONE) {
+                if (info.name) name = info.name;
+                jvmti_->Deallocate(reinterpret_cast<unsigned char *>(info.name));
+                if (info.thread_group) jni->DeleteLocalRef(info.thread_group);
+                if (info.context_class_loader) jni->DeleteLocalRef(info.context_class_loader);
+            }
+            log_->info("  #{:<2} {:5.1f}% {:8.1f}ms [{}]", i + 1, percent(entry.window),
+                       static_cast<double>(entry.window) / 1e6, name);
+            if (options_.stack_depth == 0) continue;
+            jvmtiFrameInfo frames[MAX_STACK_DEPTH];
+            jint depth = 0;
+            if (jvmti_->GetStackTrace(entry.thread, 0, static_cast<jint>(options_.stack_depth), frames, &depth) !=
+                JVMTI_ERROR_NONE) {
+                continue;
+            }
+            for (jint j = 0; j < depth; ++j) {
+                log_->info("        at {}", methods_.frame(jni, frames[j].method, frames[j].location));
+            }
+        }
+    }
+} // jvmti_tools
@@ -0,0 +1,56 @@
+#ifndef CPUSAMPLER_H
+#define CPUSAMPLER_H
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <jvmti.h>
+
+#include "MethodResolver.h"
+#include "ThreadState.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct CpuSamplerOptions {
+        std::chrono::milliseconds interval{1000}; // 采样间隔
+        std::chrono::seconds report_interval{10}; // 报告间隔（覆盖多个采样周期）
+        size_t top = 10; // 报告输出的线程数量
+        uint32_t stack_depth = 0; // 大于 0 时为排名靠前的线程附带调用栈
+    };
+
+    // 线程 CPU 采样（Java 线程版 top -H）：每个采样周期通过 GetAllThreads + GetThreadCpuTime
+    // 计算各线程 CPU 时间增量，累计到线程状态中；每个报告周期输出 CPU 占用最高的线程。
+    // 线程上一次的 CPU 时间保存在 ThreadState 中，采样缓冲区按线程数增长后复用，稳定后不再分配内存
+    // （GetAllThreads 返回的数组由 JVMTI 分配）。需要 can_get_thread_cpu_time，在 AgentThread 中执行
+    class CpuSampler {
+    public:
+        static constexpr uint32_t MAX_STACK_DEPTH = 32;
+
+    private:
+        struct Entry {
+            jthread thread;
+            ThreadState *state;
+            uint64_t window;
+        };
+
+        jvmtiEnv *jvmti_;
+        CpuSamplerOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        MethodResolver methods_;
+        std::vector<Entry> entries_;
+        std::chrono::steady_clock::time_point window_start_;
+        uint64_t samples_ = 0;
+
+        void report(JNIEnv *jni, std::chrono::nanoseconds elapsed);
+
+    public:
+        CpuSampler(jvmtiEnv *jvmti, const CpuSamplerOptions &options, std::shared_ptr<spdlog::logger> log);
+
+        // 执行一次采样，到达报告间隔时输出报告；仅由采样线程调用
+        void sample(JNIEnv *jni);
+
+        const CpuSamplerOptions &options() const { return options_; }
+    };
+} // jvmti_tools
+
+#endif //CPUSAMPLER_H
@@ -0,0 +1,105 @@
+#include "ExceptionProfiler.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "ClassRegistry.h"
+
+namespace jvmti_tools {
+    ExceptionProfiler::ExceptionProfiler(jvmtiEnv *jvmti, const ExceptionProfilerOptions &options,
+                                         std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)), sites_(options.capacity),
+          stacks_(options.capacity), methods_(jvmti) {
+        options_.sample = std::max<uint32_t>(1, options_.sample);
+        options_.stack_depth = std::min(options_.stack_depth, MAX_STACK_DEPTH);
+    }
+
+    jlong ExceptionProfiler::typeOf(JNIEnv *jni, jobject exception) const {
+        const jclass type = jni->GetObjectClass(exception);
+        if (!type) return 0;
+        const jlong id = ClassRegistry::global().idOf(jvmti_, type);
+        jni->DeleteLocalRef(type);
+        return id;
+    }
+
+    void ExceptionProfiler::record(JNIEnv *jni, const jthread thread, const jmethodID method, const jlocation location,
+                                   const jobject exception, const jmethodID catch_method) {
+        const uint64_t event = events_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (!catch_method) uncaught_.fetch_add(1, std::memory_order_relaxed);
+        if (options_.sample > 1 && event % options_.sample != 0) return;
+
+        const jlong type = typeOf(jni, exception);
+        uint64_t key = combineHash(combineHash(static_cast<uint64_t>(type), reinterpret_cast<uintptr_t>(method)),
+                                   static_cast<uint64_t>(location));
+
+        uint64_t stack = 0;
+        if (options_.stack_depth > 0) {
+            jvmtiFrameInfo frames[MAX_STACK_DEPTH];
+            jint depth = 0;
+            if (jvmti_->GetStackTrace(thread, 0, static_cast<jint>(options_.stack_depth), frames, &depth) ==
+                JVMTI_ERROR_NONE) {
+                stack = stacks_.intern(frames, depth);
+                key = combineHash(key, stack);
+            }
+        }
+
+        sites_.add(key, options_.sample, [&](Site &site) {
+            site.type = type;
+            site.method = method;
+            site.location = location;
+            site.catch_method = catch_method;
+            site.stack = stack;
+        });
+    }
+
+    void ExceptionProfiler::periodicReport(JNIEnv *jni) {
+        const uint64_t events = events_.load(std::memory_order_relaxed);
+        if (events == reported_events_) return;
+        reported_events_ = events;
+        report(jni, options_.top);
+    }
+
+    void ExceptionProfiler::report(JNIEnv *jni, const size_t top) const {
+        if (!log_) return;
+        struct Row {
+            uint64_t count = 0;
+            Site site;
+        };
+        std::vector<Row> rows;
+        rows.reserve(sites_.size());
+        sites_.forEach([&](uint64_t, const uint64_t count, const Site &site) { rows.push_back({count, site}); });
+
+        // 同名异常类型可能被重复登记，按名称与位置合并
+        const ClassRegistry &classes = ClassRegistry::global();
+        const auto typeName = [&](const jlong id) { return classes.name(id); };
+        std::map<std::tuple<std::string, jmethodID, jlocation, uint64_t>, Row> merged;
+        for (const auto &row: rows) {
+            auto &target = merged[{typeName(row.site.type), row.site.method, row.site.location, row.site.stack}];
+            if (target.count == 0) target.site = row.site;
+            target.count += row.count;
+        }
+        rows.clear();
+        for (const auto &[key, row]: merged) rows.push_back(row);
+        const size_t shown = std::min(top, rows.size());
+        std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(shown), rows.end(),
+                          [](const Row &a, const Row &b) { return a.count > b.count; });
+
+        const uint64_t events = events_.load(std::memory_order_relaxed);
+        log_->info("Exception profile: events={} uncaught={} sites={} dropped={} sample=1/{}", events,
+                   uncaught_.load(std::memory_order_relaxed), sites_.size(), sites_.dropped(), options_.sample);
+        for (size_t i = 0; i < shown; ++i) {
+            const auto &[count, site] = rows[i];
+            log_->info("  #{:<2} {}{} {} at {} ({})", i + 1, options_.sample > 1 ? "~" : "", count,
+                       typeName(site.type), methods_.frame(jni, site.method, site.location),
+                       site.catch_method ? "caught in " + methods_.name(jni, site.catch_method) : "uncaught");
+            if (site.stack == 0) continue;
+            for (const auto &frame: stacks_.frames(site.stack)) {
+                log_->info("        at {}", methods_.frame(jni, frame.method, frame.location));
+            }
+        }
+    }
+} // jvmti_tools
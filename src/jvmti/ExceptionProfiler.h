@@ -0,0 +1,71 @@
+#ifndef EXCEPTIONPROFILER_H
+#define EXCEPTIONPROFILER_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <jvmti.h>
+
+#include "CounterTable.h"
+#include "MethodResolver.h"
+#include "StackTable.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct ExceptionProfilerOptions {
+        size_t capacity = 4096; // 抛出点数量上限（计数表容量）
+        uint32_t sample = 1; // 每 N 次异常记录一次，计数按 N 放大
+        uint32_t stack_depth = 0; // 大于 0 时按调用栈哈希区分抛出点
+        size_t top = 20; // 报告输出的抛出点数量
+        std::chrono::seconds report_interval{60}; // 定期报告间隔，0 表示仅在停止时报告
+    };
+
+    // 异常分析：按（异常类型、抛出方法、字节码位置[、调用栈]）聚合异常事件。
+    // 异常类型通过 ClassRegistry 识别，之后每次事件只需 GetObjectClass + GetTag；
+    // 计数保存在无锁计数表中。事件回调只做查找与计数，定期报告由代理线程调用 periodicReport 完成
+    class ExceptionProfiler {
+    public:
+        static constexpr uint32_t MAX_STACK_DEPTH = 32;
+
+    private:
+        struct Site {
+            jlong type = 0; // 异常类型编号（ClassRegistry）
+            jmethodID method = nullptr;
+            jlocation location = 0;
+            jmethodID catch_method = nullptr; // 首次记录时的捕获方法，为空表示未捕获
+            uint64_t stack = 0; // 调用栈编号，0 表示未采集
+        };
+
+        jvmtiEnv *jvmti_;
+        ExceptionProfilerOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        CounterTable<Site> sites_;
+        StackTable stacks_;
+        MethodResolver methods_;
+        std::atomic<uint64_t> events_{0};
+        std::atomic<uint64_t> uncaught_{0};
+        uint64_t reported_events_ = 0; // 上次定期报告时的事件数，仅由报告线程访问
+
+        jlong typeOf(JNIEnv *jni, jobject exception) const;
+
+    public:
+        ExceptionProfiler(jvmtiEnv *jvmti, const ExceptionProfilerOptions &options,
+                          std::shared_ptr<spdlog::logger> log);
+
+        // Exception 事件回调中调用
+        void record(JNIEnv *jni, jthread thread, jmethodID method, jlocation location, jobject exception,
+                    jmethodID catch_method);
+
+        // 输出计数最高的抛出点；jni 可为空
+        void report(JNIEnv *jni, size_t top) const;
+
+        // 报告线程中调用：自上次报告以来有新异常时输出报告
+        void periodicReport(JNIEnv *jni);
+
+        uint64_t events() const { return events_.load(std::memory_order_relaxed); }
+
+        const ExceptionProfilerOptions &options() const { return options_; }
+    };
+} // jvmti_tools
+
+#endif //EXCEPTIONPROFILER_H
@@ -0,0 +1,162 @@
+#include "GcTimeline.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <ctime>
+
+#include "Metrics.h"
+
+namespace jvmti_tools {
+    namespace {
+        int64_t wallNanos() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        double millis(const uint64_t nanos) {
+            return static_cast<double>(nanos) / 1e6;
+        }
+    }
+
+    GcTimeline::GcTimeline(const GcTimelineOptions &options, std::shared_ptr<spdlog::logger> log)
+        : options_(options), log_(std::move(log)),
+          ring_(std::make_unique<Slot[]>(std::bit_ceil(std::max<size_t>(options.capacity, 16)))),
+          mask_(std::bit_ceil(std::max<size_t>(options.capacity, 16)) - 1),
+          wall_offset_(wallNanos() - monotonicNanos()) {
+    }
+
+    GcTimeline::~GcTimeline() {
+        stop();
+    }
+
+    int64_t GcTimeline::monotonicNanos() {
+        // steady_clock 基于 clock_gettime(CLOCK_MONOTONIC)，可在 GC 事件回调中调用
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string GcTimeline::wallTime(const int64_t epoch_nanos) {
+        const auto seconds = static_cast<std::time_t>(epoch_nanos / 1000000000);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char buffer[32];
+        const size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+        std::snprintf(buffer + n, sizeof(buffer) - n, ".%03d", static_cast<int>(epoch_nanos / 1000000 % 1000));
+        return buffer;
+    }
+
+    void GcTimeline::gcStart() {
+        pending_start_.store(monotonicNanos(), std::memory_order_relaxed);
+    }
+
+    void GcTimeline::gcFinish() {
+        const int64_t end = monotonicNanos();
+        const int64_t start = pending_start_.exchange(0, std::memory_order_relaxed);
+        if (start == 0) {
+            unmatched_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const uint64_t index = written_.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = ring_[index & mask_];
+        // 按顺序锁（seqlock）写入：复用槽位前先标记为无效，栅栏保证读到新字段的汇总线程在复查时也能看到无效序号，
+        // 不会把上一圈的 start 与本次的 end 拼成一条记录
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    bool GcTimeline::start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return true;
+        if (!options_.timeline_file.empty()) {
+            timeline_.open(options_.timeline_file, std::ios::out | std::ios::app);
+            if (!timeline_.is_open()) {
+                log_->error("GC timeline: failed to open {}", options_.timeline_file);
+            } else if (timeline_.tellp() == 0) {
+                timeline_ << "start,epoch_micros,pause_micros,interval_micros\n";
+            }
+        }
+        next_report_ = monotonicNanos() + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           options_.report_interval).count();
+        running_ = true;
+        worker_ = std::thread([this] {
+            std::unique_lock<std::mutex> guard(mutex_);
+            while (running_) {
+                guard.unlock();
+                drain();
+                guard.lock();
+                wakeup_.wait_for(guard, options_.drain_interval, [this] { return !running_; });
+            }
+        });
+        return true;
+    }
+
+    void GcTimeline::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        wakeup_.notify_all();
+        if (worker_.joinable()) worker_.join();
+        drain();
+        if (timeline_.is_open()) timeline_.close();
+        report(pauses_, "GC pauses (total)");
+        if (const uint64_t unmatched = unmatched_.load(std::memory_order_relaxed); unmatched > 0 || lost_ > 0) {
+            log_->warn("GC timeline: {} pauses overwritten, {} finish events without start", lost_, unmatched);
+        }
+    }
+
+    void GcTimeline::drain() {
+        const uint64_t written = written_.load(std::memory_order_acquire);
+        if (written - read_ > mask_ + 1) {
+            // 汇总落后于写入超过一圈，最旧的记录已被覆盖
+            lost_ += written - read_ - (mask_ + 1);
+            read_ = written - (mask_ + 1);
+        }
+        for (; read_ < written; ++read_) {
+            const Slot &slot = ring_[read_ & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != read_ + 1) break; // 尚未写完
+            const int64_t start = slot.start.load(std::memory_order_relaxed);
+            const int64_t end = slot.end.load(std::memory_order_relaxed);
+            // 与 gcFinish 的栅栏配对：读取字段后复查序号，序号不变才说明两个字段属于同一条记录
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != read_ + 1) {
+                // 读取期间被下一圈覆盖
+                ++lost_;
+                continue;
+            }
+            const auto pause = static_cast<uint64_t>(std::max<int64_t>(end - start, 0));
+            pauses_.record(pause);
+            period_.record(pause);
+            Metrics::global().record(Timer::GcPause, pause);
+            if (timeline_.is_open()) {
+                const int64_t wall = start + wall_offset_;
+                timeline_ << wallTime(wall) << ',' << wall / 1000 << ',' << pause / 1000 << ','
+                        << (last_end_ == 0 ? 0 : (start - last_end_) / 1000) << '\n';
+            }
+            last_end_ = end;
+        }
+        if (timeline_.is_open()) timeline_.flush();
+
+        if (const int64_t now = monotonicNanos(); options_.report_interval.count() > 0 && now >= next_report_) {
+            next_report_ = now + std::chrono::duration_cast<std::chrono::nanoseconds>(options_.report_interval).count();
+            if (period_.count() > 0) report(period_, "GC pauses");
+            period_.reset();
+        }
+    }
+
+    void GcTimeline::report(const Histogram &histogram, const char *title) const {
+        if (!log_) return;
+        log_->info("{}: count={} total={:.1f}ms mean={:.2f}ms p50<={:.2f}ms p99<={:.2f}ms max={:.2f}ms", title,
+                   histogram.count(), millis(histogram.sum()), histogram.mean() / 1e6,
+                   millis(histogram.percentile(0.5)), millis(histogram.percentile(0.99)), millis(histogram.max()));
+    }
+} // jvmti_tools
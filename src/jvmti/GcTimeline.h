@@ -0,0 +1,92 @@
+#ifndef GCTIMELINE_H
+#define GCTIMELINE_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Histogram.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct GcTimelineOptions {
+        size_t capacity = 4096; // 环形缓冲区容量（GC 次数），汇总线程来不及处理时覆盖最旧的记录
+        std::chrono::milliseconds drain_interval{1000}; // 汇总线程处理间隔
+        std::chrono::seconds report_interval{60}; // 定期输出停顿统计，0 表示仅在停止时输出
+        std::string timeline_file; // 停顿时间线 CSV，为空时不写文件
+    };
+
+    // GC 停顿时间线：GarbageCollectionStart/Finish 回调中只读取单调时钟并写入预分配的环形缓冲区
+    // （仅原子操作，满足 JVMTI 对这两个事件的限制）；后台线程把记录汇总为停顿直方图并追加到时间线文件。
+    // 时间线使用与日志相同的本地墙上时间，可直接与方法耗时、异常等日志对齐。
+    // 后台线程不附加到 JVM、不调用 JNI/JVMTI，VM 退出时不会阻塞；模块停止时结束
+    class GcTimeline {
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence{0}; // 写入序号 + 1，0 表示尚未写入或正在改写
+            std::atomic<int64_t> start{0};
+            std::atomic<int64_t> end{0};
+        };
+
+        GcTimelineOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        std::unique_ptr<Slot[]> ring_;
+        size_t mask_;
+        int64_t wall_offset_; // 墙上时间 - 单调时钟（纳秒）
+
+        std::atomic<int64_t> pending_start_{0}; // 0 表示没有进行中的 GC
+        std::atomic<uint64_t> written_{0};
+        std::atomic<uint64_t> unmatched_{0}; // 缺少 Start 的 Finish 事件（如附加时正在 GC）
+
+        // 以下仅由汇总线程（或停止后的调用线程）访问
+        uint64_t read_ = 0;
+        uint64_t lost_ = 0;
+        int64_t last_end_ = 0;
+        Histogram pauses_; // 全部停顿（纳秒）
+        Histogram period_; // 本报告周期内的停顿
+        int64_t next_report_ = 0;
+        std::ofstream timeline_;
+
+        std::mutex mutex_;
+        std::condition_variable wakeup_;
+        std::thread worker_;
+        bool running_ = false;
+
+        void drain();
+
+        void report(const Histogram &histogram, const char *title) const;
+
+    public:
+        GcTimeline(const GcTimelineOptions &options, std::shared_ptr<spdlog::logger> log);
+
+        ~GcTimeline();
+
+        GcTimeline(const GcTimeline &) = delete;
+
+        GcTimeline &operator=(const GcTimeline &) = delete;
+
+        // GarbageCollectionStart / GarbageCollectionFinish 回调中调用
+        void gcStart();
+
+        void gcFinish();
+
+        bool start();
+
+        // 结束汇总线程，处理剩余记录并输出总体统计
+        void stop();
+
+        const Histogram &pauses() const { return pauses_; }
+
+        static int64_t monotonicNanos();
+
+        // 本地时间 yyyy-MM-dd HH:mm:ss.SSS，与日志时间戳格式一致
+        static std::string wallTime(int64_t epoch_nanos);
+    };
+} // jvmti_tools
+
+#endif //GCTIMELINE_H
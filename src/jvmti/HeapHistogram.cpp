@@ -0,0 +1,189 @@
+#include "HeapHistogram.h"
+
+#include <algorithm>
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+
+namespace jvmti_tools {
+    namespace {
+        struct ClassSlot {
+            uint64_t instances = 0;
+            uint64_t bytes = 0;
+        };
+
+        struct HeapWalk {
+            ClassSlot *slots;
+            jlong count; // slots[0] 统计遍历期间新加载、未打标签的类
+        };
+
+        // 堆遍历回调：仅按类标签累加，不分配内存、不调用 JNI
+        jint JNICALL countObject(const jlong class_tag, const jlong size, jlong *, jint, void *user_data) {
+            const auto *walk = static_cast<const HeapWalk *>(user_data);
+            ClassSlot &slot = walk->slots[class_tag > 0 && class_tag < walk->count ? class_tag : 0];
+            ++slot.instances;
+            slot.bytes += static_cast<uint64_t>(size);
+            return JVMTI_VISIT_OBJECTS;
+        }
+
+        std::string className(const char *signature) {
+            std::string_view name = signature ? signature : "?";
+            if (name.size() >= 2 && name.front() == 'L' && name.back() == ';') {
+                name = name.substr(1, name.size() - 2);
+            }
+            return std::string(name);
+        }
+
+        template<typename T>
+        bool parseNumber(const std::string_view text, T &value) {
+            const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return ec == std::errc() && ptr == text.data() + text.size();
+        }
+    }
+
+    void HeapSnapshot::write(std::ostream &out) const {
+        out << "instances,bytes,class\n";
+        for (const auto &stats: classes) {
+            out << stats.instances << ',' << stats.bytes << ',' << stats.name << '\n';
+        }
+    }
+
+    std::optional<HeapSnapshot> HeapSnapshot::read(std::istream &in) {
+        HeapSnapshot snapshot;
+        std::string line;
+        if (!std::getline(in, line) || line.rfind("instances,bytes,class", 0) != 0) return std::nullopt;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            const size_t first = line.find(',');
+            const size_t second = first == std::string::npos ? first : line.find(',', first + 1);
+            if (second == std::string::npos) return std::nullopt;
+            HeapClassStats stats;
+            if (!parseNumber(std::string_view(line).substr(0, first), stats.instances)
+                || !parseNumber(std::string_view(line).substr(first + 1, second - first - 1), stats.bytes)) {
+                return std::nullopt;
+            }
+            stats.name = line.substr(second + 1);
+            snapshot.instances += stats.instances;
+            snapshot.bytes += stats.bytes;
+            snapshot.classes.push_back(std::move(stats));
+        }
+        return snapshot;
+    }
+
+    std::vector<HeapClassDelta> diff(const HeapSnapshot &before, const HeapSnapshot &after) {
+        std::unordered_map<std::string_view, HeapClassDelta> deltas;
+        for (const auto &stats: after.classes) {
+            auto &delta = deltas[stats.name];
+            delta.instances += static_cast<int64_t>(stats.instances);
+            delta.bytes += static_cast<int64_t>(stats.bytes);
+        }
+        for (const auto &stats: before.classes) {
+            auto &delta = deltas[stats.name];
+            delta.instances -= static_cast<int64_t>(stats.instances);
+            delta.bytes -= static_cast<int64_t>(stats.bytes);
+        }
+        std::vector<HeapClassDelta> result;
+        for (auto &[name, delta]: deltas) {
+            if (delta.instances == 0 && delta.bytes == 0) continue;
+            delta.name = std::string(name);
+            result.push_back(std::move(delta));
+        }
+        std::sort(result.begin(), result.end(), [](const HeapClassDelta &a, const HeapClassDelta &b) {
+            return a.bytes != b.bytes ? a.bytes > b.bytes : a.name < b.name;
+        });
+        return result;
+    }
+
+    std::optional<HeapSnapshot> HeapHistogram::take(JavaVM *vm, JNIEnv *jni, spdlog::logger &log) {
+        const auto start = std::chrono::steady_clock::now();
+
+        // 独立环境：标签只属于本环境，释放后全部清除
+        jvmtiEnv *env = nullptr;
+        if (vm->GetEnv(reinterpret_cast<void **>(&env), JVMTI_VERSION_1_2) != JNI_OK || env == nullptr) {
+            log.error("Heap histogram: failed to create JVMTI environment");
+            return std::nullopt;
+        }
+        struct Dispose {
+            jvmtiEnv *env;
+            ~Dispose() { env->DisposeEnvironment(); }
+        } dispose{env};
+
+        jvmtiCapabilities capabilities = {};
+        capabilities.can_tag_objects = 1;
+        if (const jvmtiError err = env->AddCapabilities(&capabilities); err != JVMTI_ERROR_NONE) {
+            log.error("Heap histogram: can_tag_objects is not available: {}", static_cast<int>(err));
+            return std::nullopt;
+        }
+
+        // 1. 已加载类依次打上标签 1..n，类名按标签存放
+        jint class_count = 0;
+        jclass *classes = nullptr;
+        if (const jvmtiError err = env->GetLoadedClasses(&class_count, &classes); err != JVMTI_ERROR_NONE) {
+            log.error("Heap histogram: GetLoadedClasses failed: {}", static_cast<int>(err));
+            return std::nullopt;
+        }
+        std::vector<std::string> names(static_cast<size_t>(class_count) + 1);
+        names[0] = "<unknown>";
+        for (jint i = 0; i < class_count; ++i) {
+            char *signature = nullptr;
+            if (env->GetClassSignature(classes[i], &signature, nullptr) == JVMTI_ERROR_NONE) {
+                names[static_cast<size_t>(i) + 1] = className(signature);
+                env->Deallocate(reinterpret_cast<unsigned char *>(signature));
+            }
+            env->SetTag(classes[i], static_cast<jlong>(i) + 1);
+            if (jni) jni->DeleteLocalRef(classes[i]);
+        }
+        env->Deallocate(reinterpret_cast<unsigned char *>(classes));
+
+        // 2. 遍历堆（安全点内执行），结果写入按标签索引的数组
+        std::vector<ClassSlot> slots(names.size());
+        HeapWalk walk{slots.data(), static_cast<jlong>(slots.size())};
+        jvmtiHeapCallbacks callbacks = {};
+        callbacks.heap_iteration_callback = &countObject;
+        if (const jvmtiError err = env->IterateThroughHeap(0, nullptr, &callbacks, &walk); err != JVMTI_ERROR_NONE) {
+            log.error("Heap histogram: IterateThroughHeap failed: {}", static_cast<int>(err));
+            return std::nullopt;
+        }
+
+        // 3. 汇总：同名类（不同类加载器）合并为一项
+        HeapSnapshot snapshot;
+        snapshot.taken_at = std::chrono::system_clock::now();
+        std::unordered_map<std::string_view, size_t> index;
+        for (size_t tag = 0; tag < slots.size(); ++tag) {
+            if (slots[tag].instances == 0) continue;
+            const auto [it, inserted] = index.try_emplace(names[tag], snapshot.classes.size());
+            if (inserted) snapshot.classes.push_back({names[tag]});
+            auto &stats = snapshot.classes[it->second];
+            stats.instances += slots[tag].instances;
+            stats.bytes += slots[tag].bytes;
+            snapshot.instances += slots[tag].instances;
+            snapshot.bytes += slots[tag].bytes;
+        }
+        std::sort(snapshot.classes.begin(), snapshot.classes.end(), [](const HeapClassStats &a, const HeapClassStats &b) {
+            return a.bytes != b.bytes ? a.bytes > b.bytes : a.name < b.name;
+        });
+        snapshot.elapsed = std::chrono::steady_clock::now() - start;
+        return snapshot;
+    }
+
+    void HeapHistogram::report(const HeapSnapshot &snapshot, const size_t top, spdlog::logger &log) {
+        log.info("Heap histogram: classes={} instances={} bytes={} elapsed={:.2f}ms", snapshot.classes.size(),
+                 snapshot.instances, snapshot.bytes,
+                 std::chrono::duration<double, std::milli>(snapshot.elapsed).count());
+        const size_t shown = std::min(top, snapshot.classes.size());
+        for (size_t i = 0; i < shown; ++i) {
+            const auto &stats = snapshot.classes[i];
+            log.info("  {:>4}: {:>12} {:>14}  {}", i + 1, stats.instances, stats.bytes, stats.name);
+        }
+    }
+
+    void HeapHistogram::report(const std::vector<HeapClassDelta> &deltas, const size_t top, spdlog::logger &log) {
+        log.info("Heap histogram diff: changed classes={}", deltas.size());
+        const size_t shown = std::min(top, deltas.size());
+        for (size_t i = 0; i < shown; ++i) {
+            const auto &delta = deltas[i];
+            log.info("  {:>4}: {:>+12} {:>+14}  {}", i + 1, delta.instances, delta.bytes, delta.name);
+        }
+    }
+} // jvmti_tools
@@ -0,0 +1,57 @@
+#ifndef HEAPHISTOGRAM_H
+#define HEAPHISTOGRAM_H
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+#include <jvmti.h>
+
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct HeapClassStats {
+        std::string name; // 类签名去掉 L...; 后的内部名称，数组保持 [I 等形式
+        uint64_t instances = 0;
+        uint64_t bytes = 0; // 浅大小
+    };
+
+    // 堆直方图快照，按占用字节数降序
+    struct HeapSnapshot {
+        std::chrono::system_clock::time_point taken_at;
+        std::chrono::nanoseconds elapsed{0}; // 遍历耗时（含打标签）
+        uint64_t instances = 0;
+        uint64_t bytes = 0;
+        std::vector<HeapClassStats> classes;
+
+        // CSV：instances,bytes,class，首行为表头
+        void write(std::ostream &out) const;
+
+        static std::optional<HeapSnapshot> read(std::istream &in);
+    };
+
+    struct HeapClassDelta {
+        std::string name;
+        int64_t instances = 0;
+        int64_t bytes = 0;
+    };
+
+    // after 相对 before 的变化，按字节增量降序（增长最多的类在前），忽略未变化的类
+    std::vector<HeapClassDelta> diff(const HeapSnapshot &before, const HeapSnapshot &after);
+
+    // 基于 IterateThroughHeap 的类直方图：不写堆转储，也不触发 Full GC。
+    // 使用独立的 jvmtiEnv 给已加载类打上连续标签（标签互不干扰，释放环境即清除），
+    // 遍历回调只按 class_tag 累加到预分配的数组，不分配内存。
+    // 结果包含尚未回收的不可达对象，与 jmap -histo:all 口径一致
+    class HeapHistogram {
+    public:
+        static std::optional<HeapSnapshot> take(JavaVM *vm, JNIEnv *jni, spdlog::logger &log);
+
+        static void report(const HeapSnapshot &snapshot, size_t top, spdlog::logger &log);
+
+        static void report(const std::vector<HeapClassDelta> &deltas, size_t top, spdlog::logger &log);
+    };
+} // jvmti_tools
+
+#endif //HEAPHISTOGRAM_H
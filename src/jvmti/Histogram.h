@@ -0,0 +1,98 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace jvmti_tools {
+    // 对数分桶的无锁直方图：第 i 个桶统计 [2^(i-1), 2^i) 区间内的样本，可在线程间合并
+    class Histogram {
+    public:
+        static constexpr size_t BUCKETS = 64;
+
+        void record(const uint64_t value) {
+            buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+            uint64_t current = max_.load(std::memory_order_relaxed);
+            while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        void merge(const Histogram &other) {
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                buckets_[i].fetch_add(other.bucket(i), std::memory_order_relaxed);
+            }
+            count_.fetch_add(other.count(), std::memory_order_relaxed);
+            sum_.fetch_add(other.sum(), std::memory_order_relaxed);
+            const uint64_t other_max = other.max();
+            uint64_t current = max_.load(std::memory_order_relaxed);
+            while (other_max > current && !max_.compare_exchange_weak(current, other_max, std::memory_order_relaxed)) {
+            }
+        }
+
+        void reset() {
+            for (auto &b: buckets_) b.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+        uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+        uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+        uint64_t bucket(const size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+        double mean() const {
+            const uint64_t n = count();
+            return n == 0 ? 0.0 : static_cast<double>(sum()) / static_cast<double>(n);
+        }
+
+        // 返回分位数所在桶的上界（q 取值 0~1），精度为 2 倍以内
+        uint64_t percentile(const double q) const {
+            std::array<uint64_t, BUCKETS> buckets{};
+            for (size_t i = 0; i < BUCKETS; ++i) buckets[i] = bucket(i);
+            return percentile(buckets, count(), max(), q);
+        }
+
+        // 按桶计数计算分位数，用于直方图快照（例如从共享内存读取的指标）
+        static uint64_t percentile(const std::array<uint64_t, BUCKETS> &buckets, const uint64_t count,
+                                   const uint64_t max, const double q) {
+            if (count == 0) return 0;
+            const auto scaled = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+            const uint64_t rank = scaled == 0 ? 1 : scaled > count ? count : scaled;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    const uint64_t bound = upperBound(i);
+                    return bound < max ? bound : max;
+                }
+            }
+            return max;
+        }
+
+        static size_t bucketOf(const uint64_t value) {
+            const auto width = static_cast<size_t>(std::bit_width(value));
+            return width < BUCKETS ? width : BUCKETS - 1;
+        }
+
+        static uint64_t upperBound(const size_t i) {
+            return i == 0 ? 0 : i >= BUCKETS - 1 ? UINT64_MAX : (uint64_t{1} << i) - 1;
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> max_{0};
+    };
+} // jvmti_tools
+
+#endif //HISTOGRAM_H
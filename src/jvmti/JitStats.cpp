@@ -0,0 +1,234 @@
+#include "JitStats.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Metrics.h"
+
+namespace jvmti_tools {
+    namespace {
+        double kib(const uint64_t bytes) {
+            return static_cast<double>(bytes) / 1024.0;
+        }
+
+        // com/example/Foo$Bar.baz => com/example
+        std::string packageName(const std::string &method) {
+            const size_t dot = method.rfind('.');
+            const size_t slash = method.rfind('/', dot == std::string::npos ? std::string::npos : dot);
+            return slash == std::string::npos ? "<default>" : method.substr(0, slash);
+        }
+    }
+
+    JitStats::JitStats(jvmtiEnv *jvmti, const JitStatsOptions &options, std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)), methods_(jvmti),
+          period_start_(std::chrono::steady_clock::now()) {
+        options_.top = std::max<size_t>(options_.top, 1);
+        options_.churn_threshold = std::max<uint32_t>(options_.churn_threshold, 2);
+    }
+
+    JitStats::~JitStats() {
+        stop();
+    }
+
+    uint32_t JitStats::packageId(std::string package) {
+        if (const auto it = package_ids_.find(package); it != package_ids_.end()) return it->second;
+        const auto id = static_cast<uint32_t>(packages_.size());
+        packages_.push_back({package});
+        package_ids_.emplace(std::move(package), id);
+        return id;
+    }
+
+    void JitStats::compiledMethodLoad(const jmethodID method, const jint code_size, const void *code_addr) {
+        if (!code_addr || code_size <= 0) return;
+        const auto address = reinterpret_cast<uintptr_t>(code_addr);
+        const auto size = static_cast<uint32_t>(code_size);
+        const bool baseline = replay_thread_.load(std::memory_order_relaxed) == std::this_thread::get_id();
+        // 名称解析只发生在方法首次编译时，且不持有锁，不阻塞其他编译线程的回调
+        std::string package;
+        bool known;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            known = entries_.count(method) != 0;
+        }
+        if (!known) package = packageName(methods_.name(nullptr, method, false));
+        uint64_t footprint;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto it = blobs_.find(address); it != blobs_.end()) {
+                // 其他模块的补发，或漏掉了卸载事件
+                if (it->second.method == method && it->second.size == size) return;
+                unloadLocked(it->second);
+                blobs_.erase(it);
+            }
+            auto [entry_it, inserted] = entries_.try_emplace(method);
+            MethodEntry &entry = entry_it->second;
+            if (inserted) entry.package = packageId(std::move(package));
+            Package &package = packages_[entry.package];
+            blobs_.emplace(address, Blob{method, size});
+            ++entry.compiles;
+            ++entry.live;
+            package.live_bytes += size;
+            live_bytes_ += size;
+            peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+            if (!baseline) {
+                ++compiles_;
+                ++period_compiles_;
+                period_bytes_ += size;
+                ++entry.period_compiles;
+                ++package.compiles;
+                ++package.period_compiles;
+                package.period_bytes += size;
+                if (entry.compiles > 1) {
+                    ++recompiles_;
+                    ++period_recompiles_;
+                }
+            }
+            footprint = live_bytes_ + stub_bytes_;
+        }
+        if (!baseline) Metrics::global().add(Counter::CompiledMethods);
+        Metrics::global().set(Counter::CodeCacheBytes, footprint);
+    }
+
+    void JitStats::unloadLocked(const Blob &blob) {
+        if (const auto it = entries_.find(blob.method); it != entries_.end()) {
+            MethodEntry &entry = it->second;
+            if (entry.live > 0) --entry.live;
+            Package &package = packages_[entry.package];
+            package.live_bytes -= std::min<uint64_t>(package.live_bytes, blob.size);
+        }
+        live_bytes_ -= std::min<uint64_t>(live_bytes_, blob.size);
+        ++unloads_;
+        ++period_unloads_;
+    }
+
+    void JitStats::compiledMethodUnload(jmethodID, const void *code_addr) {
+        uint64_t footprint;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 类卸载时方法可能已失效，只按代码地址查找
+            const auto it = blobs_.find(reinterpret_cast<uintptr_t>(code_addr));
+            if (it == blobs_.end()) return;
+            unloadLocked(it->second);
+            blobs_.erase(it);
+            footprint = live_bytes_ + stub_bytes_;
+        }
+        Metrics::global().set(Counter::CodeCacheBytes, footprint);
+    }
+
+    void JitStats::dynamicCodeGenerated(const void *address, const jint length) {
+        if (!address || length <= 0) return;
+        uint64_t footprint;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 同一地址重复补发时只记一次
+            auto &size = stubs_[reinterpret_cast<uintptr_t>(address)];
+            stub_bytes_ = stub_bytes_ - size + static_cast<uint32_t>(length);
+            size = static_cast<uint32_t>(length);
+            footprint = live_bytes_ + stub_bytes_;
+        }
+        Metrics::global().set(Counter::CodeCacheBytes, footprint);
+    }
+
+    void JitStats::replay() {
+        replay_thread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        for (const jvmtiEvent event: {JVMTI_EVENT_COMPILED_METHOD_LOAD, JVMTI_EVENT_DYNAMIC_CODE_GENERATED}) {
+            if (const jvmtiError err = jvmti_->GenerateEvents(event); err != JVMTI_ERROR_NONE) {
+                log_->warn("JIT stats: GenerateEvents({}) failed: {}", static_cast<int>(event), static_cast<int>(err));
+            }
+        }
+        replay_thread_.store(std::thread::id{}, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        log_->info("JIT stats: baseline methods={} code={:.1f}KiB stubs={:.1f}KiB", blobs_.size(), kib(live_bytes_),
+                   kib(stub_bytes_));
+    }
+
+    bool JitStats::start() {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        if (running_ || stopped_ || options_.report_interval.count() == 0) return true;
+        running_ = true;
+        worker_ = std::thread([this] {
+            std::unique_lock<std::mutex> guard(worker_mutex_);
+            while (!wakeup_.wait_for(guard, options_.report_interval, [this] { return !running_; })) {
+                guard.unlock();
+                report(false);
+                guard.lock();
+            }
+        });
+        return true;
+    }
+
+    void JitStats::stop() {
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            if (stopped_) return;
+            stopped_ = true;
+            running_ = false;
+        }
+        wakeup_.notify_all();
+        if (worker_.joinable()) worker_.join();
+        report(true);
+    }
+
+    void JitStats::report(const bool total) {
+        struct ChurnRow {
+            jmethodID method;
+            uint32_t compiles;
+            uint32_t live;
+        };
+        std::vector<Package> packages;
+        std::vector<ChurnRow> churn;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - period_start_).
+                    count();
+            if (total) {
+                log_->info("JIT (total): compiled={} recompiled={} unloaded={} methods={} code={:.1f}KiB "
+                           "peak={:.1f}KiB stubs={:.1f}KiB", compiles_, recompiles_, unloads_, entries_.size(),
+                           kib(live_bytes_), kib(peak_bytes_), kib(stub_bytes_));
+            } else {
+                log_->info("JIT: window={:.0f}s compiled={} ({:.1f}/s) recompiled={} unloaded={} +{:.1f}KiB "
+                           "code={:.1f}KiB stubs={:.1f}KiB", seconds, period_compiles_,
+                           seconds > 0 ? static_cast<double>(period_compiles_) / seconds : 0.0, period_recompiles_,
+                           period_unloads_, kib(period_bytes_), kib(live_bytes_), kib(stub_bytes_));
+            }
+            for (const Package &package: packages_) {
+                if (total ? package.live_bytes > 0 : package.period_compiles > 0) packages.push_back(package);
+            }
+            for (auto &[method, entry]: entries_) {
+                if (entry.compiles >= options_.churn_threshold && (total || entry.period_compiles > 0)) {
+                    churn.push_back({method, entry.compiles, entry.live});
+                }
+                entry.period_compiles = 0;
+            }
+            for (Package &package: packages_) {
+                package.period_bytes = 0;
+                package.period_compiles = 0;
+            }
+            period_compiles_ = 0;
+            period_recompiles_ = 0;
+            period_unloads_ = 0;
+            period_bytes_ = 0;
+            period_start_ = std::chrono::steady_clock::now();
+        }
+
+        // 总体统计按当前代码量排序，周期统计按本周期新增代码量排序
+        const size_t shown_packages = std::min(options_.top, packages.size());
+        std::partial_sort(packages.begin(), packages.begin() + static_cast<std::ptrdiff_t>(shown_packages),
+                          packages.end(), [total](const Package &a, const Package &b) {
+                              return total ? a.live_bytes > b.live_bytes : a.period_bytes > b.period_bytes;
+                          });
+        for (size_t i = 0; i < shown_packages; ++i) {
+            const Package &package = packages[i];
+            log_->info("  {:<48} code={:9.1f}KiB +{:8.1f}KiB compiled={}", package.name, kib(package.live_bytes),
+                       kib(package.period_bytes), total ? package.compiles : package.period_compiles);
+        }
+        const size_t shown_churn = std::min(options_.top, churn.size());
+        std::partial_sort(churn.begin(), churn.begin() + static_cast<std::ptrdiff_t>(shown_churn), churn.end(),
+                          [](const ChurnRow &a, const ChurnRow &b) { return a.compiles > b.compiles; });
+        for (size_t i = 0; i < shown_churn; ++i) {
+            // 名称在首次编译时已缓存
+            log_->info("  recompiled x{:<3} {} (live={})", churn[i].compiles, methods_.name(nullptr, churn[i].method),
+                       churn[i].live);
+        }
+    }
+} // jvmti_tools
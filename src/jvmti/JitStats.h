@@ -0,0 +1,116 @@
+#ifndef JITSTATS_H
+#define JITSTATS_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <jvmti.h>
+
+#include "MethodResolver.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct JitStatsOptions {
+        std::chrono::seconds report_interval{60}; // 定期输出本周期的编译活动，0 表示仅在停止时输出
+        size_t top = 10; // 包与反复编译方法的输出条数
+        uint32_t churn_threshold = 4; // 编译次数达到该值的方法视为反复编译（分层编译正常为 2~3 次）
+    };
+
+    // JIT 编译活动与代码缓存统计：按 CompiledMethodLoad / CompiledMethodUnload 汇总每个周期编译的方法数与代码量、
+    // 每个包的代码量、同一方法的重复编译次数（去优化后重新编译），以及编译代码与桩代码占用的代码缓存大小。
+    // 方法首次编译时解析一次名称并缓存其包编号，之后每次编译只需一次哈希查找，名称解析不会计入编译风暴期间的开销。
+    // 附加时通过 GenerateEvents 补发的记录只计入代码缓存占用，不计为本周期的编译；同一地址的重复补发会被忽略
+    class JitStats {
+    private:
+        struct MethodEntry {
+            uint32_t package = 0;
+            uint32_t compiles = 0; // 累计编译次数（含附加前的基线）
+            uint32_t period_compiles = 0;
+            uint32_t live = 0; // 当前仍在代码缓存中的版本数
+        };
+
+        struct Blob {
+            jmethodID method;
+            uint32_t size;
+        };
+
+        struct Package {
+            std::string name;
+            uint64_t live_bytes = 0;
+            uint64_t compiles = 0;
+            uint64_t period_bytes = 0;
+            uint64_t period_compiles = 0;
+        };
+
+        jvmtiEnv *jvmti_;
+        JitStatsOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        MethodResolver methods_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<jmethodID, MethodEntry> entries_;
+        std::unordered_map<uintptr_t, Blob> blobs_; // 代码地址 => 方法
+        std::unordered_map<uintptr_t, uint32_t> stubs_; // 桩代码地址 => 大小
+        std::unordered_map<std::string, uint32_t> package_ids_;
+        std::vector<Package> packages_;
+        uint64_t live_bytes_ = 0;
+        uint64_t peak_bytes_ = 0;
+        uint64_t stub_bytes_ = 0;
+        uint64_t compiles_ = 0;
+        uint64_t recompiles_ = 0;
+        uint64_t unloads_ = 0;
+        uint64_t period_compiles_ = 0;
+        uint64_t period_recompiles_ = 0;
+        uint64_t period_unloads_ = 0;
+        uint64_t period_bytes_ = 0;
+
+        std::atomic<std::thread::id> replay_thread_{};
+
+        std::mutex worker_mutex_;
+        std::condition_variable wakeup_;
+        std::thread worker_;
+        bool running_ = false;
+        bool stopped_ = false;
+        std::chrono::steady_clock::time_point period_start_;
+
+        // 以下由持有 mutex_ 的调用方执行
+        uint32_t packageId(std::string package);
+
+        void unloadLocked(const Blob &blob);
+
+        void report(bool total);
+
+    public:
+        JitStats(jvmtiEnv *jvmti, const JitStatsOptions &options, std::shared_ptr<spdlog::logger> log);
+
+        ~JitStats();
+
+        JitStats(const JitStats &) = delete;
+
+        JitStats &operator=(const JitStats &) = delete;
+
+        // CompiledMethodLoad / CompiledMethodUnload / DynamicCodeGenerated 回调中调用
+        void compiledMethodLoad(jmethodID method, jint code_size, const void *code_addr);
+
+        void compiledMethodUnload(jmethodID method, const void *code_addr);
+
+        void dynamicCodeGenerated(const void *address, jint length);
+
+        // 附加时补发已编译的方法与桩代码，在当前线程上同步执行
+        void replay();
+
+        // 启动定期报告线程（report_interval 为 0 时不启动）
+        bool start();
+
+        // 结束报告线程并输出总体统计，只生效一次
+        void stop();
+    };
+} // jvmti_tools
+
+#endif //JITSTATS_H
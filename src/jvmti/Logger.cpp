@@ -15,9 +15,7 @@ namespace jvmti {
     std::mutex Logger::mutex_;
     std::atomic_bool Logger::shutdown_(false);
 
-    Logger::Logger() {
-        thread_pool_ = std::make_shared<spdlog::details::thread_pool>(8192, 2);
-    };
+    Logger::Logger() = default;
 
     Logger::~Logger() = default;
 
@@ -64,6 +62,10 @@ namespace jvmti {
         }
         if (event_loggers_[event]) return event_loggers_[event];
         try {
+            // 线程池在首次获取日志器时创建，静态实例不会在库加载时启动线程
+            if (thread_pool_ == nullptr) {
+                thread_pool_ = std::make_shared<spdlog::details::thread_pool>(8192, 2);
+            }
             bool isDefaultLogger = false;
 
             if (event == 0) {
@@ -0,0 +1,63 @@
+#include "MethodResolver.h"
+
+#include <string_view>
+
+namespace jvmti_tools {
+    std::string MethodResolver::name(JNIEnv *jni, const jmethodID method, const bool signature) const {
+        if (!method) return "?";
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto it = names_.find(method); it != names_.end()) name = it->second;
+        }
+        if (name.empty()) {
+            jclass declaring = nullptr;
+            char *class_signature = nullptr;
+            char *method_name = nullptr;
+            char *method_signature = nullptr;
+            if (jvmti_->GetMethodDeclaringClass(method, &declaring) == JVMTI_ERROR_NONE) {
+                jvmti_->GetClassSignature(declaring, &class_signature, nullptr);
+                if (jni) jni->DeleteLocalRef(declaring);
+            }
+            if (jvmti_->GetMethodName(method, &method_name, &method_signature, nullptr) != JVMTI_ERROR_NONE) {
+                // 方法所在类已被卸载
+                name = "<unloaded>";
+            } else {
+                std::string_view owner = class_signature ? class_signature : "?";
+                if (owner.size() >= 2 && owner.front() == 'L' && owner.back() == ';') {
+                    owner = owner.substr(1, owner.size() - 2);
+                }
+                name.append(owner).append(".").append(method_name).append(method_signature);
+            }
+            for (char *p: {class_signature, method_name, method_signature}) {
+                if (p) jvmti_->Deallocate(reinterpret_cast<unsigned char *>(p));
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            names_.emplace(method, name);
+        }
+        if (!signature) {
+            if (const size_t paren = name.find('('); paren != std::string::npos) name.resize(paren);
+        }
+        return name;
+    }
+
+    std::string MethodResolver::frame(JNIEnv *jni, const jmethodID method, const jlocation location) const {
+        std::string result = name(jni, method);
+        jint count = 0;
+        jvmtiLineNumberEntry *lines = nullptr;
+        if (jvmti_->GetLineNumberTable(method, &count, &lines) == JVMTI_ERROR_NONE && lines) {
+            // 行号表不保证有序，取起始位置不超过 location 的最近一项
+            jint line = -1;
+            jlocation best = -1;
+            for (jint i = 0; i < count; ++i) {
+                if (lines[i].start_location <= location && lines[i].start_location > best) {
+                    best = lines[i].start_location;
+                    line = lines[i].line_number;
+                }
+            }
+            jvmti_->Deallocate(reinterpret_cast<unsigned char *>(lines));
+            if (line >= 0) return result + ":" + std::to_string(line);
+        }
+        return result + "@" + std::to_string(location);
+    }
+} // jvmti_tools
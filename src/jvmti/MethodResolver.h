@@ -0,0 +1,29 @@
+#ifndef METHODRESOLVER_H
+#define METHODRESOLVER_H
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <jvmti.h>
+
+namespace jvmti_tools {
+    // jmethodID 到可读名称的缓存，主要在报告/导出时使用；JIT 事件回调（perf 符号导出）中依靠缓存，
+    // 分层编译重复加载的方法只解析一次
+    class MethodResolver {
+    private:
+        jvmtiEnv *jvmti_;
+        mutable std::mutex mutex_;
+        mutable std::unordered_map<jmethodID, std::string> names_;
+
+    public:
+        explicit MethodResolver(jvmtiEnv *jvmti): jvmti_(jvmti) {
+        }
+
+        // com/example/Foo.bar(I)V；signature=false 时省略参数签名。类已卸载时返回 <unloaded>。jni 可为空
+        std::string name(JNIEnv *jni, jmethodID method, bool signature = true) const;
+
+        // 方法名加行号（需要 can_get_line_numbers，无行号表时为字节码位置）
+        std::string frame(JNIEnv *jni, jmethodID method, jlocation location) const;
+    };
+} // jvmti_tools
+
+#endif //METHODRESOLVER_H
@@ -5,48 +5,8 @@
 #include "MethodTrace.h"
 using namespace jvmti_tools;
 
-template<typename T>
-BlockingQueue<T>::BlockingQueue(const size_t max_size): max_size_(max_size) {
-}
-
-template<typename T>
-void BlockingQueue<T>::push(const T &value) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
-    // 队列满时等待
-    not_full_.wait(lock, [this] {
-        return max_size_ == 0 || queue_.size() < max_size_;
-    });
-
-    queue_.push(value);
-    not_empty_.notify_one();
-}
-
-template<typename T>
-bool BlockingQueue<T>::pop(T &value, std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
-    // 队列为空时等待
-    if (!not_empty_.wait_for(lock, timeout, [this] { return !queue_.empty(); })) {
-        return false;
-    }
-
-    value = std::move(queue_.front());
-    queue_.pop();
-    not_full_.notify_one();
-    return true;
-}
-
-template<typename T>
-size_t BlockingQueue<T>::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.size();
-}
-
-// 初始化线程局部变量
-thread_local std::unique_ptr<ThreadData> AgentState::thread_data_ = nullptr;
-
-AgentState::AgentState(const std::shared_ptr<spdlog::logger> &logger): timing_queue_(config_.max_queue_size) {
+AgentState::AgentState(const std::shared_ptr<spdlog::logger> &logger)
+    : timing_queue_(getConfig()->trace_queue_size) {
     // 启动异步日志线程
     logging_thread_ = std::thread(&AgentState::loggingLoop, this);
     logger_ = logger;
@@ -60,30 +20,29 @@ AgentState::~AgentState() {
     }
 }
 
-AgentConfig AgentState::getConfig() {
-    return config_;
+ConfigSnapshot AgentState::getConfig() {
+    return ConfigStore::global().acquire();
 }
 
 void AgentState::logTiming(const MethodTiming &timing) {
-    if (config_.async_logging) {
+    if (getConfig()->trace_async_logging) {
         timing_queue_.push(timing);
     } else {
         writeTimingToLog(timing);
     }
 }
 
-ThreadData &AgentState::getThreadData(jvmtiEnv *jvmti, jthread thread) {
-    if (!thread_data_) {
-        thread_data_ = std::make_unique<ThreadData>();
+ThreadState *AgentState::getThreadData(jvmtiEnv *jvmti, jthread thread) {
+    ThreadState *state = ThreadStates::global().get(jvmti, thread);
+    if (state && state->name.empty()) {
         // 获取线程名称
-        jvmtiThreadInfo jti;
-        jvmti->GetThreadInfo(thread, &jti);
-        if (jti.name) {
-            thread_data_->thread_name = jti.name;
-            // jvmti->Deallocate(reinterpret_cast<unsigned char *>(jti));
+        jvmtiThreadInfo info{};
+        if (jvmti->GetThreadInfo(thread, &info) == JVMTI_ERROR_NONE && info.name) {
+            state->name = info.name;
+            jvmti->Deallocate(reinterpret_cast<unsigned char *>(info.name));
         }
     }
-    return *thread_data_;
+    return state;
 }
 
 // 日志线程主循环
@@ -8,19 +8,14 @@
 #include <unordered_set>
 #include <chrono>
 #include <jvmti.h>
-#include <queue>
-#include <stack>
 #include <thread>
 
+#include "BlockingQueue.h"
+#include "Config.h"
+#include "ThreadState.h"
 #include "spdlog/logger.h"
 
 namespace jvmti_tools {
-    // 方法调用记录（使用智能指针管理资源）
-    struct MethodCall {
-        jmethodID method{};
-        std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
-    };
-
     // 方法耗时统计（用于异步处理）
     struct MethodTiming {
         std::string thread_name;
@@ -29,56 +24,13 @@ namespace jvmti_tools {
         double elapsed_ms;
     };
 
-    // 线程本地存储数据
-    struct ThreadData {
-        std::stack<MethodCall> call_stack;
-        std::string thread_name;
-    };
-
-    // 全局配置
-    struct AgentConfig {
-        bool enabled = true;
-        bool async_logging = true;
-        size_t max_queue_size = 10240;
-        std::unordered_set<std::string> target_packages = {
-            "com/fr/jvm/",
-            "com/fr/license/",
-            "TestApp",
-            "DataGuard",
-        };
-    };
-
-    // 无界阻塞队列（支持生产者-消费者模型）
-    template<typename T>
-    class BlockingQueue {
-    private:
-        std::queue<T> queue_;
-        mutable std::mutex mutex_;
-        std::condition_variable not_empty_;
-        std::condition_variable not_full_;
-        std::atomic<size_t> max_size_;
-
-    public:
-        explicit BlockingQueue(size_t max_size = 0);
-
-        ~BlockingQueue() = default;
-
-        void push(const T &value);
-
-        bool pop(T &value, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
-
-        size_t size() const;
-    };
-
     // 全局状态
     class AgentState {
     private:
         std::shared_ptr<spdlog::logger> logger_;
-        AgentConfig config_;
         BlockingQueue<MethodTiming> timing_queue_;
         std::atomic<bool> running_{true};
         std::thread logging_thread_;
-        static thread_local std::unique_ptr<ThreadData> thread_data_;
 
     public:
         explicit AgentState() = default;
@@ -87,10 +39,12 @@ namespace jvmti_tools {
 
         ~AgentState();
 
-        AgentConfig getConfig();
+        // 当前配置快照（trace_* 配置项），持有期间不会被回收
+        static ConfigSnapshot getConfig();
 
-        // 获取线程本地数据
-        static ThreadData &getThreadData(jvmtiEnv *jvmti, jthread thread);
+        // 获取线程状态（调用栈、线程名），保存在 JVMTI 线程本地存储中，线程结束时由
+        // ThreadStates::release 归还；失败时返回 nullptr
+        static ThreadState *getThreadData(jvmtiEnv *jvmti, jthread thread);
 
         // 异步记录方法耗时
         void logTiming(const MethodTiming &timing);
@@ -0,0 +1,314 @@
+#include "Metrics.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jvmti_tools {
+    namespace {
+        using namespace metrics_layout;
+
+        // 读取端重试次数：发布线程写入一次只需微秒级，超过次数说明写入端异常
+        constexpr int READ_RETRIES = 1000;
+
+        uint64_t nowNanos() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        void copyName(char (&target)[NAME_SIZE], const char *name) {
+            std::strncpy(target, name, NAME_SIZE - 1);
+            target[NAME_SIZE - 1] = '\0';
+        }
+
+        SharedCounter *sharedCounters(void *segment) {
+            return reinterpret_cast<SharedCounter *>(static_cast<char *>(segment) + sizeof(SharedHeader));
+        }
+
+        SharedHistogram *sharedHistograms(void *segment, const uint32_t counters) {
+            return reinterpret_cast<SharedHistogram *>(static_cast<char *>(segment) + sizeof(SharedHeader) +
+                                                       counters * sizeof(SharedCounter));
+        }
+    }
+
+    Metrics::~Metrics() {
+        stop();
+    }
+
+    const char *Metrics::name(const Counter counter) {
+        switch (counter) {
+            case Counter::ClassesSeen: return "classes_seen";
+            case Counter::EncryptedClasses: return "encrypted_classes";
+            case Counter::DumpedClasses: return "dumped_classes";
+            case Counter::DumpedBytes: return "dumped_bytes";
+            case Counter::NativeBinds: return "native_binds";
+            case Counter::ReboundNatives: return "rebound_natives";
+            case Counter::RetransformedClasses: return "retransformed_classes";
+            case Counter::RetransformFailures: return "retransform_failures";
+            case Counter::LogQueueDepth: return "log_queue_depth";
+            case Counter::LogDrops: return "log_drops";
+            case Counter::Exceptions: return "exceptions";
+            case Counter::AllocationSamples: return "allocation_samples";
+            case Counter::FreedSamples: return "freed_samples";
+            case Counter::MonitorContentions: return "monitor_contentions";
+            case Counter::PerfMapRecords: return "perf_map_records";
+            case Counter::CompiledMethods: return "compiled_methods";
+            case Counter::CodeCacheBytes: return "code_cache_bytes";
+            default: return "unknown";
+        }
+    }
+
+    const char *Metrics::name(const Timer timer) {
+        switch (timer) {
+            case Timer::ClassFileLoadHook: return "class_file_load_hook_nanos";
+            case Timer::NativeMethodBind: return "native_method_bind_nanos";
+            case Timer::ClassPrepare: return "class_prepare_nanos";
+            case Timer::Exception: return "exception_nanos";
+            case Timer::SampledObjectAlloc: return "sampled_object_alloc_nanos";
+            case Timer::GcPause: return "gc_pause_nanos";
+            case Timer::CompiledMethodLoad: return "compiled_method_load_nanos";
+            default: return "unknown";
+        }
+    }
+
+    bool Metrics::isGauge(const Counter counter) {
+        return counter == Counter::LogQueueDepth || counter == Counter::CodeCacheBytes;
+    }
+
+    std::string Metrics::segmentName(const uint64_t pid) {
+        return "/jvmti-agent-" + std::to_string(pid);
+    }
+
+    bool Metrics::start(const std::chrono::milliseconds interval, Sampler sampler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return true;
+        if (!createSegment(interval)) return false;
+        sampler_ = std::move(sampler);
+        running_ = true;
+        publisher_ = std::thread([this, interval] {
+            std::unique_lock<std::mutex> guard(mutex_);
+            while (running_) {
+                guard.unlock();
+                if (sampler_) sampler_(*this);
+                publish();
+                guard.lock();
+                wakeup_.wait_for(guard, interval, [this] { return !running_; });
+            }
+        });
+        return true;
+    }
+
+    void Metrics::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        wakeup_.notify_all();
+        if (publisher_.joinable()) publisher_.join();
+        // 发布线程已结束，写入最终数值后删除，外部读取端已映射的部分仍然有效
+        if (sampler_) sampler_(*this);
+        publish();
+        sampler_ = nullptr;
+        removeSegment();
+    }
+
+#ifdef _WIN32
+    bool Metrics::createSegment(std::chrono::milliseconds) {
+        return false;
+    }
+
+    void Metrics::removeSegment() {
+    }
+#else
+    bool Metrics::createSegment(const std::chrono::milliseconds interval) {
+        constexpr auto counters = static_cast<uint32_t>(Counter::Count);
+        constexpr auto histograms = static_cast<uint32_t>(Timer::Count);
+        const size_t size = segmentSize(counters, histograms);
+        const auto pid = static_cast<uint64_t>(getpid());
+        const std::string segment_name = segmentName(pid);
+
+        // 同一 pid 的残留段（上一个模块未正常卸载）直接覆盖
+        const int fd = shm_open(segment_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            shm_unlink(segment_name.c_str());
+            return false;
+        }
+        void *segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (segment == MAP_FAILED) {
+            shm_unlink(segment_name.c_str());
+            return false;
+        }
+
+        // ftruncate 已将内容清零，序号为 0 表示尚无数据；头部写完后才会发布第一个偶数序号
+        auto *header = static_cast<SharedHeader *>(segment);
+        std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version = VERSION;
+        header->counters = counters;
+        header->histograms = histograms;
+        header->buckets = static_cast<uint32_t>(Histogram::BUCKETS);
+        header->pid = pid;
+        header->interval_ms = static_cast<uint64_t>(interval.count());
+        auto *shared_counters = sharedCounters(segment);
+        for (uint32_t i = 0; i < counters; ++i) {
+            copyName(shared_counters[i].name, name(static_cast<Counter>(i)));
+            shared_counters[i].kind = isGauge(static_cast<Counter>(i)) ? GAUGE : COUNTER;
+        }
+        auto *shared_histograms = sharedHistograms(segment, counters);
+        for (uint32_t i = 0; i < histograms; ++i) {
+            copyName(shared_histograms[i].name, name(static_cast<Timer>(i)));
+        }
+
+        segment_ = segment;
+        segment_size_ = size;
+        segment_name_ = segment_name;
+        return true;
+    }
+
+    void Metrics::removeSegment() {
+        if (segment_ == nullptr) return;
+        munmap(segment_, segment_size_);
+        shm_unlink(segment_name_.c_str());
+        segment_ = nullptr;
+        segment_size_ = 0;
+        segment_name_.clear();
+    }
+#endif
+
+    void Metrics::publish() {
+        if (segment_ == nullptr) return;
+        auto *header = static_cast<SharedHeader *>(segment_);
+        const uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+
+        // 奇数序号：写入中
+        header->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto *shared_counters = sharedCounters(segment_);
+        for (size_t i = 0; i < counters_.size(); ++i) {
+            shared_counters[i].value.store(counters_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        auto *shared_histograms = sharedHistograms(segment_, header->counters);
+        for (size_t i = 0; i < timers_.size(); ++i) {
+            const Histogram &source = timers_[i];
+            SharedHistogram &target = shared_histograms[i];
+            for (size_t b = 0; b < Histogram::BUCKETS; ++b) {
+                target.buckets[b].store(source.bucket(b), std::memory_order_relaxed);
+            }
+            target.count.store(source.count(), std::memory_order_relaxed);
+            target.sum.store(source.sum(), std::memory_order_relaxed);
+            target.max.store(source.max(), std::memory_order_relaxed);
+        }
+        header->updated_ns.store(nowNanos(), std::memory_order_relaxed);
+
+        // 偶数序号：写入完成
+        header->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    Metrics &Metrics::global() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+#ifdef _WIN32
+    std::optional<MetricsSnapshot> readMetrics(uint64_t, std::string &error) {
+        error = "shared memory metrics are not supported on this platform";
+        return std::nullopt;
+    }
+#else
+    std::optional<MetricsSnapshot> readMetrics(const uint64_t pid, std::string &error) {
+        const std::string name = Metrics::segmentName(pid);
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            error = "metrics segment " + name + " not found: " + std::strerror(errno);
+            return std::nullopt;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedHeader)) {
+            close(fd);
+            error = "metrics segment " + name + " is truncated";
+            return std::nullopt;
+        }
+        const auto size = static_cast<size_t>(st.st_size);
+        void *segment = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (segment == MAP_FAILED) {
+            error = "failed to map metrics segment " + name + ": " + std::strerror(errno);
+            return std::nullopt;
+        }
+        // 仅在本函数内访问映射，返回前解除
+        struct Unmap {
+            void *segment;
+            size_t size;
+            ~Unmap() { munmap(segment, size); }
+        } unmap{segment, size};
+
+        const auto *header = static_cast<const SharedHeader *>(segment);
+        if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+            error = "metrics segment " + name + " has an unsupported layout (version " +
+                    std::to_string(header->version) + ")";
+            return std::nullopt;
+        }
+        if (header->buckets != Histogram::BUCKETS || segmentSize(header->counters, header->histograms) > size) {
+            error = "metrics segment " + name + " is inconsistent";
+            return std::nullopt;
+        }
+
+        MetricsSnapshot snapshot;
+        snapshot.pid = header->pid;
+        snapshot.interval_ms = header->interval_ms;
+        const auto *shared_counters = sharedCounters(segment);
+        const auto *shared_histograms = sharedHistograms(segment, header->counters);
+        for (uint32_t i = 0; i < header->counters; ++i) {
+            snapshot.counters.push_back({
+                std::string(shared_counters[i].name, strnlen(shared_counters[i].name, NAME_SIZE)),
+                shared_counters[i].kind == GAUGE
+            });
+        }
+        for (uint32_t i = 0; i < header->histograms; ++i) {
+            MetricsSnapshot::HistogramValue histogram;
+            histogram.name.assign(shared_histograms[i].name, strnlen(shared_histograms[i].name, NAME_SIZE));
+            snapshot.histograms.push_back(std::move(histogram));
+        }
+
+        // seqlock 读取：只读映射上只有原子加载，不会对写入端造成任何影响
+        for (int attempt = 0; attempt < READ_RETRIES; ++attempt) {
+            const uint64_t before = header->sequence.load(std::memory_order_acquire);
+            if (before == 0 || (before & 1) != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (uint32_t i = 0; i < header->counters; ++i) {
+                snapshot.counters[i].value = shared_counters[i].value.load(std::memory_order_relaxed);
+            }
+            for (uint32_t i = 0; i < header->histograms; ++i) {
+                auto &target = snapshot.histograms[i];
+                const auto &source = shared_histograms[i];
+                target.count = source.count.load(std::memory_order_relaxed);
+                target.sum = source.sum.load(std::memory_order_relaxed);
+                target.max = source.max.load(std::memory_order_relaxed);
+                for (size_t b = 0; b < Histogram::BUCKETS; ++b) {
+                    target.buckets[b] = source.buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+            snapshot.updated_ns = header->updated_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_relaxed) == before) {
+                snapshot.sequence = before;
+                return snapshot;
+            }
+        }
+        error = "metrics segment " + name + " is not ready or is being updated continuously";
+        return std::nullopt;
+    }
+#endif
+} // jvmti_tools
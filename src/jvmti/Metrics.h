@@ -0,0 +1,226 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Histogram.h"
+
+namespace jvmti_tools {
+    // 计数器：Gauge 类型（队列深度等）由采样函数在每次发布前写入，其余只增不减
+    enum class Counter : uint32_t {
+        ClassesSeen,
+        EncryptedClasses,
+        DumpedClasses,
+        DumpedBytes,
+        NativeBinds,
+        ReboundNatives,
+        RetransformedClasses,
+        RetransformFailures,
+        LogQueueDepth,
+        LogDrops,
+        Exceptions,
+        AllocationSamples,
+        FreedSamples,
+        MonitorContentions,
+        PerfMapRecords,
+        CompiledMethods,
+        CodeCacheBytes, // 编译代码与桩代码占用的代码缓存（字节）
+        Count
+    };
+
+    // 回调耗时（纳秒）
+    enum class Timer : uint32_t {
+        ClassFileLoadHook,
+        NativeMethodBind,
+        ClassPrepare,
+        Exception,
+        SampledObjectAlloc,
+        GcPause, // GC 停顿时长，由 GC 时间线汇总线程记录
+        CompiledMethodLoad,
+        Count
+    };
+
+    // 共享内存段布局：头部之后依次是 counters 个 SharedCounter 与 histograms 个 SharedHistogram。
+    // 名称在创建时写入后不再变化；数值由唯一的发布线程按 seqlock 协议更新：
+    // sequence 为奇数表示正在写入，读取端在前后两次读到相同的偶数时数据一致。
+    // 布局变化时必须增加 VERSION，读取端拒绝不认识的版本
+    namespace metrics_layout {
+        constexpr char MAGIC[8] = {'J', 'V', 'M', 'T', 'I', 'M', 'X', '\0'};
+        constexpr uint32_t VERSION = 1;
+        constexpr size_t NAME_SIZE = 48;
+
+        enum Kind : uint32_t {
+            COUNTER = 0,
+            GAUGE = 1,
+        };
+
+        struct SharedHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t counters;
+            uint32_t histograms;
+            uint32_t buckets;
+            uint64_t pid;
+            uint64_t interval_ms;
+            std::atomic<uint64_t> sequence;
+            std::atomic<uint64_t> updated_ns; // 最近一次发布的时间（Unix 纪元纳秒）
+        };
+
+        struct SharedCounter {
+            char name[NAME_SIZE];
+            uint32_t kind;
+            uint32_t reserved;
+            std::atomic<uint64_t> value;
+        };
+
+        struct SharedHistogram {
+            char name[NAME_SIZE];
+            std::atomic<uint64_t> count;
+            std::atomic<uint64_t> sum;
+            std::atomic<uint64_t> max;
+            std::atomic<uint64_t> buckets[Histogram::BUCKETS];
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared metrics require lock-free 64-bit atomics");
+
+        inline size_t segmentSize(const uint32_t counters, const uint32_t histograms) {
+            return sizeof(SharedHeader) + counters * sizeof(SharedCounter) + histograms * sizeof(SharedHistogram);
+        }
+    }
+
+    // 进程内指标：回调线程只做 relaxed 原子累加，不访问共享内存；
+    // 发布线程按固定间隔把数值复制到共享内存段 /dev/shm/jvmti-agent-<pid>，
+    // 外部读取只映射该段，不与 JVM 进程产生任何交互
+    class Metrics {
+    public:
+        using Sampler = std::function<void(Metrics &)>;
+
+    private:
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count)> counters_{};
+        std::array<Histogram, static_cast<size_t>(Timer::Count)> timers_;
+
+        std::mutex mutex_;
+        std::condition_variable wakeup_;
+        std::thread publisher_;
+        bool running_ = false;
+        Sampler sampler_;
+        std::string segment_name_;
+        void *segment_ = nullptr;
+        size_t segment_size_ = 0;
+
+        bool createSegment(std::chrono::milliseconds interval);
+
+        void removeSegment();
+
+        // 单写者：仅由发布线程（或停止后的调用线程）执行
+        void publish();
+
+    public:
+        Metrics() = default;
+
+        ~Metrics();
+
+        Metrics(const Metrics &) = delete;
+
+        Metrics &operator=(const Metrics &) = delete;
+
+        void add(const Counter counter, const uint64_t n = 1) {
+            counters_[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        void set(const Counter counter, const uint64_t value) {
+            counters_[static_cast<size_t>(counter)].store(value, std::memory_order_relaxed);
+        }
+
+        void record(const Timer timer, const uint64_t nanos) {
+            timers_[static_cast<size_t>(timer)].record(nanos);
+        }
+
+        uint64_t value(const Counter counter) const {
+            return counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+        }
+
+        const Histogram &timer(const Timer timer) const { return timers_[static_cast<size_t>(timer)]; }
+
+        // 创建共享内存段并启动发布线程；不支持的平台或创建失败时返回 false，计数仍在进程内累加
+        bool start(std::chrono::milliseconds interval, Sampler sampler = nullptr);
+
+        // 停止发布线程，写入最后一次数值后删除共享内存段；模块卸载前必须调用
+        void stop();
+
+        bool publishing() const { return segment_ != nullptr; }
+
+        const std::string &segment() const { return segment_name_; }
+
+        static const char *name(Counter counter);
+
+        static const char *name(Timer timer);
+
+        static bool isGauge(Counter counter);
+
+        // 共享内存对象名，Linux 上对应 /dev/shm/jvmti-agent-<pid>
+        static std::string segmentName(uint64_t pid);
+
+        static Metrics &global();
+    };
+
+    // 作用域计时：析构时把耗时记录到对应的直方图
+    class ScopedTimer {
+    private:
+        Timer timer_;
+        std::chrono::steady_clock::time_point start_;
+
+    public:
+        explicit ScopedTimer(const Timer timer): timer_(timer), start_(std::chrono::steady_clock::now()) {
+        }
+
+        ~ScopedTimer() {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            Metrics::global().record(
+                timer_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+    };
+
+    // 外部读取到的一致快照
+    struct MetricsSnapshot {
+        struct CounterValue {
+            std::string name;
+            bool gauge = false;
+            uint64_t value = 0;
+        };
+
+        struct HistogramValue {
+            std::string name;
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t max = 0;
+            std::array<uint64_t, Histogram::BUCKETS> buckets{};
+        };
+
+        uint64_t pid = 0;
+        uint64_t interval_ms = 0;
+        uint64_t sequence = 0;
+        uint64_t updated_ns = 0;
+        std::vector<CounterValue> counters;
+        std::vector<HistogramValue> histograms;
+    };
+
+    // 以只读方式映射目标进程的共享内存段并读取一致快照；失败时返回空并设置 error
+    std::optional<MetricsSnapshot> readMetrics(uint64_t pid, std::string &error);
+} // jvmti_tools
+
+#endif //METRICS_H
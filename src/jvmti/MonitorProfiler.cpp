@@ -0,0 +1,152 @@
+#include "MonitorProfiler.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ClassRegistry.h"
+#include "ThreadState.h"
+
+namespace jvmti_tools {
+    namespace {
+        constexpr uint32_t NO_SITE = UINT32_MAX;
+        // 每个监视器类型最多输出的等待点数量
+        constexpr size_t SITES_PER_TYPE = 5;
+
+        int64_t nowNanos() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        double millis(const uint64_t nanos) {
+            return static_cast<double>(nanos) / 1e6;
+        }
+
+        const char *kindName(const MonitorProfiler::Kind kind) {
+            return kind == MonitorProfiler::Kind::Wait ? "wait" : "contended";
+        }
+    }
+
+    MonitorProfiler::MonitorProfiler(jvmtiEnv *jvmti, const MonitorProfilerOptions &options,
+                                     std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)), index_(options.capacity),
+          sites_(std::make_unique<Site[]>(index_.capacity())), stacks_(options.capacity), methods_(jvmti) {
+        options_.stack_depth = std::clamp<uint32_t>(options_.stack_depth, 1, MAX_STACK_DEPTH);
+    }
+
+    uint32_t MonitorProfiler::siteOf(JNIEnv *jni, const jthread thread, const jobject object, const Kind kind) {
+        jlong type = 0;
+        if (const jclass klass = jni->GetObjectClass(object)) {
+            type = ClassRegistry::global().idOf(jvmti_, klass);
+            jni->DeleteLocalRef(klass);
+        }
+        jvmtiFrameInfo frames[MAX_STACK_DEPTH];
+        jint depth = 0;
+        uint64_t stack = 0;
+        if (jvmti_->GetStackTrace(thread, 0, static_cast<jint>(options_.stack_depth), frames, &depth) ==
+            JVMTI_ERROR_NONE) {
+            stack = stacks_.intern(frames, depth);
+        }
+        const uint64_t key = combineHash(combineHash(mixHash(static_cast<uint64_t>(type)), stack),
+                                         static_cast<uint64_t>(kind));
+        const uint32_t *index = index_.acquire(key, 1, [&](uint32_t &slot) {
+            slot = next_site_.fetch_add(1, std::memory_order_relaxed);
+            sites_[slot].type = type;
+            sites_[slot].stack = stack;
+            sites_[slot].kind = kind;
+        });
+        return index ? *index : NO_SITE;
+    }
+
+    void MonitorProfiler::enter(JNIEnv *jni, const jthread thread, const jobject object, const Kind kind) {
+        ThreadState *state = ThreadStates::global().get(jvmti_, thread);
+        if (!state) return;
+        const uint32_t site = siteOf(jni, thread, object, kind);
+        // 最后读取时钟，等待点查找的耗时不计入等待时间
+        if (kind == Kind::Wait) {
+            state->wait_site = site;
+            state->wait_since = nowNanos();
+        } else {
+            state->contended_site = site;
+            state->contended_since = nowNanos();
+        }
+    }
+
+    void MonitorProfiler::exit(const jthread thread, const Kind kind) {
+        const int64_t now = nowNanos();
+        ThreadState *state = ThreadStates::global().get(jvmti_, thread);
+        if (!state) return;
+        int64_t &since = kind == Kind::Wait ? state->wait_since : state->contended_since;
+        const uint32_t site = kind == Kind::Wait ? state->wait_site : state->contended_site;
+        // 附加前已开始的等待没有起点，忽略
+        if (since == 0 || site == NO_SITE) {
+            since = 0;
+            return;
+        }
+        sites_[site].wait.record(static_cast<uint64_t>(std::max<int64_t>(now - since, 0)));
+        since = 0;
+        events_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void MonitorProfiler::periodicReport(JNIEnv *jni) {
+        const uint64_t events = events_.load(std::memory_order_relaxed);
+        if (events == reported_events_) return;
+        reported_events_ = events;
+        report(jni, options_.top);
+    }
+
+    void MonitorProfiler::report(JNIEnv *jni, const size_t top) const {
+        if (!log_) return;
+        // 同一类型的各等待点直方图合并为类型直方图；同名类型可能被重复登记，按名称合并
+        struct Group {
+            Histogram wait;
+            std::vector<uint32_t> sites;
+        };
+        const ClassRegistry &classes = ClassRegistry::global();
+        std::map<std::pair<std::string, Kind>, Group> groups;
+        index_.forEach([&](uint64_t, uint64_t, const uint32_t index) {
+            const Site &site = sites_[index];
+            if (site.wait.count() == 0) return;
+            Group &group = groups[{classes.name(site.type), site.kind}];
+            group.wait.merge(site.wait);
+            group.sites.push_back(index);
+        });
+
+        std::vector<const std::pair<const std::pair<std::string, Kind>, Group> *> ranked;
+        ranked.reserve(groups.size());
+        for (const auto &entry: groups) ranked.push_back(&entry);
+        const size_t shown = std::min(top, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(shown), ranked.end(),
+                          [](const auto *a, const auto *b) { return a->second.wait.sum() > b->second.wait.sum(); });
+
+        log_->info("Monitor contention: waits={} sites={} stacks={} dropped={} threads={}",
+                   events_.load(std::memory_order_relaxed), index_.size(), stacks_.size(),
+                   index_.dropped() + stacks_.dropped(), ThreadStates::global().size());
+        const auto bySum = [this](const uint32_t a, const uint32_t b) {
+            return sites_[a].wait.sum() > sites_[b].wait.sum();
+        };
+        for (size_t i = 0; i < shown; ++i) {
+            const auto &[key, group] = *ranked[i];
+            const Histogram &wait = group.wait;
+            log_->info("  #{:<2} {} ({}): count={} total={:.1f}ms p99<={:.2f}ms max={:.2f}ms", i + 1, key.first,
+                       kindName(key.second), wait.count(), millis(wait.sum()), millis(wait.percentile(0.99)),
+                       millis(wait.max()));
+            auto sites = group.sites;
+            const size_t listed = std::min(SITES_PER_TYPE, sites.size());
+            std::partial_sort(sites.begin(), sites.begin() + static_cast<std::ptrdiff_t>(listed), sites.end(), bySum);
+            for (size_t j = 0; j < listed; ++j) {
+                const Site &site = sites_[sites[j]];
+                std::string where;
+                for (const auto &frame: stacks_.frames(site.stack)) {
+                    if (!where.empty()) where += " <- ";
+                    where += methods_.frame(jni, frame.method, frame.location);
+                }
+                log_->info("        count={} total={:.1f}ms p99<={:.2f}ms at {}", site.wait.count(),
+                           millis(site.wait.sum()), millis(site.wait.percentile(0.99)),
+                           where.empty() ? "?" : where);
+            }
+        }
+    }
+} // jvmti_tools
@@ -0,0 +1,77 @@
+#ifndef MONITORPROFILER_H
+#define MONITORPROFILER_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <jvmti.h>
+
+#include "CounterTable.h"
+#include "Histogram.h"
+#include "MethodResolver.h"
+#include "StackTable.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct MonitorProfilerOptions {
+        size_t capacity = 1024; // 等待点数量上限
+        uint32_t stack_depth = 1; // 区分等待点的调用栈深度，1 表示只看栈顶方法
+        size_t top = 10; // 报告输出的监视器类型数量
+        std::chrono::seconds report_interval{60}; // 定期报告间隔，0 表示仅在停止时报告
+    };
+
+    // 监视器竞争分析：MonitorContendedEnter/Entered（可选 MonitorWait/Waited）之间的等待时长
+    // 按（监视器类型、等待点调用栈、等待方式）记录到各自的直方图中，报告时按类型合并直方图并按总等待时间排序。
+    // 进入等待的时间与等待点保存在 JVMTI 线程本地存储的 ThreadState 中。事件回调只做查找与记录，
+    // 定期报告由代理线程调用 periodicReport 完成，不在持有被竞争监视器的线程上进行
+    class MonitorProfiler {
+    public:
+        static constexpr uint32_t MAX_STACK_DEPTH = 16;
+
+        enum class Kind : uint8_t {
+            Contended, // synchronized 竞争
+            Wait, // Object.wait
+        };
+
+    private:
+        struct Site {
+            Histogram wait; // 等待时长（纳秒）
+            jlong type = 0; // 监视器对象类型编号（ClassRegistry）
+            uint64_t stack = 0;
+            Kind kind = Kind::Contended;
+        };
+
+        jvmtiEnv *jvmti_;
+        MonitorProfilerOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        CounterTable<uint32_t> index_; // (类型, 调用栈, 等待方式) => 等待点编号
+        std::unique_ptr<Site[]> sites_;
+        std::atomic<uint32_t> next_site_{0};
+        StackTable stacks_;
+        MethodResolver methods_;
+        std::atomic<uint64_t> events_{0};
+        uint64_t reported_events_ = 0; // 上次定期报告时的等待次数，仅由报告线程访问
+
+        // 取得等待点编号，失败时返回 UINT32_MAX
+        uint32_t siteOf(JNIEnv *jni, jthread thread, jobject object, Kind kind);
+
+    public:
+        MonitorProfiler(jvmtiEnv *jvmti, const MonitorProfilerOptions &options, std::shared_ptr<spdlog::logger> log);
+
+        // MonitorContendedEnter / MonitorWait 中调用
+        void enter(JNIEnv *jni, jthread thread, jobject object, Kind kind);
+
+        // MonitorContendedEntered / MonitorWaited 中调用
+        void exit(jthread thread, Kind kind);
+
+        // 输出总等待时间最长的监视器类型及其主要等待点；jni 可为空
+        void report(JNIEnv *jni, size_t top) const;
+
+        // 报告线程中调用：自上次报告以来有新的等待时输出报告
+        void periodicReport(JNIEnv *jni);
+
+        const MonitorProfilerOptions &options() const { return options_; }
+    };
+} // jvmti_tools
+
+#endif //MONITORPROFILER_H
@@ -0,0 +1,301 @@
+#include "NativeInterceptor.h"
+
+#include <array>
+#include <chrono>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace jvmti_tools {
+    namespace {
+        // 跳板槽位数量与单个方法最多转发的参数字数（不含 JNIEnv 与 this/class）
+        constexpr size_t MAX_SLOTS = 64;
+#if defined(__APPLE__) && defined(__aarch64__)
+        // Apple arm64 的栈上参数按自然大小紧凑排列，按 8 字节转发会错位；
+        // 只转发能全部放进 x0-x7 的参数（JNIEnv、this/class 之外 6 个），更长的签名不拦截
+        constexpr size_t MAX_WORDS = 6;
+#else
+        constexpr size_t MAX_WORDS = 8;
+#endif
+
+        using Word = uintptr_t;
+        template<size_t>
+        using WordAt = Word;
+
+        // 由方法签名解析出的调用形态
+        struct CallShape {
+            size_t words = 0; // 参数占用的机器字数
+            bool returns_void = false;
+            uint32_t array_mask = 0; // 第 i 个字为数组引用
+            uint32_t string_mask = 0; // 第 i 个字为 String 引用
+            std::array<uint8_t, MAX_WORDS> element_size{}; // 数组元素字节数
+        };
+
+        struct Slot {
+            std::atomic<void *> target{nullptr};
+            NativeMethodStats *stats = nullptr;
+            CallShape shape;
+        };
+
+        Slot slots[MAX_SLOTS];
+        std::atomic<size_t> next_slot{0};
+        std::unordered_map<jmethodID, size_t> slot_of_method;
+
+        uint8_t elementSize(const char type) {
+            switch (type) {
+                case 'B':
+                case 'Z':
+                    return 1;
+                case 'C':
+                case 'S':
+                    return 2;
+                case 'I':
+                case 'F':
+                    return 4;
+                case 'J':
+                case 'D':
+                    return 8;
+                default:
+                    return sizeof(void *);
+            }
+        }
+
+        // 解析 "(...)R" 形式的签名；float/double 走浮点寄存器，无法按字转发；参数超过 MAX_WORDS 个字时不拦截
+        std::optional<CallShape> parseShape(const std::string_view signature) {
+            if (signature.empty() || signature.front() != '(') return std::nullopt;
+
+            CallShape shape;
+            size_t i = 1;
+            while (i < signature.size() && signature[i] != ')') {
+                if (shape.words >= MAX_WORDS) return std::nullopt;
+                const size_t word = shape.words;
+                switch (signature[i]) {
+                    case 'F':
+                    case 'D':
+                        return std::nullopt;
+                    case 'J':
+                        shape.words += sizeof(jlong) / sizeof(Word);
+                        ++i;
+                        break;
+                    case 'L': {
+                        const size_t end = signature.find(';', i);
+                        if (end == std::string_view::npos) return std::nullopt;
+                        if (signature.substr(i, end - i + 1) == "Ljava/lang/String;") {
+                            shape.string_mask |= 1u << word;
+                        }
+                        shape.words += 1;
+                        i = end + 1;
+                        break;
+                    }
+                    case '[': {
+                        size_t element = i;
+                        while (element < signature.size() && signature[element] == '[') ++element;
+                        if (element >= signature.size()) return std::nullopt;
+                        // 多维数组按引用数组统计
+                        shape.element_size[word] = element - i > 1 ? sizeof(void *) : elementSize(signature[element]);
+                        shape.array_mask |= 1u << word;
+                        shape.words += 1;
+                        i = signature[element] == 'L' ? signature.find(';', element) + 1 : element + 1;
+                        if (i == 0) return std::nullopt;
+                        break;
+                    }
+                    default:
+                        shape.words += 1;
+                        ++i;
+                        break;
+                }
+            }
+            if (i + 1 >= signature.size() || shape.words > MAX_WORDS) return std::nullopt;
+
+            const char ret = signature[i + 1];
+            if (ret == 'F' || ret == 'D') return std::nullopt;
+            // 32 位平台上 long 返回值占用两个寄存器
+            if (ret == 'J' && sizeof(Word) < sizeof(jlong)) return std::nullopt;
+            shape.returns_void = ret == 'V';
+            return shape;
+        }
+
+        uint64_t argumentBytes(JNIEnv *env, const CallShape &shape, const Word *words, const size_t count) {
+            uint64_t total = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const auto ref = reinterpret_cast<jobject>(words[i]);
+                if (ref == nullptr) continue;
+                if (shape.array_mask >> i & 1u) {
+                    total += static_cast<uint64_t>(env->GetArrayLength(static_cast<jarray>(ref))) * shape.element_size[i];
+                } else if (shape.string_mask >> i & 1u) {
+                    total += static_cast<uint64_t>(env->GetStringUTFLength(static_cast<jstring>(ref)));
+                }
+            }
+            return total;
+        }
+
+        void record(const Slot &slot, const std::chrono::steady_clock::time_point start, const uint64_t bytes) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            auto &stats = *slot.stats;
+            stats.latency.record(static_cast<uint64_t>(elapsed));
+            if (slot.shape.array_mask | slot.shape.string_mask) stats.arg_bytes.record(bytes);
+        }
+
+        // 通用跳板：按机器字原样转发参数，前后记录统计信息
+        template<size_t S, bool Void, typename... Words>
+        std::conditional_t<Void, void, Word> JNICALL intercept_thunk(JNIEnv *env, jobject self, Words... words) {
+            const Slot &slot = slots[S];
+            const auto target = slot.target.load(std::memory_order_acquire);
+
+            uint64_t bytes = 0;
+            if constexpr (sizeof...(Words) > 0) {
+                if (slot.shape.array_mask | slot.shape.string_mask) {
+                    const Word args[] = {words...};
+                    bytes = argumentBytes(env, slot.shape, args, sizeof...(Words));
+                }
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            if constexpr (Void) {
+                reinterpret_cast<void (JNICALL *)(JNIEnv *, jobject, Words...)>(target)(env, self, words...);
+                record(slot, start, bytes);
+            } else {
+                const Word result = reinterpret_cast<Word (JNICALL *)(JNIEnv *, jobject, Words...)>(target)(
+                    env, self, words...);
+                record(slot, start, bytes);
+                return result;
+            }
+        }
+
+        // 跳板表：[槽位][参数字数][是否 void 返回]
+        using ThunkRow = std::array<std::array<void *, 2>, MAX_WORDS + 1>;
+
+        template<size_t S, bool Void, size_t... I>
+        void *thunkOf(std::index_sequence<I...>) {
+            return reinterpret_cast<void *>(&intercept_thunk<S, Void, WordAt<I>...>);
+        }
+
+        template<size_t S, size_t... N>
+        ThunkRow thunkRow(std::index_sequence<N...>) {
+            return {{{thunkOf<S, false>(std::make_index_sequence<N>{}), thunkOf<S, true>(std::make_index_sequence<N>{})}...}};
+        }
+
+        template<size_t... S>
+        std::array<ThunkRow, sizeof...(S)> thunkTable(std::index_sequence<S...>) {
+            return {thunkRow<S>(std::make_index_sequence<MAX_WORDS + 1>{})...};
+        }
+
+        const auto thunk_table = thunkTable(std::make_index_sequence<MAX_SLOTS>{});
+
+        void *thunkFor(const size_t slot, const CallShape &shape) {
+            return thunk_table[slot][shape.words][shape.returns_void ? 1 : 0];
+        }
+    }
+
+    std::optional<WordSignature> wordSignature(const std::string_view signature) {
+        const auto shape = parseShape(signature);
+        if (!shape) return std::nullopt;
+        return WordSignature{shape->words, shape->returns_void};
+    }
+
+    std::optional<InterceptRule> InterceptRule::parse(const std::string_view rule) {
+        if (rule.empty()) return std::nullopt;
+
+        InterceptRule result;
+        const size_t hash = rule.find('#');
+        result.class_name = std::string(rule.substr(0, hash));
+        for (auto &c: result.class_name) {
+            if (c == '.') c = '/';
+        }
+        if (result.class_name.empty()) return std::nullopt;
+
+        if (hash != std::string_view::npos) {
+            const std::string_view member = rule.substr(hash + 1);
+            const size_t paren = member.find('(');
+            result.method_name = std::string(member.substr(0, paren));
+            if (paren != std::string_view::npos) {
+                result.signature = std::string(member.substr(paren));
+            }
+        }
+        if (result.method_name == "*") result.method_name.clear();
+        return result;
+    }
+
+    bool InterceptRule::matchesClass(const std::string_view name) const {
+        if (!class_name.empty() && class_name.back() == '*') {
+            return name.starts_with(std::string_view(class_name).substr(0, class_name.size() - 1));
+        }
+        return name == class_name;
+    }
+
+    bool InterceptRule::matches(const std::string_view name, const std::string_view method,
+                                const std::string_view sig) const {
+        return matchesClass(name)
+               && (method_name.empty() || method == method_name)
+               && (signature.empty() || sig == signature);
+    }
+
+    NativeInterceptor::NativeInterceptor(std::vector<InterceptRule> rules): rules_(std::move(rules)) {
+    }
+
+    bool NativeInterceptor::matchesClass(const std::string_view class_name) const {
+        for (const auto &rule: rules_) {
+            if (rule.matchesClass(class_name)) return true;
+        }
+        return false;
+    }
+
+    bool NativeInterceptor::matches(const std::string_view class_name, const std::string_view method,
+                                    const std::string_view signature) const {
+        for (const auto &rule: rules_) {
+            if (rule.matches(class_name, method, signature)) return true;
+        }
+        return false;
+    }
+
+    void *NativeInterceptor::bind(const jmethodID method, const std::string_view class_name,
+                                  const std::string_view method_name, const std::string_view signature,
+                                  void *target) {
+        const auto shape = parseShape(signature);
+        if (!shape || target == nullptr) return nullptr;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t index;
+        if (const auto it = slot_of_method.find(method); it != slot_of_method.end()) {
+            index = it->second;
+            // 重复绑定到自身跳板时无需更新目标地址
+            if (target == thunkFor(index, slots[index].shape)) return target;
+        } else {
+            index = next_slot.fetch_add(1, std::memory_order_relaxed);
+            if (index >= MAX_SLOTS) {
+                next_slot.store(MAX_SLOTS, std::memory_order_relaxed);
+                return nullptr;
+            }
+            auto &stats = stats_.emplace_back();
+            stats.class_name = class_name;
+            stats.method_name = method_name;
+            stats.signature = signature;
+            slots[index].stats = &stats;
+            slots[index].shape = *shape;
+            slot_of_method[method] = index;
+        }
+
+        slots[index].target.store(target, std::memory_order_release);
+        return thunkFor(index, *shape);
+    }
+
+    void NativeInterceptor::report(spdlog::logger &log) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &stats: stats_) {
+            const auto &latency = stats.latency;
+            log.info("Native {}.{}{} calls={} mean={:.2f}us p50={:.2f}us p99={:.2f}us max={:.2f}us",
+                     stats.class_name, stats.method_name, stats.signature, stats.calls(),
+                     latency.mean() / 1000.0,
+                     static_cast<double>(latency.percentile(0.50)) / 1000.0,
+                     static_cast<double>(latency.percentile(0.99)) / 1000.0,
+                     static_cast<double>(latency.max()) / 1000.0);
+            const auto &args = stats.arg_bytes;
+            if (args.count() == 0) continue;
+            // 分位数为所在对数桶的上界
+            log.info("  args total={}B mean={:.0f}B p50={}B p90={}B p99={}B max={}B",
+                     args.sum(), args.mean(), args.percentile(0.50), args.percentile(0.90), args.percentile(0.99),
+                     args.max());
+        }
+    }
+} // jvmti_tools
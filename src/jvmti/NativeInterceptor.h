@@ -0,0 +1,81 @@
+#ifndef NATIVEINTERCEPTOR_H
+#define NATIVEINTERCEPTOR_H
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <jvmti.h>
+
+#include "Histogram.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    // 拦截规则：class#method(signature)
+    // - class 支持 '.' 或 '/' 分隔，以 '*' 结尾表示包前缀匹配
+    // - method 为空或 '*' 表示任意方法
+    // - signature 省略表示任意签名
+    struct InterceptRule {
+        std::string class_name;
+        std::string method_name;
+        std::string signature;
+
+        static std::optional<InterceptRule> parse(std::string_view rule);
+
+        bool matchesClass(std::string_view name) const;
+
+        bool matches(std::string_view name, std::string_view method, std::string_view sig) const;
+    };
+
+    // 按机器字转发参数时的调用形态：参数字数（不含 JNIEnv 与 this/class）及是否 void 返回
+    struct WordSignature {
+        size_t words = 0;
+        bool returns_void = false;
+    };
+
+    // 签名含 float/double 或参数过多、无法按机器字转发时返回空
+    std::optional<WordSignature> wordSignature(std::string_view signature);
+
+    // 单个被拦截 native 方法的统计数据
+    struct NativeMethodStats {
+        std::string class_name;
+        std::string method_name;
+        std::string signature;
+        Histogram latency; // 调用耗时（纳秒），样本数即调用次数
+        Histogram arg_bytes; // 单次调用数组/字符串参数字节数，方法没有此类参数时为空
+
+        uint64_t calls() const { return latency.count(); }
+    };
+
+    // 通用 native 方法拦截器：在 NativeMethodBind 时为匹配规则的方法分配跳板，
+    // 跳板记录调用次数、耗时分布与参数大小分布后转发到原始实现。
+    // 跳板按机器字转发参数，因此不支持含 float/double 参数或返回值的签名。
+    class NativeInterceptor {
+    private:
+        std::vector<InterceptRule> rules_;
+        std::deque<NativeMethodStats> stats_; // deque 保证元素地址稳定，供跳板直接引用
+        mutable std::mutex mutex_;
+
+    public:
+        explicit NativeInterceptor(std::vector<InterceptRule> rules);
+
+        bool empty() const { return rules_.empty(); }
+
+        // 快速判断类是否可能被拦截，避免对无关类获取方法信息
+        bool matchesClass(std::string_view class_name) const;
+
+        bool matches(std::string_view class_name, std::string_view method, std::string_view signature) const;
+
+        // 为方法分配跳板并返回跳板地址；签名不支持或槽位耗尽时返回 nullptr
+        void *bind(jmethodID method, std::string_view class_name, std::string_view method_name,
+                   std::string_view signature, void *target);
+
+        // 输出所有被拦截方法的统计信息
+        void report(spdlog::logger &log) const;
+    };
+} // jvmti_tools
+
+#endif //NATIVEINTERCEPTOR_H
@@ -0,0 +1,85 @@
+#include "Options.h"
+
+#include <charconv>
+
+namespace jvmti_tools {
+    namespace {
+        std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+
+        bool isTrue(std::string_view value) {
+            return value == "true" || value == "1" || value == "on" || value == "yes";
+        }
+
+        bool isFalse(std::string_view value) {
+            return value == "false" || value == "0" || value == "off" || value == "no";
+        }
+    }
+
+    Options::Options(const char *args) {
+        if (args == nullptr) return;
+
+        std::string_view rest(args);
+        while (!rest.empty()) {
+            const size_t comma = rest.find(',');
+            const std::string_view item = trim(rest.substr(0, comma));
+            rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+            if (item.empty()) continue;
+
+            if (const size_t eq = item.find('='); eq == std::string_view::npos) {
+                entries_.emplace_back(std::string(item), "true");
+            } else {
+                entries_.emplace_back(std::string(trim(item.substr(0, eq))), std::string(trim(item.substr(eq + 1))));
+            }
+        }
+    }
+
+    bool Options::has(const std::string_view key) const {
+        for (const auto &[k, v]: entries_) {
+            if (k == key) return true;
+        }
+        return false;
+    }
+
+    std::string Options::get(const std::string_view key, const std::string_view fallback) const {
+        for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+            if (it->first == key) return it->second;
+        }
+        return std::string(fallback);
+    }
+
+    std::vector<std::string> Options::getAll(const std::string_view key) const {
+        std::vector<std::string> values;
+        for (const auto &[k, v]: entries_) {
+            if (k == key) values.push_back(v);
+        }
+        return values;
+    }
+
+    long long Options::getInt(const std::string_view key, const long long fallback) const {
+        const std::string value = get(key);
+        long long result = 0;
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (value.empty() || ec != std::errc() || ptr != value.data() + value.size()) {
+            return fallback;
+        }
+        return result;
+    }
+
+    bool Options::getBool(const std::string_view key, const bool fallback) const {
+        if (!has(key)) return fallback;
+        return isTrue(get(key));
+    }
+
+    std::optional<std::string> Options::getFlagOrPath(const std::string_view key,
+                                                      const std::string_view flag_value) const {
+        if (!has(key)) return std::nullopt;
+        std::string value = get(key);
+        if (isFalse(value)) return std::nullopt;
+        if (isTrue(value)) return std::string(flag_value);
+        return value;
+    }
+} // jvmti_tools
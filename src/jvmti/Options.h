@@ -0,0 +1,39 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace jvmti_tools {
+    // 代理参数：逗号分隔的 key=value 列表，同名 key 可重复出现，仅有 key 时视为 true
+    // 例如：-agentpath:libagent.so=intercept=com/fr/license/*#decrypt,intercept=DataGuard#*
+    class Options {
+    private:
+        std::vector<std::pair<std::string, std::string> > entries_;
+
+    public:
+        Options() = default;
+
+        explicit Options(const char *args);
+
+        bool has(std::string_view key) const;
+
+        // 同名 key 以最后一次出现为准
+        std::string get(std::string_view key, std::string_view fallback = "") const;
+
+        std::vector<std::string> getAll(std::string_view key) const;
+
+        long long getInt(std::string_view key, long long fallback) const;
+
+        bool getBool(std::string_view key, bool fallback) const;
+
+        // 开关或路径：未指定或为 false/0/off/no 时返回空，为 true/1/on/yes 时返回 flag_value，其余视为路径
+        std::optional<std::string> getFlagOrPath(std::string_view key, std::string_view flag_value = "") const;
+
+        bool empty() const { return entries_.empty(); }
+    };
+} // jvmti_tools
+
+#endif //OPTIONS_H
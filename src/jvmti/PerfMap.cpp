@@ -0,0 +1,279 @@
+#include "PerfMap.h"
+
+#include <cstring>
+
+#include "Metrics.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace jvmti_tools {
+    namespace {
+        // jitdump 格式（tools/perf/Documentation/jitdump-specification.txt），字段按本机字节序写入
+        constexpr uint32_t JITDUMP_MAGIC = 0x4A695444;
+        constexpr uint32_t JITDUMP_VERSION = 1;
+        constexpr uint32_t JIT_CODE_LOAD = 0;
+        constexpr uint32_t JIT_CODE_CLOSE = 3;
+
+        struct JitdumpHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t total_size;
+            uint32_t elf_mach;
+            uint32_t pad1;
+            uint32_t pid;
+            uint64_t timestamp;
+            uint64_t flags;
+        };
+
+        struct JitdumpRecordHeader {
+            uint32_t id;
+            uint32_t total_size;
+            uint64_t timestamp;
+        };
+
+        // 之后依次为以 '\0' 结尾的名称与机器码
+        struct JitdumpCodeLoad {
+            JitdumpRecordHeader header;
+            uint32_t pid;
+            uint32_t tid;
+            uint64_t vma;
+            uint64_t code_addr;
+            uint64_t code_size;
+            uint64_t code_index;
+        };
+
+        static_assert(sizeof(JitdumpHeader) == 40);
+        static_assert(sizeof(JitdumpCodeLoad) == 56);
+
+        // ELF e_machine
+        constexpr uint32_t elfMachine() {
+#if defined(__x86_64__) || defined(_M_X64)
+            return 62; // EM_X86_64
+#elif defined(__aarch64__) || defined(_M_ARM64)
+            return 183; // EM_AARCH64
+#elif defined(__i386__) || defined(_M_IX86)
+            return 3; // EM_386
+#elif defined(__arm__)
+            return 40; // EM_ARM
+#elif defined(__riscv)
+            return 243; // EM_RISCV
+#else
+            return 0;
+#endif
+        }
+
+        // perf record -k mono 使用 CLOCK_MONOTONIC，steady_clock 与之一致
+        uint64_t monotonicNanos() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        uint32_t currentPid() {
+#ifdef _WIN32
+            return static_cast<uint32_t>(_getpid());
+#else
+            return static_cast<uint32_t>(getpid());
+#endif
+        }
+
+        uint32_t currentTid() {
+#ifdef __linux__
+            return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+            return 0;
+#endif
+        }
+    }
+
+    PerfMapWriter::PerfMapWriter(jvmtiEnv *jvmti, const PerfMapOptions &options, std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)), methods_(jvmti), pid_(currentPid()) {
+    }
+
+    PerfMapWriter::~PerfMapWriter() {
+        stop();
+    }
+
+    std::string PerfMapWriter::mapPath(const uint32_t pid) {
+        return "/tmp/perf-" + std::to_string(pid) + ".map";
+    }
+
+    void PerfMapWriter::compiledMethodLoad(const jmethodID method, const jint code_size, const void *code_addr) {
+        if (!running_.load(std::memory_order_acquire) || !code_addr || code_size <= 0) return;
+        Record record;
+        record.kind = Record::Kind::Method;
+        record.address = reinterpret_cast<uintptr_t>(code_addr);
+        record.size = static_cast<uint64_t>(code_size);
+        record.timestamp = monotonicNanos();
+        record.tid = currentTid();
+        // 同一方法分层编译会多次加载，名称只解析一次；回调中没有 JNIEnv，局部引用随事件返回释放
+        record.name = methods_.name(nullptr, method);
+        if (!options_.jitdump_dir.empty()) {
+            // 代码在卸载后可能被覆盖，必须在回调中复制
+            const auto *begin = static_cast<const unsigned char *>(code_addr);
+            record.code.assign(begin, begin + code_size);
+        }
+        queue_.push(std::move(record));
+    }
+
+    void PerfMapWriter::compiledMethodUnload(jmethodID, const void *) {
+        // 两种格式都没有卸载记录：perf-map 中以后写入的同地址记录为准，jitdump 依靠时间戳区分
+        unloads_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void PerfMapWriter::dynamicCodeGenerated(const char *name, const void *address, const jint length) {
+        if (!running_.load(std::memory_order_acquire) || !address || length <= 0) return;
+        Record record;
+        record.kind = Record::Kind::Stub;
+        record.address = reinterpret_cast<uintptr_t>(address);
+        record.size = static_cast<uint64_t>(length);
+        record.timestamp = monotonicNanos();
+        record.tid = currentTid();
+        record.name = name ? name : "<stub>";
+        if (!options_.jitdump_dir.empty()) {
+            const auto *begin = static_cast<const unsigned char *>(address);
+            record.code.assign(begin, begin + length);
+        }
+        queue_.push(std::move(record));
+    }
+
+    bool PerfMapWriter::openJitdump() {
+#ifdef __linux__
+        const std::string path = options_.jitdump_dir + "/jit-" + std::to_string(pid_) + ".dump";
+        const int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+        if (fd < 0) {
+            log_->error("perf map: failed to create {}: {}", path, std::strerror(errno));
+            return false;
+        }
+        jitdump_ = fdopen(fd, "wb");
+        if (!jitdump_) {
+            close(fd);
+            return false;
+        }
+        std::setvbuf(jitdump_, nullptr, _IOFBF, 1 << 20);
+        const JitdumpHeader header{
+            JITDUMP_MAGIC, JITDUMP_VERSION, sizeof(JitdumpHeader), elfMachine(), 0, pid_, monotonicNanos(), 0
+        };
+        std::fwrite(&header, sizeof(header), 1, jitdump_);
+        std::fflush(jitdump_);
+        // perf 通过进程对 jitdump 文件的可执行映射（PERF_RECORD_MMAP）找到文件，映射本身不会被访问
+        jitdump_marker_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        jitdump_marker_ = mmap(nullptr, jitdump_marker_size_, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+        if (jitdump_marker_ == MAP_FAILED) {
+            jitdump_marker_ = nullptr;
+            log_->warn("perf map: failed to map {}, perf record will not find it", path);
+        }
+        log_->info("perf map: writing jitdump to {}", path);
+        return true;
+#else
+        log_->warn("perf map: jitdump is only supported on Linux");
+        return false;
+#endif
+    }
+
+    void PerfMapWriter::closeJitdump() {
+        if (!jitdump_) return;
+        const JitdumpRecordHeader close_record{JIT_CODE_CLOSE, sizeof(JitdumpRecordHeader), monotonicNanos()};
+        std::fwrite(&close_record, sizeof(close_record), 1, jitdump_);
+        std::fclose(jitdump_);
+        jitdump_ = nullptr;
+#ifdef __linux__
+        if (jitdump_marker_) munmap(jitdump_marker_, jitdump_marker_size_);
+#endif
+        jitdump_marker_ = nullptr;
+    }
+
+    bool PerfMapWriter::start() {
+        if (running_.load()) return true;
+        if (options_.perf_map) {
+            const std::string path = mapPath(pid_);
+            map_ = std::fopen(path.c_str(), "w");
+            if (!map_) {
+                log_->error("perf map: failed to create {}: {}", path, std::strerror(errno));
+            } else {
+                std::setvbuf(map_, nullptr, _IOFBF, 256 * 1024);
+                log_->info("perf map: writing symbols to {}", path);
+            }
+        }
+        if (!options_.jitdump_dir.empty() && !openJitdump()) {
+            options_.jitdump_dir.clear();
+        }
+        if (!map_ && !jitdump_) return false;
+        running_.store(true, std::memory_order_release);
+        worker_ = std::thread(&PerfMapWriter::loop, this);
+        return true;
+    }
+
+    void PerfMapWriter::stop() {
+        if (!running_.exchange(false)) return;
+        if (worker_.joinable()) worker_.join();
+        // 停止后仍在执行的回调可能再放入少量记录
+        Record record;
+        while (queue_.pop(record)) write(record);
+        flush();
+        log_->info("perf map: methods={} stubs={} unloads={}", methods_written_, stubs_written_, unloads_.load());
+        if (map_) {
+            std::fclose(map_);
+            map_ = nullptr;
+        }
+        closeJitdump();
+    }
+
+    void PerfMapWriter::write(const Record &record) {
+        if (map_) {
+            std::fprintf(map_, "%llx %llx %s\n", static_cast<unsigned long long>(record.address),
+                         static_cast<unsigned long long>(record.size), record.name.c_str());
+        }
+        if (jitdump_) {
+            const auto name_size = static_cast<uint32_t>(record.name.size() + 1);
+            JitdumpCodeLoad load{};
+            load.header.id = JIT_CODE_LOAD;
+            load.header.total_size = static_cast<uint32_t>(sizeof(load) + name_size + record.code.size());
+            load.header.timestamp = record.timestamp;
+            load.pid = pid_;
+            load.tid = record.tid;
+            load.vma = record.address;
+            load.code_addr = record.address;
+            load.code_size = record.code.size();
+            load.code_index = code_index_++;
+            std::fwrite(&load, sizeof(load), 1, jitdump_);
+            std::fwrite(record.name.c_str(), name_size, 1, jitdump_);
+            if (!record.code.empty()) std::fwrite(record.code.data(), record.code.size(), 1, jitdump_);
+        }
+        if (record.kind == Record::Kind::Method) {
+            ++methods_written_;
+        } else {
+            ++stubs_written_;
+        }
+        Metrics::global().add(Counter::PerfMapRecords);
+        dirty_ = true;
+    }
+
+    void PerfMapWriter::flush() {
+        if (!dirty_) return;
+        if (map_) std::fflush(map_);
+        if (jitdump_) std::fflush(jitdump_);
+        dirty_ = false;
+    }
+
+    void PerfMapWriter::loop() {
+        auto last_flush = std::chrono::steady_clock::now();
+        Record record;
+        while (running_.load(std::memory_order_acquire)) {
+            // 空闲 100ms 或距上次刷新超过 flush_interval 时刷新；编译风暴期间按批写入
+            if (queue_.pop(record, std::chrono::milliseconds(100))) {
+                write(record);
+                if (std::chrono::steady_clock::now() - last_flush < options_.flush_interval) continue;
+            }
+            flush();
+            last_flush = std::chrono::steady_clock::now();
+        }
+    }
+} // jvmti_tools
@@ -0,0 +1,100 @@
+#ifndef PERFMAP_H
+#define PERFMAP_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <jvmti.h>
+
+#include "BlockingQueue.h"
+#include "MethodResolver.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct PerfMapOptions {
+        bool perf_map = false; // 写入 /tmp/perf-<pid>.map
+        std::string jitdump_dir; // 非空时在该目录写入 jit-<pid>.dump（perf inject --jit 使用）
+        std::chrono::milliseconds flush_interval{1000}; // 写入线程空闲时刷新文件的间隔
+    };
+
+    // JIT 代码符号导出，供 Linux perf 解析 Java 帧：
+    // CompiledMethodLoad / DynamicCodeGenerated 回调中解析方法名（jmethodID 名称有缓存）、复制机器码（仅 jitdump），
+    // 放入队列即返回；后台线程按批写入带缓冲的文件，队列空闲时刷新。
+    // perf-<pid>.map 格式为每行 "起始地址 长度 名称"（十六进制），没有卸载记录，地址被复用时以后写入的为准；
+    // jitdump 带单调时钟时间戳，perf 按时间区分同一地址上先后加载的代码，需要 perf record -k mono。
+    // 后台线程不附加到 JVM、不调用 JNI/JVMTI
+    class PerfMapWriter {
+    private:
+        struct Record {
+            enum class Kind : uint8_t { Method, Stub } kind = Kind::Method;
+            uint64_t address = 0;
+            uint64_t size = 0;
+            uint64_t timestamp = 0;
+            uint32_t tid = 0;
+            std::string name;
+            std::vector<unsigned char> code; // 仅 jitdump
+        };
+
+        jvmtiEnv *jvmti_;
+        PerfMapOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        MethodResolver methods_;
+        BlockingQueue<Record> queue_;
+        uint32_t pid_;
+
+        // 以下仅由写入线程（或停止后的调用线程）访问
+        FILE *map_ = nullptr;
+        FILE *jitdump_ = nullptr;
+        void *jitdump_marker_ = nullptr; // jitdump 文件的可执行映射，perf record 据此记录文件路径
+        size_t jitdump_marker_size_ = 0;
+        uint64_t code_index_ = 0;
+        bool dirty_ = false;
+        uint64_t methods_written_ = 0;
+        uint64_t stubs_written_ = 0;
+
+        std::atomic<uint64_t> unloads_{0};
+
+        std::atomic<bool> running_{false};
+        std::thread worker_;
+
+        bool openJitdump();
+
+        void closeJitdump();
+
+        void write(const Record &record);
+
+        void flush();
+
+        void loop();
+
+    public:
+        PerfMapWriter(jvmtiEnv *jvmti, const PerfMapOptions &options, std::shared_ptr<spdlog::logger> log);
+
+        ~PerfMapWriter();
+
+        PerfMapWriter(const PerfMapWriter &) = delete;
+
+        PerfMapWriter &operator=(const PerfMapWriter &) = delete;
+
+        // CompiledMethodLoad / CompiledMethodUnload / DynamicCodeGenerated 回调中调用
+        void compiledMethodLoad(jmethodID method, jint code_size, const void *code_addr);
+
+        void compiledMethodUnload(jmethodID method, const void *code_addr);
+
+        void dynamicCodeGenerated(const char *name, const void *address, jint length);
+
+        // 创建文件并启动写入线程
+        bool start();
+
+        // 结束写入线程，写入剩余记录后关闭文件
+        void stop();
+
+        static std::string mapPath(uint32_t pid);
+    };
+} // jvmti_tools
+
+#endif //PERFMAP_H
@@ -0,0 +1,283 @@
+#include "Probe.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace jvmti_tools {
+    namespace {
+        // 单个字段类型描述符：基本类型、L...; 或数组
+        bool isFieldDescriptor(const std::string_view descriptor) {
+            size_t i = 0;
+            while (i < descriptor.size() && descriptor[i] == '[') ++i;
+            if (i >= descriptor.size()) return false;
+            if (descriptor[i] == 'L') {
+                return descriptor.size() > i + 2 && descriptor.back() == ';'
+                       && descriptor.find(';', i) == descriptor.size() - 1;
+            }
+            return i + 1 == descriptor.size() && std::string_view("ZBCSIJFD").find(descriptor[i]) != std::string_view::npos;
+        }
+
+        // 无法解析时 error 写入原因
+        std::optional<ProbeTarget> parseTarget(const std::string_view member, std::string &error) {
+            ProbeTarget target;
+            if (const size_t paren = member.find('('); paren != std::string_view::npos) {
+                // 仅支持无参静态方法
+                if (member.substr(paren, 2) != "()") {
+                    error = "method " + std::string(member) + " must take no arguments";
+                    return std::nullopt;
+                }
+                target.kind = ProbeTarget::Kind::Method;
+                target.name = std::string(member.substr(0, paren));
+                if (const auto returns = member.substr(paren + 2); !returns.empty()) {
+                    target.descriptor = std::string(returns);
+                }
+            } else {
+                const size_t colon = member.find(':');
+                target.name = std::string(member.substr(0, colon));
+                if (colon != std::string_view::npos) target.descriptor = std::string(member.substr(colon + 1));
+            }
+            if (target.name.empty()) {
+                error = "member " + std::string(member) + " has no name";
+                return std::nullopt;
+            }
+            if (!isFieldDescriptor(target.descriptor)) {
+                error = "invalid type descriptor " + target.descriptor + " in " + std::string(member);
+                return std::nullopt;
+            }
+            return target;
+        }
+
+        std::string memberName(const ProbeTarget &target) {
+            return target.kind == ProbeTarget::Kind::Method ? target.name + "()" : target.name;
+        }
+
+        std::string key(const std::string_view class_name, const std::string_view member) {
+            std::string result;
+            result.reserve(class_name.size() + member.size() + 1);
+            result.append(class_name).append("#").append(member);
+            return result;
+        }
+
+        // 取出并清除挂起的异常，返回异常类名
+        std::string takeException(JNIEnv *jni) {
+            jthrowable exception = jni->ExceptionOccurred();
+            jni->ExceptionClear();
+            if (!exception) return "exception";
+            std::string name = "exception";
+            const jclass type = jni->GetObjectClass(exception);
+            const jclass class_type = jni->FindClass("java/lang/Class");
+            if (type && class_type) {
+                if (const jmethodID get_name = jni->GetMethodID(class_type, "getName", "()Ljava/lang/String;")) {
+                    if (const auto value = static_cast<jstring>(jni->CallObjectMethod(type, get_name))) {
+                        if (const char *chars = jni->GetStringUTFChars(value, nullptr)) {
+                            name = chars;
+                            jni->ReleaseStringUTFChars(value, chars);
+                        }
+                        jni->DeleteLocalRef(value);
+                    }
+                }
+            }
+            if (jni->ExceptionCheck()) jni->ExceptionClear();
+            if (class_type) jni->DeleteLocalRef(class_type);
+            if (type) jni->DeleteLocalRef(type);
+            jni->DeleteLocalRef(exception);
+            return name;
+        }
+
+        // 对象转字符串：String 直接读取，其余调用 toString()；会释放传入的局部引用
+        bool stringify(JNIEnv *jni, jobject object, std::string &out) {
+            if (!object) {
+                out = "null";
+                return true;
+            }
+            auto text = static_cast<jstring>(nullptr);
+            const jclass string_type = jni->FindClass("java/lang/String");
+            if (string_type && jni->IsInstanceOf(object, string_type)) {
+                text = static_cast<jstring>(jni->NewLocalRef(object));
+            } else if (const jclass object_type = jni->FindClass("java/lang/Object")) {
+                if (const jmethodID to_string = jni->GetMethodID(object_type, "toString", "()Ljava/lang/String;")) {
+                    text = static_cast<jstring>(jni->CallObjectMethod(object, to_string));
+                }
+                jni->DeleteLocalRef(object_type);
+            }
+            if (string_type) jni->DeleteLocalRef(string_type);
+            jni->DeleteLocalRef(object);
+            if (jni->ExceptionCheck()) {
+                out = takeException(jni);
+                return false;
+            }
+            if (!text) {
+                out = "null";
+                return true;
+            }
+            if (const char *chars = jni->GetStringUTFChars(text, nullptr)) {
+                out = chars;
+                jni->ReleaseStringUTFChars(text, chars);
+            }
+            jni->DeleteLocalRef(text);
+            return true;
+        }
+
+        bool readField(JNIEnv *jni, const jclass klass, const ProbeTarget &target, std::string &out) {
+            const jfieldID field = jni->GetStaticFieldID(klass, target.name.c_str(), target.descriptor.c_str());
+            if (!field) {
+                takeException(jni); // NoSuchFieldError
+                out = "field not found";
+                return false;
+            }
+            switch (target.descriptor.front()) {
+                case 'Z': out = jni->GetStaticBooleanField(klass, field) ? "true" : "false"; return true;
+                case 'B': out = std::to_string(jni->GetStaticByteField(klass, field)); return true;
+                case 'C': out = std::to_string(jni->GetStaticCharField(klass, field)); return true;
+                case 'S': out = std::to_string(jni->GetStaticShortField(klass, field)); return true;
+                case 'I': out = std::to_string(jni->GetStaticIntField(klass, field)); return true;
+                case 'J': out = std::to_string(jni->GetStaticLongField(klass, field)); return true;
+                case 'F': out = std::to_string(jni->GetStaticFloatField(klass, field)); return true;
+                case 'D': out = std::to_string(jni->GetStaticDoubleField(klass, field)); return true;
+                default: return stringify(jni, jni->GetStaticObjectField(klass, field), out);
+            }
+        }
+
+        bool callMethod(JNIEnv *jni, const jclass klass, const ProbeTarget &target, std::string &out) {
+            const std::string signature = "()" + target.descriptor;
+            const jmethodID method = jni->GetStaticMethodID(klass, target.name.c_str(), signature.c_str());
+            if (!method) {
+                takeException(jni); // NoSuchMethodError
+                out = "method not found";
+                return false;
+            }
+            switch (target.descriptor.front()) {
+                case 'Z': out = jni->CallStaticBooleanMethod(klass, method) ? "true" : "false"; break;
+                case 'B': out = std::to_string(jni->CallStaticByteMethod(klass, method)); break;
+                case 'C': out = std::to_string(jni->CallStaticCharMethod(klass, method)); break;
+                case 'S': out = std::to_string(jni->CallStaticShortMethod(klass, method)); break;
+                case 'I': out = std::to_string(jni->CallStaticIntMethod(klass, method)); break;
+                case 'J': out = std::to_string(jni->CallStaticLongMethod(klass, method)); break;
+                case 'F': out = std::to_string(jni->CallStaticFloatMethod(klass, method)); break;
+                case 'D': out = std::to_string(jni->CallStaticDoubleMethod(klass, method)); break;
+                default: {
+                    jobject result = jni->CallStaticObjectMethod(klass, method);
+                    if (jni->ExceptionCheck()) {
+                        if (result) jni->DeleteLocalRef(result);
+                        out = takeException(jni);
+                        return false;
+                    }
+                    return stringify(jni, result, out);
+                }
+            }
+            if (jni->ExceptionCheck()) {
+                out = takeException(jni);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    std::optional<ProbeRule> ProbeRule::parse(const std::string_view rule, std::string *error) {
+        std::string reason;
+        const auto fail = [&](std::string message) -> std::optional<ProbeRule> {
+            if (error) *error = std::move(message);
+            return std::nullopt;
+        };
+        const size_t hash = rule.find('#');
+        if (hash == std::string_view::npos) return fail("missing '#' between class and member list");
+        if (hash == 0) return fail("missing class name");
+
+        ProbeRule result;
+        std::string class_name(rule.substr(0, hash));
+        std::replace(class_name.begin(), class_name.end(), '.', '/');
+        result.signature = class_name.front() == 'L' && class_name.back() == ';' ? class_name : "L" + class_name + ";";
+
+        const std::string_view members = rule.substr(hash + 1);
+        size_t start = 0;
+        while (start <= members.size()) {
+            const size_t end = std::min(members.find('|', start), members.size());
+            if (const auto member = members.substr(start, end - start); !member.empty()) {
+                auto target = parseTarget(member, reason);
+                if (!target) return fail(std::move(reason));
+                result.targets.push_back(std::move(*target));
+            }
+            start = end + 1;
+        }
+        if (result.targets.empty()) return fail("missing field or method list");
+        return result;
+    }
+
+    ProbeRules::ProbeRules(const std::vector<std::string> &rules, std::vector<InvalidProbeRule> *invalid) {
+        for (const auto &value: rules) {
+            std::string reason;
+            auto rule = ProbeRule::parse(value, &reason);
+            if (!rule) {
+                if (invalid) invalid->push_back({value, std::move(reason)});
+                continue;
+            }
+            // 同一类的多条规则合并
+            auto &targets = rules_[rule->signature];
+            for (auto &target: rule->targets) targets.push_back(std::move(target));
+        }
+    }
+
+    const std::vector<ProbeTarget> *ProbeRules::find(const std::string_view signature) const {
+        const auto it = rules_.find(signature);
+        return it == rules_.end() ? nullptr : &it->second;
+    }
+
+    std::vector<ProbeValue> ProbeTable::capture(JNIEnv *jni, const jclass klass, std::string_view signature,
+                                                const std::vector<ProbeTarget> &targets) {
+        if (signature.size() >= 2 && signature.front() == 'L' && signature.back() == ';') {
+            signature = signature.substr(1, signature.size() - 2);
+        }
+        std::vector<ProbeValue> captured;
+        captured.reserve(targets.size());
+        for (const auto &target: targets) {
+            ProbeValue value;
+            value.class_name = std::string(signature);
+            value.member = memberName(target);
+            value.ok = target.kind == ProbeTarget::Kind::Method
+                           ? callMethod(jni, klass, target, value.value)
+                           : readField(jni, klass, target, value.value);
+            value.captured_at = std::chrono::system_clock::now();
+            record(value);
+            captured.push_back(std::move(value));
+        }
+        return captured;
+    }
+
+    void ProbeTable::record(ProbeValue value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto k = key(value.class_name, value.member);
+        values_.insert_or_assign(std::move(k), std::move(value));
+    }
+
+    std::optional<ProbeValue> ProbeTable::find(const std::string_view class_name, const std::string_view member) const {
+        std::string name(class_name);
+        std::replace(name.begin(), name.end(), '.', '/');
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = values_.find(key(name, member));
+        if (it == values_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    std::vector<ProbeValue> ProbeTable::values() const {
+        std::vector<std::pair<std::string, ProbeValue> > sorted;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sorted.assign(values_.begin(), values_.end());
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        std::vector<ProbeValue> result;
+        result.reserve(sorted.size());
+        for (auto &entry: sorted) result.push_back(std::move(entry.second));
+        return result;
+    }
+
+    void ProbeTable::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        values_.clear();
+    }
+
+    ProbeTable &ProbeTable::global() {
+        static ProbeTable table;
+        return table;
+    }
+} // jvmti_tools
@@ -0,0 +1,93 @@
+#ifndef PROBE_H
+#define PROBE_H
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <jvmti.h>
+
+#include "Retransformer.h"
+
+namespace jvmti_tools {
+    // 探针目标：静态字段或无参静态方法，descriptor 为字段类型/方法返回类型
+    struct ProbeTarget {
+        enum class Kind { Field, Method };
+
+        Kind kind = Kind::Field;
+        std::string name;
+        std::string descriptor = "Ljava/lang/String;";
+    };
+
+    // 探针规则：class#member|member...
+    // - class 支持 '.' 或 '/' 分隔
+    // - 字段写作 NAME 或 NAME:descriptor，方法写作 name() 或 name()descriptor，类型省略时为 String
+    // 例如：probe=com.fr.general.GeneralUtils#readBuildNO()|getVersion()
+    struct ProbeRule {
+        std::string signature; // Lcom/fr/general/GeneralUtils;
+        std::vector<ProbeTarget> targets;
+
+        // 无法解析时返回空，error（可为空）写入原因
+        static std::optional<ProbeRule> parse(std::string_view rule, std::string *error = nullptr);
+    };
+
+    // 无法解析的探针规则及原因
+    struct InvalidProbeRule {
+        std::string rule;
+        std::string reason;
+    };
+
+    // 编译后的探针规则：以类签名为键的哈希表，未命中的类只需一次哈希查找
+    class ProbeRules {
+    private:
+        std::unordered_map<std::string, std::vector<ProbeTarget>, SignatureHash, std::equal_to<> > rules_;
+
+    public:
+        ProbeRules() = default;
+
+        // 无法解析的规则写入 invalid（可为空）
+        explicit ProbeRules(const std::vector<std::string> &rules, std::vector<InvalidProbeRule> *invalid = nullptr);
+
+        const std::vector<ProbeTarget> *find(std::string_view signature) const;
+
+        bool empty() const { return rules_.empty(); }
+
+        size_t size() const { return rules_.size(); }
+    };
+
+    // 采集结果
+    struct ProbeValue {
+        std::string class_name; // com/fr/general/GeneralUtils
+        std::string member; // 方法带 () 后缀
+        std::string value;
+        bool ok = false; // 失败时 value 为错误原因
+        std::chrono::system_clock::time_point captured_at;
+    };
+
+    // 采集结果表：按 class#member 保存最近一次的值，可在任意线程查询
+    class ProbeTable {
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, ProbeValue> values_;
+
+    public:
+        // 读取类的探针目标并写入结果表，返回本次采集的值
+        std::vector<ProbeValue> capture(JNIEnv *jni, jclass klass, std::string_view signature,
+                                        const std::vector<ProbeTarget> &targets);
+
+        void record(ProbeValue value);
+
+        std::optional<ProbeValue> find(std::string_view class_name, std::string_view member) const;
+
+        // 按 class#member 排序的全部结果
+        std::vector<ProbeValue> values() const;
+
+        void clear();
+
+        static ProbeTable &global();
+    };
+} // jvmti_tools
+
+#endif //PROBE_H
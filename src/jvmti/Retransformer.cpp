@@ -0,0 +1,185 @@
+#include "Retransformer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace jvmti_tools {
+    namespace {
+        // JVMTI 分配的内存在作用域结束时释放
+        class Deallocated {
+        private:
+            jvmtiEnv *jvmti_;
+            char *ptr_ = nullptr;
+
+        public:
+            explicit Deallocated(jvmtiEnv *jvmti): jvmti_(jvmti) {
+            }
+
+            ~Deallocated() { if (ptr_) jvmti_->Deallocate(reinterpret_cast<unsigned char *>(ptr_)); }
+
+            Deallocated(const Deallocated &) = delete;
+
+            Deallocated &operator=(const Deallocated &) = delete;
+
+            char **out() { return &ptr_; }
+
+            std::string_view view() const { return ptr_ ? std::string_view(ptr_) : std::string_view(); }
+        };
+
+        std::chrono::nanoseconds since(const std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        }
+
+        double millis(const std::chrono::nanoseconds value) {
+            return static_cast<double>(value.count()) / 1e6;
+        }
+    }
+
+    std::string Retransformer::toSignature(const std::string_view class_name) {
+        if (class_name.size() > 1 && class_name.front() == 'L' && class_name.back() == ';') {
+            return std::string(class_name);
+        }
+        std::string signature;
+        signature.reserve(class_name.size() + 2);
+        signature.push_back('L');
+        for (const char c: class_name) {
+            signature.push_back(c == '.' ? '/' : c);
+        }
+        signature.push_back(';');
+        return signature;
+    }
+
+    Retransformer::Retransformer(jvmtiEnv *jvmti, JNIEnv *jni, RetransformOptions options)
+        : jvmti_(jvmti), jni_(jni), options_(std::move(options)) {
+        if (options_.batch_size == 0) options_.batch_size = 1;
+        for (const auto &loader: options_.loaders) {
+            if (loader == "bootstrap") {
+                bootstrap_ = true;
+            } else if (!loader.empty()) {
+                loaders_.insert(toSignature(loader));
+            }
+        }
+    }
+
+    bool Retransformer::acceptLoader(const jclass klass) const {
+        if (jni_ == nullptr || (loaders_.empty() && !bootstrap_)) return true;
+
+        jobject loader = nullptr;
+        if (jvmti_->GetClassLoader(klass, &loader) != JVMTI_ERROR_NONE) return false;
+        if (loader == nullptr) return bootstrap_;
+
+        const jclass loader_class = jni_->GetObjectClass(loader);
+        Deallocated signature(jvmti_);
+        const bool accepted = jvmti_->GetClassSignature(loader_class, signature.out(), nullptr) == JVMTI_ERROR_NONE
+                              && loaders_.find(signature.view()) != loaders_.end();
+        jni_->DeleteLocalRef(loader_class);
+        jni_->DeleteLocalRef(loader);
+        return accepted;
+    }
+
+    void Retransformer::retransformBatch(const std::vector<jclass> &batch, const std::vector<std::string> &names,
+                                         RetransformResult &result, spdlog::logger &log) const {
+        const auto start = std::chrono::steady_clock::now();
+        const jvmtiError err = jvmti_->RetransformClasses(static_cast<jint>(batch.size()), batch.data());
+        if (err == JVMTI_ERROR_NONE) {
+            result.retransformed += batch.size();
+        } else {
+            // 批次失败时无法得知具体是哪个类出错，逐个重试
+            log.warn("Retransform batch failed ({}), retrying {} classes one by one",
+                     static_cast<int>(err), batch.size());
+            for (size_t i = 0; i < batch.size(); ++i) {
+                const jvmtiError class_err = jvmti_->RetransformClasses(1, &batch[i]);
+                if (class_err == JVMTI_ERROR_NONE) {
+                    ++result.retransformed;
+                } else {
+                    ++result.failed;
+                    log.error("Failed to retransform class {}: {}", names[i], static_cast<int>(class_err));
+                }
+            }
+        }
+
+        const auto elapsed = since(start);
+        result.max_batch = std::max(result.max_batch, elapsed);
+        ++result.batches;
+        log.debug("Retransform batch {}: {} classes in {:.2f}ms ({}/{})", result.batches, batch.size(),
+                  millis(elapsed), result.retransformed + result.failed, result.matched);
+    }
+
+    RetransformResult Retransformer::run(const std::unordered_set<std::string> &targets, spdlog::logger &log) const {
+        if (targets.empty()) return {};
+
+        SignatureSet signatures;
+        signatures.reserve(targets.size());
+        for (const auto &target: targets) {
+            signatures.insert(toSignature(target));
+        }
+        return run([&signatures](const std::string_view signature) {
+            return signatures.find(signature) != signatures.end();
+        }, log);
+    }
+
+    RetransformResult Retransformer::run(const std::function<bool(std::string_view signature)> &match,
+                                         spdlog::logger &log) const {
+        RetransformResult result;
+        const auto start = std::chrono::steady_clock::now();
+
+        jclass *classes = nullptr;
+        jint class_count = 0;
+        if (const jvmtiError err = jvmti_->GetLoadedClasses(&class_count, &classes); err != JVMTI_ERROR_NONE) {
+            log.error("Failed to get loaded classes: {}", static_cast<int>(err));
+            return result;
+        }
+        result.loaded = static_cast<size_t>(class_count);
+
+        // GetLoadedClasses 返回的是局部引用，类数量较多时不能全部留到附加线程返回：
+        // 未匹配的类立即释放，匹配的类在所属批次转换后释放
+        const auto release = [this](const jclass klass) {
+            if (jni_) jni_->DeleteLocalRef(klass);
+        };
+
+        // 筛选目标类：每个类的签名在本次迭代内释放
+        std::vector<jclass> matched;
+        std::vector<std::string> names;
+        for (jint i = 0; i < class_count; ++i) {
+            Deallocated signature(jvmti_);
+            if (jvmti_->GetClassSignature(classes[i], signature.out(), nullptr) != JVMTI_ERROR_NONE
+                || !match(signature.view())) {
+                release(classes[i]);
+                continue;
+            }
+
+            jboolean modifiable = JNI_FALSE;
+            jvmti_->IsModifiableClass(classes[i], &modifiable);
+            if (!modifiable || !acceptLoader(classes[i])) {
+                release(classes[i]);
+                continue;
+            }
+
+            log.trace("Found target class: {}", signature.view());
+            matched.push_back(classes[i]);
+            names.emplace_back(signature.view());
+        }
+        jvmti_->Deallocate(reinterpret_cast<unsigned char *>(classes));
+        result.matched = matched.size();
+
+        // 分批转换，限制单次 VM 停顿时长
+        std::vector<jclass> batch;
+        std::vector<std::string> batch_names;
+        batch.reserve(std::min(options_.batch_size, matched.size()));
+        for (size_t offset = 0; offset < matched.size(); offset += options_.batch_size) {
+            const size_t end = std::min(offset + options_.batch_size, matched.size());
+            batch.assign(matched.begin() + static_cast<ptrdiff_t>(offset),
+                         matched.begin() + static_cast<ptrdiff_t>(end));
+            batch_names.assign(names.begin() + static_cast<ptrdiff_t>(offset),
+                               names.begin() + static_cast<ptrdiff_t>(end));
+            retransformBatch(batch, batch_names, result, log);
+            for (const jclass klass: batch) release(klass);
+        }
+
+        result.elapsed = since(start);
+        log.info("Retransformed {}/{} classes ({} failed, {} loaded) in {} batches, total {:.2f}ms, "
+                 "max batch {:.2f}ms", result.retransformed, result.matched, result.failed, result.loaded,
+                 result.batches, millis(result.elapsed), millis(result.max_batch));
+        return result;
+    }
+} // jvmti_tools
@@ -0,0 +1,72 @@
+#ifndef RETRANSFORMER_H
+#define RETRANSFORMER_H
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <jvmti.h>
+
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    // 类名查找表：以类签名（Lcom/example/Foo;）为键，支持 string_view 直接查找
+    struct SignatureHash {
+        using is_transparent = void;
+
+        size_t operator()(const std::string_view value) const { return std::hash<std::string_view>{}(value); }
+    };
+
+    using SignatureSet = std::unordered_set<std::string, SignatureHash, std::equal_to<> >;
+
+    struct RetransformOptions {
+        size_t batch_size = 256; // 单次 RetransformClasses 的类数量上限，控制每次停顿时长
+        // 类加载器过滤：加载器类名（'.' 或 '/' 分隔），"bootstrap" 表示启动类加载器；为空表示不过滤
+        std::vector<std::string> loaders;
+    };
+
+    struct RetransformResult {
+        size_t loaded = 0; // 已加载类数量
+        size_t matched = 0; // 命中目标的类数量
+        size_t retransformed = 0; // 转换成功的类数量
+        size_t failed = 0; // 转换失败的类数量
+        size_t batches = 0;
+        std::chrono::nanoseconds elapsed{0}; // 总耗时
+        std::chrono::nanoseconds max_batch{0}; // 单批次最长耗时
+    };
+
+    // 增量类转换：
+    // 1. 已加载类的签名经哈希表查找，复杂度 O(N)
+    // 2. 命中的类再按类加载器过滤，并跳过不可修改的类
+    // 3. 按批次调用 RetransformClasses，批次失败时逐个重试，单个类失败不影响其余类
+    class Retransformer {
+    private:
+        jvmtiEnv *jvmti_;
+        JNIEnv *jni_; // 用于类加载器过滤与释放类的局部引用，可为 nullptr（此时忽略加载器过滤）
+        RetransformOptions options_;
+        SignatureSet loaders_; // 加载器类签名
+        bool bootstrap_ = false; // 是否包含启动类加载器
+
+        bool acceptLoader(jclass klass) const;
+
+        void retransformBatch(const std::vector<jclass> &batch, const std::vector<std::string> &names,
+                              RetransformResult &result, spdlog::logger &log) const;
+
+    public:
+        Retransformer(jvmtiEnv *jvmti, JNIEnv *jni, RetransformOptions options = {});
+
+        // targets 为内部类名（com/example/Foo）
+        RetransformResult run(const std::unordered_set<std::string> &targets, spdlog::logger &log) const;
+
+        // 按类签名（Lcom/example/Foo;）筛选已加载类，用于尚未记录目标类时按规则选择
+        RetransformResult run(const std::function<bool(std::string_view signature)> &match,
+                              spdlog::logger &log) const;
+
+        // 类名转为类签名：com.example.Foo / com/example/Foo -> Lcom/example/Foo;
+        static std::string toSignature(std::string_view class_name);
+    };
+} // jvmti_tools
+
+#endif //RETRANSFORMER_H
@@ -0,0 +1,24 @@
+#include "StackTable.h"
+
+namespace jvmti_tools {
+    uint64_t StackTable::intern(const jvmtiFrameInfo *frames, const jint depth) {
+        if (depth <= 0) return 0;
+        uint64_t id = 1;
+        for (jint i = 0; i < depth; ++i) {
+            id = combineHash(combineHash(id, reinterpret_cast<uintptr_t>(frames[i].method)),
+                             static_cast<uint64_t>(frames[i].location));
+        }
+        if (id == 0) id = 1;
+        const bool stored = known_.add(id, 1, [&](uint8_t &) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frames_.try_emplace(id, frames, frames + depth);
+        });
+        return stored ? id : 0;
+    }
+
+    std::vector<jvmtiFrameInfo> StackTable::frames(const uint64_t id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto it = frames_.find(id); it != frames_.end()) return it->second;
+        return {};
+    }
+} // jvmti_tools
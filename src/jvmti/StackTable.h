@@ -0,0 +1,36 @@
+#ifndef STACKTABLE_H
+#define STACKTABLE_H
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <jvmti.h>
+
+#include "CounterTable.h"
+
+namespace jvmti_tools {
+    // 调用栈驻留表：相同调用栈只保存一份帧数据，以栈哈希作为编号。
+    // 已出现过的调用栈只需一次无锁查找；首次出现时才在锁内复制帧数据
+    class StackTable {
+    private:
+        CounterTable<uint8_t> known_;
+        mutable std::mutex mutex_;
+        std::unordered_map<uint64_t, std::vector<jvmtiFrameInfo> > frames_;
+
+    public:
+        explicit StackTable(const size_t capacity): known_(capacity) {
+        }
+
+        // 返回栈编号（非 0）；depth 为 0 或表已满时返回 0
+        uint64_t intern(const jvmtiFrameInfo *frames, jint depth);
+
+        // 栈顶在前
+        std::vector<jvmtiFrameInfo> frames(uint64_t id) const;
+
+        size_t size() const { return known_.size(); }
+
+        uint64_t dropped() const { return known_.dropped(); }
+    };
+} // jvmti_tools
+
+#endif //STACKTABLE_H
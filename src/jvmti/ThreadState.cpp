@@ -0,0 +1,64 @@
+#include "ThreadState.h"
+
+namespace jvmti_tools {
+    namespace {
+        // 线程已结束的标记：release 后留在线程本地存储中，之后其他线程（采样线程）不会再为该线程创建状态
+        char ended_marker;
+        void *const ENDED = &ended_marker;
+    }
+
+    ThreadState *ThreadStates::get(jvmtiEnv *jvmti, const jthread thread) {
+        void *data = nullptr;
+        if (jvmti->GetThreadLocalStorage(thread, &data) != JVMTI_ERROR_NONE || data == ENDED) return nullptr;
+        if (data) return static_cast<ThreadState *>(data);
+
+        // 创建与 release 在同一把锁内读写线程本地存储：采样线程不会在线程结束之后装入状态，
+        // 否则该状态不会再归还空闲列表
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jvmti->GetThreadLocalStorage(thread, &data) != JVMTI_ERROR_NONE || data == ENDED) return nullptr;
+        if (data) return static_cast<ThreadState *>(data);
+
+        ThreadState *state = nullptr;
+        if (!free_.empty()) {
+            state = free_.back();
+            free_.pop_back();
+        } else {
+            state = states_.emplace_back(std::make_unique<ThreadState>()).get();
+        }
+        state->reset();
+        if (jvmti->SetThreadLocalStorage(thread, state) != JVMTI_ERROR_NONE) {
+            free_.push_back(state);
+            return nullptr;
+        }
+        return state;
+    }
+
+    ThreadState *ThreadStates::find(jvmtiEnv *jvmti, const jthread thread) {
+        void *data = nullptr;
+        if (jvmti->GetThreadLocalStorage(thread, &data) != JVMTI_ERROR_NONE || data == ENDED) return nullptr;
+        return static_cast<ThreadState *>(data);
+    }
+
+    void ThreadStates::release(jvmtiEnv *jvmti, const jthread thread) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        void *data = nullptr;
+        if (jvmti->GetThreadLocalStorage(thread, &data) != JVMTI_ERROR_NONE || data == ENDED) return;
+        jvmti->SetThreadLocalStorage(thread, ENDED);
+        if (data) free_.push_back(static_cast<ThreadState *>(data));
+    }
+
+    size_t ThreadStates::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return states_.size() - free_.size();
+    }
+
+    size_t ThreadStates::capacity() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return states_.size();
+    }
+
+    ThreadStates &ThreadStates::global() {
+        static ThreadStates states;
+        return states;
+    }
+} // jvmti_tools
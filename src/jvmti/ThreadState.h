@@ -0,0 +1,78 @@
+#ifndef THREADSTATE_H
+#define THREADSTATE_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <jvmti.h>
+
+namespace jvmti_tools {
+    // 方法调用记录（方法耗时跟踪）
+    struct MethodCall {
+        jmethodID method{};
+        std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
+    };
+
+    // 线程级代理状态。监视器、方法跟踪字段仅由所属线程在事件回调中读写；
+    // 采样字段由采样线程读写，线程结束后状态可能被复用，因此使用原子变量
+    struct ThreadState {
+        int64_t contended_since = 0; // 进入 MonitorContendedEnter 的时间（纳秒），0 表示未在等待
+        uint32_t contended_site = 0;
+        int64_t wait_since = 0; // 进入 Object.wait 的时间
+        uint32_t wait_site = 0;
+
+        std::string name; // 线程名缓存，按需读取
+        std::vector<MethodCall> call_stack;
+
+        std::atomic<int64_t> cpu_time{-1}; // 上一次采样的线程 CPU 时间，-1 表示尚未采样
+        std::atomic<uint64_t> cpu_window{0}; // 当前报告周期内累计的 CPU 时间
+        std::atomic<uint8_t> sample_filter{0}; // 墙钟采样线程名过滤结果缓存：0 未判断，1 采样，2 忽略
+
+        // 复用前清空，保留字符串与调用栈已分配的容量
+        void reset() {
+            contended_since = 0;
+            wait_since = 0;
+            name.clear();
+            call_stack.clear();
+            cpu_time.store(-1, std::memory_order_relaxed);
+            cpu_window.store(0, std::memory_order_relaxed);
+            sample_filter.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // 线程状态登记：状态指针保存在 JVMTI 线程本地存储中（SetThreadLocalStorage），每次事件只需一次
+    // GetThreadLocalStorage；不使用 C++ thread_local，虚拟线程在不同载体线程上调度时状态跟随虚拟线程，
+    // 热卸载后也不会在线程退出时执行已卸载的析构代码。
+    // 所有状态由登记表持有，ThreadEnd / VirtualThreadEnd 时归还空闲列表而不释放内存：
+    // 状态数量只随同时存活的线程数增长，大量短生命周期的虚拟线程不会使内存持续增长；
+    // 采样线程跨越线程结束持有的指针也始终有效
+    class ThreadStates {
+    private:
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<ThreadState> > states_;
+        std::vector<ThreadState *> free_;
+
+    public:
+        // 返回线程的状态，首次访问时创建（可在其他线程上为 thread 创建）；失败或线程已结束（release 之后）时返回 nullptr
+        ThreadState *get(jvmtiEnv *jvmti, jthread thread);
+
+        // 只查找不创建
+        static ThreadState *find(jvmtiEnv *jvmti, jthread thread);
+
+        // ThreadEnd / VirtualThreadEnd 事件中调用，可重复调用；之后该线程不再创建状态
+        void release(jvmtiEnv *jvmti, jthread thread);
+
+        // 正在使用的状态数量
+        size_t size() const;
+
+        // 已分配的状态数量（包括空闲列表）
+        size_t capacity() const;
+
+        static ThreadStates &global();
+    };
+} // jvmti_tools
+
+#endif //THREADSTATE_H
@@ -0,0 +1,193 @@
+#include "WallSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "ThreadState.h"
+
+namespace jvmti_tools {
+    namespace {
+        constexpr uint8_t FILTER_UNKNOWN = 0;
+        constexpr uint8_t FILTER_SAMPLED = 1;
+        constexpr uint8_t FILTER_IGNORED = 2;
+
+        double micros(const uint64_t nanos) {
+            return static_cast<double>(nanos) / 1e3;
+        }
+    }
+
+    WallSampler::WallSampler(jvmtiEnv *jvmti, const WallSamplerOptions &options, std::shared_ptr<spdlog::logger> log)
+        : jvmti_(jvmti), options_(options), log_(std::move(log)), traces_(options.capacity),
+          stacks_(options.capacity), methods_(jvmti), interval_ms_(options.interval.count()) {
+        options_.stack_depth = std::clamp<uint32_t>(options_.stack_depth, 1, MAX_STACK_DEPTH);
+        options_.max_interval = std::max(options_.max_interval, options_.interval);
+        options_.budget = std::clamp(options_.budget, 0.001, 1.0);
+    }
+
+    const char *WallSampler::stateName(const State state) {
+        switch (state) {
+            case State::Runnable: return "RUNNABLE";
+            case State::Blocked: return "BLOCKED";
+            case State::Waiting: return "WAITING";
+            case State::TimedWaiting: return "TIMED_WAITING";
+            default: return "UNKNOWN";
+        }
+    }
+
+    bool WallSampler::stateOf(const jint thread_state, State *state) {
+        // 与 java.lang.Thread.State 的划分一致，未启动或已结束的线程不计入
+        if ((thread_state & JVMTI_THREAD_STATE_ALIVE) == 0) return false;
+        if (thread_state & JVMTI_THREAD_STATE_BLOCKED_ON_MONITOR_ENTER) {
+            *state = State::Blocked;
+        } else if (thread_state & JVMTI_THREAD_STATE_WAITING_WITH_TIMEOUT) {
+            *state = State::TimedWaiting;
+        } else if (thread_state & JVMTI_THREAD_STATE_WAITING) {
+            *state = State::Waiting;
+        } else if (thread_state & JVMTI_THREAD_STATE_RUNNABLE) {
+            *state = State::Runnable;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool WallSampler::selected(JNIEnv *jni, const jthread thread) {
+        // 线程名只在首次遇到时读取，结果缓存在线程状态中
+        ThreadState *state = ThreadStates::global().get(jvmti_, thread);
+        if (state) {
+            if (const uint8_t cached = state->sample_filter.load(std::memory_order_relaxed);
+                cached != FILTER_UNKNOWN) {
+                return cached == FILTER_SAMPLED;
+            }
+        }
+        jvmtiThreadInfo info{};
+        if (jvmti_->GetThreadInfo(thread, &info) != JVMTI_ERROR_NONE) return false;
+        const std::string_view name = info.name ? info.name : "";
+        const bool matched = std::any_of(options_.threads.begin(), options_.threads.end(),
+                                         [&](const std::string &prefix) { return name.starts_with(prefix); });
+        jvmti_->Deallocate(reinterpret_cast<unsigned char *>(info.name));
+        if (info.thread_group) jni->DeleteLocalRef(info.thread_group);
+        if (info.context_class_loader) jni->DeleteLocalRef(info.context_class_loader);
+        if (state) state->sample_filter.store(matched ? FILTER_SAMPLED : FILTER_IGNORED, std::memory_order_relaxed);
+        return matched;
+    }
+
+    std::chrono::milliseconds WallSampler::sample(JNIEnv *jni) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto depth = static_cast<jint>(options_.stack_depth);
+        jvmtiStackInfo *infos = nullptr;
+        jint count = 0;
+        if (options_.threads.empty()) {
+            if (jvmti_->GetAllStackTraces(depth, &infos, &count) != JVMTI_ERROR_NONE) infos = nullptr;
+        } else {
+            jint total = 0;
+            jthread *threads = nullptr;
+            if (jvmti_->GetAllThreads(&total, &threads) == JVMTI_ERROR_NONE) {
+                selected_.clear();
+                for (jint i = 0; i < total; ++i) {
+                    if (selected(jni, threads[i])) selected_.push_back(threads[i]);
+                }
+                count = static_cast<jint>(selected_.size());
+                if (count > 0 && jvmti_->GetThreadListStackTraces(count, selected_.data(), depth, &infos) !=
+                    JVMTI_ERROR_NONE) {
+                    infos = nullptr;
+                }
+                for (jint i = 0; i < total; ++i) jni->DeleteLocalRef(threads[i]);
+                jvmti_->Deallocate(reinterpret_cast<unsigned char *>(threads));
+            }
+        }
+
+        if (infos) {
+            for (jint i = 0; i < count; ++i) {
+                const jvmtiStackInfo &info = infos[i];
+                State state;
+                // 没有 Java 栈帧的线程（包括采样线程自身）不计入
+                if (info.frame_count > 0 && stateOf(info.state, &state)) {
+                    if (const uint64_t stack = stacks_.intern(info.frame_buffer, info.frame_count)) {
+                        const uint64_t key = combineHash(mixHash(stack), static_cast<uint64_t>(state));
+                        traces_.add(key, 1, [&](Trace &trace) {
+                            trace.state = state;
+                            trace.stack = stack;
+                        });
+                        states_[static_cast<size_t>(state)].fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (info.thread) jni->DeleteLocalRef(info.thread);
+            }
+            // 帧缓冲区与 jvmtiStackInfo 数组在同一块内存中
+            jvmti_->Deallocate(reinterpret_cast<unsigned char *>(infos));
+        }
+        passes_.fetch_add(1, std::memory_order_relaxed);
+
+        const auto cost = std::chrono::steady_clock::now() - start;
+        cost_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count()));
+        adapt(cost);
+        return std::chrono::milliseconds(interval_ms_.load(std::memory_order_relaxed));
+    }
+
+    void WallSampler::adapt(const std::chrono::nanoseconds cost) {
+        const int64_t current = interval_ms_.load(std::memory_order_relaxed);
+        const double allowed = options_.budget * static_cast<double>(current) * 1e6;
+        const auto nanos = static_cast<double>(cost.count());
+        int64_t next = current;
+        if (nanos > allowed) {
+            // 线程多时单次采样变慢：拉长间隔使采样耗时回到预算之内
+            next = std::min<int64_t>(options_.max_interval.count(),
+                                     static_cast<int64_t>(std::ceil(nanos / options_.budget / 1e6)));
+        } else if (current > options_.interval.count() && nanos * 2 < allowed) {
+            next = std::max<int64_t>(options_.interval.count(), current * 3 / 4);
+        }
+        if (next == current) return;
+        interval_ms_.store(next, std::memory_order_relaxed);
+        if (log_) log_->debug("Wall-clock sampling interval {}ms -> {}ms (cost {:.0f}us)", current, next, nanos / 1e3);
+    }
+
+    void WallSampler::report(JNIEnv *jni, const size_t top) const {
+        if (!log_) return;
+        struct Row {
+            uint64_t count;
+            Trace trace;
+        };
+        std::vector<Row> rows;
+        rows.reserve(traces_.size());
+        traces_.forEach([&](uint64_t, const uint64_t count, const Trace &trace) { rows.push_back({count, trace}); });
+        const size_t shown = std::min(top, rows.size());
+        std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(shown), rows.end(),
+                          [](const Row &a, const Row &b) { return a.count > b.count; });
+
+        uint64_t total = 0;
+        for (const auto &state: states_) total += state.load(std::memory_order_relaxed);
+        const auto percent = [total](const uint64_t n) {
+            return total == 0 ? 0.0 : static_cast<double>(n) * 100.0 / static_cast<double>(total);
+        };
+        const auto samples = [this](const State state) {
+            return states_[static_cast<size_t>(state)].load(std::memory_order_relaxed);
+        };
+        log_->info("Wall-clock profile: passes={} samples={} RUNNABLE={} BLOCKED={} WAITING={} TIMED_WAITING={} "
+                   "stacks={} dropped={}", passes_.load(std::memory_order_relaxed), total, samples(State::Runnable),
+                   samples(State::Blocked), samples(State::Waiting), samples(State::TimedWaiting), stacks_.size(),
+                   traces_.dropped() + stacks_.dropped());
+        log_->info("  sampling cost: p50<={:.0f}us p99<={:.0f}us max={:.0f}us interval={}ms", micros(cost_.percentile(0.5)),
+                   micros(cost_.percentile(0.99)), micros(cost_.max()), interval_ms_.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < shown; ++i) {
+            const auto &[count, trace] = rows[i];
+            log_->info("  #{:<2} {} samples ({:.1f}%) {}", i + 1, count, percent(count), stateName(trace.state));
+            for (const auto &frame: stacks_.frames(trace.stack)) {
+                log_->info("        at {}", methods_.frame(jni, frame.method, frame.location));
+            }
+        }
+    }
+
+    void WallSampler::writeFlame(JNIEnv *jni, std::ostream &out) const {
+        traces_.forEach([&](uint64_t, const uint64_t count, const Trace &trace) {
+            // GetStackTrace 返回的帧栈顶在前，折叠栈需要根帧在前
+            out << stateName(trace.state);
+            const auto frames = stacks_.frames(trace.stack);
+            for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+                out << ';' << methods_.name(jni, it->method, false);
+            }
+            out << ' ' << count << '\n';
+        });
+    }
+} // jvmti_tools
@@ -0,0 +1,87 @@
+#ifndef WALLSAMPLER_H
+#define WALLSAMPLER_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <jvmti.h>
+
+#include "CounterTable.h"
+#include "Histogram.h"
+#include "MethodResolver.h"
+#include "StackTable.h"
+#include "spdlog/logger.h"
+
+namespace jvmti_tools {
+    struct WallSamplerOptions {
+        std::chrono::milliseconds interval{100}; // 目标采样间隔
+        std::chrono::milliseconds max_interval{5000}; // 自动降频的上限
+        double budget = 0.02; // 采样耗时占采样间隔的上限比例
+        uint32_t stack_depth = 64;
+        size_t capacity = 16384; // (线程状态, 调用栈) 组合数量上限
+        size_t top = 10; // 报告输出的调用栈数量
+        std::vector<std::string> threads; // 线程名前缀，为空时采样全部线程
+    };
+
+    // 墙钟采样：每个周期用 GetAllStackTraces（或按线程名过滤后 GetThreadListStackTraces）一次取得
+    // 所有线程的调用栈与状态，调用栈驻留到 StackTable，按（线程状态、调用栈）计数，可输出火焰图。
+    // 每次采样计时，耗时超过 budget × 间隔时自动拉长间隔，耗时回落后逐步恢复。仅由 AgentThread 调用 sample
+    class WallSampler {
+    public:
+        static constexpr uint32_t MAX_STACK_DEPTH = 128;
+
+        enum class State : uint8_t {
+            Runnable,
+            Blocked,
+            Waiting,
+            TimedWaiting,
+            Count
+        };
+
+    private:
+        struct Trace {
+            State state = State::Runnable;
+            uint64_t stack = 0;
+        };
+
+        jvmtiEnv *jvmti_;
+        WallSamplerOptions options_;
+        std::shared_ptr<spdlog::logger> log_;
+        CounterTable<Trace> traces_;
+        StackTable stacks_;
+        MethodResolver methods_;
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(State::Count)> states_{};
+        std::atomic<uint64_t> passes_{0};
+        std::atomic<int64_t> interval_ms_; // 当前采样间隔
+        Histogram cost_; // 每次采样耗时（纳秒）
+        std::vector<jthread> selected_; // 按线程名过滤后的线程，复用缓冲区
+
+        bool selected(JNIEnv *jni, jthread thread);
+
+        void adapt(std::chrono::nanoseconds cost);
+
+    public:
+        WallSampler(jvmtiEnv *jvmti, const WallSamplerOptions &options, std::shared_ptr<spdlog::logger> log);
+
+        // 执行一次采样，返回下一次采样前的等待间隔
+        std::chrono::milliseconds sample(JNIEnv *jni);
+
+        // 输出各状态样本数与样本最多的调用栈；jni 可为空
+        void report(JNIEnv *jni, size_t top) const;
+
+        // 折叠栈格式，线程状态作为根帧
+        void writeFlame(JNIEnv *jni, std::ostream &out) const;
+
+        const WallSamplerOptions &options() const { return options_; }
+
+        static const char *stateName(State state);
+
+        static bool stateOf(jint thread_state, State *state);
+    };
+} // jvmti_tools
+
+#endif //WALLSAMPLER_H